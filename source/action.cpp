@@ -22,13 +22,25 @@
 #include "map.h"
 #include "editor.h"
 #include "gui.h"
+#include "tile_delta.h"
+#include "undo_store.h"
+#include "trace.h"
 
-// Add necessary includes for exception handling and file operations
 #include <exception>
-#include <fstream>
-#include <wx/filename.h>
-#include <wx/datetime.h>
-#include <wx/stdpaths.h>
+
+TileMoveList::~TileMoveList() {
+	for (auto& entry : displaced) {
+		delete entry.second;
+	}
+}
+
+size_t TileMoveList::memsize() const {
+	size_t mem = sizeof(*this) + sources.capacity() * sizeof(Position) + displaced.capacity() * sizeof(displaced[0]);
+	for (const auto& entry : displaced) {
+		mem += entry.second->memsize();
+	}
+	return mem;
+}
 
 Change::Change() :
 	type(CHANGE_NONE), data(nullptr) {
@@ -61,6 +73,27 @@ Change* Change::Create(Waypoint* wp, const Position& where) {
 	return c;
 }
 
+Change* Change::Create(ItemIdChangeList&& items) {
+	Change* c = newd Change();
+	c->type = CHANGE_ITEM_IDS;
+	c->data = newd ItemIdChangeList(std::move(items));
+	return c;
+}
+
+Change* Change::Create(SelectionChangeList&& selection) {
+	Change* c = newd Change();
+	c->type = CHANGE_SELECTION;
+	c->data = newd SelectionChangeList(std::move(selection));
+	return c;
+}
+
+Change* Change::Create(TileMoveList&& moves) {
+	Change* c = newd Change();
+	c->type = CHANGE_MOVE_TILES;
+	c->data = newd TileMoveList(std::move(moves));
+	return c;
+}
+
 Change::~Change() {
 	clear();
 }
@@ -79,6 +112,22 @@ void Change::clear() {
 			ASSERT(data);
 			delete reinterpret_cast<std::pair<std::string, Position>*>(data);
 			break;
+		case CHANGE_ITEM_IDS:
+			ASSERT(data);
+			delete reinterpret_cast<ItemIdChangeList*>(data);
+			break;
+		case CHANGE_SELECTION:
+			ASSERT(data);
+			delete reinterpret_cast<SelectionChangeList*>(data);
+			break;
+		case CHANGE_TILE_DELTA:
+			ASSERT(data);
+			delete reinterpret_cast<TileDelta*>(data);
+			break;
+		case CHANGE_MOVE_TILES:
+			ASSERT(data);
+			delete reinterpret_cast<TileMoveList*>(data);
+			break;
 		case CHANGE_NONE:
 			break;
 		default:
@@ -100,6 +149,22 @@ uint32_t Change::memsize() const {
 			ASSERT(data);
 			mem += reinterpret_cast<Tile*>(data)->memsize();
 			break;
+		case CHANGE_ITEM_IDS:
+			ASSERT(data);
+			mem += sizeof(ItemIdChangeList) + reinterpret_cast<ItemIdChangeList*>(data)->capacity() * sizeof(ItemIdChange);
+			break;
+		case CHANGE_SELECTION:
+			ASSERT(data);
+			mem += reinterpret_cast<SelectionChangeList*>(data)->memsize();
+			break;
+		case CHANGE_TILE_DELTA:
+			ASSERT(data);
+			mem += reinterpret_cast<TileDelta*>(data)->memsize();
+			break;
+		case CHANGE_MOVE_TILES:
+			ASSERT(data);
+			mem += reinterpret_cast<TileMoveList*>(data)->memsize();
+			break;
 		default:
 			break;
 	}
@@ -122,7 +187,14 @@ Action::~Action() {
 
 size_t Action::approx_memsize() const {
 	uint32_t mem = sizeof(*this);
-	mem += changes.size() * (sizeof(Change) + sizeof(Tile) + sizeof(Item) + 6 /* approx overhead*/);
+	for (const Change* c : changes) {
+		if (c->type == CHANGE_TILE) {
+			mem += sizeof(Change) + sizeof(Tile) + sizeof(Item) + 6 /* approx overhead*/;
+		} else {
+			// Packed changes can be much smaller or larger than a tile
+			mem += c->memsize();
+		}
+	}
 	return mem;
 }
 
@@ -139,6 +211,15 @@ size_t Action::memsize() const {
 				break;
 			}
 
+			case CHANGE_ITEM_IDS:
+			case CHANGE_SELECTION:
+			case CHANGE_TILE_DELTA:
+			case CHANGE_MOVE_TILES: {
+				ASSERT(c->data);
+				mem += c->memsize();
+				break;
+			}
+
 			default:
 				break;
 		}
@@ -148,6 +229,7 @@ size_t Action::memsize() const {
 }
 
 void Action::commit(DirtyList* dirty_list) {
+	unpackTiles();
 	editor.selection.start(Selection::INTERNAL);
 	ChangeList::const_iterator it = changes.begin();
 	while (it != changes.end()) {
@@ -178,6 +260,8 @@ void Action::commit(DirtyList* dirty_list) {
 				}
 
 				newtile->update();
+				// The colour may only be known after update, refresh what swapTile stored
+				editor.map.updateMinimapColor(pos);
 
 				// std::cout << "\tSwitched tile at " << pos.x << ";" << pos.y << ";" << pos.z << " from " << (void*)oldtile << " to " << *data <<  std::endl;
 				if (newtile->isSelected()) {
@@ -282,6 +366,24 @@ void Action::commit(DirtyList* dirty_list) {
 				break;
 			}
 
+			case CHANGE_ITEM_IDS: {
+				ASSERT(c->data);
+				swapItemIds(*reinterpret_cast<ItemIdChangeList*>(c->data), dirty_list);
+				break;
+			}
+
+			case CHANGE_SELECTION: {
+				ASSERT(c->data);
+				swapSelection(*reinterpret_cast<SelectionChangeList*>(c->data), false);
+				break;
+			}
+
+			case CHANGE_MOVE_TILES: {
+				ASSERT(c->data);
+				moveTiles(*reinterpret_cast<TileMoveList*>(c->data), false, dirty_list);
+				break;
+			}
+
 			default:
 				break;
 		}
@@ -289,6 +391,7 @@ void Action::commit(DirtyList* dirty_list) {
 	}
 	editor.selection.finish(Selection::INTERNAL);
 	commited = true;
+	packTiles();
 }
 
 void Action::undo(DirtyList* dirty_list) {
@@ -296,6 +399,7 @@ void Action::undo(DirtyList* dirty_list) {
 		return;
 	}
 
+	unpackTiles();
 	editor.selection.start(Selection::INTERNAL);
 	ChangeList::reverse_iterator it = changes.rbegin();
 
@@ -411,6 +515,24 @@ void Action::undo(DirtyList* dirty_list) {
 				break;
 			}
 
+			case CHANGE_ITEM_IDS: {
+				ASSERT(c->data);
+				swapItemIds(*reinterpret_cast<ItemIdChangeList*>(c->data), dirty_list);
+				break;
+			}
+
+			case CHANGE_SELECTION: {
+				ASSERT(c->data);
+				swapSelection(*reinterpret_cast<SelectionChangeList*>(c->data), true);
+				break;
+			}
+
+			case CHANGE_MOVE_TILES: {
+				ASSERT(c->data);
+				moveTiles(*reinterpret_cast<TileMoveList*>(c->data), true, dirty_list);
+				break;
+			}
+
 			default:
 				break;
 		}
@@ -418,13 +540,200 @@ void Action::undo(DirtyList* dirty_list) {
 	}
 	editor.selection.finish(Selection::INTERNAL);
 	commited = false;
+	packTiles();
+}
+
+void Action::packTiles() {
+	// The dirty list of a live client still refers to the tiles
+	if (editor.IsLiveClient()) {
+		return;
+	}
+
+	// A delta is only valid against the map tile left by its own change, so
+	// positions changed more than once by the action keep their tiles
+	std::vector<Position> positions;
+	positions.reserve(changes.size());
+	for (Change* c : changes) {
+		if (c->type == CHANGE_TILE && c->data) {
+			positions.push_back(reinterpret_cast<Tile*>(c->data)->getPosition());
+		}
+	}
+	std::sort(positions.begin(), positions.end());
+
+	for (Change* c : changes) {
+		if (c->type != CHANGE_TILE || !c->data) {
+			continue;
+		}
+
+		Tile* tile = reinterpret_cast<Tile*>(c->data);
+		const Position pos = tile->getPosition();
+		auto range = std::equal_range(positions.begin(), positions.end(), pos);
+		const Tile* base = editor.map.getTile(pos);
+		if (range.second - range.first != 1 || !base) {
+			continue;
+		}
+
+		c->data = TileDelta::Create(tile, base);
+		c->type = CHANGE_TILE_DELTA;
+	}
+}
+
+void Action::unpackTiles() {
+	for (Change* c : changes) {
+		if (c->type != CHANGE_TILE_DELTA) {
+			continue;
+		}
+
+		TileDelta* delta = reinterpret_cast<TileDelta*>(c->data);
+		c->data = delta->createTile(editor.map);
+		c->type = CHANGE_TILE;
+		delete delta;
+	}
+}
+
+void Action::swapItemIds(ItemIdChangeList& items, DirtyList* dirty_list) {
+	size_t next = 0;
+	while (next < items.size()) {
+		const Position pos = items[next].position;
+		size_t end = next;
+		while (end < items.size() && items[end].position == pos) {
+			++end;
+		}
+
+		Tile* tile = editor.map.getTile(pos);
+		ASSERT(tile);
+		if (!tile) {
+			next = end;
+			continue;
+		}
+
+		// The entries of a tile are sorted by index
+		uint32_t index = 0;
+		auto swap = [&](Item* item) {
+			if (index++ == items[next].index) {
+				ItemIdChange& change = items[next++];
+				ASSERT(item->getID() == change.from);
+				editor.map.changeItemId(pos, item, change.to);
+				std::swap(change.from, change.to);
+			}
+			return next < end;
+		};
+		foreach_ItemOnTile(tile, swap);
+		next = end;
+
+		tile->update();
+		tile->modify();
+		editor.map.updateMinimapColor(pos);
+
+		// Update other nodes in the network
+		if (editor.IsLiveServer() && dirty_list) {
+			dirty_list->AddPosition(pos.x, pos.y, pos.z);
+		}
+	}
+}
+
+void Action::swapSelection(SelectionChangeList& selection, bool undo) {
+	for (size_t i = 0; i < selection.size(); ++i) {
+		const size_t entry = undo ? selection.size() - 1 - i : i;
+		Tile* tile = editor.map.getTile(selection.getPosition(entry));
+		ASSERT(tile);
+		if (!tile) {
+			continue;
+		}
+
+		selection.swap(entry, tile);
+		tile->update();
+		if (tile->isSelected()) {
+			editor.selection.addInternal(tile);
+		} else {
+			editor.selection.removeInternal(tile);
+		}
+	}
+}
+
+void Action::moveTiles(TileMoveList& moves, bool undo, DirtyList* dirty_list) {
+	Map& map = editor.map;
+	const size_t count = moves.sources.size();
+
+	// Houses and spawns refer to their tiles by position
+	auto detach = [&](Tile* tile) {
+		if (House* house = map.houses.getHouse(tile->getHouseID())) {
+			house->removeTile(tile);
+			tile->setHouse(house);
+		}
+		map.removeSpawn(tile);
+		if (tile->isSelected()) {
+			editor.selection.removeInternal(tile);
+		}
+	};
+	auto attach = [&](Tile* tile, const Position& pos) {
+		if (House* house = map.houses.getHouse(tile->getHouseID())) {
+			house->addTile(tile);
+		}
+		if (tile->spawn) {
+			map.addSpawn(tile);
+		}
+		if (tile->isSelected()) {
+			editor.selection.addInternal(tile);
+		}
+		tile->modify();
+		if (editor.IsLiveServer() && dirty_list) {
+			dirty_list->AddPosition(pos.x, pos.y, pos.z);
+		}
+	};
+
+	std::vector<Tile*> lifted(count, nullptr);
+	auto displaced = moves.displaced.begin();
+	for (size_t i = 0; i < count; ++i) {
+		const Position pos = undo ? moves.sources[i] - moves.offset : moves.sources[i];
+		Tile* tile = map.getTile(pos);
+		ASSERT(tile);
+		if (tile) {
+			detach(tile);
+		}
+
+		// Undoing puts back what the move replaced
+		Tile* restored = nullptr;
+		if (undo && displaced != moves.displaced.end() && displaced->first == i) {
+			restored = displaced->second;
+			++displaced;
+		}
+		map.swapTile(pos, restored);
+		if (restored) {
+			attach(restored, pos);
+		} else if (editor.IsLiveServer() && dirty_list) {
+			dirty_list->AddPosition(pos.x, pos.y, pos.z);
+		}
+		lifted[i] = tile;
+	}
+	if (undo) {
+		moves.displaced.clear();
+	}
+
+	for (size_t i = 0; i < count; ++i) {
+		Tile* tile = lifted[i];
+		if (!tile) {
+			continue;
+		}
+
+		const Position pos = undo ? moves.sources[i] : moves.sources[i] - moves.offset;
+		tile->setLocation(map.createTileL(pos));
+		Tile* replaced = map.swapTile(pos, tile);
+		if (replaced) {
+			ASSERT(!undo);
+			detach(replaced);
+			moves.displaced.emplace_back(uint32_t(i), replaced);
+		}
+		attach(tile, pos);
+	}
 }
 
 BatchAction::BatchAction(Editor& editor, ActionIdentifier ident) :
 	editor(editor),
 	timestamp(0),
 	memory_size(0),
-	type(ident) {
+	type(ident),
+	spilled(false) {
 	////
 }
 
@@ -443,12 +752,7 @@ BatchAction::~BatchAction() {
 				}
 			} catch (const std::exception& e) {
 				// Log error but continue cleanup
-				std::ofstream logFile((wxStandardPaths::Get().GetUserDataDir() + wxFileName::GetPathSeparator() + "action_error.log").ToStdString(), std::ios::app);
-				if (logFile.is_open()) {
-					wxDateTime now = wxDateTime::Now();
-					logFile << now.FormatISOCombined() << ": Error in BatchAction destructor: " << e.what() << "\n";
-					logFile.close();
-				}
+				TRACE_ERROR(Actions, "Error in BatchAction destructor: %s", e.what());
 			}
 		}
 		
@@ -456,12 +760,7 @@ BatchAction::~BatchAction() {
 		batch.clear();
 	} catch (const std::exception& e) {
 		// Log error but don't crash
-		std::ofstream logFile((wxStandardPaths::Get().GetUserDataDir() + wxFileName::GetPathSeparator() + "action_error.log").ToStdString(), std::ios::app);
-		if (logFile.is_open()) {
-			wxDateTime now = wxDateTime::Now();
-			logFile << now.FormatISOCombined() << ": Critical error in BatchAction destructor: " << e.what() << "\n";
-			logFile.close();
-		}
+		TRACE_ERROR(Actions, "Critical error in BatchAction destructor: %s", e.what());
 	}
 }
 
@@ -513,12 +812,7 @@ void BatchAction::addAction(Action* action) {
 	}
 	catch (const std::exception& e) {
 		// Log error but don't crash
-		std::ofstream logFile((wxStandardPaths::Get().GetUserDataDir() + wxFileName::GetPathSeparator() + "action_error.log").ToStdString(), std::ios::app);
-		if (logFile.is_open()) {
-			wxDateTime now = wxDateTime::Now();
-			logFile << now.FormatISOCombined() << ": Error in BatchAction::addAction: " << e.what() << "\n";
-			logFile.close();
-		}
+		TRACE_ERROR(Actions, "Error in BatchAction::addAction: %s", e.what());
 		
 		// Try to clean up action if possible
 		try {
@@ -591,17 +885,12 @@ void BatchAction::merge(BatchAction* other) {
 		other->batch.clear();
 	} catch (const std::exception& e) {
 		// Log error but don't crash
-		std::ofstream logFile((wxStandardPaths::Get().GetUserDataDir() + wxFileName::GetPathSeparator() + "action_error.log").ToStdString(), std::ios::app);
-		if (logFile.is_open()) {
-			wxDateTime now = wxDateTime::Now();
-			logFile << now.FormatISOCombined() << ": Error merging batch actions: " << e.what() << "\n";
-			logFile.close();
-		}
+		TRACE_ERROR(Actions, "Error merging batch actions: %s", e.what());
 	}
 }
 
 ActionQueue::ActionQueue(Editor& editor) :
-	current(0), memory_size(0), editor(editor) {
+	current(0), memory_size(0), editor(editor), store(newd UndoStore(editor)) {
 	////
 }
 
@@ -615,23 +904,13 @@ ActionQueue::~ActionQueue() {
 				delete action;
 			} catch (const std::exception& e) {
 				// Log error but continue cleanup
-				std::ofstream logFile((wxStandardPaths::Get().GetUserDataDir() + wxFileName::GetPathSeparator() + "action_error.log").ToStdString(), std::ios::app);
-				if (logFile.is_open()) {
-					wxDateTime now = wxDateTime::Now();
-					logFile << now.FormatISOCombined() << ": Error deleting action in queue destructor: " << e.what() << "\n";
-					logFile.close();
-				}
+				TRACE_ERROR(Actions, "Error deleting action in queue destructor: %s", e.what());
 			}
 		}
 		actions.clear(); // Ensure container is empty
 	} catch (const std::exception& e) {
 		// Log error but don't crash
-		std::ofstream logFile((wxStandardPaths::Get().GetUserDataDir() + wxFileName::GetPathSeparator() + "action_error.log").ToStdString(), std::ios::app);
-		if (logFile.is_open()) {
-			wxDateTime now = wxDateTime::Now();
-			logFile << now.FormatISOCombined() << ": Error in ActionQueue destructor: " << e.what() << "\n";
-			logFile.close();
-		}
+		TRACE_ERROR(Actions, "Error in ActionQueue destructor: %s", e.what());
 	}
 }
 
@@ -647,6 +926,76 @@ BatchAction* ActionQueue::createBatch(ActionIdentifier ident) {
 	return newd BatchAction(editor, ident);
 }
 
+const UndoStore& ActionQueue::getUndoStore() const {
+	return *store;
+}
+
+bool ActionQueue::spillBatch() {
+	const uint64_t max_disk_size = uint64_t(1024 * 1024) * g_settings.getInteger(Config::UNDO_DISK_SIZE);
+	// Live sessions keep the whole history in memory
+	if (max_disk_size == 0 || editor.IsLive()) {
+		return false;
+	}
+
+	size_t oldest = 0;
+	while (oldest + 1 < current && actions[oldest]->isSpilled()) {
+		++oldest;
+	}
+	size_t newest = actions.size();
+	while (newest > current + 1 && actions[newest - 1]->isSpilled()) {
+		--newest;
+	}
+
+	BatchAction* batch = nullptr;
+	if (oldest + 1 < current && (newest <= current + 1 || current - oldest >= newest - 1 - current)) {
+		batch = actions[oldest];
+	} else if (newest > current + 1) {
+		batch = actions[newest - 1];
+	}
+	if (!batch) {
+		return false;
+	}
+
+	const size_t size = batch->memsize();
+	if (!store->spill(batch, max_disk_size)) {
+		return false;
+	}
+	memory_size -= size;
+	return true;
+}
+
+bool ActionQueue::reloadBatch(BatchAction* batch) {
+	if (!store->reload(batch)) {
+		clear();
+		g_gui.PopupDialog("Error", "The undo history could not be read back from disk and has been cleared.", wxOK);
+		return false;
+	}
+	memory_size += batch->memsize(true);
+	return true;
+}
+
+void ActionQueue::deleteBatch(BatchAction* batch) {
+	if (batch->isSpilled()) {
+		store->discard(batch);
+	} else {
+		memory_size -= batch->memsize();
+	}
+	delete batch;
+}
+
+void ActionQueue::deleteOldest() {
+	BatchAction* todelete = actions.front();
+	actions.pop_front(); // Remove from container before accessing or deleting
+
+	if (todelete) {
+		deleteBatch(todelete);
+	}
+
+	if (current > 0) {
+		current--;
+	}
+}
+
 void ActionQueue::resetTimer() {
 	if (!actions.empty()) {
 		actions.back()->resetTimer();
@@ -696,12 +1045,7 @@ void ActionQueue::addAction(Action* action, int stacking_delay) {
 		}
 		catch (const std::exception& e) {
 			// Log error but don't crash
-			std::ofstream logFile((wxStandardPaths::Get().GetUserDataDir() + wxFileName::GetPathSeparator() + "action_error.log").ToStdString(), std::ios::app);
-			if (logFile.is_open()) {
-				wxDateTime now = wxDateTime::Now();
-				logFile << now.FormatISOCombined() << ": Error in addAction: " << e.what() << "\n";
-				logFile.close();
-			}
+			TRACE_ERROR(Actions, "Error in addAction: %s", e.what());
 			
 			// Clean up if exception occurred
 			delete batch;
@@ -709,12 +1053,7 @@ void ActionQueue::addAction(Action* action, int stacking_delay) {
 	}
 	catch (const std::exception& e) {
 		// Log error but don't crash
-		std::ofstream logFile((wxStandardPaths::Get().GetUserDataDir() + wxFileName::GetPathSeparator() + "action_error.log").ToStdString(), std::ios::app);
-		if (logFile.is_open()) {
-			wxDateTime now = wxDateTime::Now();
-			logFile << now.FormatISOCombined() << ": Critical error in addAction: " << e.what() << "\n";
-			logFile.close();
-		}
+		TRACE_ERROR(Actions, "Critical error in addAction: %s", e.what());
 		
 		// Try to clean up action if possible
 		try {
@@ -789,22 +1128,12 @@ void ActionQueue::addBatch(BatchAction* batch, int stacking_delay) {
 						}
 					} catch (const std::exception& e) {
 						// Log error but continue cleanup
-						std::ofstream logFile((wxStandardPaths::Get().GetUserDataDir() + wxFileName::GetPathSeparator() + "action_error.log").ToStdString(), std::ios::app);
-						if (logFile.is_open()) {
-							wxDateTime now = wxDateTime::Now();
-							logFile << now.FormatISOCombined() << ": Error deleting remote action: " << e.what() << "\n";
-							logFile.close();
-						}
+						TRACE_ERROR(Actions, "Error deleting remote action: %s", e.what());
 					}
 				}
 			} catch (const std::exception& e) {
 				// Log error but don't crash
-				std::ofstream logFile((wxStandardPaths::Get().GetUserDataDir() + wxFileName::GetPathSeparator() + "action_error.log").ToStdString(), std::ios::app);
-				if (logFile.is_open()) {
-					wxDateTime now = wxDateTime::Now();
-					logFile << now.FormatISOCombined() << ": Error handling remote batch: " << e.what() << "\n";
-					logFile.close();
-				}
+				TRACE_ERROR(Actions, "Error handling remote batch: %s", e.what());
 			}
 			return;
 		}
@@ -818,50 +1147,19 @@ void ActionQueue::addBatch(BatchAction* batch, int stacking_delay) {
 				actions.pop_back(); // Remove from container before deleting to avoid invalid references
 				
 				if (todelete) {
-					memory_size -= todelete->memsize();
-					delete todelete;
+					deleteBatch(todelete);
 				}
 			} catch (const std::exception& e) {
 				// Log error but continue processing
-				std::ofstream logFile((wxStandardPaths::Get().GetUserDataDir() + wxFileName::GetPathSeparator() + "action_error.log").ToStdString(), std::ios::app);
-				if (logFile.is_open()) {
-					wxDateTime now = wxDateTime::Now();
-					logFile << now.FormatISOCombined() << ": Error clearing action: " << e.what() << "\n";
-					logFile.close();
-				}
+				TRACE_ERROR(Actions, "Error clearing action: %s", e.what());
 			}
 		}
 
 		// Safely manage memory for undo size limits
 		try {
-			// Limit by memory size
-			while (memory_size > size_t(1024 * 1024 * g_settings.getInteger(Config::UNDO_MEM_SIZE)) && !actions.empty()) {
-				BatchAction* todelete = actions.front();
-				actions.pop_front(); // Remove from container before accessing or deleting
-				
-				if (todelete) {
-					memory_size -= todelete->memsize();
-					delete todelete;
-				}
-				
-				if (current > 0) {
-					current--;
-				}
-			}
-
 			// Limit by action count
 			while (actions.size() > size_t(g_settings.getInteger(Config::UNDO_SIZE)) && !actions.empty()) {
-				BatchAction* todelete = actions.front();
-				actions.pop_front(); // Remove from container before accessing or deleting
-				
-				if (todelete) {
-					memory_size -= todelete->memsize();
-					delete todelete;
-				}
-				
-				if (current > 0) {
-					current--;
-				}
+				deleteOldest();
 			}
 
 			// Process action with additional safety
@@ -869,6 +1167,7 @@ void ActionQueue::addBatch(BatchAction* batch, int stacking_delay) {
 			if (!actions.empty()) {
 				BatchAction* lastAction = actions.back();
 				if (lastAction && batch && 
+					!lastAction->isSpilled() &&
 					lastAction->type == batch->type && 
 					g_settings.getInteger(Config::GROUP_ACTIONS) && 
 					time(nullptr) - stacking_delay < lastAction->timestamp) {
@@ -894,14 +1193,18 @@ void ActionQueue::addBatch(BatchAction* batch, int stacking_delay) {
 				batch->timestamp = time(nullptr);
 				current++;
 			}
+
+			// Limit by memory size, older batches go to the undo store until
+			// it is full, then the oldest ones are deleted
+			const size_t max_memory = size_t(1024 * 1024) * g_settings.getInteger(Config::UNDO_MEM_SIZE);
+			while (memory_size > max_memory && actions.size() > 1) {
+				if (!spillBatch()) {
+					deleteOldest();
+				}
+			}
 		} catch (const std::exception& e) {
 			// Log error but don't crash
-			std::ofstream logFile((wxStandardPaths::Get().GetUserDataDir() + wxFileName::GetPathSeparator() + "action_error.log").ToStdString(), std::ios::app);
-			if (logFile.is_open()) {
-				wxDateTime now = wxDateTime::Now();
-				logFile << now.FormatISOCombined() << ": Error processing batch: " << e.what() << "\n";
-				logFile.close();
-			}
+			TRACE_ERROR(Actions, "Error processing batch: %s", e.what());
 			
 			// If we caught an exception and haven't added or deleted the batch yet, delete it now
 			if (batch) {
@@ -910,12 +1213,7 @@ void ActionQueue::addBatch(BatchAction* batch, int stacking_delay) {
 		}
 	} catch (const std::exception& e) {
 		// Last resort error handler for entire function
-		std::ofstream logFile((wxStandardPaths::Get().GetUserDataDir() + wxFileName::GetPathSeparator() + "action_error.log").ToStdString(), std::ios::app);
-		if (logFile.is_open()) {
-			wxDateTime now = wxDateTime::Now();
-			logFile << now.FormatISOCombined() << ": Critical error in addBatch: " << e.what() << "\n";
-			logFile.close();
-		}
+		TRACE_ERROR(Actions, "Critical error in addBatch: %s", e.what());
 		
 		// Clean up batch if we haven't processed it yet
 		if (batch) {
@@ -929,18 +1227,19 @@ void ActionQueue::undo() {
 		if (current > 0 && current <= actions.size()) {
 			current--;
 			BatchAction* batch = actions[current];
+			if (batch && batch->isSpilled() && !reloadBatch(batch)) {
+				return;
+			}
 			if (batch) {
 				batch->undo();
 			}
+
+			const size_t max_memory = size_t(1024 * 1024) * g_settings.getInteger(Config::UNDO_MEM_SIZE);
+			while (memory_size > max_memory && spillBatch()) { }
 		}
 	} catch (const std::exception& e) {
 		// Log error but don't crash
-		std::ofstream logFile((wxStandardPaths::Get().GetUserDataDir() + wxFileName::GetPathSeparator() + "action_error.log").ToStdString(), std::ios::app);
-		if (logFile.is_open()) {
-			wxDateTime now = wxDateTime::Now();
-			logFile << now.FormatISOCombined() << ": Error in undo(): " << e.what() << "\n";
-			logFile.close();
-		}
+		TRACE_ERROR(Actions, "Error in undo(): %s", e.what());
 	}
 }
 
@@ -948,19 +1247,20 @@ void ActionQueue::redo() {
 	try {
 		if (current < actions.size()) {
 			BatchAction* batch = actions[current];
+			if (batch && batch->isSpilled() && !reloadBatch(batch)) {
+				return;
+			}
 			if (batch) {
 				batch->redo();
 			}
 			current++;
+
+			const size_t max_memory = size_t(1024 * 1024) * g_settings.getInteger(Config::UNDO_MEM_SIZE);
+			while (memory_size > max_memory && spillBatch()) { }
 		}
 	} catch (const std::exception& e) {
 		// Log error but don't crash
-		std::ofstream logFile((wxStandardPaths::Get().GetUserDataDir() + wxFileName::GetPathSeparator() + "action_error.log").ToStdString(), std::ios::app);
-		if (logFile.is_open()) {
-			wxDateTime now = wxDateTime::Now();
-			logFile << now.FormatISOCombined() << ": Error in redo(): " << e.what() << "\n";
-			logFile.close();
-		}
+		TRACE_ERROR(Actions, "Error in redo(): %s", e.what());
 	}
 }
 
@@ -973,6 +1273,7 @@ void ActionQueue::clear() {
 		actions.clear();
 		current = 0;
 		memory_size = 0;
+		store->clear();
 		
 		// Now safely delete each action
 		for (BatchAction* action : actionsCopy) {
@@ -982,22 +1283,12 @@ void ActionQueue::clear() {
 				}
 			} catch (const std::exception& e) {
 				// Log error but continue cleanup
-				std::ofstream logFile((wxStandardPaths::Get().GetUserDataDir() + wxFileName::GetPathSeparator() + "action_error.log").ToStdString(), std::ios::app);
-				if (logFile.is_open()) {
-					wxDateTime now = wxDateTime::Now();
-					logFile << now.FormatISOCombined() << ": Error in clear() deleting action: " << e.what() << "\n";
-					logFile.close();
-				}
+				TRACE_ERROR(Actions, "Error in clear() deleting action: %s", e.what());
 			}
 		}
 	} catch (const std::exception& e) {
 		// Log error but don't crash
-		std::ofstream logFile((wxStandardPaths::Get().GetUserDataDir() + wxFileName::GetPathSeparator() + "action_error.log").ToStdString(), std::ios::app);
-		if (logFile.is_open()) {
-			wxDateTime now = wxDateTime::Now();
-			logFile << now.FormatISOCombined() << ": Critical error in clear(): " << e.what() << "\n";
-			logFile.close();
-		}
+		TRACE_ERROR(Actions, "Critical error in clear(): %s", e.what());
 		
 		// Reset state as much as possible
 		actions.clear();
@@ -1006,27 +1297,61 @@ void ActionQueue::clear() {
 	}
 }
 
+namespace {
+	// Spreads the low 16 bits of value to the even bits
+	uint32_t spreadBits(uint32_t value) {
+		value &= 0x0000FFFF;
+		value = (value | (value << 8)) & 0x00FF00FF;
+		value = (value | (value << 4)) & 0x0F0F0F0F;
+		value = (value | (value << 2)) & 0x33333333;
+		value = (value | (value << 1)) & 0x55555555;
+		return value;
+	}
+
+	uint32_t compactBits(uint32_t value) {
+		value &= 0x55555555;
+		value = (value | (value >> 1)) & 0x33333333;
+		value = (value | (value >> 2)) & 0x0F0F0F0F;
+		value = (value | (value >> 4)) & 0x00FF00FF;
+		value = (value | (value >> 8)) & 0x0000FFFF;
+		return value;
+	}
+}
+
+int DirtyList::ValueType::getNodeX() const {
+	return int(compactBits(pos));
+}
+
+int DirtyList::ValueType::getNodeY() const {
+	return int(compactBits(pos >> 1));
+}
+
+uint32_t DirtyList::MakeKey(int ndx, int ndy) {
+	return spreadBits(uint32_t(ndx)) | (spreadBits(uint32_t(ndy)) << 1);
+}
+
 DirtyList::DirtyList() :
-	owner(0) {
-	;
+	owner(0),
+	compacted(0) {
+	////
 }
 
 DirtyList::~DirtyList() {
-	;
+	////
 }
 
 void DirtyList::AddPosition(int x, int y, int z) {
-	uint32_t m = ((x >> 2) << 18) | ((y >> 2) << 4);
-	ValueType fi = { m, 0 };
-	SetType::iterator s = iset.find(fi);
-	if (s != iset.end()) {
-		ValueType v = *s;
-		iset.erase(s);
-		v.floors = (1 << z) | v.floors;
-		iset.insert(v);
-	} else {
-		ValueType v = { m, (uint32_t)(1 << z) };
-		iset.insert(v);
+	const uint32_t key = MakeKey(x >> 2, y >> 2);
+	const uint32_t floor = uint32_t(1) << z;
+	// Changes mostly come tile by tile through the same node
+	if (!entries.empty() && entries.back().pos == key) {
+		entries.back().floors |= floor;
+		return;
+	}
+
+	entries.push_back({ key, floor });
+	if (entries.size() >= 2 * std::max<size_t>(compacted, 4096)) {
+		Compact();
 	}
 }
 
@@ -1034,8 +1359,32 @@ void DirtyList::AddChange(Change* c) {
 	ichanges.push_back(c);
 }
 
-DirtyList::SetType& DirtyList::GetPosList() {
-	return iset;
+void DirtyList::Compact() {
+	if (compacted == entries.size()) {
+		return;
+	}
+
+	auto less = [](const ValueType& a, const ValueType& b) {
+		return a.pos < b.pos;
+	};
+	std::sort(entries.begin() + compacted, entries.end(), less);
+	std::inplace_merge(entries.begin(), entries.begin() + compacted, entries.end(), less);
+
+	size_t last = 0;
+	for (size_t i = 1; i < entries.size(); ++i) {
+		if (entries[i].pos == entries[last].pos) {
+			entries[last].floors |= entries[i].floors;
+		} else {
+			entries[++last] = entries[i];
+		}
+	}
+	entries.resize(last + 1);
+	compacted = entries.size();
+}
+
+const DirtyList::NodeList& DirtyList::GetPosList() {
+	Compact();
+	return entries;
 }
 
 ChangeList& DirtyList::GetChanges() {
@@ -21,21 +21,59 @@
 #include "position.h"
 
 #include <deque>
+#include <memory>
 
 class Editor;
 class Tile;
 class House;
 class Waypoint;
+class SelectionChangeList;
 class Change;
 class Action;
 class BatchAction;
 class ActionQueue;
+class UndoStore;
 
 enum ChangeType {
 	CHANGE_NONE,
 	CHANGE_TILE,
 	CHANGE_MOVE_HOUSE_EXIT,
 	CHANGE_MOVE_WAYPOINT,
+	CHANGE_ITEM_IDS,
+	CHANGE_SELECTION,
+	// A CHANGE_TILE of a committed or undone action, stored as a TileDelta
+	CHANGE_TILE_DELTA,
+	CHANGE_MOVE_TILES,
+};
+
+// An item whose id was changed in place, it keeps its class and everything
+// else. Applying the change swaps from and to, so the same entry undoes it.
+struct ItemIdChange {
+	Position position;
+	// Index of the item on its tile in foreach_ItemOnTile order
+	uint32_t index;
+	uint16_t from;
+	uint16_t to;
+};
+
+// Entries of the same tile are expected next to each other
+typedef std::vector<ItemIdChange> ItemIdChangeList;
+
+// Tiles moved as they are, without copying. Applying the change relocates the
+// tile objects from every source to source - offset, undoing it moves them
+// back. The tiles a move replaced at its destination are kept here while the
+// change is applied.
+struct TileMoveList {
+	TileMoveList() = default;
+	TileMoveList(TileMoveList&& other) = default;
+	~TileMoveList();
+
+	size_t memsize() const;
+
+	Position offset;
+	PositionVector sources;
+	// Index into sources and the tile replaced at its destination, by index
+	std::vector<std::pair<uint32_t, Tile*>> displaced;
 };
 
 class Change {
@@ -49,6 +87,9 @@ public:
 	Change(Tile* tile);
 	static Change* Create(House* house, const Position& where);
 	static Change* Create(Waypoint* wp, const Position& where);
+	static Change* Create(ItemIdChangeList&& items);
+	static Change* Create(SelectionChangeList&& selection);
+	static Change* Create(TileMoveList&& moves);
 	~Change();
 	void clear();
 
@@ -63,11 +104,16 @@ public:
 	uint32_t memsize() const;
 
 	friend class Action;
+	friend class UndoStore;
 };
 
 typedef std::vector<Change*> ChangeList;
 
-// A dirty list represents a list of all tiles that was changed in an action
+// A dirty list represents a list of all tiles that was changed in an action.
+// Positions are appended as (node key, floor mask) entries and sorted and
+// merged only when the list grows or is read, so adding one is a push_back.
+// The keys are Morton codes of the node coordinates: nodes of an aligned
+// block of 2^level x 2^level nodes are next to each other in the list.
 class DirtyList {
 public:
 	DirtyList();
@@ -76,30 +122,48 @@ public:
 	struct ValueType {
 		uint32_t pos;
 		uint32_t floors;
+
+		// Coordinates of the map node, in nodes of 4x4 tiles
+		int getNodeX() const;
+		int getNodeY() const;
 	};
+	typedef std::vector<ValueType> NodeList;
 
 	uint32_t owner;
 
-protected:
-	struct Comparator {
-		bool operator()(const ValueType& a, const ValueType& b) const {
-			return a.pos < b.pos;
-		}
-	};
-
-public:
-	typedef std::set<ValueType, Comparator> SetType;
+	static uint32_t MakeKey(int ndx, int ndy);
 
 	void AddPosition(int x, int y, int z);
 	void AddChange(Change* c);
 	bool Empty() const {
-		return iset.empty() && ichanges.empty();
+		return entries.empty() && ichanges.empty();
 	}
-	SetType& GetPosList();
+	// Sorted by key, one entry per node
+	const NodeList& GetPosList();
 	ChangeList& GetChanges();
 
+	// Calls visit(block_x, block_y, first, last) for every aligned block of
+	// 2^level x 2^level nodes with changes, block coordinates are in blocks
+	template <typename Visit>
+	void ForEachGroup(int level, Visit visit) {
+		const NodeList& nodes = GetPosList();
+		for (size_t first = 0; first < nodes.size();) {
+			const uint32_t group = nodes[first].pos >> (2 * level);
+			size_t last = first + 1;
+			while (last < nodes.size() && (nodes[last].pos >> (2 * level)) == group) {
+				++last;
+			}
+			visit(nodes[first].getNodeX() >> level, nodes[first].getNodeY() >> level, nodes.data() + first, nodes.data() + last);
+			first = last;
+		}
+	}
+
 protected:
-	SetType iset;
+	void Compact();
+
+	NodeList entries;
+	// Entries before this are sorted and merged
+	size_t compacted;
 	ChangeList ichanges;
 };
 
@@ -152,12 +216,23 @@ public:
 protected:
 	Action(Editor& editor, ActionIdentifier ident);
 
+	void swapItemIds(ItemIdChangeList& items, DirtyList* dirty_list);
+	// Entries are applied last to first when undoing, a tile can appear several times
+	void swapSelection(SelectionChangeList& selection, bool undo);
+	// All tiles are lifted before any is placed, so sources and destinations may overlap
+	void moveTiles(TileMoveList& moves, bool undo, DirtyList* dirty_list);
+	// The tiles held once the action is applied are stored as deltas to the
+	// map, they are rebuilt before the action is applied the other way
+	void packTiles();
+	void unpackTiles();
+
 	bool commited;
 	ChangeList changes;
 	Editor& editor;
 	ActionIdentifier type;
 
 	friend class ActionQueue;
+	friend class UndoStore;
 };
 
 using ActionVector = std::vector<Action*>;
@@ -178,6 +253,10 @@ public:
 	ActionIdentifier getType() const {
 		return type;
 	}
+	// The actions are in the spill file of the undo store
+	bool isSpilled() const {
+		return spilled;
+	}
 
 	virtual void addAction(Action* action);
 	virtual void addAndCommitAction(Action* action);
@@ -196,8 +275,10 @@ protected:
 	uint32_t memory_size;
 	ActionIdentifier type;
 	ActionVector batch;
+	bool spilled;
 
 	friend class ActionQueue;
+	friend class UndoStore;
 };
 
 class ActionQueue {
@@ -227,11 +308,29 @@ public:
 		return current < actions.size();
 	}
 
+	size_t size() const {
+		return actions.size();
+	}
+	// Size of the batches held in memory
+	size_t getMemorySize() const {
+		return memory_size;
+	}
+	const UndoStore& getUndoStore() const;
+
 protected:
+	// Moves the batch farthest from current to the undo store, the batches
+	// right before and after current stay in memory
+	bool spillBatch();
+	// Brings a spilled batch back, on failure the history is cleared
+	bool reloadBatch(BatchAction* batch);
+	void deleteBatch(BatchAction* batch);
+	void deleteOldest();
+
 	size_t current;
 	size_t memory_size;
 	Editor& editor;
 	ActionList actions;
+	std::unique_ptr<UndoStore> store;
 };
 
 #endif
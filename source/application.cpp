@@ -35,6 +35,7 @@
 #include "map.h"
 #include "complexitem.h"
 #include "creature.h"
+#include "trace.h"
 
 // Add exception handling includes
 #include <exception>
@@ -227,6 +228,10 @@ bool Application::OnInit() {
 		sessionLog.close();
 	}
 
+	// Trace messages of the session go next to it, including those traced so far
+	Trace::setCategories(uint32_t(g_settings.getInteger(Config::TRACE_CATEGORIES)));
+	Trace::start((logDir + wxFileName::GetPathSeparator() + "trace.log").ToStdString());
+
 	// Show welcome dialog with color-shifted bitmap
 	if (g_settings.getInteger(Config::WELCOME_DIALOG) == 1 && m_file_to_open == wxEmptyString) {
 		g_gui.ShowWelcomeDialog(iconBitmap);
@@ -356,6 +361,7 @@ int Application::OnExit() {
 	wxDELETE(m_proc_server);
 	wxDELETE(m_single_instance_checker);
 #endif
+	Trace::stop();
 	return 1;
 }
 
@@ -462,6 +468,9 @@ MainFrame::~MainFrame() = default;
 
 void MainFrame::OnIdle(wxIdleEvent& event) {
 	g_gui.CheckAutoSave();
+	if (g_gui.BuildItemIndexes()) {
+		event.RequestMore();
+	}
 	event.Skip();
 }
 
@@ -19,10 +19,14 @@
 
 #include "tile.h"
 #include "basemap.h"
+#include "minimap_store.h"
+#include "item_index.h"
+#include "map_statistics.h"
 
 BaseMap::BaseMap() :
 	allocator(),
 	tilecount(0),
+	revision(0),
 	root(*this) {
 	////
 }
@@ -46,6 +50,80 @@ void BaseMap::clearVisible(uint32_t mask) {
 	root.clearVisible(mask);
 }
 
+void BaseMap::enableMinimapStore() {
+	if (minimap_store) {
+		return;
+	}
+
+	minimap_store = std::make_shared<MinimapStore>();
+	for (MapIterator map_iter = begin(); map_iter != end(); ++map_iter) {
+		const Tile* tile = (*map_iter)->get();
+		const Position& pos = tile->getPosition();
+		minimap_store->setColor(pos.x, pos.y, pos.z, tile->getMiniMapColor());
+	}
+}
+
+void BaseMap::updateMinimapColor(const Position& pos) {
+	if (minimap_store) {
+		const Tile* tile = getTile(pos);
+		minimap_store->setColor(pos.x, pos.y, pos.z, tile ? tile->getMiniMapColor() : 0);
+	}
+}
+
+void BaseMap::enableItemIndex() {
+	if (!item_index) {
+		item_index = std::make_shared<ItemIndex>();
+	}
+}
+
+void BaseMap::enableStatistics() {
+	if (!statistics) {
+		statistics = std::make_shared<MapStatistics>();
+	}
+}
+
+void BaseMap::invalidateIndexes() {
+	++revision;
+	if (item_index) {
+		item_index->invalidate();
+	}
+	if (statistics) {
+		statistics->invalidate();
+	}
+}
+
+void BaseMap::changeItemId(const Position& pos, Item* item, uint16_t id) {
+	const uint16_t old_id = item->getID();
+	item->setID(id);
+	++revision;
+	if (item_index) {
+		item_index->onItemIdChanged(pos, old_id, id);
+	}
+	if (statistics) {
+		statistics->onItemIdChanged(old_id, id);
+	}
+}
+
+void BaseMap::onItemRemoved(const Position& pos, Item* item) {
+	++revision;
+	if (item_index) {
+		item_index->onItemRemoved(pos, item);
+	}
+	if (statistics) {
+		statistics->onItemRemoved(item);
+	}
+}
+
+void BaseMap::onTileChanged(const Position& pos, Tile* oldtile, Tile* newtile) {
+	++revision;
+	if (item_index) {
+		item_index->onTileChanged(pos, oldtile, newtile);
+	}
+	if (statistics) {
+		statistics->onTileChanged(pos, oldtile, newtile);
+	}
+}
+
 Tile* BaseMap::createTile(int x, int y, int z) {
 	ASSERT(z < MAP_LAYERS);
 	QTreeNode* leaf = root.getLeafForce(x, y);
@@ -24,6 +24,8 @@
 #include "map_allocator.h"
 #include "tile.h"
 
+#include <memory>
+
 // Class declarations
 class QTreeNode;
 class BaseMap;
@@ -31,6 +33,9 @@ class MapIterator;
 class Floor;
 class QTreeNode;
 class TileLocation;
+class MinimapStore;
+class ItemIndex;
+class MapStatistics;
 
 class MapIterator {
 public:
@@ -117,6 +122,10 @@ public:
 	QTreeNode* createLeaf(int x, int y) {
 		return root.getLeafForce(x, y);
 	}
+	// Get the node covering the size x size area holding (x, y), see QTreeNode::getNode
+	QTreeNode* getNode(int x, int y, int size) {
+		return root.getNode(x, y, size);
+	}
 
 	// Assigns a tile, it might seem pointless to provide position, but it is not, as the passed tile may be nullptr
 	void setTile(int _x, int _y, int _z, Tile* newtile, bool remove = false);
@@ -139,11 +148,55 @@ public:
 		return tilecount;
 	}
 
+	// Bumped whenever a tile is placed or removed and by changeItemId and
+	// onItemRemoved, views built from the map compare it to tell whether they
+	// are stale
+	uint64_t getRevision() const noexcept {
+		return revision;
+	}
+
+	// Minimap colours mirrored for readers on other threads, null for maps
+	// that are never shown on the minimap
+	std::shared_ptr<MinimapStore> getMinimapStore() const {
+		return minimap_store;
+	}
+	void enableMinimapStore();
+	// Writes the current colour of the tile at pos, for tiles that were changed in place
+	void updateMinimapColor(const Position& pos);
+
+	// Index of the items on the map, null until enabled. It is filled from the
+	// idle handler, see ItemIndex.
+	std::shared_ptr<ItemIndex> getItemIndex() const {
+		return item_index;
+	}
+	void enableItemIndex();
+	// Counts of the whole map, null until enabled. They are built the first
+	// time they are needed, see MapStatistics.
+	std::shared_ptr<MapStatistics> getStatistics() const {
+		return statistics;
+	}
+	void enableStatistics();
+	// Builds the item index and the statistics again, for edits that changed
+	// the items of many tiles in place
+	void invalidateIndexes();
+	// Gives an item of the tile at pos another id in place, the item has to
+	// stay the same class (see Item::Create)
+	void changeItemId(const Position& pos, Item* item, uint16_t id);
+	// Has to be called before an item (and its contents) is taken off the tile at pos in place
+	void onItemRemoved(const Position& pos, Item* item);
+
 public:
 	MapAllocator allocator;
 
 protected:
 	uint64_t tilecount;
+	uint64_t revision;
+	std::shared_ptr<MinimapStore> minimap_store;
+	std::shared_ptr<ItemIndex> item_index;
+	std::shared_ptr<MapStatistics> statistics;
+
+	// Called by QTreeNode for every tile swapped in or out, either tile may be null
+	void onTileChanged(const Position& pos, Tile* oldtile, Tile* newtile);
 
 	QTreeNode root; // The Quad Tree root
 
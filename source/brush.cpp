@@ -53,6 +53,8 @@ Brushes::~Brushes() {
 }
 
 void Brushes::clear() {
+	GroundBrush::clearBorderTable();
+
 	for (auto brushEntry : brushes) {
 		delete brushEntry.second;
 	}
@@ -90,6 +92,8 @@ void Brushes::init() {
 	WallBrush::init();
 	TableBrush::init();
 	CarpetBrush::init();
+
+	GroundBrush::compileBorderTable();
 }
 
 bool Brushes::unserializeBrush(pugi::xml_node node, wxArrayString& warnings) {
@@ -33,6 +33,8 @@
 #include "common_windows.h"
 #include "positionctrl.h"
 #include "string_utils.h"
+#include "map_display.h"
+#include "map_render_exporter.h"
 
 
 #ifdef _MSC_VER
@@ -573,33 +575,36 @@ void ExportMiniMapWindow::OnFileNameChanged(wxKeyEvent& event) {
 void ExportMiniMapWindow::OnClickOK(wxCommandEvent& WXUNUSED(event)) {
 	g_gui.CreateLoadBar("Exporting minimap");
 
+	bool exported = true;
 	try {
 		FileName directory(directory_text_field->GetValue());
 		g_settings.setString(Config::MINIMAP_EXPORT_DIR, directory_text_field->GetValue().ToStdString());
 
 		switch (floor_options->GetSelection()) {
 			case 0: { // All floors
+				// Every floor goes in one call so they are exported concurrently
+				std::vector<MinimapExporter::Job> jobs;
 				for (int floor = 0; floor < MAP_LAYERS; ++floor) {
-					g_gui.SetLoadScale(int(floor * (100.f / 16.f)), int((floor + 1) * (100.f / 16.f)));
-					FileName file(file_name_text_field->GetValue() + "_" + i2ws(floor) + ".bmp");
+					FileName file(file_name_text_field->GetValue() + "_" + i2ws(floor) + ".png");
 					file.Normalize(wxPATH_NORM_ALL, directory.GetFullPath());
-					editor.exportMiniMap(file, floor, true);
+					jobs.push_back({ floor, nstr(file.GetFullPath()) });
 				}
+				exported = editor.map.exportMinimap(jobs, true);
 				break;
 			}
 
 			case 1: { // Ground floor
-				FileName file(file_name_text_field->GetValue() + "_" + i2ws(GROUND_LAYER) + ".bmp");
+				FileName file(file_name_text_field->GetValue() + "_" + i2ws(GROUND_LAYER) + ".png");
 				file.Normalize(wxPATH_NORM_ALL, directory.GetFullPath());
-				editor.exportMiniMap(file, GROUND_LAYER, true);
+				exported = editor.exportMiniMap(file, GROUND_LAYER, true);
 				break;
 			}
 
 			case 2: { // Specific floors
 				int floor = floor_number->GetValue();
-				FileName file(file_name_text_field->GetValue() + "_" + i2ws(floor) + ".bmp");
+				FileName file(file_name_text_field->GetValue() + "_" + i2ws(floor) + ".png");
 				file.Normalize(wxPATH_NORM_ALL, directory.GetFullPath());
-				editor.exportMiniMap(file, floor, true);
+				exported = editor.exportMiniMap(file, floor, true);
 				break;
 			}
 
@@ -613,6 +618,9 @@ void ExportMiniMapWindow::OnClickOK(wxCommandEvent& WXUNUSED(event)) {
 	}
 
 	g_gui.DestroyLoadBar();
+	if (!exported) {
+		g_gui.PopupDialog("Error", editor.map.getError(), wxOK);
+	}
 	EndModal(1);
 }
 
@@ -841,6 +849,207 @@ void ExportTilesetsWindow::CheckValues() {
 	ok_button->Enable(true);
 }
 
+// ============================================================================
+// Export Map Render window
+
+BEGIN_EVENT_TABLE(ExportMapRenderWindow, wxDialog)
+EVT_BUTTON(MAP_RENDER_FILE_BUTTON, ExportMapRenderWindow::OnClickBrowse)
+EVT_BUTTON(wxID_OK, ExportMapRenderWindow::OnClickOK)
+EVT_BUTTON(wxID_CANCEL, ExportMapRenderWindow::OnClickCancel)
+END_EVENT_TABLE()
+
+ExportMapRenderWindow::ExportMapRenderWindow(wxWindow* parent, Editor& editor, MapCanvas& canvas) :
+	wxDialog(parent, wxID_ANY, "Export Map Render", wxDefaultPosition, wxSize(400, 360)),
+	editor(editor),
+	canvas(canvas) {
+	wxSizer* sizer = newd wxBoxSizer(wxVERTICAL);
+	wxSizer* tmpsizer;
+
+	// Error field
+	error_field = newd wxStaticText(this, wxID_VIEW_DETAILS, "", wxDefaultPosition, wxDefaultSize);
+	error_field->SetForegroundColour(*wxRED);
+	tmpsizer = newd wxBoxSizer(wxHORIZONTAL);
+	tmpsizer->Add(error_field, 0, wxALL, 5);
+	sizer->Add(tmpsizer, 0, wxLEFT | wxRIGHT | wxBOTTOM | wxEXPAND, 5);
+
+	// Output
+	wxArrayString formats;
+	formats.Add("PNG Image");
+	formats.Add("Tile Pyramid (Folder)");
+	format_options = newd wxChoice(this, wxID_ANY, wxDefaultPosition, wxDefaultSize, formats);
+	format_options->SetSelection(0);
+	format_options->Bind(wxEVT_CHOICE, [this](wxCommandEvent&) { CheckValues(); });
+
+	wxString mapName(editor.map.getName().c_str(), wxConvUTF8);
+	FileName file(mapName.BeforeLast('.') + ".png");
+	file.Normalize(wxPATH_NORM_ALL, wxstr(g_settings.getString(Config::SCREENSHOT_DIRECTORY)));
+	path_text_field = newd wxTextCtrl(this, wxID_ANY, file.GetFullPath(), wxDefaultPosition, wxDefaultSize);
+	path_text_field->Bind(wxEVT_KEY_UP, &ExportMapRenderWindow::OnPathChanged, this);
+
+	wxSizer* outputsizer = newd wxStaticBoxSizer(wxVERTICAL, this, "Output");
+	outputsizer->Add(format_options, 0, wxALL | wxEXPAND, 5);
+	tmpsizer = newd wxBoxSizer(wxHORIZONTAL);
+	tmpsizer->Add(path_text_field, 1, wxALL, 5);
+	tmpsizer->Add(newd wxButton(this, MAP_RENDER_FILE_BUTTON, "Browse"), 0, wxALL, 5);
+	outputsizer->Add(tmpsizer, 0, wxEXPAND);
+	sizer->Add(outputsizer, 0, wxALL | wxEXPAND, 5);
+
+	// Area options
+	wxArrayString areas;
+	areas.Add("Visible Area");
+	areas.Add("Custom Area");
+	if (editor.hasSelection()) {
+		areas.Add("Selected Area");
+	}
+	area_options = newd wxChoice(this, wxID_ANY, wxDefaultPosition, wxDefaultSize, areas);
+	area_options->SetSelection(0);
+	area_options->Bind(wxEVT_CHOICE, &ExportMapRenderWindow::OnAreaChange, this);
+
+	x_spin = newd wxSpinCtrl(this, wxID_ANY, "0", wxDefaultPosition, wxSize(80, -1), wxSP_ARROW_KEYS, 0, MAP_MAX_WIDTH);
+	y_spin = newd wxSpinCtrl(this, wxID_ANY, "0", wxDefaultPosition, wxSize(80, -1), wxSP_ARROW_KEYS, 0, MAP_MAX_HEIGHT);
+	width_spin = newd wxSpinCtrl(this, wxID_ANY, "1", wxDefaultPosition, wxSize(80, -1), wxSP_ARROW_KEYS, 1, MAP_MAX_WIDTH + 1);
+	height_spin = newd wxSpinCtrl(this, wxID_ANY, "1", wxDefaultPosition, wxSize(80, -1), wxSP_ARROW_KEYS, 1, MAP_MAX_HEIGHT + 1);
+	floor_spin = newd wxSpinCtrl(this, wxID_ANY, i2ws(GROUND_LAYER), wxDefaultPosition, wxSize(80, -1), wxSP_ARROW_KEYS, 0, MAP_MAX_LAYER, GROUND_LAYER);
+
+	wxFlexGridSizer* gridsizer = newd wxFlexGridSizer(4, 5, 5);
+	gridsizer->Add(newd wxStaticText(this, wxID_ANY, "X"), 0, wxALIGN_CENTER_VERTICAL);
+	gridsizer->Add(x_spin);
+	gridsizer->Add(newd wxStaticText(this, wxID_ANY, "Width"), 0, wxALIGN_CENTER_VERTICAL);
+	gridsizer->Add(width_spin);
+	gridsizer->Add(newd wxStaticText(this, wxID_ANY, "Y"), 0, wxALIGN_CENTER_VERTICAL);
+	gridsizer->Add(y_spin);
+	gridsizer->Add(newd wxStaticText(this, wxID_ANY, "Height"), 0, wxALIGN_CENTER_VERTICAL);
+	gridsizer->Add(height_spin);
+	gridsizer->Add(newd wxStaticText(this, wxID_ANY, "Floor"), 0, wxALIGN_CENTER_VERTICAL);
+	gridsizer->Add(floor_spin);
+
+	wxSizer* areasizer = newd wxStaticBoxSizer(wxVERTICAL, this, "Area Options");
+	areasizer->Add(area_options, 0, wxALL | wxEXPAND, 5);
+	areasizer->Add(gridsizer, 0, wxALL, 5);
+	sizer->Add(areasizer, 0, wxLEFT | wxRIGHT | wxBOTTOM | wxEXPAND, 5);
+
+	// OK/Cancel buttons
+	tmpsizer = newd wxBoxSizer(wxHORIZONTAL);
+	tmpsizer->Add(ok_button = newd wxButton(this, wxID_OK, "OK"), wxSizerFlags(1).Center());
+	tmpsizer->Add(newd wxButton(this, wxID_CANCEL, "Cancel"), wxSizerFlags(1).Center());
+	sizer->Add(tmpsizer, 0, wxCENTER, 10);
+
+	SetSizerAndFit(sizer);
+	Centre(wxBOTH);
+
+	wxCommandEvent event;
+	OnAreaChange(event);
+	CheckValues();
+}
+
+ExportMapRenderWindow::~ExportMapRenderWindow() = default;
+
+void ExportMapRenderWindow::SetArea(int x, int y, int width, int height, int floor) {
+	x_spin->SetValue(x);
+	y_spin->SetValue(y);
+	width_spin->SetValue(width);
+	height_spin->SetValue(height);
+	floor_spin->SetValue(floor);
+}
+
+void ExportMapRenderWindow::OnAreaChange(wxCommandEvent& WXUNUSED(event)) {
+	const wxString area = area_options->GetStringSelection();
+	if (area == "Visible Area") {
+		int start_x, start_y, end_x, end_y;
+		const wxSize size = canvas.GetClientSize();
+		canvas.ScreenToMap(0, 0, &start_x, &start_y);
+		canvas.ScreenToMap(size.GetWidth(), size.GetHeight(), &end_x, &end_y);
+		SetArea(start_x, start_y, std::max(1, end_x - start_x), std::max(1, end_y - start_y), canvas.GetFloor());
+	} else if (area == "Selected Area") {
+		const Position start = editor.selection.minPosition();
+		const Position end = editor.selection.maxPosition();
+		SetArea(start.x, start.y, end.x - start.x + 1, end.y - start.y + 1, canvas.GetFloor());
+	}
+
+	const bool custom = area == "Custom Area";
+	x_spin->Enable(custom);
+	y_spin->Enable(custom);
+	width_spin->Enable(custom);
+	height_spin->Enable(custom);
+	floor_spin->Enable(custom);
+}
+
+void ExportMapRenderWindow::OnClickBrowse(wxCommandEvent& WXUNUSED(event)) {
+	if (format_options->GetSelection() == MapRenderExporter::FORMAT_PYRAMID) {
+		wxDirDialog dialog(this, "Select the output folder", path_text_field->GetValue(), wxDD_DEFAULT_STYLE);
+		if (dialog.ShowModal() == wxID_OK) {
+			path_text_field->ChangeValue(dialog.GetPath());
+		}
+	} else {
+		wxFileDialog dialog(this, "Save the render as", "", path_text_field->GetValue(), "PNG files (*.png)|*.png", wxFD_SAVE | wxFD_OVERWRITE_PROMPT);
+		if (dialog.ShowModal() == wxID_OK) {
+			path_text_field->ChangeValue(dialog.GetPath());
+		}
+	}
+	CheckValues();
+}
+
+void ExportMapRenderWindow::OnPathChanged(wxKeyEvent& event) {
+	CheckValues();
+	event.Skip();
+}
+
+void ExportMapRenderWindow::OnClickOK(wxCommandEvent& WXUNUSED(event)) {
+	MapRenderExporter::Region region;
+	region.x = x_spin->GetValue();
+	region.y = y_spin->GetValue();
+	region.width = width_spin->GetValue();
+	region.height = height_spin->GetValue();
+	region.floor = floor_spin->GetValue();
+
+	const MapRenderExporter::Format format = static_cast<MapRenderExporter::Format>(format_options->GetSelection());
+	const wxString path = path_text_field->GetValue();
+
+	g_gui.CreateLoadBar("Rendering map...", true);
+
+	std::string error;
+	bool exported = false;
+	try {
+		MapRenderExporter exporter(canvas);
+		exported = exporter.exportRegion(region, format, nstr(path), error, [](int done) {
+			return g_gui.SetLoadDone(done);
+		});
+	} catch (std::bad_alloc&) {
+		error = "There is not enough memory available to complete the operation.";
+	}
+
+	g_gui.DestroyLoadBar();
+	if (exported) {
+		g_gui.SetStatusText("Exported map render to " + path);
+	} else {
+		g_gui.PopupDialog("Error", wxstr(error), wxOK);
+	}
+	EndModal(1);
+}
+
+void ExportMapRenderWindow::OnClickCancel(wxCommandEvent& WXUNUSED(event)) {
+	// Just close this window
+	EndModal(0);
+}
+
+void ExportMapRenderWindow::CheckValues() {
+	if (path_text_field->IsEmpty()) {
+		error_field->SetLabel(format_options->GetSelection() == MapRenderExporter::FORMAT_PYRAMID ? "Type or select an output folder." : "Type or select an output file.");
+		ok_button->Enable(false);
+		return;
+	}
+
+	FileName file(path_text_field->GetValue());
+	if (format_options->GetSelection() == MapRenderExporter::FORMAT_PNG && !FileName::DirExists(file.GetPath())) {
+		error_field->SetLabel("Output folder not found.");
+		ok_button->Enable(false);
+		return;
+	}
+
+	error_field->SetLabel(wxEmptyString);
+	ok_button->Enable(true);
+}
+
 // ============================================================================
 // Numkey forwarding text control
 
@@ -25,6 +25,7 @@
 
 class GameSprite;
 class MapTab;
+class MapCanvas;
 
 /**
  * A toggle button with an item on it.
@@ -160,6 +161,41 @@ protected:
 	DECLARE_EVENT_TABLE();
 };
 
+/**
+ * The export map render dialog, select the area and output path.
+ */
+class ExportMapRenderWindow : public wxDialog {
+public:
+	ExportMapRenderWindow(wxWindow* parent, Editor& editor, MapCanvas& canvas);
+	virtual ~ExportMapRenderWindow();
+
+	void OnClickBrowse(wxCommandEvent&);
+	void OnPathChanged(wxKeyEvent&);
+	void OnAreaChange(wxCommandEvent&);
+	void OnClickOK(wxCommandEvent&);
+	void OnClickCancel(wxCommandEvent&);
+
+protected:
+	void CheckValues();
+	void SetArea(int x, int y, int width, int height, int floor);
+
+	Editor& editor;
+	MapCanvas& canvas;
+
+	wxStaticText* error_field;
+	wxTextCtrl* path_text_field;
+	wxChoice* format_options;
+	wxChoice* area_options;
+	wxSpinCtrl* x_spin;
+	wxSpinCtrl* y_spin;
+	wxSpinCtrl* width_spin;
+	wxSpinCtrl* height_spin;
+	wxSpinCtrl* floor_spin;
+	wxButton* ok_button;
+
+	DECLARE_EVENT_TABLE();
+};
+
 /**
  * Text control that will forward up/down pgup / pgdown keys to parent window
  */
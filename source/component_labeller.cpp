@@ -0,0 +1,229 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+
+#include "main.h"
+
+#include "component_labeller.h"
+
+void ComponentLabeller::clear() {
+	chunks.clear();
+	parents.clear();
+	components.clear();
+}
+
+void ComponentLabeller::add(int x, int y) {
+	ASSERT(x >= 0 && y >= 0);
+	Chunk& chunk = chunks[makeKey(x >> ChunkShift, y >> ChunkShift)];
+	chunk.rows[y & (ChunkSize - 1)] |= uint64_t(1) << (x & (ChunkSize - 1));
+}
+
+bool ComponentLabeller::contains(int x, int y) const {
+	if (x < 0 || y < 0) {
+		return false;
+	}
+	auto it = chunks.find(makeKey(x >> ChunkShift, y >> ChunkShift));
+	return it != chunks.end() && it->second.test(x & (ChunkSize - 1), y & (ChunkSize - 1));
+}
+
+int ComponentLabeller::getComponent(int x, int y) const {
+	if (x < 0 || y < 0) {
+		return -1;
+	}
+	auto it = chunks.find(makeKey(x >> ChunkShift, y >> ChunkShift));
+	if (it == chunks.end() || it->second.labels.empty()) {
+		return -1;
+	}
+	const uint32_t label = it->second.labels[(y & (ChunkSize - 1)) * ChunkSize + (x & (ChunkSize - 1))];
+	return label == NoLabel ? -1 : int(label);
+}
+
+uint32_t ComponentLabeller::find(uint32_t label) {
+	while (parents[label] != label) {
+		// Path halving
+		parents[label] = parents[parents[label]];
+		label = parents[label];
+	}
+	return label;
+}
+
+void ComponentLabeller::unite(uint32_t a, uint32_t b) {
+	a = find(a);
+	b = find(b);
+	if (a != b) {
+		// The older label wins so roots stay stable while scanning
+		if (a < b) {
+			parents[b] = a;
+		} else {
+			parents[a] = b;
+		}
+	}
+}
+
+void ComponentLabeller::labelChunk(Chunk& chunk) {
+	chunk.labels.assign(ChunkSize * ChunkSize, NoLabel);
+	for (int y = 0; y < ChunkSize; ++y) {
+		const uint64_t row = chunk.rows[y];
+		if (row == 0) {
+			continue;
+		}
+
+		uint32_t* labels = &chunk.labels[y * ChunkSize];
+		const uint32_t* above = y > 0 ? labels - ChunkSize : nullptr;
+		for (int x = 0; x < ChunkSize; ++x) {
+			if (!((row >> x) & 1)) {
+				continue;
+			}
+
+			const uint32_t left = x > 0 ? labels[x - 1] : NoLabel;
+			const uint32_t up = above ? above[x] : NoLabel;
+			if (left != NoLabel) {
+				labels[x] = left;
+				if (up != NoLabel && up != left) {
+					unite(left, up);
+				}
+			} else if (up != NoLabel) {
+				labels[x] = up;
+			} else {
+				labels[x] = uint32_t(parents.size());
+				parents.push_back(labels[x]);
+			}
+		}
+	}
+}
+
+const std::vector<ComponentLabeller::Component>& ComponentLabeller::label() {
+	parents.clear();
+	components.clear();
+
+	for (auto& entry : chunks) {
+		labelChunk(entry.second);
+	}
+
+	// Joins the cells on the right and bottom edge of every chunk with the
+	// neighbouring chunks
+	for (auto& entry : chunks) {
+		const int chunk_x = int(entry.first >> 32);
+		const int chunk_y = int(entry.first & 0xFFFFFFFF);
+		const Chunk& chunk = entry.second;
+
+		auto right = chunks.find(makeKey(chunk_x + 1, chunk_y));
+		if (right != chunks.end()) {
+			for (int y = 0; y < ChunkSize; ++y) {
+				if (chunk.test(ChunkSize - 1, y) && right->second.test(0, y)) {
+					unite(chunk.labels[y * ChunkSize + ChunkSize - 1], right->second.labels[y * ChunkSize]);
+				}
+			}
+		}
+
+		auto below = chunks.find(makeKey(chunk_x, chunk_y + 1));
+		if (below != chunks.end()) {
+			const uint64_t shared = chunk.rows[ChunkSize - 1] & below->second.rows[0];
+			for (int x = 0; x < ChunkSize && shared != 0; ++x) {
+				if ((shared >> x) & 1) {
+					unite(chunk.labels[(ChunkSize - 1) * ChunkSize + x], below->second.labels[x]);
+				}
+			}
+		}
+	}
+
+	// Turns the roots into component indices and gathers the size, bounds and
+	// mean of every component
+	std::vector<uint32_t> indices(parents.size(), NoLabel);
+	std::vector<int64_t> sums;
+	for (auto& entry : chunks) {
+		const int base_x = int(entry.first >> 32) << ChunkShift;
+		const int base_y = int(entry.first & 0xFFFFFFFF) << ChunkShift;
+		Chunk& chunk = entry.second;
+		for (int y = 0; y < ChunkSize; ++y) {
+			if (chunk.rows[y] == 0) {
+				continue;
+			}
+			for (int x = 0; x < ChunkSize; ++x) {
+				uint32_t& label = chunk.labels[y * ChunkSize + x];
+				if (label == NoLabel) {
+					continue;
+				}
+
+				const uint32_t root = find(label);
+				if (indices[root] == NoLabel) {
+					indices[root] = uint32_t(components.size());
+					Component component;
+					component.size = 0;
+					component.min_x = component.max_x = base_x + x;
+					component.min_y = component.max_y = base_y + y;
+					component.center_x = component.center_y = 0.0;
+					component.anchor_x = component.anchor_y = 0;
+					components.push_back(component);
+					sums.push_back(0);
+					sums.push_back(0);
+				}
+				label = indices[root];
+
+				Component& component = components[label];
+				const int cell_x = base_x + x;
+				const int cell_y = base_y + y;
+				++component.size;
+				component.min_x = std::min(component.min_x, cell_x);
+				component.min_y = std::min(component.min_y, cell_y);
+				component.max_x = std::max(component.max_x, cell_x);
+				component.max_y = std::max(component.max_y, cell_y);
+				sums[label * 2] += cell_x;
+				sums[label * 2 + 1] += cell_y;
+			}
+		}
+	}
+
+	for (size_t i = 0; i < components.size(); ++i) {
+		components[i].center_x = double(sums[i * 2]) / components[i].size;
+		components[i].center_y = double(sums[i * 2 + 1]) / components[i].size;
+	}
+
+	// Picks the anchor cells, ties go to the topmost then leftmost cell so the
+	// result does not depend on the chunk order
+	std::vector<double> best(components.size(), std::numeric_limits<double>::max());
+	for (const auto& entry : chunks) {
+		const int base_x = int(entry.first >> 32) << ChunkShift;
+		const int base_y = int(entry.first & 0xFFFFFFFF) << ChunkShift;
+		const Chunk& chunk = entry.second;
+		for (int y = 0; y < ChunkSize; ++y) {
+			if (chunk.rows[y] == 0) {
+				continue;
+			}
+			for (int x = 0; x < ChunkSize; ++x) {
+				const uint32_t label = chunk.labels[y * ChunkSize + x];
+				if (label == NoLabel) {
+					continue;
+				}
+
+				Component& component = components[label];
+				const int cell_x = base_x + x;
+				const int cell_y = base_y + y;
+				const double dx = cell_x - component.center_x;
+				const double dy = cell_y - component.center_y;
+				const double distance = dx * dx + dy * dy;
+				if (distance < best[label] || (distance == best[label] && (cell_y < component.anchor_y || (cell_y == component.anchor_y && cell_x < component.anchor_x)))) {
+					best[label] = distance;
+					component.anchor_x = cell_x;
+					component.anchor_y = cell_y;
+				}
+			}
+		}
+	}
+
+	return components;
+}
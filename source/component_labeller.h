@@ -0,0 +1,94 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+
+#ifndef RME_COMPONENT_LABELLER_H_
+#define RME_COMPONENT_LABELLER_H_
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Finds the 4-connected components of a set of cells, such as the tiles of a
+// zone or the patches of a generated terrain layer. The cells are kept in
+// ChunkSize x ChunkSize bitmaps, every chunk is labelled with a scanline pass
+// and a union-find joins the labels across rows and chunk edges. Memory
+// follows the number of occupied chunks rather than the bounding box and
+// nothing recurses, so components of any size are fine.
+class ComponentLabeller {
+public:
+	static constexpr int ChunkShift = 6;
+	static constexpr int ChunkSize = 1 << ChunkShift;
+
+	struct Component {
+		int size;
+		int min_x, min_y;
+		int max_x, max_y;
+		// Mean position of the cells
+		double center_x, center_y;
+		// The cell closest to the mean, it is always part of the component
+		int anchor_x, anchor_y;
+	};
+
+	void clear();
+	// Coordinates must not be negative, adding a cell twice is harmless
+	void add(int x, int y);
+	bool contains(int x, int y) const;
+	bool empty() const noexcept {
+		return chunks.empty();
+	}
+
+	// Labels the cells added so far, the components are in no particular order
+	const std::vector<Component>& label();
+	const std::vector<Component>& getComponents() const noexcept {
+		return components;
+	}
+	// Index of the component holding the cell as of the last label(), -1 if
+	// the cell is not part of the set
+	int getComponent(int x, int y) const;
+
+private:
+	static constexpr uint32_t NoLabel = 0xFFFFFFFF;
+
+	struct Chunk {
+		Chunk() :
+			rows {} { }
+
+		// Bit x of rows[y] is set for every cell
+		uint64_t rows[ChunkSize];
+		// Per cell, union-find labels while labelling and component indices after
+		std::vector<uint32_t> labels;
+
+		bool test(int x, int y) const noexcept {
+			return (rows[y] >> x) & 1;
+		}
+	};
+
+	static uint64_t makeKey(int chunk_x, int chunk_y) noexcept {
+		return (uint64_t(uint32_t(chunk_x)) << 32) | uint32_t(chunk_y);
+	}
+
+	uint32_t find(uint32_t label);
+	void unite(uint32_t a, uint32_t b);
+	void labelChunk(Chunk& chunk);
+
+	std::unordered_map<uint64_t, Chunk> chunks;
+	std::vector<uint32_t> parents;
+	std::vector<Component> components;
+};
+
+#endif
@@ -21,20 +21,230 @@
 #include "editor.h"
 #include "gui.h"
 #include "creature.h"
+#include "spawn.h"
+#include "iomap_otbm.h"
+#include "filehandle.h"
 #include "minimap_window.h"
+#include "trace.h"
+
+#include <cstring>
+
+namespace {
+	// Header of the blob, followed by a root node with a tile node (OTBM_TILE)
+	// for every copied tile and item nodes (OTBM_ITEM) as its children
+	constexpr uint32_t BufferMagic = 0x434D4552; // "RMEC"
+	constexpr uint16_t BufferVersion = 1;
+	constexpr size_t HeaderSize = 4 + 2 + 4 + 2 + 2 + 1 + 4 + 4;
+
+	// Pastes of more tiles show a progress bar
+	constexpr size_t ProgressTileCount = 20000;
+	constexpr size_t ProgressStep = 4096;
+
+	enum : uint8_t {
+		HAS_SPAWN = 1 << 0,
+		HAS_CREATURE = 1 << 1,
+	};
+
+	const IOMap& getBufferIOMap() {
+		static VirtualIOMap iomap(MapVersion(MAP_OTBM_4, CLIENT_VERSION_NONE));
+		return iomap;
+	}
+
+	const wxDataFormat& getClipboardFormat() {
+		static const wxDataFormat format("application/x-rme-copybuffer");
+		return format;
+	}
+
+	template <typename T>
+	void putValue(std::vector<uint8_t>& out, T value) {
+		const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+		out.insert(out.end(), bytes, bytes + sizeof(T));
+	}
+
+	template <typename T>
+	T getValue(const uint8_t*& in) {
+		T value;
+		std::memcpy(&value, in, sizeof(T));
+		in += sizeof(T);
+		return value;
+	}
+
+	std::vector<uint8_t> makeBlob(MemoryNodeFileWriteHandle& writer, const Position& position, size_t tile_count, size_t item_count) {
+		std::vector<uint8_t> blob;
+		blob.reserve(HeaderSize + writer.getSize());
+		putValue(blob, BufferMagic);
+		putValue(blob, BufferVersion);
+		putValue(blob, uint32_t(g_gui.GetCurrentVersionID()));
+		putValue(blob, uint16_t(position.x));
+		putValue(blob, uint16_t(position.y));
+		putValue(blob, uint8_t(position.z));
+		putValue(blob, uint32_t(tile_count));
+		putValue(blob, uint32_t(item_count));
+		blob.insert(blob.end(), writer.getMemory(), writer.getMemory() + writer.getSize());
+		return blob;
+	}
+
+	// The copied parts of a tile, its properties only come along with a selected ground
+	void writeTile(NodeFileWriteHandle& writer, const Tile* tile, bool with_ground, const ItemVector& items, const Creature* creature, const Spawn* spawn) {
+		writer.addNode(OTBM_TILE);
+		const Position position = tile->getPosition();
+		writer.addU16(position.x);
+		writer.addU16(position.y);
+		writer.addU8(position.z);
+		writer.addU32(with_ground ? tile->house_id : 0);
+		writer.addU16(with_ground ? tile->getMapFlags() : 0);
+
+		const std::vector<uint16_t>& zones = tile->getZoneIds();
+		writer.addU16(with_ground ? uint16_t(zones.size()) : 0);
+		if (with_ground) {
+			for (uint16_t zone : zones) {
+				writer.addU16(zone);
+			}
+		}
+
+		writer.addU8((spawn ? HAS_SPAWN : 0) | (creature ? HAS_CREATURE : 0));
+		if (spawn) {
+			writer.addU32(uint32_t(spawn->getSize()));
+		}
+		if (creature) {
+			writer.addString(creature->getName());
+			writer.addU32(uint32_t(creature->getSpawnTime()));
+			writer.addU8(uint8_t(creature->getDirection()));
+		}
+
+		for (const Item* item : items) {
+			item->serializeItemNode_OTBM(getBufferIOMap(), writer);
+		}
+		writer.endNode();
+	}
+
+	// Reads the rest of a tile record, everything ends up selected like it
+	// was when copied
+	bool readTile(BinaryNode* node, Tile* tile) {
+		uint32_t house_id;
+		uint16_t mapflags, zones;
+		uint8_t contents;
+		if (!node->getU32(house_id) || !node->getU16(mapflags) || !node->getU16(zones)) {
+			return false;
+		}
+		tile->house_id = house_id;
+		tile->setMapFlags(mapflags);
+		for (uint16_t i = 0; i < zones; ++i) {
+			uint16_t zone;
+			if (!node->getU16(zone)) {
+				return false;
+			}
+			tile->addZoneId(zone);
+		}
+		if (mapflags != 0) {
+			tile->validateZoneConsistency();
+		}
+
+		if (!node->getU8(contents)) {
+			return false;
+		}
+		if (contents & HAS_SPAWN) {
+			uint32_t size;
+			if (!node->getU32(size)) {
+				return false;
+			}
+			tile->spawn = newd Spawn(int(size));
+		}
+		if (contents & HAS_CREATURE) {
+			std::string name;
+			uint32_t spawn_time;
+			uint8_t direction;
+			if (!node->getString(name) || !node->getU32(spawn_time) || !node->getU8(direction)) {
+				return false;
+			}
+			tile->creature = newd Creature(name);
+			tile->creature->setSpawnTime(int(spawn_time));
+			tile->creature->setDirection(Direction(direction));
+		}
+
+		BinaryNode* child = node->getChild();
+		while (child) {
+			uint8_t type;
+			if (!child->getByte(type) || type != OTBM_ITEM) {
+				return false;
+			}
+			Item* item = Item::Create_OTBM(getBufferIOMap(), child);
+			if (!item) {
+				return false;
+			}
+			if (!item->unserializeItemNode_OTBM(getBufferIOMap(), child)) {
+				delete item;
+				return false;
+			}
+			tile->addItem(item);
+			child = child->advance();
+		}
+
+		tile->select();
+		return true;
+	}
+
+	// Calls visit(position, node) for every tile record until it returns false
+	template <typename Visit>
+	bool forEachRecord(const std::vector<uint8_t>& data, Visit visit) {
+		if (data.size() <= HeaderSize) {
+			return false;
+		}
+
+		MemoryNodeFileReadHandle reader(data.data() + HeaderSize, data.size() - HeaderSize);
+		BinaryNode* root = reader.getRootNode();
+		uint8_t type;
+		if (!root || !root->getByte(type)) {
+			return false;
+		}
+
+		BinaryNode* node = root->getChild();
+		while (node) {
+			uint16_t x, y;
+			uint8_t z;
+			if (!node->getByte(type) || type != OTBM_TILE || !node->getU16(x) || !node->getU16(y) || !node->getU8(z)) {
+				return false;
+			}
+			if (!visit(Position(x, y, z), node)) {
+				return false;
+			}
+			node = node->advance();
+		}
+		return true;
+	}
+}
 
 CopyBuffer::CopyBuffer() :
-	tiles(newd BaseMap()) {
-	;
+	tile_count(0),
+	item_count(0) {
+	////
 }
 
 size_t CopyBuffer::GetTileCount() {
-	return tiles ? (size_t)tiles->size() : 0;
+	return tile_count;
 }
 
 BaseMap& CopyBuffer::getBufferMap() {
-	ASSERT(tiles);
-	return *tiles;
+	if (!preview) {
+		loadFromClipboard();
+	}
+	if (!preview) {
+		preview.reset(newd BaseMap());
+		forEachRecord(data, [this](const Position& position, BinaryNode* node) {
+			Tile* tile = preview->allocator(preview->createTileL(position));
+			if (!readTile(node, tile)) {
+				delete tile;
+				return false;
+			}
+			preview->setTile(tile);
+			return true;
+		});
+	}
+	return *preview;
+}
+
+void CopyBuffer::releaseBufferMap() {
+	preview.reset();
 }
 
 CopyBuffer::~CopyBuffer() {
@@ -42,13 +252,69 @@ CopyBuffer::~CopyBuffer() {
 }
 
 Position CopyBuffer::getPosition() const {
-	ASSERT(tiles);
 	return copyPos;
 }
 
 void CopyBuffer::clear() {
-	delete tiles;
-	tiles = nullptr;
+	data.clear();
+	data.shrink_to_fit();
+	preview.reset();
+	tile_count = 0;
+	item_count = 0;
+}
+
+bool CopyBuffer::setData(std::vector<uint8_t>&& blob) {
+	if (blob.size() <= HeaderSize) {
+		return false;
+	}
+
+	const uint8_t* header = blob.data();
+	const uint32_t magic = getValue<uint32_t>(header);
+	const uint16_t version = getValue<uint16_t>(header);
+	const uint32_t client = getValue<uint32_t>(header);
+	if (magic != BufferMagic || version != BufferVersion) {
+		return false;
+	}
+	if (client != uint32_t(g_gui.GetCurrentVersionID())) {
+		g_gui.SetStatusText("The copied tiles are from another client version.");
+		return false;
+	}
+
+	const uint16_t x = getValue<uint16_t>(header);
+	const uint16_t y = getValue<uint16_t>(header);
+	const uint8_t z = getValue<uint8_t>(header);
+	copyPos = Position(x, y, z);
+	tile_count = getValue<uint32_t>(header);
+	item_count = getValue<uint32_t>(header);
+	data = std::move(blob);
+	preview.reset();
+	return true;
+}
+
+void CopyBuffer::storeInClipboard() const {
+	if (data.empty() || !wxTheClipboard->Open()) {
+		return;
+	}
+	wxCustomDataObject* object = newd wxCustomDataObject(getClipboardFormat());
+	object->SetData(data.size(), data.data());
+	wxTheClipboard->SetData(object);
+	wxTheClipboard->Close();
+}
+
+void CopyBuffer::loadFromClipboard() {
+	if (!wxTheClipboard->IsSupported(getClipboardFormat()) || !wxTheClipboard->Open()) {
+		return;
+	}
+	wxCustomDataObject object(getClipboardFormat());
+	if (wxTheClipboard->GetData(object)) {
+		const uint8_t* bytes = static_cast<const uint8_t*>(object.GetData());
+		std::vector<uint8_t> blob(bytes, bytes + object.GetSize());
+		// Usually the buffer this instance put there itself
+		if (blob != data) {
+			setData(std::move(blob));
+		}
+	}
+	wxTheClipboard->Close();
 }
 
 void CopyBuffer::copy(Editor& editor, int floor) {
@@ -57,53 +323,33 @@ void CopyBuffer::copy(Editor& editor, int floor) {
 		return;
 	}
 
-	clear();
-	tiles = newd BaseMap();
-
-	int tile_count = 0;
-	int item_count = 0;
-	copyPos = Position(0xFFFF, 0xFFFF, floor);
+	int copied_tiles = 0;
+	int copied_items = 0;
+	Position position(0xFFFF, 0xFFFF, floor);
 
+	MemoryNodeFileWriteHandle writer;
+	writer.addNode(0);
 	for (TileSet::iterator it = editor.selection.begin(); it != editor.selection.end(); ++it) {
-		++tile_count;
+		++copied_tiles;
 
 		Tile* tile = *it;
-		TileLocation* newlocation = tiles->createTileL(tile->getPosition());
-		Tile* copied_tile = tiles->allocator(newlocation);
-
-		if (tile->ground && tile->ground->isSelected()) {
-			copied_tile->house_id = tile->house_id;
-			copied_tile->setMapFlags(tile->getMapFlags());
-			copied_tile->setZoneIds(tile);
-		}
-
+		const bool with_ground = tile->ground && tile->ground->isSelected();
 		ItemVector tile_selection = tile->getSelectedItems();
-		for (ItemVector::iterator iit = tile_selection.begin(); iit != tile_selection.end(); ++iit) {
-			++item_count;
-			// Copy items to copybuffer
-			copied_tile->addItem((*iit)->deepCopy());
-		}
-
-		if (tile->creature && tile->creature->isSelected()) {
-			copied_tile->creature = tile->creature->deepCopy();
-		}
-		if (tile->spawn && tile->spawn->isSelected()) {
-			copied_tile->spawn = tile->spawn->deepCopy();
-		}
-
-		tiles->setTile(copied_tile);
+		copied_items += tile_selection.size();
+		const Creature* creature = tile->creature && tile->creature->isSelected() ? tile->creature : nullptr;
+		const Spawn* spawn = tile->spawn && tile->spawn->isSelected() ? tile->spawn : nullptr;
+		writeTile(writer, tile, with_ground, tile_selection, creature, spawn);
 
-		if (copied_tile->getX() < copyPos.x) {
-			copyPos.x = copied_tile->getX();
-		}
-
-		if (copied_tile->getY() < copyPos.y) {
-			copyPos.y = copied_tile->getY();
-		}
+		position.x = std::min(position.x, tile->getX());
+		position.y = std::min(position.y, tile->getY());
 	}
+	writer.endNode();
+
+	setData(makeBlob(writer, position, copied_tiles, copied_items));
+	storeInClipboard();
 
 	std::ostringstream ss;
-	ss << "Copied " << tile_count << " tile" << (tile_count > 1 ? "s" : "") << " (" << item_count << " item" << (item_count > 1 ? "s" : "") << ")";
+	ss << "Copied " << copied_tiles << " tile" << (copied_tiles > 1 ? "s" : "") << " (" << copied_items << " item" << (copied_items > 1 ? "s" : "") << ")";
 	g_gui.SetStatusText(wxstr(ss.str()));
 }
 
@@ -141,11 +387,7 @@ void CopyBuffer::cut(Editor& editor, int floor) {
 		for (TileSet::iterator it = editor.selection.begin(); it != editor.selection.end(); ++it) {
 			Tile* tile = *it;
 			if (tile && (tile->getMapFlags() & TILESTATE_ZONE_BRUSH)) {
-				char debug_msg[256];
-				sprintf(debug_msg, "DEBUG DRAG: Cut operation - clearing zones from tile at (%d,%d,%d) - zones=%zu\n", 
-					tile->getPosition().x, tile->getPosition().y, tile->getPosition().z,
-					tile->getZoneIds().size());
-				OutputDebugStringA(debug_msg);
+				TRACE_DEBUG(Selection, "Cut operation - clearing zones from tile at (%d,%d,%d) - zones=%zu", tile->getPosition().x, tile->getPosition().y, tile->getPosition().z, tile->getZoneIds().size());
 				
 				tile->unsetMapFlags(TILESTATE_ZONE_BRUSH);
 				tile->clearZoneId();
@@ -167,12 +409,11 @@ void CopyBuffer::cut(Editor& editor, int floor) {
 	}
 
 	// Normal cut operation for non-zone tiles
-	clear();
-	tiles = newd BaseMap();
-
-	int tile_count = 0;
-	int item_count = 0;
-	copyPos = Position(0xFFFF, 0xFFFF, floor);
+	int cut_tiles = 0;
+	int cut_items = 0;
+	Position position(0xFFFF, 0xFFFF, floor);
+	MemoryNodeFileWriteHandle writer;
+	writer.addNode(0);
 
 	BatchAction* batch = nullptr;
 	Action* action = nullptr;
@@ -204,7 +445,7 @@ void CopyBuffer::cut(Editor& editor, int floor) {
 	}
 
 	for (TileSet::iterator it = editor.selection.begin(); it != editor.selection.end(); ++it) {
-		tile_count++;
+		cut_tiles++;
 
 		Tile* tile = *it;
 		if (!tile) {
@@ -216,51 +457,37 @@ void CopyBuffer::cut(Editor& editor, int floor) {
 			continue; // Skip if deepCopy failed
 		}
 		
-		TileLocation* location = tiles->createTileL(tile->getPosition());
-		Tile* copied_tile = tiles->allocator(location);
-		if (!copied_tile) {
-			continue; // Skip if allocator failed
-		}
-
-		if (tile->ground && tile->ground->isSelected()) {
-			copied_tile->house_id = newtile->house_id;
-			newtile->house_id = 0;
-			copied_tile->setZoneIds(tile);
-			copied_tile->setMapFlags(tile->getMapFlags());
-			newtile->setMapFlags(TILESTATE_NONE);
-			newtile->clearZoneId();
-			
-			// ENHANCED FIX: Validate both tiles after zone operations
-			copied_tile->validateZoneConsistency();
-			newtile->validateZoneConsistency();
-		}
-
+		const bool with_ground = tile->ground && tile->ground->isSelected();
 		ItemVector tile_selection = newtile->popSelectedItems();
-		for (ItemVector::iterator iit = tile_selection.begin(); iit != tile_selection.end(); ++iit) {
-			item_count++;
-			// Add items to copybuffer
-			copied_tile->addItem(*iit);
+		cut_items += tile_selection.size();
+		Creature* creature = newtile->creature && newtile->creature->isSelected() ? newtile->creature : nullptr;
+		Spawn* spawn = newtile->spawn && newtile->spawn->isSelected() ? newtile->spawn : nullptr;
+		writeTile(writer, tile, with_ground, tile_selection, creature, spawn);
+
+		// Everything cut out now lives in the buffer records
+		for (Item* item : tile_selection) {
+			delete item;
 		}
-
-		if (newtile->creature && newtile->creature->isSelected()) {
-			copied_tile->creature = newtile->creature;
+		if (creature) {
+			delete creature;
 			newtile->creature = nullptr;
 		}
-
-		if (newtile->spawn && newtile->spawn->isSelected()) {
-			copied_tile->spawn = newtile->spawn;
+		if (spawn) {
+			delete spawn;
 			newtile->spawn = nullptr;
 		}
 
-		tiles->setTile(copied_tile);
+		if (with_ground) {
+			newtile->house_id = 0;
+			newtile->setMapFlags(TILESTATE_NONE);
+			newtile->clearZoneId();
 
-		if (copied_tile->getX() < copyPos.x) {
-			copyPos.x = copied_tile->getX();
+			// ENHANCED FIX: Validate the tile after zone operations
+			newtile->validateZoneConsistency();
 		}
 
-		if (copied_tile->getY() < copyPos.y) {
-			copyPos.y = copied_tile->getY();
-		}
+		position.x = std::min(position.x, tile->getX());
+		position.y = std::min(position.y, tile->getY());
 
 		if (g_settings.getInteger(Config::USE_AUTOMAGIC)) {
 			// Only add to tilestoborder if this tile is on the perimeter (adjacent to a non-selected tile)
@@ -283,6 +510,10 @@ void CopyBuffer::cut(Editor& editor, int floor) {
 
 	batch->addAndCommitAction(action);
 
+	writer.endNode();
+	setData(makeBlob(writer, position, cut_tiles, cut_items));
+	storeInClipboard();
+
 	// Remove duplicates
 	tilestoborder.sort();
 	tilestoborder.unique();
@@ -325,7 +556,7 @@ void CopyBuffer::cut(Editor& editor, int floor) {
 	try {
 		editor.addBatch(batch);
 		std::stringstream ss;
-		ss << "Cut out " << tile_count << " tile" << (tile_count > 1 ? "s" : "") << " (" << item_count << " item" << (item_count > 1 ? "s" : "") << ")";
+		ss << "Cut out " << cut_tiles << " tile" << (cut_tiles > 1 ? "s" : "") << " (" << cut_items << " item" << (cut_items > 1 ? "s" : "") << ")";
 		g_gui.SetStatusText(wxstr(ss.str()));
 	} catch (...) {
 		g_gui.SetStatusText("Exception occurred while finalizing cut operation.");
@@ -333,7 +564,11 @@ void CopyBuffer::cut(Editor& editor, int floor) {
 }
 
 void CopyBuffer::paste(Editor& editor, const Position& toPosition) {
-	if (!tiles) {
+	// While previewing, the previewed buffer is the one that gets pasted
+	if (!preview) {
+		loadFromClipboard();
+	}
+	if (data.empty()) {
 		return;
 	}
 
@@ -342,14 +577,24 @@ void CopyBuffer::paste(Editor& editor, const Position& toPosition) {
 	
 	// Track modified positions for minimap update
 	PositionVector modifiedPositions;
-	
-	// Original paste logic
-	for (MapIterator it = tiles->begin(); it != tiles->end(); ++it) {
-		Tile* buffer_tile = (*it)->get();
-		Position pos = buffer_tile->getPosition() - copyPos + toPosition;
-		
+	Map& map = editor.map;
+	const bool merge = g_settings.getInteger(Config::MERGE_PASTE) != 0;
+
+	const bool show_progress = tile_count >= ProgressTileCount;
+	if (show_progress) {
+		g_gui.CreateLoadBar("Pasting tiles...");
+	}
+
+	// The records are decoded straight into the new tiles
+	size_t done = 0;
+	const bool ok = forEachRecord(data, [&](const Position& source, BinaryNode* node) {
+		if (show_progress && ++done % ProgressStep == 0) {
+			g_gui.SetLoadDone(int(done * 100 / tile_count));
+		}
+
+		Position pos = source - copyPos + toPosition;
 		if (!pos.isValid()) {
-			continue;
+			return true;
 		}
 		
 		// Add position for minimap update
@@ -365,17 +610,20 @@ void CopyBuffer::paste(Editor& editor, const Position& toPosition) {
 			}
 		}
 
-		TileLocation* location = editor.map.createTileL(pos);
-		Tile* copy_tile = buffer_tile->deepCopy(editor.map);
+		TileLocation* location = map.createTileL(pos);
+		Tile* copy_tile = map.allocator(location);
+		if (!readTile(node, copy_tile)) {
+			delete copy_tile;
+			return false;
+		}
+
 		Tile* old_dest_tile = location->get();
 		Tile* new_dest_tile = nullptr;
-		copy_tile->setLocation(location);
-
-		if (g_settings.getInteger(Config::MERGE_PASTE) || !copy_tile->ground) {
+		if (merge || !copy_tile->ground) {
 			if (old_dest_tile) {
-				new_dest_tile = old_dest_tile->deepCopy(editor.map);
+				new_dest_tile = old_dest_tile->deepCopy(map);
 			} else {
-				new_dest_tile = editor.map.allocator(location);
+				new_dest_tile = map.allocator(location);
 			}
 			new_dest_tile->merge(copy_tile);
 			delete copy_tile;
@@ -384,6 +632,17 @@ void CopyBuffer::paste(Editor& editor, const Position& toPosition) {
 		}
 
 		action->addChange(newd Change(new_dest_tile));
+		return true;
+	});
+
+	if (show_progress) {
+		g_gui.DestroyLoadBar();
+	}
+	if (!ok) {
+		delete action;
+		delete batchAction;
+		g_gui.SetStatusText("The copy buffer is damaged and could not be pasted.");
+		return;
 	}
 	
 	batchAction->addAndCommitAction(action);
@@ -391,7 +650,6 @@ void CopyBuffer::paste(Editor& editor, const Position& toPosition) {
 	if (g_settings.getInteger(Config::USE_AUTOMAGIC) && g_settings.getInteger(Config::BORDERIZE_PASTE)) {
 		action = editor.actionQueue->createAction(batchAction);
 		TileList borderize_tiles;
-		Map& map = editor.map;
 
 		for (const Position& pos : modifiedPositions) {
 			Tile* tile = map.getTile(pos);
@@ -425,5 +683,5 @@ void CopyBuffer::paste(Editor& editor, const Position& toPosition) {
 }
 
 bool CopyBuffer::canPaste() const {
-	return tiles && tiles->size() != 0;
+	return !data.empty() || wxTheClipboard->IsSupported(getClipboardFormat());
 }
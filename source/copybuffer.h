@@ -23,8 +23,15 @@
 #include "position.h"
 #include "basemap.h"
 
+#include <memory>
+#include <vector>
+
 class Editor;
 
+// The copied tiles are kept as one compact blob: a small header followed by
+// OTBM tile nodes holding the copied parts of every tile. Pasting decodes the
+// records straight into the new tiles. The blob is also put on the system
+// clipboard so it can be pasted into another instance of the editor.
 class CopyBuffer {
 public:
 	CopyBuffer();
@@ -43,12 +50,24 @@ public:
 
 	size_t GetTileCount();
 
+	// The copied tiles decoded into a map, used to preview pasting. It is
+	// kept until releaseBufferMap() or the buffer changes.
 	BaseMap& getBufferMap();
+	void releaseBufferMap();
 
 private:
 	void collectModifiedPositions(const Position& toPosition, PositionVector& positions);
+	// Takes the blob if it is valid for the loaded client version
+	bool setData(std::vector<uint8_t>&& blob);
+	// Picks up a buffer copied by another instance, if the clipboard holds one
+	void loadFromClipboard();
+	void storeInClipboard() const;
+
 	Position copyPos;
-	BaseMap* tiles;
+	size_t tile_count;
+	size_t item_count;
+	std::vector<uint8_t> data;
+	std::unique_ptr<BaseMap> preview;
 };
 
 #endif
@@ -42,8 +42,8 @@
 #include "live_client.h"
 #include "live_action.h"
 #include "minimap_window.h"
-#include "borderize_window.h"
-#include "wallize_window.h"
+#include "tile_processor.h"
+#include "trace.h"
 
 Editor::Editor(CopyBuffer& copybuffer) :
 	live_server(nullptr),
@@ -53,6 +53,8 @@ Editor::Editor(CopyBuffer& copybuffer) :
 	selection(*this),
 	copybuffer(copybuffer),
 	replace_brush(nullptr) {
+	map.enableMinimapStore();
+
 	wxString error;
 	wxArrayString warnings;
 	bool ok = true;
@@ -95,6 +97,9 @@ Editor::Editor(CopyBuffer& copybuffer) :
 	map.unnamed = true;
 
 	map.doChange();
+	startMinimapPyramid();
+	map.enableItemIndex();
+	map.enableStatistics();
 }
 
 Editor::Editor(CopyBuffer& copybuffer, const FileName& fn) :
@@ -104,6 +109,8 @@ Editor::Editor(CopyBuffer& copybuffer, const FileName& fn) :
 	selection(*this),
 	copybuffer(copybuffer),
 	replace_brush(nullptr) {
+	map.enableMinimapStore();
+
 	MapVersion ver;
 	if (!IOMapOTBM::getVersionInfo(fn, ver)) {
 		// g_gui.PopupDialog("Error", "Could not open file \"" + fn.GetFullPath() + "\".", wxOK);
@@ -150,6 +157,12 @@ Editor::Editor(CopyBuffer& copybuffer, const FileName& fn) :
 		}
 		*/
 	}
+
+	if (success) {
+		startMinimapPyramid();
+		map.enableItemIndex();
+		map.enableStatistics();
+	}
 }
 
 Editor::Editor(CopyBuffer& copybuffer, LiveClient* client) :
@@ -159,7 +172,10 @@ Editor::Editor(CopyBuffer& copybuffer, LiveClient* client) :
 	selection(*this),
 	copybuffer(copybuffer),
 	replace_brush(nullptr) {
-	;
+	map.enableMinimapStore();
+	startMinimapPyramid();
+	map.enableItemIndex();
+	map.enableStatistics();
 }
 
 Editor::~Editor() {
@@ -424,6 +440,10 @@ void Editor::saveMap(FileName filename, bool showdialog) {
 	}
 
 	map.clearChanges();
+
+	if (minimap_pyramid) {
+		minimap_pyramid->onMapSaved(map.filename, getMinimapCacheFilename());
+	}
 }
 
 bool Editor::importMiniMap(FileName filename, int import, int import_x_offset, int import_y_offset, int import_z_offset) {
@@ -878,27 +898,22 @@ void Editor::borderizeSelection() {
 		return;
 	}
 
-	BorderizeWindow* window = newd BorderizeWindow(g_gui.root, *this);
-	window->Start();
-	window->Destroy();
+	TileProcessor processor(*this, TileProcessor::BORDERIZE);
+	processor.addSelection();
+	processor.run();
 }
 
 void Editor::borderizeMap(bool showdialog) {
-	if (!showdialog) {
-		// Old immediate processing for automated calls
-		uint64_t tiles_done = 0;
-		for (TileLocation* tileLocation : map) {
-			Tile* tile = tileLocation->get();
-			ASSERT(tile);
-			tile->borderize(&map);
-			++tiles_done;
-		}
-		return;
-	}
+	TileProcessor processor(*this, TileProcessor::BORDERIZE);
+	processor.addMap();
 
-	BorderizeWindow* window = newd BorderizeWindow(g_gui.root, *this);
-	window->Start();
-	window->Destroy();
+	if (showdialog) {
+		g_gui.CreateLoadBar("Borderizing map...");
+		processor.run([](int done) { g_gui.SetLoadDone(done); });
+		g_gui.DestroyLoadBar();
+	} else {
+		processor.run();
+	}
 }
 
 void Editor::wallizeSelection() {
@@ -907,29 +922,22 @@ void Editor::wallizeSelection() {
 		return;
 	}
 
-	// Create a custom wallize window similar to BorderizeWindow
-	WallizeWindow* window = newd WallizeWindow(g_gui.root, *this);
-	window->Start();
-	window->Destroy();
+	TileProcessor processor(*this, TileProcessor::WALLIZE);
+	processor.addSelection();
+	processor.run();
 }
 
 void Editor::wallizeMap(bool showdialog) {
-	if (!showdialog) {
-		// Old immediate processing for automated calls
-		uint64_t tiles_done = 0;
-		for (TileLocation* tileLocation : map) {
-			Tile* tile = tileLocation->get();
-			ASSERT(tile);
-			tile->wallize(&map);
-			++tiles_done;
-		}
-		return;
-	}
+	TileProcessor processor(*this, TileProcessor::WALLIZE);
+	processor.addMap();
 
-	// Create a custom wallize window similar to BorderizeWindow
-	WallizeWindow* window = newd WallizeWindow(g_gui.root, *this);
-	window->Start();
-	window->Destroy();
+	if (showdialog) {
+		g_gui.CreateLoadBar("Wallizing map...");
+		processor.run([](int done) { g_gui.SetLoadDone(done); });
+		g_gui.DestroyLoadBar();
+	} else {
+		processor.run();
+	}
 }
 
 void Editor::randomizeSelection() {
@@ -1076,26 +1084,147 @@ void Editor::clearModifiedTileState(bool showdialog) {
 	}
 }
 
+namespace {
+	// Everything on the tile is selected, so the tile object itself can be moved
+	bool isWholeTileSelected(const Tile* tile) {
+		if (!tile->ground || !tile->ground->isSelected()) {
+			return false;
+		}
+		for (const Item* item : tile->items) {
+			if (!item->isSelected()) {
+				return false;
+			}
+		}
+		return (!tile->creature || tile->creature->isSelected()) && (!tile->spawn || tile->spawn->isSelected());
+	}
+
+	// The selected tiles that are relocated instead of copied: whole tiles
+	// whose destination is empty or would be replaced by the move anyway. A
+	// destination held by another selected tile is only free if that tile is
+	// relocated as well, so the tiles are decided from the far end of the move.
+	void collectTileMoves(Map& map, Selection& selection, const Position& offset, bool merge, TileMoveList& moves, TileSet& relocated) {
+		auto rank = [&offset](const Tile* tile) {
+			const Position pos = tile->getPosition();
+			return int64_t(pos.x) * offset.x + int64_t(pos.y) * offset.y + int64_t(pos.z) * offset.z;
+		};
+
+		std::vector<Tile*> candidates;
+		for (Tile* tile : selection) {
+			if (isWholeTileSelected(tile)) {
+				candidates.push_back(tile);
+			}
+		}
+		std::sort(candidates.begin(), candidates.end(), [&rank](const Tile* a, const Tile* b) {
+			return rank(a) < rank(b);
+		});
+
+		moves.offset = offset;
+		for (Tile* tile : candidates) {
+			const Position destination = tile->getPosition() - offset;
+			if (!destination.isValid()) {
+				continue;
+			}
+
+			Tile* target = map.getTile(destination);
+			if (target && target->isSelected()) {
+				if (relocated.count(target) == 0) {
+					continue;
+				}
+			} else if (target && merge) {
+				continue;
+			}
+
+			relocated.insert(tile);
+			moves.sources.push_back(tile->getPosition());
+		}
+	}
+
+	// The tiles whose borders a move can change: the unselected tiles at or
+	// next to the positions and, with touching, the tiles at the positions
+	// that have such a neighbour. Tiles inside the moved area keep theirs.
+	void collectBorderRing(Map& map, const PositionVector& positions, bool touching, TileList& ring) {
+		for (const Position& pos : positions) {
+			bool touched = false;
+			for (int dy = -1; dy <= 1; ++dy) {
+				for (int dx = -1; dx <= 1; ++dx) {
+					Tile* tile = map.getTile(pos.x + dx, pos.y + dy, pos.z);
+					if (tile && !tile->isSelected()) {
+						ring.push_back(tile);
+						touched = true;
+					}
+				}
+			}
+			if (touching && touched) {
+				if (Tile* tile = map.getTile(pos)) {
+					ring.push_back(tile);
+				}
+			}
+		}
+
+		// Remove duplicates
+		ring.sort();
+		ring.unique();
+	}
+
+	void addBorderChanges(Map& map, Action* action, const TileList& tiles, bool doborders) {
+		for (Tile* tile : tiles) {
+			if (!tile->ground || !tile->ground->getGroundBrush()) {
+				continue;
+			}
+
+			Tile* new_tile = tile->deepCopy(map);
+			if (doborders) {
+				new_tile->borderize(&map);
+			}
+
+			new_tile->wallize(&map);
+			new_tile->tableize(&map);
+			new_tile->carpetize(&map);
+			if (tile->ground->isSelected()) {
+				new_tile->selectGround();
+			}
+
+			action->addChange(newd Change(new_tile));
+		}
+	}
+}
+
 void Editor::moveSelection(Position offset) {
 	// Add debugging output for move selection operation
-	char debug_msg[512];
-	sprintf(debug_msg, "DEBUG DRAG: moveSelection called with offset=(%d,%d,%d), selection_size=%zu\n", 
-		offset.x, offset.y, offset.z, selection.size());
-	OutputDebugStringA(debug_msg);
+	TRACE_DEBUG(Selection, "moveSelection called with offset=(%d,%d,%d), selection_size=%zu", offset.x, offset.y, offset.z, selection.size());
 	
 	BatchAction* batchAction = actionQueue->createBatch(ACTION_MOVE); // Our saved action batch, for undo!
 	Action* action;
 
+	const bool merge = g_settings.getInteger(Config::MERGE_MOVE) != 0;
+	const bool borderize = g_settings.getInteger(Config::USE_AUTOMAGIC) && g_settings.getInteger(Config::BORDERIZE_DRAG) && selection.size() < size_t(g_settings.getInteger(Config::BORDERIZE_DRAG_THRESHOLD));
+
 	// Remove tiles from the map
 	action = actionQueue->createAction(batchAction); // Our action!
 	bool doborders = false;
 	TileSet tmp_storage;
 
-	// Update the tiles with the newd positions
+	// Whole tiles are relocated by a single change, only the undo record
+	// remembers where they came from. The changes of a live client are sent
+	// as tiles, so it copies them like the rest.
+	TileMoveList moves;
+	TileSet relocated;
+	if (!IsLiveClient()) {
+		collectTileMoves(map, selection, offset, merge, moves, relocated);
+	}
+	PositionVector vacated = moves.sources;
+	if (!moves.sources.empty()) {
+		doborders = true;
+		action->addChange(Change::Create(std::move(moves)));
+	}
+
+	// The remaining tiles are split into what stays and a temporary tile with what moves
 	for (TileSet::iterator it = selection.begin(); it != selection.end(); ++it) {
 		// First we get the old tile and it's position
 		Tile* tile = (*it);
-		// const Position pos = tile->getPosition();
+		if (relocated.count(tile) != 0) {
+			continue;
+		}
 
 		// Create the duplicate source tile, which will replace the old one later
 		Tile* old_src_tile = tile;
@@ -1137,11 +1266,7 @@ void Editor::moveSelection(Position offset) {
 		// Clear zone flags from source tile to prevent empty tiles with zone data
 		// (which causes division by zero crashes in drawing code)
 		if (!tmp_storage_tile->ground && (new_src_tile->getMapFlags() & TILESTATE_ZONE_BRUSH)) {
-			char debug_msg[256];
-			sprintf(debug_msg, "DEBUG DRAG: Clearing zones from empty source tile at (%d,%d,%d) - zones=%zu\n", 
-				new_src_tile->getPosition().x, new_src_tile->getPosition().y, new_src_tile->getPosition().z,
-				new_src_tile->getZoneIds().size());
-			OutputDebugStringA(debug_msg);
+			TRACE_DEBUG(Selection, "Clearing zones from empty source tile at (%d,%d,%d) - zones=%zu", new_src_tile->getPosition().x, new_src_tile->getPosition().y, new_src_tile->getPosition().z, new_src_tile->getZoneIds().size());
 			
 			// If we're not moving ground but the tile has zones, clear them to avoid crashes
 			new_src_tile->unsetMapFlags(TILESTATE_ZONE_BRUSH);
@@ -1153,6 +1278,7 @@ void Editor::moveSelection(Position offset) {
 		new_src_tile->validateZoneConsistency();
 
 		tmp_storage.insert(tmp_storage_tile);
+		vacated.push_back(tile->getPosition());
 
 		// Add the tile copy to the action
 		action->addChange(newd Change(new_src_tile));
@@ -1161,92 +1287,17 @@ void Editor::moveSelection(Position offset) {
 	batchAction->addAndCommitAction(action);
 
 	// Remove old borders (and create some newd?)
-	if (g_settings.getInteger(Config::USE_AUTOMAGIC) && g_settings.getInteger(Config::BORDERIZE_DRAG) && selection.size() < size_t(g_settings.getInteger(Config::BORDERIZE_DRAG_THRESHOLD))) {
-		sprintf(debug_msg, "DEBUG DRAG: Applying autoborder on drag - USE_AUTOMAGIC=%d, BORDERIZE_DRAG=%d, selection_size=%zu, threshold=%d\n", 
-			g_settings.getInteger(Config::USE_AUTOMAGIC), g_settings.getInteger(Config::BORDERIZE_DRAG), 
-			selection.size(), g_settings.getInteger(Config::BORDERIZE_DRAG_THRESHOLD));
-		OutputDebugStringA(debug_msg);
+	if (borderize) {
+		TRACE_DEBUG(Selection, "Applying autoborder on drag - USE_AUTOMAGIC=%d, BORDERIZE_DRAG=%d, selection_size=%zu, threshold=%d", g_settings.getInteger(Config::USE_AUTOMAGIC), g_settings.getInteger(Config::BORDERIZE_DRAG), selection.size(), g_settings.getInteger(Config::BORDERIZE_DRAG_THRESHOLD));
 		
 		action = actionQueue->createAction(batchAction);
 		TileList borderize_tiles;
-		// Go through all modified (selected) tiles (might be slow)
-		for (TileSet::iterator it = tmp_storage.begin(); it != tmp_storage.end(); ++it) {
-			Position pos = (*it)->getPosition();
-			
-			sprintf(debug_msg, "DEBUG DRAG: Processing tmp_storage tile at pos=(%d,%d,%d)\n", pos.x, pos.y, pos.z);
-			OutputDebugStringA(debug_msg);
-			
-			// Go through all neighbours
-			Tile* t;
-			t = map.getTile(pos.x, pos.y, pos.z);
-			if (t && !t->isSelected()) {
-				borderize_tiles.push_back(t);
-			}
-			t = map.getTile(pos.x - 1, pos.y - 1, pos.z);
-			if (t && !t->isSelected()) {
-				borderize_tiles.push_back(t);
-			}
-			t = map.getTile(pos.x, pos.y - 1, pos.z);
-			if (t && !t->isSelected()) {
-				borderize_tiles.push_back(t);
-			}
-			t = map.getTile(pos.x + 1, pos.y - 1, pos.z);
-			if (t && !t->isSelected()) {
-				borderize_tiles.push_back(t);
-			}
-			t = map.getTile(pos.x - 1, pos.y, pos.z);
-			if (t && !t->isSelected()) {
-				borderize_tiles.push_back(t);
-			}
-			t = map.getTile(pos.x + 1, pos.y, pos.z);
-			if (t && !t->isSelected()) {
-				borderize_tiles.push_back(t);
-			}
-			t = map.getTile(pos.x - 1, pos.y + 1, pos.z);
-			if (t && !t->isSelected()) {
-				borderize_tiles.push_back(t);
-			}
-			t = map.getTile(pos.x, pos.y + 1, pos.z);
-			if (t && !t->isSelected()) {
-				borderize_tiles.push_back(t);
-			}
-			t = map.getTile(pos.x + 1, pos.y + 1, pos.z);
-			if (t && !t->isSelected()) {
-				borderize_tiles.push_back(t);
-			}
-		}
-		// Remove duplicates
-		borderize_tiles.sort();
-		borderize_tiles.unique();
+		collectBorderRing(map, vacated, false, borderize_tiles);
 		
-		sprintf(debug_msg, "DEBUG DRAG: Found %zu borderize tiles\n", borderize_tiles.size());
-		OutputDebugStringA(debug_msg);
+		TRACE_DEBUG(Selection, "Found %zu borderize tiles", borderize_tiles.size());
 		
 		// Do le borders!
-		for (TileList::iterator it = borderize_tiles.begin(); it != borderize_tiles.end(); it++) {
-			Tile* tile = *it;
-			if (tile->ground) {
-				if (tile->ground->getGroundBrush()) {
-					Tile* new_tile = tile->deepCopy(map);
-
-					if (doborders) {
-						sprintf(debug_msg, "DEBUG DRAG: Calling borderize on tile at pos=(%d,%d,%d)\n", 
-							tile->getPosition().x, tile->getPosition().y, tile->getPosition().z);
-						OutputDebugStringA(debug_msg);
-						new_tile->borderize(&map);
-					}
-
-					new_tile->wallize(&map);
-					new_tile->tableize(&map);
-					new_tile->carpetize(&map);
-					if (tile->ground->isSelected()) {
-						new_tile->selectGround();
-					}
-
-					action->addChange(newd Change(new_tile));
-				}
-			}
-		}
+		addBorderChanges(map, action, borderize_tiles, doborders);
 		// Commit changes to map
 		batchAction->addAndCommitAction(action);
 	}
@@ -1269,7 +1320,7 @@ void Editor::moveSelection(Position offset) {
 		Tile* old_dest_tile = location->get();
 		Tile* new_dest_tile = nullptr;
 
-		if (g_settings.getInteger(Config::MERGE_MOVE) || !tile->ground) {
+		if (merge || !tile->ground) {
 			// Move items
 			if (old_dest_tile) {
 				new_dest_tile = old_dest_tile->deepCopy(map);
@@ -1291,89 +1342,18 @@ void Editor::moveSelection(Position offset) {
 	batchAction->addAndCommitAction(action);
 
 	// Create borders
-	if (g_settings.getInteger(Config::USE_AUTOMAGIC) && g_settings.getInteger(Config::BORDERIZE_DRAG) && selection.size() < size_t(g_settings.getInteger(Config::BORDERIZE_DRAG_THRESHOLD))) {
+	if (borderize) {
 		action = actionQueue->createAction(batchAction);
-		TileList borderize_tiles;
-		// Go through all modified (selected) tiles (might be slow)
-		for (TileSet::iterator it = selection.begin(); it != selection.end(); it++) {
-			bool add_me = false; // If this tile is touched
-			Position pos = (*it)->getPosition();
-			// Go through all neighbours
-			Tile* t;
-			t = map.getTile(pos.x - 1, pos.y - 1, pos.z);
-			if (t && !t->isSelected()) {
-				borderize_tiles.push_back(t);
-				add_me = true;
-			}
-			t = map.getTile(pos.x - 1, pos.y - 1, pos.z);
-			if (t && !t->isSelected()) {
-				borderize_tiles.push_back(t);
-				add_me = true;
-			}
-			t = map.getTile(pos.x, pos.y - 1, pos.z);
-			if (t && !t->isSelected()) {
-				borderize_tiles.push_back(t);
-				add_me = true;
-			}
-			t = map.getTile(pos.x + 1, pos.y - 1, pos.z);
-			if (t && !t->isSelected()) {
-				borderize_tiles.push_back(t);
-				add_me = true;
-			}
-			t = map.getTile(pos.x - 1, pos.y, pos.z);
-			if (t && !t->isSelected()) {
-				borderize_tiles.push_back(t);
-				add_me = true;
-			}
-			t = map.getTile(pos.x + 1, pos.y, pos.z);
-			if (t && !t->isSelected()) {
-				borderize_tiles.push_back(t);
-				add_me = true;
-			}
-			t = map.getTile(pos.x - 1, pos.y + 1, pos.z);
-			if (t && !t->isSelected()) {
-				borderize_tiles.push_back(t);
-				add_me = true;
-			}
-			t = map.getTile(pos.x, pos.y + 1, pos.z);
-			if (t && !t->isSelected()) {
-				borderize_tiles.push_back(t);
-				add_me = true;
-			}
-			t = map.getTile(pos.x + 1, pos.y + 1, pos.z);
-			if (t && !t->isSelected()) {
-				borderize_tiles.push_back(t);
-				add_me = true;
-			}
-			if (add_me) {
-				borderize_tiles.push_back(*it);
-			}
+		PositionVector moved;
+		moved.reserve(selection.size());
+		for (Tile* tile : selection) {
+			moved.push_back(tile->getPosition());
 		}
-		// Remove duplicates
-		borderize_tiles.sort();
-		borderize_tiles.unique();
-		// Do le borders!
-		for (TileList::iterator it = borderize_tiles.begin(); it != borderize_tiles.end(); it++) {
-			Tile* tile = *it;
-			if (tile->ground) {
-				if (tile->ground->getGroundBrush()) {
-					Tile* new_tile = tile->deepCopy(map);
-
-					if (doborders) {
-						new_tile->borderize(&map);
-					}
 
-					new_tile->wallize(&map);
-					new_tile->tableize(&map);
-					new_tile->carpetize(&map);
-					if (tile->ground->isSelected()) {
-						new_tile->selectGround();
-					}
-
-					action->addChange(newd Change(new_tile));
-				}
-			}
-		}
+		TileList borderize_tiles;
+		collectBorderRing(map, moved, true, borderize_tiles);
+		// Do le borders!
+		addBorderChanges(map, action, borderize_tiles, doborders);
 		// Commit changes to map
 		batchAction->addAndCommitAction(action);
 	}
@@ -1382,8 +1362,7 @@ void Editor::moveSelection(Position offset) {
 	addBatch(batchAction);
 	selection.updateSelectionCount();
 	
-	sprintf(debug_msg, "DEBUG DRAG: editor.moveSelection completed successfully\n");
-	OutputDebugStringA(debug_msg);
+	TRACE_DEBUG(Selection, "editor.moveSelection completed successfully");
 }
 
 void Editor::destroySelection() {
@@ -2170,6 +2149,7 @@ void Editor::SendNodeRequests() {
 
 // Add new helper method to update minimap for a single position
 void Editor::updateMinimap(const Position& pos) {
+	map.updateMinimapColor(pos);
 	if (g_gui.minimap) {
 		PositionVector positions;
 		positions.push_back(pos);
@@ -2179,13 +2159,36 @@ void Editor::updateMinimap(const Position& pos) {
 
 // Add new helper method to update minimap for multiple positions
 void Editor::updateMinimap(const PositionVector& positions) {
+	for (const Position& pos : positions) {
+		map.updateMinimapColor(pos);
+	}
 	if (g_gui.minimap && !positions.empty()) {
 		g_gui.minimap->UpdateDrawnTiles(positions);
 	}
 }
 
+void Editor::startMinimapPyramid() {
+	minimap_pyramid = std::make_shared<MinimapPyramid>(map.getMinimapStore());
+	// Unsaved maps are not cached, there is no file the cache could be checked against
+	if (map.unnamed || map.filename.empty()) {
+		minimap_pyramid->start("", "");
+	} else {
+		minimap_pyramid->start(map.filename, getMinimapCacheFilename());
+	}
+}
+
+std::string Editor::getMinimapCacheFilename() const {
+	wxFileName cache(g_gui.GetDataDirectory(), "minimap_pyramid.bin");
+	cache.AppendDir("cachedmaps");
+	cache.AppendDir(wxstr(map.name));
+	return nstr(cache.GetFullPath());
+}
+
 // Add new helper method to update minimap for a tile
 void Editor::updateMinimapTile(Tile* tile) {
+	if (tile && tile->getLocation()) {
+		map.updateMinimapColor(tile->getPosition());
+	}
 	if (g_gui.minimap && tile) {
 		PositionVector positions;
 		positions.push_back(tile->getPosition());
@@ -2215,6 +2218,8 @@ uint32_t Editor::validateGrounds(bool validateStack, bool generateEmpty, bool re
     g_gui.DestroyLoadBar();
 
     if (changes > 0) {
+        // The grounds were fixed in place
+        map.invalidateIndexes();
         map.doChange();
     }
 
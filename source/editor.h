@@ -26,6 +26,7 @@
 #include "action.h"
 #include "selection.h"
 #include "minimap_window.h"
+#include "minimap_pyramid.h"
 
 class BaseMap;
 class CopyBuffer;
@@ -53,6 +54,9 @@ public:
 	GroundBrush* replace_brush;
 	Map map; // The map that is being edited
 
+protected:
+	std::shared_ptr<MinimapPyramid> minimap_pyramid;
+
 public: // Functions
 	// Live Server handling
 	LiveClient* GetLiveClient() const;
@@ -85,6 +89,11 @@ public: // Functions
 		return map;
 	}
 
+	// Zoomed out minimap levels, built in the background after the map was loaded
+	std::shared_ptr<MinimapPyramid> getMinimapPyramid() const noexcept {
+		return minimap_pyramid;
+	}
+
 	void LoadGeneratedMap(const Map& generatedMap);
 
 	uint16_t getMapWidth() const {
@@ -158,6 +167,9 @@ protected:
 	void drawInternal(const PositionVector& posvec, bool alt, bool dodraw);
 	void drawInternal(const PositionVector& todraw, PositionVector& toborder, bool alt, bool dodraw);
 
+	void startMinimapPyramid();
+	std::string getMinimapCacheFilename() const;
+
 	Editor(const Editor&);
 	Editor& operator=(const Editor&);
 };
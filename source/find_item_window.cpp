@@ -546,25 +546,7 @@ void FindItemDialog::RefreshContentsInternal() {
 						id, range.first, range.second).c_str());
 
 					// Check if ID is ignored
-					bool is_ignored = false;
-					if (ignore_ids_checkbox->GetValue()) {
-						// Check individual ignored IDs
-						if (std::find(ignored_ids.begin(), ignored_ids.end(), id) != ignored_ids.end()) {
-							OutputDebugStringA(wxString::Format("ID %d is in ignored individual IDs list\n", id).c_str());
-							is_ignored = true;
-						}
-						// Check ignored ranges
-						for (const auto& ignored_range : ignored_ranges) {
-							if (id >= ignored_range.first && id <= ignored_range.second) {
-								OutputDebugStringA(wxString::Format("ID %d is in ignored range %d-%d\n", 
-									id, ignored_range.first, ignored_range.second).c_str());
-								is_ignored = true;
-								break;
-							}
-						}
-					}
-					
-					if (is_ignored) {
+					if (ignore_ids_checkbox->GetValue() && ignored_set.test(id)) {
 						OutputDebugStringA(wxString::Format("Skipping ignored ID %d\n", id).c_str());
 						continue;
 					}
@@ -599,18 +581,7 @@ void FindItemDialog::RefreshContentsInternal() {
 			uint16_t serverID = static_cast<uint16_t>(result_id);
 			if(serverID <= g_items.getMaxID()) {
 				// Check if ID is ignored
-				bool is_ignored = false;
-				if (ignore_ids_checkbox->GetValue()) {
-					if (std::find(ignored_ids.begin(), ignored_ids.end(), serverID) != ignored_ids.end()) {
-						is_ignored = true;
-					}
-					for (const auto& range : ignored_ranges) {
-						if (serverID >= range.first && serverID <= range.second) {
-							is_ignored = true;
-							break;
-						}
-					}
-				}
+				const bool is_ignored = ignore_ids_checkbox->GetValue() && ignored_set.test(serverID);
 				if (!is_ignored) {
 					ItemType& item = g_items.getItemType(serverID);
 					RAWBrush* raw_brush = item.raw_brush;
@@ -651,18 +622,7 @@ void FindItemDialog::RefreshContentsInternal() {
 				}
 
 				// Check if clientID is ignored
-				bool is_ignored = false;
-				if (ignore_ids_checkbox->GetValue()) {
-					if (std::find(ignored_ids.begin(), ignored_ids.end(), item.clientID) != ignored_ids.end()) {
-						is_ignored = true;
-					}
-					for (const auto& range : ignored_ranges) {
-						if (item.clientID >= range.first && item.clientID <= range.second) {
-							is_ignored = true;
-							break;
-						}
-					}
-				}
+				const bool is_ignored = ignore_ids_checkbox->GetValue() && ignored_set.test(item.clientID);
 				if (is_ignored) continue;
 
 				RAWBrush* raw_brush = item.raw_brush;
@@ -677,18 +637,7 @@ void FindItemDialog::RefreshContentsInternal() {
 			uint16_t clientID = (uint16_t)client_id_spin->GetValue();
 			
 			// Check if clientID is ignored
-			bool is_ignored = false;
-			if (ignore_ids_checkbox->GetValue()) {
-				if (std::find(ignored_ids.begin(), ignored_ids.end(), clientID) != ignored_ids.end()) {
-					is_ignored = true;
-				}
-				for (const auto& range : ignored_ranges) {
-					if (clientID >= range.first && clientID <= range.second) {
-						is_ignored = true;
-						break;
-					}
-				}
-			}
+			const bool is_ignored = ignore_ids_checkbox->GetValue() && ignored_set.test(clientID);
 			if (!is_ignored) {
 				for (int id = 100; id <= g_items.getMaxID(); ++id) {
 					ItemType& item = g_items.getItemType(id);
@@ -961,10 +910,20 @@ void FindItemDialog::ParseIgnoredIDs() {
 		}
 	}
 	
+	ignored_set = MapSearch::makeIdSet(ignored_ids, ignored_ranges);
+
 	OutputDebugStringA(wxString::Format("Total ignored IDs: %zu, Total ranges: %zu\n", 
 		ignored_ids.size(), ignored_ranges.size()).c_str());
 }
 
+MapSearch::IdSet FindItemDialog::GetIgnoredIdSet() {
+	if (!IsIgnoreIdsEnabled()) {
+		return MapSearch::IdSet();
+	}
+	ParseIgnoredIDs();
+	return ignored_set;
+}
+
 namespace RME {
 
 // Helper function to split a string by a delimiter
@@ -27,6 +27,8 @@
 #include <wx/button.h>
 #include <wx/dialog.h>
 
+#include "map_search.h"
+
 class FindDialogListBox;
 
 class FindItemDialog : public wxDialog {
@@ -77,6 +79,8 @@ public:
 	// Public methods
 
 	std::vector<uint16_t> GetIgnoredIds() const { return ignored_ids; }
+	// Every id the ignore list covers, empty when the list is disabled
+	MapSearch::IdSet GetIgnoredIdSet();
 
 protected:
 	void EnableProperties(bool enable);
@@ -147,6 +151,8 @@ protected:
 	
 	std::vector<uint16_t> ignored_ids;
 	std::vector<std::pair<uint16_t, uint16_t>> ignored_ranges;
+	// ignored_ids and ignored_ranges combined, rebuilt by ParseIgnoredIDs
+	MapSearch::IdSet ignored_set;
 	
 	void ParseIgnoredIDs();
 
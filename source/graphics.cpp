@@ -19,6 +19,7 @@
 
 #include "sprites.h"
 #include "graphics.h"
+#include "sprite_kernels.h"
 #include "filehandle.h"
 #include "settings.h"
 #include "gui.h"
@@ -188,13 +189,24 @@ GraphicManager::GraphicManager() :
 	has_transparency(false),
 	has_frame_durations(false),
 	has_frame_groups(false),
+	template_cache_hits(0),
+	template_cache_misses(0),
+	template_cache_evictions(0),
 	loaded_textures(0),
-	lastclean(0) {
+	frame_count(0),
+	resident_head(nullptr),
+	resident_tail(nullptr),
+	texture_uploads(0),
+	texture_reuploads(0),
+	texture_evictions(0),
+	dump_sweep_cursor(0) {
 	animation_timer = newd wxStopWatch();
 	animation_timer->Start();
 }
 
 GraphicManager::~GraphicManager() {
+	clearTemplateCache();
+
 	for (SpriteMap::iterator iter = sprite_space.begin(); iter != sprite_space.end(); ++iter) {
 		delete iter->second;
 	}
@@ -220,6 +232,8 @@ GLuint GraphicManager::getFreeTextureID() {
 }
 
 void GraphicManager::clear() {
+	clearTemplateCache();
+
 	SpriteMap new_sprite_space;
 	for (SpriteMap::iterator iter = sprite_space.begin(); iter != sprite_space.end(); ++iter) {
 		if (iter->first >= 0) { // Don't clean internal sprites
@@ -240,7 +254,9 @@ void GraphicManager::clear() {
 	item_count = 0;
 	creature_count = 0;
 	loaded_textures = 0;
-	lastclean = time(nullptr);
+	resident_head = nullptr;
+	resident_tail = nullptr;
+	dump_sweep_cursor = 0;
 	spritefile = "";
 
 	unloaded = true;
@@ -939,25 +955,141 @@ void GraphicManager::addSpriteToCleanup(GameSprite* spr) {
 }
 
 void GraphicManager::garbageCollection() {
+	// Upper bounds on the work done per frame, so cleaning never shows up as a spike
+	const int max_evictions_per_frame = 256;
+	const int dump_sweep_per_frame = 512;
+
 	if (g_settings.getInteger(Config::TEXTURE_MANAGEMENT)) {
-		int t = time(nullptr);
-		if (loaded_textures > g_settings.getInteger(Config::TEXTURE_CLEAN_THRESHOLD) && t - lastclean > g_settings.getInteger(Config::TEXTURE_CLEAN_PULSE)) {
-			ImageMap::iterator iit = image_space.begin();
-			while (iit != image_space.end()) {
-				iit->second->clean(t);
-				++iit;
+		const int budget = std::max(100, g_settings.getInteger(Config::TEXTURE_CLEAN_THRESHOLD));
+		int evicted = 0;
+		while (loaded_textures > budget && resident_tail && evicted < max_evictions_per_frame) {
+			GameSprite::Image* coldest = resident_tail;
+			// Everything further up the list was drawn this frame as well
+			if (coldest->lastaccess == frame_count) {
+				break;
 			}
-			SpriteMap::iterator sit = sprite_space.begin();
-			while (sit != sprite_space.end()) {
-				GameSprite* gs = dynamic_cast<GameSprite*>(sit->second);
-				if (gs) {
-					gs->clean(t);
-				}
-				++sit;
+			coldest->evict();
+			++texture_evictions;
+			++evicted;
+		}
+	}
+
+	// Sprite dumps of images that aren't on the GPU are only needed again when they
+	// get uploaded, free a slice of them every frame instead of walking all at once
+	if (!g_settings.getInteger(Config::USE_MEMCACHED_SPRITES) && !image_space.empty()) {
+		ImageMap::iterator it = image_space.lower_bound(dump_sweep_cursor);
+		for (int i = 0; i < dump_sweep_per_frame; ++i) {
+			if (it == image_space.end()) {
+				it = image_space.begin();
+			}
+			GameSprite::NormalImage* img = static_cast<GameSprite::NormalImage*>(it->second);
+			if (img && !img->isGLLoaded && frame_count - img->lastaccess > 300) {
+				img->cleanDump();
 			}
-			lastclean = t;
+			++it;
 		}
+		dump_sweep_cursor = (it == image_space.end() ? 0 : it->first);
 	}
+
+	++frame_count;
+}
+
+GraphicManager::TextureStats GraphicManager::getTextureStats() const {
+	TextureStats stats;
+	stats.resident = std::max(0, loaded_textures);
+	stats.resident_bytes = stats.resident * SPRITE_PIXELS_SIZE * 4;
+	stats.budget = std::max(100, g_settings.getInteger(Config::TEXTURE_CLEAN_THRESHOLD));
+	stats.uploads = texture_uploads;
+	stats.reuploads = texture_reuploads;
+	stats.evictions = texture_evictions;
+	return stats;
+}
+
+void GraphicManager::linkResident(GameSprite::Image* img) {
+	img->lru_prev = nullptr;
+	img->lru_next = resident_head;
+	if (resident_head) {
+		resident_head->lru_prev = img;
+	} else {
+		resident_tail = img;
+	}
+	resident_head = img;
+}
+
+void GraphicManager::unlinkResident(GameSprite::Image* img) {
+	if (img->lru_prev) {
+		img->lru_prev->lru_next = img->lru_next;
+	} else if (resident_head == img) {
+		resident_head = img->lru_next;
+	}
+	if (img->lru_next) {
+		img->lru_next->lru_prev = img->lru_prev;
+	} else if (resident_tail == img) {
+		resident_tail = img->lru_prev;
+	}
+	img->lru_prev = nullptr;
+	img->lru_next = nullptr;
+}
+
+void GraphicManager::touchResident(GameSprite::Image* img) {
+	if (resident_head != img) {
+		unlinkResident(img);
+		linkResident(img);
+	}
+}
+
+GameSprite::TemplateImage* GraphicManager::getTemplateImage(GameSprite* sprite, int sprite_index, const Outfit& outfit) {
+	const size_t template_index = sprite_index + sprite->height * sprite->width;
+	if (template_index >= sprite->spriteList.size()) {
+		return nullptr;
+	}
+
+	const TemplateKey key {
+		sprite->spriteList[sprite_index]->id,
+		sprite->spriteList[template_index]->id,
+		outfit.getColorHash()
+	};
+
+	auto it = template_cache.find(key);
+	if (it != template_cache.end()) {
+		++template_cache_hits;
+		template_lru.splice(template_lru.begin(), template_lru, it->second);
+		return it->second->second;
+	}
+
+	++template_cache_misses;
+	GameSprite::TemplateImage* img = newd GameSprite::TemplateImage(sprite, sprite_index, outfit);
+	template_lru.emplace_front(key, img);
+	template_cache.emplace(key, template_lru.begin());
+
+	// Never evict the entry that was just added, the caller is about to use it
+	const size_t budget = std::max<int>(1, g_settings.getInteger(Config::TEMPLATE_TEXTURE_BUDGET));
+	while (template_lru.size() > budget) {
+		auto& coldest = template_lru.back();
+		template_cache.erase(coldest.first);
+		delete coldest.second;
+		template_lru.pop_back();
+		++template_cache_evictions;
+	}
+	return img;
+}
+
+GraphicManager::TemplateCacheStats GraphicManager::getTemplateCacheStats() const {
+	TemplateCacheStats stats;
+	stats.size = template_lru.size();
+	stats.budget = std::max<int>(1, g_settings.getInteger(Config::TEMPLATE_TEXTURE_BUDGET));
+	stats.hits = template_cache_hits;
+	stats.misses = template_cache_misses;
+	stats.evictions = template_cache_evictions;
+	return stats;
+}
+
+void GraphicManager::clearTemplateCache() {
+	for (auto& entry : template_lru) {
+		delete entry.second;
+	}
+	template_lru.clear();
+	template_cache.clear();
 }
 
 EditorSprite::EditorSprite(wxBitmap* b16x16, wxBitmap* b32x32, wxBitmap* b64x64) {
@@ -1013,21 +1145,9 @@ GameSprite::GameSprite() :
 
 GameSprite::~GameSprite() {
 	unloadDC();
-	for (std::list<TemplateImage*>::iterator iter = instanced_templates.begin(); iter != instanced_templates.end(); ++iter) {
-		delete *iter;
-	}
-
 	delete animator;
 }
 
-void GameSprite::clean(int time) {
-	for (std::list<TemplateImage*>::iterator iter = instanced_templates.begin();
-		 iter != instanced_templates.end();
-		 ++iter) {
-		(*iter)->clean(time);
-	}
-}
-
 void GameSprite::unloadDC() {
 	delete dc[SPRITE_SIZE_16x16];
 	delete dc[SPRITE_SIZE_32x32];
@@ -1069,24 +1189,7 @@ GLuint GameSprite::getHardwareID(int _x, int _y, int _layer, int _count, int _pa
 }
 
 GameSprite::TemplateImage* GameSprite::getTemplateImage(int sprite_index, const Outfit& outfit) {
-	if (instanced_templates.empty()) {
-		TemplateImage* img = newd TemplateImage(this, sprite_index, outfit);
-		instanced_templates.push_back(img);
-		return img;
-	}
-	// While this is linear lookup, it is very rare for the list to contain more than 4-8 entries, so it's faster than a hashmap anyways.
-	for (std::list<TemplateImage*>::iterator iter = instanced_templates.begin(); iter != instanced_templates.end(); ++iter) {
-		TemplateImage* img = *iter;
-		if (img->sprite_index == sprite_index) {
-			uint32_t lookHash = img->lookHead << 24 | img->lookBody << 16 | img->lookLegs << 8 | img->lookFeet;
-			if (outfit.getColorHash() == lookHash) {
-				return img;
-			}
-		}
-	}
-	TemplateImage* img = newd TemplateImage(this, sprite_index, outfit);
-	instanced_templates.push_back(img);
-	return img;
+	return g_gui.gfx.getTemplateImage(this, sprite_index, outfit);
 }
 
 GLuint GameSprite::getHardwareID(int _x, int _y, int _dir, int _addon, int _pattern_z, const Outfit& _outfit, int _frame) {
@@ -1099,8 +1202,9 @@ GLuint GameSprite::getHardwareID(int _x, int _y, int _dir, int _addon, int _patt
 		}
 	}
 	if (layers > 1) { // Template
-		TemplateImage* img = getTemplateImage(v, _outfit);
-		return img->getHardwareID();
+		if (TemplateImage* img = getTemplateImage(v, _outfit)) {
+			return img->getHardwareID();
+		}
 	}
 	return spriteList[v]->getHardwareID();
 }
@@ -1260,12 +1364,17 @@ void GameSprite::DrawOutfit(wxDC* dc, SpriteSize sz, int start_x, int start_y, c
 
 GameSprite::Image::Image() :
 	isGLLoaded(false),
-	lastaccess(0) {
+	lastaccess(0),
+	wasUploaded(false),
+	lru_prev(nullptr),
+	lru_next(nullptr) {
 	////
 }
 
 GameSprite::Image::~Image() {
-	unloadGLTexture(0);
+	if (isGLLoaded) {
+		unloadGLTexture(0);
+	}
 }
 
 void GameSprite::Image::createGLTexture(GLuint whatid) {
@@ -1278,6 +1387,12 @@ void GameSprite::Image::createGLTexture(GLuint whatid) {
 
 	isGLLoaded = true;
 	g_gui.gfx.loaded_textures += 1;
+	g_gui.gfx.texture_uploads += 1;
+	if (wasUploaded) {
+		g_gui.gfx.texture_reuploads += 1;
+	}
+	wasUploaded = true;
+	g_gui.gfx.linkResident(this);
 
 	glBindTexture(GL_TEXTURE_2D, whatid);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR); // Linear Filtering
@@ -1293,15 +1408,19 @@ void GameSprite::Image::createGLTexture(GLuint whatid) {
 void GameSprite::Image::unloadGLTexture(GLuint whatid) {
 	isGLLoaded = false;
 	g_gui.gfx.loaded_textures -= 1;
+	g_gui.gfx.unlinkResident(this);
 	glDeleteTextures(1, &whatid);
 }
 
 void GameSprite::Image::visit() {
-	lastaccess = time(nullptr);
+	lastaccess = g_gui.gfx.frame_count;
+	if (isGLLoaded) {
+		g_gui.gfx.touchResident(this);
+	}
 }
 
-void GameSprite::Image::clean(int time) {
-	if (isGLLoaded && time - lastaccess > g_settings.getInteger(Config::TEXTURE_LONGEVITY)) {
+void GameSprite::Image::evict() {
+	if (isGLLoaded) {
 		unloadGLTexture(0);
 	}
 }
@@ -1317,9 +1436,13 @@ GameSprite::NormalImage::~NormalImage() {
 	delete[] dump;
 }
 
-void GameSprite::NormalImage::clean(int time) {
-	Image::clean(time);
-	if (time - lastaccess > 5 && !g_settings.getInteger(Config::USE_MEMCACHED_SPRITES)) { // We keep dumps around for 5 seconds.
+void GameSprite::NormalImage::evict() {
+	Image::evict();
+	cleanDump();
+}
+
+void GameSprite::NormalImage::cleanDump() {
+	if (!g_settings.getInteger(Config::USE_MEMCACHED_SPRITES)) {
 		delete[] dump;
 		dump = nullptr;
 	}
@@ -1336,41 +1459,8 @@ uint8_t* GameSprite::NormalImage::getRGBData() {
 		}
 	}
 
-	const int pixels_data_size = SPRITE_PIXELS * SPRITE_PIXELS * 3;
-	uint8_t* data = newd uint8_t[pixels_data_size];
-	uint8_t bpp = g_gui.gfx.hasTransparency() ? 4 : 3;
-	int write = 0;
-	int read = 0;
-
-	// decompress pixels
-	while (read < size && write < pixels_data_size) {
-		int transparent = dump[read] | dump[read + 1] << 8;
-		read += 2;
-		for (int i = 0; i < transparent && write < pixels_data_size; i++) {
-			data[write + 0] = 0xFF; // red
-			data[write + 1] = 0x00; // green
-			data[write + 2] = 0xFF; // blue
-			write += 3;
-		}
-
-		int colored = dump[read] | dump[read + 1] << 8;
-		read += 2;
-		for (int i = 0; i < colored && write < pixels_data_size; i++) {
-			data[write + 0] = dump[read + 0]; // red
-			data[write + 1] = dump[read + 1]; // green
-			data[write + 2] = dump[read + 2]; // blue
-			write += 3;
-			read += bpp;
-		}
-	}
-
-	// fill remaining pixels
-	while (write < pixels_data_size) {
-		data[write + 0] = 0xFF; // red
-		data[write + 1] = 0x00; // green
-		data[write + 2] = 0xFF; // blue
-		write += 3;
-	}
+	uint8_t* data = newd uint8_t[SPRITE_PIXELS_SIZE * 3];
+	SpriteKernels::decodeRGB(dump, size, g_gui.gfx.hasTransparency(), data);
 	return data;
 }
 
@@ -1385,48 +1475,8 @@ uint8_t* GameSprite::NormalImage::getRGBAData() {
 		}
 	}
 
-	const int pixels_data_size = SPRITE_PIXELS_SIZE * 4;
-	uint8_t* data = newd uint8_t[pixels_data_size];
-	bool use_alpha = g_gui.gfx.hasTransparency();
-	uint8_t bpp = use_alpha ? 4 : 3;
-	int write = 0;
-	int read = 0;
-
-	// decompress pixels
-	while (read < size && write < pixels_data_size) {
-		int transparent = dump[read] | dump[read + 1] << 8;
-		if (use_alpha && transparent >= SPRITE_PIXELS_SIZE) { // Corrupted sprite?
-			break;
-		}
-		read += 2;
-		for (int i = 0; i < transparent && write < pixels_data_size; i++) {
-			data[write + 0] = 0x00; // red
-			data[write + 1] = 0x00; // green
-			data[write + 2] = 0x00; // blue
-			data[write + 3] = 0x00; // alpha
-			write += 4;
-		}
-
-		int colored = dump[read] | dump[read + 1] << 8;
-		read += 2;
-		for (int i = 0; i < colored && write < pixels_data_size; i++) {
-			data[write + 0] = dump[read + 0]; // red
-			data[write + 1] = dump[read + 1]; // green
-			data[write + 2] = dump[read + 2]; // blue
-			data[write + 3] = use_alpha ? dump[read + 3] : 0xFF; // alpha
-			write += 4;
-			read += bpp;
-		}
-	}
-
-	// fill remaining pixels
-	while (write < pixels_data_size) {
-		data[write + 0] = 0x00; // red
-		data[write + 1] = 0x00; // green
-		data[write + 2] = 0x00; // blue
-		data[write + 3] = 0x00; // alpha
-		write += 4;
-	}
+	uint8_t* data = newd uint8_t[SPRITE_PIXELS_SIZE * 4];
+	SpriteKernels::decodeRGBA(dump, size, g_gui.gfx.hasTransparency(), data);
 	return data;
 }
 
@@ -1458,17 +1508,10 @@ GameSprite::TemplateImage::TemplateImage(GameSprite* parent, int v, const Outfit
 }
 
 GameSprite::TemplateImage::~TemplateImage() {
-	////
-}
-
-void GameSprite::TemplateImage::colorizePixel(uint8_t color, uint8_t& red, uint8_t& green, uint8_t& blue) {
-	// Thanks! Khaos, or was it mips? Hmmm... =)
-	uint8_t ro = (TemplateOutfitLookupTable[color] & 0xFF0000) >> 16; // rgb outfit
-	uint8_t go = (TemplateOutfitLookupTable[color] & 0xFF00) >> 8;
-	uint8_t bo = (TemplateOutfitLookupTable[color] & 0xFF);
-	red = (uint8_t)(red * (ro / 255.f));
-	green = (uint8_t)(green * (go / 255.f));
-	blue = (uint8_t)(blue * (bo / 255.f));
+	// The base destructor can't reach our texture id
+	if (isGLLoaded) {
+		unloadGLTexture(gl_tid);
+	}
 }
 
 uint8_t* GameSprite::TemplateImage::getRGBData() {
@@ -1497,27 +1540,13 @@ uint8_t* GameSprite::TemplateImage::getRGBData() {
 		lookFeet = 0;
 	}
 
-	for (int y = 0; y < SPRITE_PIXELS; ++y) {
-		for (int x = 0; x < SPRITE_PIXELS; ++x) {
-			uint8_t& red = rgbdata[y * SPRITE_PIXELS * 3 + x * 3 + 0];
-			uint8_t& green = rgbdata[y * SPRITE_PIXELS * 3 + x * 3 + 1];
-			uint8_t& blue = rgbdata[y * SPRITE_PIXELS * 3 + x * 3 + 2];
-
-			uint8_t& tred = template_rgbdata[y * SPRITE_PIXELS * 3 + x * 3 + 0];
-			uint8_t& tgreen = template_rgbdata[y * SPRITE_PIXELS * 3 + x * 3 + 1];
-			uint8_t& tblue = template_rgbdata[y * SPRITE_PIXELS * 3 + x * 3 + 2];
-
-			if (tred && tgreen && !tblue) { // yellow => head
-				colorizePixel(lookHead, red, green, blue);
-			} else if (tred && !tgreen && !tblue) { // red => body
-				colorizePixel(lookBody, red, green, blue);
-			} else if (!tred && tgreen && !tblue) { // green => legs
-				colorizePixel(lookLegs, red, green, blue);
-			} else if (!tred && !tgreen && tblue) { // blue => feet
-				colorizePixel(lookFeet, red, green, blue);
-			}
-		}
-	}
+	const uint32_t colors[4] = {
+		TemplateOutfitLookupTable[lookHead],
+		TemplateOutfitLookupTable[lookBody],
+		TemplateOutfitLookupTable[lookLegs],
+		TemplateOutfitLookupTable[lookFeet]
+	};
+	SpriteKernels::colorizeRGB(rgbdata, template_rgbdata, colors);
 	delete[] template_rgbdata;
 	return rgbdata;
 }
@@ -1548,27 +1577,13 @@ uint8_t* GameSprite::TemplateImage::getRGBAData() {
 		lookFeet = 0;
 	}
 
-	for (int y = 0; y < SPRITE_PIXELS; ++y) {
-		for (int x = 0; x < SPRITE_PIXELS; ++x) {
-			uint8_t& red = rgbadata[y * SPRITE_PIXELS * 4 + x * 4 + 0];
-			uint8_t& green = rgbadata[y * SPRITE_PIXELS * 4 + x * 4 + 1];
-			uint8_t& blue = rgbadata[y * SPRITE_PIXELS * 4 + x * 4 + 2];
-
-			uint8_t& tred = template_rgbdata[y * SPRITE_PIXELS * 3 + x * 3 + 0];
-			uint8_t& tgreen = template_rgbdata[y * SPRITE_PIXELS * 3 + x * 3 + 1];
-			uint8_t& tblue = template_rgbdata[y * SPRITE_PIXELS * 3 + x * 3 + 2];
-
-			if (tred && tgreen && !tblue) { // yellow => head
-				colorizePixel(lookHead, red, green, blue);
-			} else if (tred && !tgreen && !tblue) { // red => body
-				colorizePixel(lookBody, red, green, blue);
-			} else if (!tred && tgreen && !tblue) { // green => legs
-				colorizePixel(lookLegs, red, green, blue);
-			} else if (!tred && !tgreen && tblue) { // blue => feet
-				colorizePixel(lookFeet, red, green, blue);
-			}
-		}
-	}
+	const uint32_t colors[4] = {
+		TemplateOutfitLookupTable[lookHead],
+		TemplateOutfitLookupTable[lookBody],
+		TemplateOutfitLookupTable[lookLegs],
+		TemplateOutfitLookupTable[lookFeet]
+	};
+	SpriteKernels::colorizeRGBA(rgbadata, template_rgbdata, colors);
 	delete[] template_rgbdata;
 	return rgbadata;
 }
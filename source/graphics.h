@@ -21,6 +21,7 @@
 #include "outfit.h"
 #include "common.h"
 #include <deque>
+#include <unordered_map>
 
 #include "client_version.h"
 
@@ -91,8 +92,6 @@ public:
 
 	virtual void unloadDC();
 
-	void clean(int time);
-
 	int getDrawHeight() const;
 	std::pair<int, int> getDrawOffset() const;
 	uint8_t getMiniMapColor() const;
@@ -118,10 +117,17 @@ protected:
 		virtual ~Image();
 
 		bool isGLLoaded;
-		int lastaccess;
+		// Frame in which the texture was last drawn
+		uint32_t lastaccess;
+		bool wasUploaded;
+
+		// Neighbours in GraphicManager's list of GL resident images
+		Image* lru_prev;
+		Image* lru_next;
 
 		void visit();
-		virtual void clean(int time);
+		// Releases the GL texture to make room for others
+		virtual void evict();
 
 		virtual GLuint getHardwareID() = 0;
 		virtual uint8_t* getRGBData() = 0;
@@ -144,7 +150,8 @@ protected:
 		uint16_t size;
 		uint8_t* dump;
 
-		virtual void clean(int time);
+		virtual void evict();
+		void cleanDump();
 
 		virtual GLuint getHardwareID();
 		virtual uint8_t* getRGBData();
@@ -173,8 +180,6 @@ protected:
 		uint8_t lookFeet;
 
 	protected:
-		void colorizePixel(uint8_t color, uint8_t& r, uint8_t& b, uint8_t& g);
-
 		virtual void createGLTexture(GLuint ignored = 0);
 		virtual void unloadGLTexture(GLuint ignored = 0);
 	};
@@ -205,7 +210,6 @@ public:
 	SpriteLight light;
 
 	std::vector<NormalImage*> spriteList;
-	std::list<TemplateImage*> instanced_templates; // Templates that use this sprite
 
 	friend class GraphicManager;
 };
@@ -297,7 +301,8 @@ public:
 	bool loadSpriteMetadataFlags(FileReadHandle& file, GameSprite* sType, wxString& error, wxArrayString& warnings);
 	bool loadSpriteData(const FileName& datafile, wxString& error, wxArrayString& warnings);
 
-	// Cleans old & unused textures according to config settings
+	// Evicts the least recently drawn textures while over the texture budget,
+	// call once per frame
 	void garbageCollection();
 	void addSpriteToCleanup(GameSprite* spr);
 
@@ -311,6 +316,26 @@ public:
 	bool hasTransparency() const;
 	bool isUnloaded() const;
 
+	struct TemplateCacheStats {
+		size_t size = 0;
+		size_t budget = 0;
+		uint64_t hits = 0;
+		uint64_t misses = 0;
+		uint64_t evictions = 0;
+	};
+	TemplateCacheStats getTemplateCacheStats() const;
+	void clearTemplateCache();
+
+	struct TextureStats {
+		size_t resident = 0;
+		size_t resident_bytes = 0;
+		size_t budget = 0;
+		uint64_t uploads = 0;
+		uint64_t reuploads = 0;
+		uint64_t evictions = 0;
+	};
+	TextureStats getTextureStats() const;
+
 	ClientVersion* client_version;
 
 private:
@@ -325,6 +350,33 @@ private:
 	ImageMap image_space;
 	std::deque<GameSprite*> cleanup_list;
 
+	// Outfit colored creature textures. Keyed by the sprite images they are built
+	// from, so every creature type sharing those images shares the texture too.
+	struct TemplateKey {
+		uint32_t sprite_id;
+		uint32_t template_id;
+		uint32_t color_hash;
+
+		bool operator==(const TemplateKey& other) const {
+			return sprite_id == other.sprite_id && template_id == other.template_id && color_hash == other.color_hash;
+		}
+	};
+	struct TemplateKeyHash {
+		size_t operator()(const TemplateKey& key) const {
+			uint64_t h = (uint64_t(key.sprite_id) << 32 | key.template_id) * 0x9E3779B97F4A7C15ULL;
+			return static_cast<size_t>(h ^ (h >> 29) ^ key.color_hash);
+		}
+	};
+	typedef std::list<std::pair<TemplateKey, GameSprite::TemplateImage*>> TemplateList;
+	// Most recently used first
+	TemplateList template_lru;
+	std::unordered_map<TemplateKey, TemplateList::iterator, TemplateKeyHash> template_cache;
+	uint64_t template_cache_hits;
+	uint64_t template_cache_misses;
+	uint64_t template_cache_evictions;
+
+	GameSprite::TemplateImage* getTemplateImage(GameSprite* sprite, int sprite_index, const Outfit& outfit);
+
 	DatFormat dat_format;
 	uint16_t item_count;
 	uint16_t creature_count;
@@ -337,10 +389,24 @@ private:
 	wxFileName sprites_file;
 
 	int loaded_textures;
-	int lastclean;
+	uint32_t frame_count;
+
+	// GL resident images, most recently drawn first
+	GameSprite::Image* resident_head;
+	GameSprite::Image* resident_tail;
+	uint64_t texture_uploads;
+	uint64_t texture_reuploads;
+	uint64_t texture_evictions;
+	// Where the sprite dump sweep continues next frame
+	int dump_sweep_cursor;
+
+	void linkResident(GameSprite::Image* img);
+	void unlinkResident(GameSprite::Image* img);
+	void touchResident(GameSprite::Image* img);
 
 	wxStopWatch* animation_timer;
 
+	friend class GameSprite;
 	friend class GameSprite::Image;
 	friend class GameSprite::NormalImage;
 	friend class GameSprite::TemplateImage;
@@ -20,11 +20,14 @@
 #include "ground_brush.h"
 #include "items.h"
 #include "basemap.h"
-
-static thread_local std::set<Position> processing_tiles;
+#include "trace.h"
 
 uint32_t GroundBrush::border_types[256];
 
+std::vector<uint16_t> GroundBrush::border_table;
+std::vector<const GroundBrush::BorderBlock*> GroundBrush::border_blocks;
+uint32_t GroundBrush::border_table_size = 0;
+
 int AutoBorder::edgeNameToID(const std::string& edgename) {
 	if (edgename == "n") {
 		return NORTH_HORIZONTAL;
@@ -124,7 +127,8 @@ GroundBrush::GroundBrush() :
 	optional_border(nullptr),
 	use_only_optional(false),
 	randomize(true),
-	total_chance(0) {
+	total_chance(0),
+	table_index(0) {
 	////
 }
 
@@ -587,9 +591,7 @@ void GroundBrush::draw(BaseMap* map, Tile* tile, void* parameter) {
 	while (it != tile->items.end()) {
 		Item* item = *it;
 		if (item && (item->isGroundTile() || item->getGroundEquivalent() != 0)) {
-#ifdef __WXDEBUG__
-			printf("DEBUG: Removing misplaced ground item with ID %d from tile items\n", item->getID());
-#endif
+			TRACE_DEBUG(Autoborder, "Removing misplaced ground item with ID %d from tile items", item->getID());
 			delete item;
 			it = tile->items.erase(it);
 		} else {
@@ -601,7 +603,71 @@ void GroundBrush::draw(BaseMap* map, Tile* tile, void* parameter) {
 	tile->ground = groundItem;
 }
 
+void GroundBrush::compileBorderTable() {
+	clearBorderTable();
+
+	// Index 0 stands for tiles without a ground brush
+	std::vector<GroundBrush*> grounds(1, nullptr);
+	for (const auto& brushEntry : g_brushes.getMap()) {
+		GroundBrush* ground = brushEntry.second->asGround();
+		if (ground && ground->table_index == 0) {
+			ground->table_index = grounds.size();
+			grounds.push_back(ground);
+		}
+	}
+
+	const size_t size = grounds.size();
+	std::vector<uint16_t> table(size * size, 0);
+	std::vector<const BorderBlock*> blocks(1, nullptr);
+	std::map<const BorderBlock*, uint16_t> block_indices;
+	for (size_t from = 0; from < size; ++from) {
+		for (size_t to = 0; to < size; ++to) {
+			const BorderBlock* borderBlock = resolveBorder(grounds[from], grounds[to]);
+			if (!borderBlock) {
+				continue;
+			}
+
+			auto it = block_indices.find(borderBlock);
+			if (it == block_indices.end()) {
+				if (blocks.size() > 0xFFFF) {
+					// Too many to index, getBrushTo keeps resolving them on every call
+					clearBorderTable();
+					return;
+				}
+				it = block_indices.emplace(borderBlock, uint16_t(blocks.size())).first;
+				blocks.push_back(borderBlock);
+			}
+			table[from * size + to] = it->second;
+		}
+	}
+
+	border_table.swap(table);
+	border_blocks.swap(blocks);
+	border_table_size = size;
+}
+
+void GroundBrush::clearBorderTable() {
+	for (const auto& brushEntry : g_brushes.getMap()) {
+		if (GroundBrush* ground = brushEntry.second->asGround()) {
+			ground->table_index = 0;
+		}
+	}
+	border_table.clear();
+	border_blocks.clear();
+	border_table_size = 0;
+}
+
 const GroundBrush::BorderBlock* GroundBrush::getBrushTo(GroundBrush* first, GroundBrush* second) {
+	const uint32_t from = first ? first->table_index : 0;
+	const uint32_t to = second ? second->table_index : 0;
+	// Brushes loaded after the table was compiled have no index yet
+	if ((!first || from != 0) && (!second || to != 0) && from < border_table_size && to < border_table_size) {
+		return border_blocks[border_table[from * border_table_size + to]];
+	}
+	return resolveBorder(first, second);
+}
+
+const GroundBrush::BorderBlock* GroundBrush::resolveBorder(GroundBrush* first, GroundBrush* second) {
 	// printf("Border from %s to %s : ", first->getName().c_str(), second->getName().c_str());
 	if (first) {
 		if (second) {
@@ -670,37 +736,16 @@ const GroundBrush::BorderBlock* GroundBrush::getBrushTo(GroundBrush* first, Grou
 }
 
 void GroundBrush::doBorders(BaseMap* map, Tile* tile) {
-	// Add debugging output for border operation
-	char debug_msg[512];
-	sprintf(debug_msg, "DEBUG DRAG: GroundBrush::doBorders called on tile at pos=(%d,%d,%d)\n", 
-		tile->getPosition().x, tile->getPosition().y, tile->getPosition().z);
-	OutputDebugStringA(debug_msg);
-	
-	// Prevent infinite recursion
-	if (processing_tiles.count(tile->getPosition()) > 0) {
-		sprintf(debug_msg, "DEBUG DRAG: Preventing recursion for tile at pos=(%d,%d,%d)\n", 
-			tile->getPosition().x, tile->getPosition().y, tile->getPosition().z);
-		OutputDebugStringA(debug_msg);
-		return;
-	}
-	processing_tiles.insert(tile->getPosition());
-	
 	if (!tile || !tile->ground) {
-		OutputDebugStringA("DEBUG DRAG: doBorders called on tile with no ground, skipping\n");
 		return;
 	}
-		
+
 	// Check if custom border is enabled and apply it
 	if (g_settings.getBoolean(Config::CUSTOM_BORDER_ENABLED)) {
 		int customBorderId = g_settings.getInteger(Config::CUSTOM_BORDER_ID);
-		sprintf(debug_msg, "DEBUG DRAG: Using custom border ID: %d\n", customBorderId);
-		OutputDebugStringA(debug_msg);
 		
 		auto it = g_brushes.borders.find(customBorderId);
 		if (it == g_brushes.borders.end() || !it->second) {
-			sprintf(debug_msg, "DEBUG DRAG: Custom border ID %d not found\n", customBorderId);
-			OutputDebugStringA(debug_msg);
-			processing_tiles.erase(tile->getPosition());
 			return; // Border ID not found
 		}
 		
@@ -712,8 +757,6 @@ void GroundBrush::doBorders(BaseMap* map, Tile* tile) {
 		uint32_t y = position.y;
 		uint32_t z = position.z;
 		
-		sprintf(debug_msg, "DEBUG DRAG: Processing neighbors for tile at (%u,%u,%u)\n", x, y, z);
-		OutputDebugStringA(debug_msg);
 		
 		// Check the 8 surrounding tiles for ground, to apply borders where there's no ground
 		// We mark each position as true if it needs a border (no ground or different ground)
@@ -768,14 +811,9 @@ void GroundBrush::doBorders(BaseMap* map, Tile* tile) {
 			}
 		}
 		
-		sprintf(debug_msg, "DEBUG DRAG: Calculated tiledata=%u (0x%X) for custom border\n", tiledata, tiledata);
-		OutputDebugStringA(debug_msg);
 		
 		// Check for potential division by zero in border_types lookup
 		if (tiledata >= 256) {
-			sprintf(debug_msg, "DEBUG DRAG: ERROR! tiledata %u >= 256, this could cause buffer overflow!\n", tiledata);
-			OutputDebugStringA(debug_msg);
-			processing_tiles.erase(tile->getPosition());
 			return;
 		}
 		
@@ -788,9 +826,6 @@ void GroundBrush::doBorders(BaseMap* map, Tile* tile) {
 			static_cast<BorderType>((border_types[tiledata] & 0xFF000000) >> 24)
 		};
 		
-		sprintf(debug_msg, "DEBUG DRAG: Border directions: [%d,%d,%d,%d]\n", 
-			directions[0], directions[1], directions[2], directions[3]);
-		OutputDebugStringA(debug_msg);
 		
 		// Apply the appropriate borders
 		for (int i = 0; i < 4; ++i) {
@@ -880,7 +915,6 @@ void GroundBrush::doBorders(BaseMap* map, Tile* tile) {
 		}
 		
 		// Early return, don't proceed with normal border handling
-		processing_tiles.erase(tile->getPosition());
 		return;
 	}
 	
@@ -1012,10 +1046,33 @@ void GroundBrush::doBorders(BaseMap* map, Tile* tile) {
 		}
 	}
 
-	static std::vector<const BorderBlock*> specificList;
+	// Nothing to add when every neighbour has the tile's own brush, and nothing
+	// to clean up either unless the tile carries borders
+	bool uniform = true;
+	for (const auto& neighbourPair : neighbours) {
+		if (!neighbourPair.first && neighbourPair.second != borderBrush) {
+			uniform = false;
+			break;
+		}
+	}
+	if (uniform && !g_settings.getBoolean(Config::SAME_GROUND_TYPE_BORDER)) {
+		for (const Item* item : tile->items) {
+			if (item->isBorder()) {
+				uniform = false;
+				break;
+			}
+		}
+	}
+	if (uniform) {
+		return;
+	}
+
+	// Reused between calls so the common case does not allocate
+	static thread_local std::vector<const BorderBlock*> specificList;
 	specificList.clear();
 
-	std::vector<BorderCluster> borderList;
+	static thread_local std::vector<BorderCluster> borderList;
+	borderList.clear();
 	for (int32_t i = 0; i < 8; ++i) {
 		auto& neighbourPair = neighbours[i];
 		if (neighbourPair.first) {
@@ -1397,13 +1454,12 @@ void GroundBrush::doBorders(BaseMap* map, Tile* tile) {
 	}
 
 	// Remove tile from processing set when done
-	processing_tiles.erase(tile->getPosition());
 }
 
 // Add a custom method to reset borderize for the auto-magic behavior
 void GroundBrush::reborderizeTile(BaseMap* map, Tile* tile) {
 	if (!tile || !tile->ground) {
-		OutputDebugStringA("DEBUG DRAG: reborderizeTile called on tile with no ground, skipping\n");
+		TRACE_DEBUG(Autoborder, "reborderizeTile called on tile with no ground, skipping");
 		return;
 	}
 
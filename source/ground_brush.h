@@ -45,6 +45,10 @@ public:
 	virtual void undraw(BaseMap* map, Tile* tile);
 	static void doBorders(BaseMap* map, Tile* tile);
 	static const BorderBlock* getBrushTo(GroundBrush* from, GroundBrush* to);
+	// Resolves getBrushTo for every pair of loaded ground brushes up front,
+	// must be called again whenever brushes are added or removed
+	static void compileBorderTable();
+	static void clearBorderTable();
 	static void reborderizeTile(BaseMap* map, Tile* tile);
 
 	virtual int32_t getZ() const {
@@ -119,9 +123,18 @@ protected: // Members
 		}
 	};
 
+	static const BorderBlock* resolveBorder(GroundBrush* from, GroundBrush* to);
+
 	std::vector<BorderBlock*> borders;
 	std::vector<ItemChanceBlock> border_items;
 	int total_chance;
+	// Row and column of the brush in the border table, 0 is "no ground"
+	uint32_t table_index;
+
+	// (from, to) -> index in border_blocks, border_table_size x border_table_size entries
+	static std::vector<uint16_t> border_table;
+	static std::vector<const BorderBlock*> border_blocks;
+	static uint32_t border_table_size;
 
 public: // Static global members
 	static uint32_t border_types[256];
@@ -2071,10 +2071,11 @@ void GUI::SetLoadScale(int32_t from, int32_t to) {
 
 bool GUI::SetLoadDone(int32_t done, const wxString& newMessage) {
 	if (done == 100) {
+		const bool cancelled = progressBar && progressBar->WasCancelled();
 		DestroyLoadBar();
-		return true;
+		return !cancelled;
 	} else if (done == currentProgress) {
-		return true;
+		return !(progressBar && progressBar->WasCancelled());
 	}
 
 	if (!newMessage.empty()) {
@@ -2084,12 +2085,11 @@ bool GUI::SetLoadDone(int32_t done, const wxString& newMessage) {
 	int32_t newProgress = progressFrom + static_cast<int32_t>((done / 100.f) * (progressTo - progressFrom));
 	newProgress = std::max<int32_t>(0, std::min<int32_t>(100, newProgress));
 
-	bool skip = false;
+	bool keep_going = true;
 	if (progressBar) {
-		progressBar->Update(
+		keep_going = progressBar->Update(
 			newProgress,
-			wxString::Format("%s (%d%%)", progressText, newProgress),
-			&skip
+			wxString::Format("%s (%d%%)", progressText, newProgress)
 		);
 		currentProgress = newProgress;
 	}
@@ -2104,7 +2104,7 @@ bool GUI::SetLoadDone(int32_t done, const wxString& newMessage) {
 		}
 	}
 
-	return skip;
+	return keep_going;
 }
 
 void GUI::DestroyLoadBar() {
@@ -2249,6 +2249,7 @@ void GUI::EndPasting() {
 	if (pasting) {
 		pasting = false;
 		secondary_map = nullptr;
+		copybuffer.releaseBufferMap();
 	}
 }
 
@@ -2467,9 +2468,7 @@ void GUI::SetDrawingMode() {
 void GUI::SetBrushSizeInternal(int nz) {
 	// Add safety check to prevent brush_size from being 0
 	if (nz < 0) {
-		char debug_msg[256];
-		sprintf(debug_msg, "DEBUG DRAG: WARNING! SetBrushSizeInternal called with negative value %d - FORCING TO 0\n", nz);
-		OutputDebugStringA(debug_msg);
+		TRACE_WARNING(Drawing, "SetBrushSizeInternal called with negative value %d - FORCING TO 0", nz);
 		nz = 0; // Minimum valid brush_size index
 	}
 	
@@ -2480,10 +2479,7 @@ void GUI::SetBrushSizeInternal(int nz) {
 	int actual_height = GetBrushHeight();
 	
 	if (actual_width <= 0 || actual_height <= 0) {
-		char debug_msg[512];
-		sprintf(debug_msg, "DEBUG DRAG: CRITICAL ERROR! SetBrushSizeInternal resulted in invalid dimensions: width=%d, height=%d, brush_size=%d\n", 
-			actual_width, actual_height, brush_size);
-		OutputDebugStringA(debug_msg);
+		TRACE_ERROR(Drawing, "SetBrushSizeInternal resulted in invalid dimensions: width=%d, height=%d, brush_size=%d", actual_width, actual_height, brush_size);
 		
 		// Force to safe values
 		if (actual_width <= 0) brush_size = 0; // Reset to minimal safe brush size
@@ -2494,9 +2490,7 @@ void GUI::SetBrushSizeInternal(int nz) {
 void GUI::SetBrushSize(int nz) {
 	// CRITICAL FIX: Prevent brush_size from being set to invalid values
 	if (nz < 0) {
-		char debug_msg[256];
-		sprintf(debug_msg, "DEBUG DRAG: WARNING! SetBrushSize called with negative value %d - FORCING TO 0\n", nz);
-		OutputDebugStringA(debug_msg);
+		TRACE_WARNING(Drawing, "SetBrushSize called with negative value %d - FORCING TO 0", nz);
 		nz = 0; // Minimum valid brush_size index
 	}
 	
@@ -2507,10 +2501,7 @@ void GUI::SetBrushSize(int nz) {
 	int actual_height = GetBrushHeight();
 	
 	if (actual_width <= 0 || actual_height <= 0) {
-		char debug_msg[512];
-		sprintf(debug_msg, "DEBUG DRAG: CRITICAL ERROR! SetBrushSize resulted in invalid dimensions: width=%d, height=%d, brush_size=%d\n", 
-			actual_width, actual_height, brush_size);
-		OutputDebugStringA(debug_msg);
+		TRACE_ERROR(Drawing, "SetBrushSize resulted in invalid dimensions: width=%d, height=%d, brush_size=%d", actual_width, actual_height, brush_size);
 		
 		// Force to safe values
 		if (actual_width <= 0) brush_size = 0; // Reset to minimal safe brush size
@@ -3106,6 +3097,31 @@ int GUI::GetHotkeyEventId(const std::string& action) {
 	return -1; // Temporary return until implementation
 }
 
+bool GUI::BuildItemIndexes() {
+	// Milliseconds spent per map and idle event, short enough to keep the
+	// editor responsive while the index of a large map is built
+	const int budget = 8;
+
+	if (!tabbook) {
+		return false;
+	}
+
+	bool pending = false;
+	for (int i = 0; i < tabbook->GetTabCount(); ++i) {
+		MapTab* tab = dynamic_cast<MapTab*>(tabbook->GetTab(i));
+		if (!tab) {
+			continue;
+		}
+
+		Map& map = tab->GetEditor()->map;
+		std::shared_ptr<ItemIndex> index = map.getItemIndex();
+		if (index && !index->isReady() && !index->build(map, budget)) {
+			pending = true;
+		}
+	}
+	return pending;
+}
+
 void GUI::CheckAutoSave() {
 	uint32_t now = time(nullptr);
 	
@@ -3440,9 +3456,7 @@ void GUI::SetCustomBrushSize(bool enable, int width, int height) {
 	if (width != -1) {
 		// CRITICAL FIX: Prevent zero or negative width
 		if (width <= 0) {
-			char debug_msg[256];
-			sprintf(debug_msg, "DEBUG DRAG: WARNING! SetCustomBrushSize called with invalid width %d - FORCING TO 1\n", width);
-			OutputDebugStringA(debug_msg);
+			TRACE_WARNING(Drawing, "SetCustomBrushSize called with invalid width %d - FORCING TO 1", width);
 			width = 1;
 		}
 		custom_brush_width = width;
@@ -3451,9 +3465,7 @@ void GUI::SetCustomBrushSize(bool enable, int width, int height) {
 	if (height != -1) {
 		// CRITICAL FIX: Prevent zero or negative height
 		if (height <= 0) {
-			char debug_msg[256];
-			sprintf(debug_msg, "DEBUG DRAG: WARNING! SetCustomBrushSize called with invalid height %d - FORCING TO 1\n", height);
-			OutputDebugStringA(debug_msg);
+			TRACE_WARNING(Drawing, "SetCustomBrushSize called with invalid height %d - FORCING TO 1", height);
 			height = 1;
 		}
 		custom_brush_height = height;
@@ -3461,16 +3473,12 @@ void GUI::SetCustomBrushSize(bool enable, int width, int height) {
 	
 	// ENHANCED FIX: Always validate current brush dimensions
 	if (custom_brush_width <= 0) {
-		char debug_msg[256];
-		sprintf(debug_msg, "DEBUG DRAG: CRITICAL ERROR! custom_brush_width is %d - FORCING TO 1\n", custom_brush_width);
-		OutputDebugStringA(debug_msg);
+		TRACE_ERROR(Drawing, "custom_brush_width is %d - FORCING TO 1", custom_brush_width);
 		custom_brush_width = 1;
 	}
 	
 	if (custom_brush_height <= 0) {
-		char debug_msg[256];
-		sprintf(debug_msg, "DEBUG DRAG: CRITICAL ERROR! custom_brush_height is %d - FORCING TO 1\n", custom_brush_height);
-		OutputDebugStringA(debug_msg);
+		TRACE_ERROR(Drawing, "custom_brush_height is %d - FORCING TO 1", custom_brush_height);
 		custom_brush_height = 1;
 	}
 	
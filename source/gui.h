@@ -33,6 +33,7 @@
 #include "monster_manager.h"
 #include "npc_manager.h"
 #include "monster_maker_window.h"
+#include "trace.h"
 #include <memory> // For smart pointers
 
 class BaseMap;
@@ -560,6 +561,8 @@ public:
 	std::map<Editor*, std::list<MapWindow*>> dockable_views;
 
 	void CheckAutoSave();
+	// Indexes a slice of every open map, returns true while work is left
+	bool BuildItemIndexes();
 	uint32_t last_autosave;
 	uint32_t last_autosave_check;
 
@@ -586,9 +589,7 @@ public:
 		if (use_custom_brush_size && brush_shape == BRUSHSHAPE_SQUARE) {
 			int result = custom_brush_width;
 			if (result <= 0) {
-				char debug_msg[256];
-				sprintf(debug_msg, "DEBUG DRAG: WARNING! GetBrushWidth custom returning %d - FORCING TO 1\n", result);
-				OutputDebugStringA(debug_msg);
+				TRACE_WARNING(Drawing, "GetBrushWidth custom returning %d - FORCING TO 1", result);
 				result = 1; // Force minimum safe value to prevent division by zero
 			}
 			return result;
@@ -614,9 +615,7 @@ public:
 		if (use_custom_brush_size && brush_shape == BRUSHSHAPE_SQUARE) {
 			int result = custom_brush_height;
 			if (result <= 0) {
-				char debug_msg[256];
-				sprintf(debug_msg, "DEBUG DRAG: WARNING! GetBrushHeight custom returning %d - FORCING TO 1\n", result);
-				OutputDebugStringA(debug_msg);
+				TRACE_WARNING(Drawing, "GetBrushHeight custom returning %d - FORCING TO 1", result);
 				result = 1; // Force minimum safe value to prevent division by zero
 			}
 			return result;
@@ -110,6 +110,7 @@ enum EditorActionID {
 
 	MAP_WINDOW_FILE_BUTTON,
 	TILESET_FILE_BUTTON,
+	MAP_RENDER_FILE_BUTTON,
 
 	PALETTE_ITEM_CHOICEBOOK,
 	PALETTE_CHOICEBOOK,
@@ -0,0 +1,265 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+
+#include "main.h"
+
+#include "item_index.h"
+#include "map.h"
+#include "map_region.h"
+
+#include <algorithm>
+#include <chrono>
+
+ItemIndex::ItemIndex() :
+	next_block(0),
+	items(0x10000),
+	item_totals(0x10000, 0) {
+	////
+}
+
+bool ItemIndex::build(BaseMap& map, int budget_ms) {
+	const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(budget_ms);
+	while (next_block < BlockCount) {
+		indexBlock(map, next_block);
+		++next_block;
+		if (std::chrono::steady_clock::now() >= deadline) {
+			break;
+		}
+	}
+	return isReady();
+}
+
+void ItemIndex::invalidate() {
+	next_block = 0;
+	items.assign(0x10000, AreaCounts());
+	std::fill(item_totals.begin(), item_totals.end(), 0);
+	action_ids.clear();
+	unique_ids.clear();
+}
+
+void ItemIndex::indexBlock(BaseMap& map, int block) {
+	const int block_x = (block & ((0x10000 >> BlockShift) - 1)) << BlockShift;
+	const int block_y = (block >> (16 - BlockShift)) << BlockShift;
+	if (!map.getNode(block_x, block_y, BlockSize)) {
+		return;
+	}
+
+	for (int y = block_y; y < block_y + BlockSize; y += 4) {
+		for (int x = block_x; x < block_x + BlockSize; x += 4) {
+			QTreeNode* leaf = map.getLeaf(x, y);
+			if (!leaf) {
+				continue;
+			}
+
+			for (int z = 0; z < MAP_LAYERS; ++z) {
+				Floor* floor = leaf->getFloor(z);
+				if (!floor) {
+					continue;
+				}
+				for (TileLocation& location : floor->locs) {
+					if (Tile* tile = location.get()) {
+						addTile(location.getPosition(), tile, 1);
+					}
+				}
+			}
+		}
+	}
+}
+
+void ItemIndex::onTileChanged(const Position& pos, Tile* oldtile, Tile* newtile) {
+	if (getBlock(pos.x, pos.y) >= next_block) {
+		// Picked up once the builder gets there
+		return;
+	}
+
+	if (oldtile) {
+		addTile(pos, oldtile, -1);
+	}
+	if (newtile) {
+		addTile(pos, newtile, 1);
+	}
+}
+
+void ItemIndex::onItemRemoved(const Position& pos, Item* item) {
+	if (getBlock(pos.x, pos.y) >= next_block) {
+		return;
+	}
+
+	const uint32_t area = makeAreaKey(pos.x, pos.y, pos.z);
+	auto remove = [&](Item* nested) {
+		addItem(area, nested, -1);
+		return true;
+	};
+	foreach_ItemInItem(item, remove);
+}
+
+void ItemIndex::onItemIdChanged(const Position& pos, uint16_t old_id, uint16_t new_id) {
+	if (getBlock(pos.x, pos.y) >= next_block) {
+		return;
+	}
+
+	const uint32_t area = makeAreaKey(pos.x, pos.y, pos.z);
+	addCount(items[old_id], area, -1);
+	if (item_totals[old_id] > 0) {
+		--item_totals[old_id];
+	}
+	addCount(items[new_id], area, 1);
+	++item_totals[new_id];
+}
+
+void ItemIndex::addTile(const Position& pos, Tile* tile, int delta) {
+	const uint32_t area = makeAreaKey(pos.x, pos.y, pos.z);
+	auto add = [&](Item* item) {
+		addItem(area, item, delta);
+		return true;
+	};
+	foreach_ItemOnTile(tile, add);
+}
+
+void ItemIndex::addItem(uint32_t area, Item* item, int delta) {
+	const uint16_t id = item->getID();
+	addCount(items[id], area, delta);
+	if (delta > 0 || item_totals[id] >= uint64_t(-delta)) {
+		item_totals[id] += delta;
+	}
+
+	if (uint16_t action_id = item->getActionID()) {
+		AreaCounts& counts = action_ids[action_id];
+		addCount(counts, area, delta);
+		if (counts.empty()) {
+			action_ids.erase(action_id);
+		}
+	}
+
+	if (uint16_t unique_id = item->getUniqueID()) {
+		AreaCounts& counts = unique_ids[unique_id];
+		addCount(counts, area, delta);
+		if (counts.empty()) {
+			unique_ids.erase(unique_id);
+		}
+	}
+}
+
+void ItemIndex::addCount(AreaCounts& counts, uint32_t area, int delta) {
+	if (delta > 0) {
+		counts[area] += delta;
+		return;
+	}
+
+	auto it = counts.find(area);
+	if (it == counts.end()) {
+		// The item was added in place without being reported, nothing to take back
+		return;
+	}
+	if (it->second <= uint32_t(-delta)) {
+		counts.erase(it);
+	} else {
+		it->second += delta;
+	}
+}
+
+bool ItemIndex::findItems(BaseMap& map, uint16_t id, const FoundCallback& found) const {
+	if (!isReady()) {
+		return false;
+	}
+
+	std::vector<uint32_t> areas;
+	areas.reserve(items[id].size());
+	for (const auto& area : items[id]) {
+		areas.push_back(area.first);
+	}
+	scanAreas(map, areas, [id](const Item* item) { return item->getID() == id; }, found);
+	return true;
+}
+
+bool ItemIndex::findActionIDs(BaseMap& map, const IdFilter& accept, const FoundCallback& found) const {
+	if (!isReady()) {
+		return false;
+	}
+
+	std::vector<uint32_t> areas;
+	collectAreas(action_ids, accept, areas);
+	scanAreas(map, areas, [&accept](const Item* item) {
+		const uint16_t action_id = item->getActionID();
+		return action_id != 0 && accept(action_id);
+	}, found);
+	return true;
+}
+
+bool ItemIndex::findUniqueIDs(BaseMap& map, const IdFilter& accept, const FoundCallback& found) const {
+	if (!isReady()) {
+		return false;
+	}
+
+	std::vector<uint32_t> areas;
+	collectAreas(unique_ids, accept, areas);
+	scanAreas(map, areas, [&accept](const Item* item) {
+		const uint16_t unique_id = item->getUniqueID();
+		return unique_id != 0 && accept(unique_id);
+	}, found);
+	return true;
+}
+
+void ItemIndex::collectAreas(const std::unordered_map<uint16_t, AreaCounts>& index, const IdFilter& accept, std::vector<uint32_t>& areas) {
+	for (const auto& entry : index) {
+		if (!accept(entry.first)) {
+			continue;
+		}
+		for (const auto& area : entry.second) {
+			areas.push_back(area.first);
+		}
+	}
+}
+
+bool ItemIndex::scanAreas(BaseMap& map, std::vector<uint32_t>& areas, const std::function<bool(const Item*)>& match, const FoundCallback& found) const {
+	// Sorted keys go floor by floor, then row by row
+	std::sort(areas.begin(), areas.end());
+	areas.erase(std::unique(areas.begin(), areas.end()), areas.end());
+
+	for (uint32_t area : areas) {
+		const int area_x = int(area & 0xFFF) << AreaShift;
+		const int area_y = int((area >> 12) & 0xFFF) << AreaShift;
+		const int z = int(area >> 24);
+
+		for (int leaf_y = area_y; leaf_y < area_y + AreaSize; leaf_y += 4) {
+			Floor* floors[AreaSize / 4];
+			for (int i = 0; i < AreaSize / 4; ++i) {
+				QTreeNode* leaf = map.getLeaf(area_x + i * 4, leaf_y);
+				floors[i] = leaf ? leaf->getFloor(z) : nullptr;
+			}
+
+			for (int y = leaf_y; y < leaf_y + 4; ++y) {
+				for (int x = area_x; x < area_x + AreaSize; ++x) {
+					Floor* floor = floors[(x - area_x) >> 2];
+					Tile* tile = floor ? floor->locs[(x & 3) * 4 + (y & 3)].get() : nullptr;
+					if (!tile) {
+						continue;
+					}
+
+					auto visit = [&](Item* item) {
+						return !match(item) || found(tile, item);
+					};
+					if (!foreach_ItemOnTile(tile, visit)) {
+						return false;
+					}
+				}
+			}
+		}
+	}
+	return true;
+}
@@ -0,0 +1,115 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+
+#ifndef RME_ITEM_INDEX_H_
+#define RME_ITEM_INDEX_H_
+
+#include "position.h"
+
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+class BaseMap;
+class Tile;
+class Item;
+
+// Map-wide index from item ids, action ids and unique ids to the areas of the
+// map holding them. An area is AreaSize x AreaSize tiles of one floor and the
+// index keeps how many matching items every area has, items in containers
+// included. Queries only look at the tiles of those areas, so they are exact
+// and cost nothing for ids that are not on the map.
+//
+// The index is built in slices from the idle handler after the map is loaded,
+// one block of BlockSize x BlockSize columns at a time, and follows every tile
+// swapped in or out of the map afterwards. Edits that change the items of a
+// tile in place have to report them through onItemRemoved, onItemIdChanged or
+// invalidate.
+class ItemIndex {
+public:
+	static constexpr int AreaShift = 4;
+	static constexpr int AreaSize = 1 << AreaShift;
+	static constexpr int BlockShift = 8;
+	static constexpr int BlockSize = 1 << BlockShift;
+	static constexpr int BlockCount = (0x10000 >> BlockShift) * (0x10000 >> BlockShift);
+
+	// Returning false stops the search
+	typedef std::function<bool(Tile*, Item*)> FoundCallback;
+	typedef std::function<bool(uint16_t)> IdFilter;
+
+	ItemIndex();
+
+	ItemIndex(const ItemIndex&) = delete;
+	ItemIndex& operator=(const ItemIndex&) = delete;
+
+	bool isReady() const noexcept {
+		return next_block == BlockCount;
+	}
+	// Indexes blocks until budget_ms passed, returns true once the whole map is indexed
+	bool build(BaseMap& map, int budget_ms);
+	// Drops everything and builds the index again from the start
+	void invalidate();
+
+	// Called whenever the tile at pos is replaced, either tile may be null
+	void onTileChanged(const Position& pos, Tile* oldtile, Tile* newtile);
+	// An item (and its contents) was taken off the tile at pos in place
+	void onItemRemoved(const Position& pos, Item* item);
+	// An item of the tile at pos got another id in place
+	void onItemIdChanged(const Position& pos, uint16_t old_id, uint16_t new_id);
+
+	// The searches return false without calling found while the index is not
+	// ready, the caller has to scan the map itself then. Matches are reported
+	// floor by floor and area by area, in stacking order within a tile.
+	bool findItems(BaseMap& map, uint16_t id, const FoundCallback& found) const;
+	bool findActionIDs(BaseMap& map, const IdFilter& accept, const FoundCallback& found) const;
+	bool findUniqueIDs(BaseMap& map, const IdFilter& accept, const FoundCallback& found) const;
+
+	// Number of items with that id on the map
+	uint64_t getItemCount(uint16_t id) const {
+		return item_totals[id];
+	}
+
+private:
+	// Matching items per area key
+	typedef std::unordered_map<uint32_t, uint32_t> AreaCounts;
+
+	static uint32_t makeAreaKey(int x, int y, int z) noexcept {
+		return uint32_t(x >> AreaShift) | (uint32_t(y >> AreaShift) << 12) | (uint32_t(z) << 24);
+	}
+	static int getBlock(int x, int y) noexcept {
+		return ((y >> BlockShift) << (16 - BlockShift)) | (x >> BlockShift);
+	}
+
+	void indexBlock(BaseMap& map, int block);
+	void addTile(const Position& pos, Tile* tile, int delta);
+	void addItem(uint32_t area, Item* item, int delta);
+	static void addCount(AreaCounts& counts, uint32_t area, int delta);
+	static void collectAreas(const std::unordered_map<uint16_t, AreaCounts>& index, const IdFilter& accept, std::vector<uint32_t>& areas);
+	bool scanAreas(BaseMap& map, std::vector<uint32_t>& areas, const std::function<bool(const Item*)>& match, const FoundCallback& found) const;
+
+	// Blocks below this one are indexed and kept up to date
+	int next_block;
+
+	std::vector<AreaCounts> items;
+	std::vector<uint64_t> item_totals;
+	std::unordered_map<uint16_t, AreaCounts> action_ids;
+	std::unordered_map<uint16_t, AreaCounts> unique_ids;
+};
+
+#endif
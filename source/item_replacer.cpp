@@ -0,0 +1,161 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+
+#include "main.h"
+
+#include "item_replacer.h"
+#include "map_search.h"
+#include "editor.h"
+#include "action.h"
+#include "items.h"
+
+namespace {
+	// The class Item::Create picks for an id, an item can only change its id
+	// in place if the new id picks the same one
+	enum ItemClass {
+		ITEM_CLASS_PLAIN,
+		ITEM_CLASS_DEPOT,
+		ITEM_CLASS_CONTAINER,
+		ITEM_CLASS_TELEPORT,
+		ITEM_CLASS_DOOR,
+		ITEM_CLASS_PODIUM,
+	};
+
+	ItemClass getItemClass(uint16_t id) {
+		const ItemType& type = g_items[id];
+		if (type.id == 0) {
+			return ITEM_CLASS_PLAIN;
+		} else if (type.isDepot()) {
+			return ITEM_CLASS_DEPOT;
+		} else if (type.isContainer()) {
+			return ITEM_CLASS_CONTAINER;
+		} else if (type.isTeleport()) {
+			return ITEM_CLASS_TELEPORT;
+		} else if (type.isDoor()) {
+			return ITEM_CLASS_DOOR;
+		} else if (type.isPodium()) {
+			return ITEM_CLASS_PODIUM;
+		}
+		return ITEM_CLASS_PLAIN;
+	}
+}
+
+ItemReplacer::ItemReplacer(Editor& editor) :
+	editor(editor),
+	table(0x10000, 0),
+	replaced(0x10000, 0) {
+	////
+}
+
+void ItemReplacer::addRule(uint16_t from, uint16_t to) {
+	table[from] = from == to ? 0 : to;
+}
+
+size_t ItemReplacer::run(bool selected_only, size_t max_per_rule, const std::function<void(int)>& progress) {
+	std::fill(replaced.begin(), replaced.end(), 0);
+
+	// Matches come in block order, so the limit always keeps the same items
+	std::vector<MapSearch::Match> matches;
+	MapSearch search(editor.map);
+	search.run([this](const Tile*, const Item* item) {
+		return table[item->getID()] != 0;
+	}, 0, selected_only, [&](const std::vector<MapSearch::Match>& batch, int percent) {
+		for (const MapSearch::Match& match : batch) {
+			uint32_t& count = replaced[match.second->getID()];
+			if (max_per_rule == 0 || count < max_per_rule) {
+				++count;
+				matches.push_back(match);
+			}
+		}
+		if (progress) {
+			progress(percent);
+		}
+		return true;
+	});
+
+	if (matches.empty()) {
+		return 0;
+	}
+
+	// Live clients send the tiles of tile changes to the server, so they keep
+	// replacing whole tiles
+	const bool in_place_allowed = !editor.IsLiveClient();
+
+	Action* action = editor.actionQueue->createAction(ACTION_REPLACE_ITEMS);
+	ItemIdChangeList in_place;
+	std::vector<uint32_t> indexes;
+	std::vector<Item*> copies;
+	for (size_t first = 0; first < matches.size();) {
+		Tile* tile = matches[first].first;
+		size_t end = first;
+		bool keep_class = in_place_allowed;
+		while (end < matches.size() && matches[end].first == tile) {
+			const uint16_t id = matches[end].second->getID();
+			keep_class = keep_class && getItemClass(id) == getItemClass(table[id]);
+			++end;
+		}
+
+		// The matches of a tile are in foreach_ItemOnTile order
+		indexes.clear();
+		uint32_t index = 0;
+		size_t next = first;
+		auto find = [&](Item* item) {
+			if (item == matches[next].second) {
+				indexes.push_back(index);
+				++next;
+			}
+			++index;
+			return next < end;
+		};
+		foreach_ItemOnTile(tile, find);
+		ASSERT(indexes.size() == end - first);
+
+		if (keep_class) {
+			for (size_t i = 0; i < indexes.size(); ++i) {
+				const uint16_t id = matches[first + i].second->getID();
+				in_place.push_back({ tile->getPosition(), indexes[i], id, table[id] });
+			}
+		} else {
+			Tile* new_tile = tile->deepCopy(editor.map);
+			copies.clear();
+			index = 0;
+			size_t picked = 0;
+			auto pick = [&](Item* item) {
+				if (index++ == indexes[picked]) {
+					copies.push_back(item);
+					++picked;
+				}
+				return picked < indexes.size();
+			};
+			foreach_ItemOnTile(new_tile, pick);
+
+			// Contents go before their container, transforming a container copies it
+			for (auto it = copies.rbegin(); it != copies.rend(); ++it) {
+				transformItem(*it, table[(*it)->getID()], new_tile);
+			}
+			action->addChange(newd Change(new_tile));
+		}
+		first = end;
+	}
+
+	if (!in_place.empty()) {
+		action->addChange(Change::Create(std::move(in_place)));
+	}
+	editor.actionQueue->addAction(action);
+	return matches.size();
+}
@@ -0,0 +1,59 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+
+#ifndef RME_ITEM_REPLACER_H_
+#define RME_ITEM_REPLACER_H_
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+class Editor;
+
+// Replaces item ids all over the map, or the selection, in one pass. The rules
+// are compiled into a table indexed by item id and the map is searched for
+// them on worker threads (see MapSearch). Items that keep their class are
+// recorded for undo as position, index and both ids only; items that turn
+// into another class (a container into a plain item for instance) replace
+// their tile with a modified copy as usual.
+class ItemReplacer {
+public:
+	explicit ItemReplacer(Editor& editor);
+
+	// A later rule for the same id replaces the earlier one
+	void addRule(uint16_t from, uint16_t to);
+
+	// Replaces at most max_per_rule items per rule (0 for no limit) and adds
+	// all of it to the action queue as one action. progress is called with
+	// values from 0 to 100 while the map is searched. Returns the number of
+	// items replaced.
+	size_t run(bool selected_only, size_t max_per_rule, const std::function<void(int)>& progress = nullptr);
+
+	// Items of that id replaced by the last run
+	uint32_t getReplacedCount(uint16_t from) const {
+		return replaced[from];
+	}
+
+private:
+	Editor& editor;
+	// New id for every id, 0 leaves the item alone
+	std::vector<uint16_t> table;
+	std::vector<uint32_t> replaced;
+};
+
+#endif
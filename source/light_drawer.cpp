@@ -18,9 +18,37 @@
 #include "main.h"
 #include "light_drawer.h"
 
-LightDrawer::LightDrawer() {
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#include <emmintrin.h>
+	#define RME_LIGHT_SSE2
+#endif
+
+namespace {
+	// Lights only ever brighten a tile, so blending is a per channel maximum
+	inline void blendMax(uint8_t* dst, const uint8_t* src, int pixels) {
+		int i = 0;
+#ifdef RME_LIGHT_SSE2
+		for (; i + 4 <= pixels; i += 4) {
+			__m128i* out = reinterpret_cast<__m128i*>(dst + i * PixelFormatRGBA);
+			const __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * PixelFormatRGBA));
+			_mm_storeu_si128(out, _mm_max_epu8(_mm_loadu_si128(out), in));
+		}
+#endif
+		for (int c = i * PixelFormatRGBA; c < pixels * PixelFormatRGBA; ++c) {
+			dst[c] = std::max(dst[c], src[c]);
+		}
+	}
+}
+
+LightDrawer::LightDrawer() :
+	cached_x(0),
+	cached_y(0),
+	cached_width(0),
+	cached_height(0),
+	cache_valid(false) {
 	texture = 0;
 	global_color = wxColor(50, 50, 50, 255);
+	buildFalloffTable();
 }
 
 LightDrawer::~LightDrawer() {
@@ -37,34 +65,12 @@ void LightDrawer::draw(int map_x, int map_y, int end_x, int end_y, int scroll_x,
 	int w = end_x - map_x;
 	int h = end_y - map_y;
 
-	buffer.resize(static_cast<size_t>(w * h * PixelFormatRGBA));
-
-	for (int x = 0; x < w; ++x) {
-		for (int y = 0; y < h; ++y) {
-			int mx = (map_x + x);
-			int my = (map_y + y);
-			int index = (y * w + x);
-			int color_index = index * PixelFormatRGBA;
-
-			buffer[color_index] = global_color.Red();
-			buffer[color_index + 1] = global_color.Green();
-			buffer[color_index + 2] = global_color.Blue();
-			buffer[color_index + 3] = 140; // global_color.Alpha();
-
-			for (auto& light : lights) {
-				float intensity = calculateIntensity(mx, my, light);
-				if (intensity == 0.f) {
-					continue;
-				}
-				wxColor light_color = colorFromEightBit(light.color);
-				uint8_t red = static_cast<uint8_t>(light_color.Red() * intensity);
-				uint8_t green = static_cast<uint8_t>(light_color.Green() * intensity);
-				uint8_t blue = static_cast<uint8_t>(light_color.Blue() * intensity);
-				buffer[color_index] = std::max(buffer[color_index], red);
-				buffer[color_index + 1] = std::max(buffer[color_index + 1], green);
-				buffer[color_index + 2] = std::max(buffer[color_index + 2], blue);
-			}
-		}
+	// Rebuilding and uploading the light map is skipped entirely while nothing
+	// that contributes to it changed, which is the common case when panning stops
+	const bool dirty = !cache_valid || map_x != cached_x || map_y != cached_y || w != cached_width || h != cached_height || global_color != cached_color || lights != cached_lights;
+
+	if (dirty) {
+		buildLightMap(map_x, map_y, w, h);
 	}
 
 	const int draw_x = map_x * TileSize - scroll_x;
@@ -74,11 +80,21 @@ void LightDrawer::draw(int map_x, int map_y, int end_x, int end_y, int scroll_x,
 
 	glBindTexture(GL_TEXTURE_2D, texture);
 
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, 0x812F);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, 0x812F);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, buffer.data());
+	if (dirty) {
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, 0x812F);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, 0x812F);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, buffer.data());
+
+		cached_lights = lights;
+		cached_x = map_x;
+		cached_y = map_y;
+		cached_width = w;
+		cached_height = h;
+		cached_color = global_color;
+		cache_valid = true;
+	}
 
 	if (!fog) {
 		glBlendFunc(GL_DST_COLOR, GL_ONE_MINUS_SRC_ALPHA);
@@ -111,6 +127,64 @@ void LightDrawer::draw(int map_x, int map_y, int end_x, int end_y, int scroll_x,
 	}
 }
 
+void LightDrawer::buildFalloffTable() {
+	falloff.resize(static_cast<size_t>((MaxLightIntensity + 1) * KernelSize * KernelSize));
+	for (int intensity = 0; intensity <= MaxLightIntensity; ++intensity) {
+		Light light;
+		light.map_x = MaxLightIntensity;
+		light.map_y = MaxLightIntensity;
+		light.intensity = intensity;
+		float* kernel = &falloff[intensity * KernelSize * KernelSize];
+		for (int y = 0; y < KernelSize; ++y) {
+			for (int x = 0; x < KernelSize; ++x) {
+				kernel[y * KernelSize + x] = calculateIntensity(x, y, light);
+			}
+		}
+	}
+}
+
+void LightDrawer::buildLightMap(int map_x, int map_y, int width, int height) {
+	buffer.resize(static_cast<size_t>(width * height * PixelFormatRGBA));
+
+	const uint8_t ambient[PixelFormatRGBA] = { global_color.Red(), global_color.Green(), global_color.Blue(), 140 }; // global_color.Alpha()
+	for (size_t i = 0; i < buffer.size(); i += PixelFormatRGBA) {
+		memcpy(&buffer[i], ambient, PixelFormatRGBA);
+	}
+
+	for (const Light& light : lights) {
+		splatLight(light, map_x, map_y, width, height);
+	}
+}
+
+void LightDrawer::splatLight(const Light& light, int map_x, int map_y, int width, int height) {
+	// No light reaches further than its intensity
+	const int radius = light.intensity;
+	const int left = std::max<int>(light.map_x - radius, map_x);
+	const int right = std::min<int>(light.map_x + radius, map_x + width - 1);
+	const int top = std::max<int>(light.map_y - radius, map_y);
+	const int bottom = std::min<int>(light.map_y + radius, map_y + height - 1);
+	if (radius == 0 || left > right || top > bottom) {
+		return;
+	}
+
+	const wxColor light_color = colorFromEightBit(light.color);
+	const float* kernel = &falloff[light.intensity * KernelSize * KernelSize];
+	const int span = right - left + 1;
+
+	uint8_t row[KernelSize * PixelFormatRGBA];
+	for (int y = top; y <= bottom; ++y) {
+		const float* kernel_row = kernel + (y - light.map_y + MaxLightIntensity) * KernelSize + (left - light.map_x + MaxLightIntensity);
+		for (int x = 0; x < span; ++x) {
+			const float intensity = kernel_row[x];
+			row[x * PixelFormatRGBA + 0] = static_cast<uint8_t>(light_color.Red() * intensity);
+			row[x * PixelFormatRGBA + 1] = static_cast<uint8_t>(light_color.Green() * intensity);
+			row[x * PixelFormatRGBA + 2] = static_cast<uint8_t>(light_color.Blue() * intensity);
+			row[x * PixelFormatRGBA + 3] = 0;
+		}
+		blendMax(&buffer[((y - map_y) * width + (left - map_x)) * PixelFormatRGBA], row, span);
+	}
+}
+
 void LightDrawer::setGlobalLightColor(uint8_t color) {
 	global_color = colorFromEightBit(color);
 }
@@ -151,4 +225,5 @@ void LightDrawer::unloadGLTexture() {
 	if (texture != 0) {
 		glDeleteTextures(1, &texture);
 	}
+	cache_valid = false;
 }
@@ -27,8 +27,15 @@ class LightDrawer {
 		uint16_t map_y = 0;
 		uint8_t color = 0;
 		uint8_t intensity = 0;
+
+		bool operator==(const Light& other) const noexcept {
+			return map_x == other.map_x && map_y == other.map_y && color == other.color && intensity == other.intensity;
+		}
 	};
 
+	// Side of the square a light can reach, centered on the light
+	static constexpr int KernelSize = MaxLightIntensity * 2 + 1;
+
 public:
 	LightDrawer();
 	virtual ~LightDrawer();
@@ -43,6 +50,10 @@ private:
 	void createGLTexture();
 	void unloadGLTexture();
 
+	void buildFalloffTable();
+	void buildLightMap(int map_x, int map_y, int width, int height);
+	void splatLight(const Light& light, int map_x, int map_y, int width, int height);
+
 	inline float calculateIntensity(int map_x, int map_y, const Light& light) {
 		int dx = map_x - light.map_x;
 		int dy = map_y - light.map_y;
@@ -61,6 +72,18 @@ private:
 	std::vector<Light> lights;
 	std::vector<uint8_t> buffer;
 	wxColor global_color;
+
+	// calculateIntensity for every offset inside the kernel, per light intensity
+	std::vector<float> falloff;
+
+	// The light map uploaded last, reused as long as neither the lights nor the view change
+	std::vector<Light> cached_lights;
+	int cached_x;
+	int cached_y;
+	int cached_width;
+	int cached_height;
+	wxColor cached_color;
+	bool cache_valid;
 };
 
 #endif
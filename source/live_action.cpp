@@ -19,6 +19,7 @@
 
 #include "live_action.h"
 #include "editor.h"
+#include "trace.h"
 
 NetworkedAction::NetworkedAction(Editor& editor, ActionIdentifier ident) :
 	Action(editor, ident),
@@ -31,12 +32,7 @@ NetworkedAction::~NetworkedAction() {
 		// Nothing specific to clean up here, base class will handle the changes
 	} catch (const std::exception& e) {
 		// Log error but don't crash
-		std::ofstream logFile((wxStandardPaths::Get().GetUserDataDir() + wxFileName::GetPathSeparator() + "action_error.log").ToStdString(), std::ios::app);
-		if (logFile.is_open()) {
-			wxDateTime now = wxDateTime::Now();
-			logFile << now.FormatISOCombined() << ": Error in NetworkedAction destructor: " << e.what() << "\n";
-			logFile.close();
-		}
+		TRACE_ERROR(Live, "Error in NetworkedAction destructor: %s", e.what());
 	}
 }
 
@@ -53,12 +49,7 @@ NetworkedBatchAction::~NetworkedBatchAction() {
 		// Nothing specific to clean up here, base class will handle the batch
 	} catch (const std::exception& e) {
 		// Log error but don't crash
-		std::ofstream logFile((wxStandardPaths::Get().GetUserDataDir() + wxFileName::GetPathSeparator() + "action_error.log").ToStdString(), std::ios::app);
-		if (logFile.is_open()) {
-			wxDateTime now = wxDateTime::Now();
-			logFile << now.FormatISOCombined() << ": Error in NetworkedBatchAction destructor: " << e.what() << "\n";
-			logFile.close();
-		}
+		TRACE_ERROR(Live, "Error in NetworkedBatchAction destructor: %s", e.what());
 	}
 }
 
@@ -90,12 +81,7 @@ void NetworkedBatchAction::addAndCommitAction(Action* action) {
 		}
 		catch (const std::exception& e) {
 			// Log error and clean up
-			std::ofstream logFile((wxStandardPaths::Get().GetUserDataDir() + wxFileName::GetPathSeparator() + "action_error.log").ToStdString(), std::ios::app);
-			if (logFile.is_open()) {
-				wxDateTime now = wxDateTime::Now();
-				logFile << now.FormatISOCombined() << ": Error committing action: " << e.what() << "\n";
-				logFile.close();
-			}
+			TRACE_ERROR(Live, "Error committing action: %s", e.what());
 			
 			// Clean up action if it wasn't added to batch
 			delete action;
@@ -105,33 +91,18 @@ void NetworkedBatchAction::addAndCommitAction(Action* action) {
 		// Broadcast changes to all clients!
 		try {
 			// Log that we're broadcasting changes
-			std::ofstream logFile((wxStandardPaths::Get().GetUserDataDir() + wxFileName::GetPathSeparator() + "action_broadcast.log").ToStdString(), std::ios::app);
-			if (logFile.is_open()) {
-				wxDateTime now = wxDateTime::Now();
-				logFile << now.FormatISOCombined() << ": Broadcasting changes from owner " << dirty_list.owner << "\n";
-				logFile.close();
-			}
+			TRACE_DEBUG(Live, "Broadcasting changes from owner %u", dirty_list.owner);
 			
 			queue.broadcast(dirty_list);
 		}
 		catch (const std::exception& e) {
 			// Log error but continue
-			std::ofstream logFile((wxStandardPaths::Get().GetUserDataDir() + wxFileName::GetPathSeparator() + "action_error.log").ToStdString(), std::ios::app);
-			if (logFile.is_open()) {
-				wxDateTime now = wxDateTime::Now();
-				logFile << now.FormatISOCombined() << ": Error broadcasting changes: " << e.what() << "\n";
-				logFile.close();
-			}
+			TRACE_ERROR(Live, "Error broadcasting changes: %s", e.what());
 		}
 	}
 	catch (const std::exception& e) {
 		// Log error but don't crash
-		std::ofstream logFile((wxStandardPaths::Get().GetUserDataDir() + wxFileName::GetPathSeparator() + "action_error.log").ToStdString(), std::ios::app);
-		if (logFile.is_open()) {
-			wxDateTime now = wxDateTime::Now();
-			logFile << now.FormatISOCombined() << ": Critical error in addAndCommitAction: " << e.what() << "\n";
-			logFile.close();
-		}
+		TRACE_ERROR(Live, "Critical error in addAndCommitAction: %s", e.what());
 		
 		// Try to clean up action if possible
 		try {
@@ -159,23 +130,13 @@ void NetworkedBatchAction::commit() {
 		}
 		
 		// Log that we're broadcasting changes from commit
-		std::ofstream logFile((wxStandardPaths::Get().GetUserDataDir() + wxFileName::GetPathSeparator() + "action_broadcast.log").ToStdString(), std::ios::app);
-		if (logFile.is_open()) {
-			wxDateTime now = wxDateTime::Now();
-			logFile << now.FormatISOCombined() << ": Broadcasting changes from commit, owner: " << dirty_list.owner << "\n";
-			logFile.close();
-		}
+		TRACE_DEBUG(Live, "Broadcasting changes from commit, owner: %u", dirty_list.owner);
 		
 		// Broadcast changes to all clients!
 		queue.broadcast(dirty_list);
 	} catch (const std::exception& e) {
 		// Log error but don't crash
-		std::ofstream logFile((wxStandardPaths::Get().GetUserDataDir() + wxFileName::GetPathSeparator() + "action_error.log").ToStdString(), std::ios::app);
-		if (logFile.is_open()) {
-			wxDateTime now = wxDateTime::Now();
-			logFile << now.FormatISOCombined() << ": Error in NetworkedBatchAction::commit(): " << e.what() << "\n";
-			logFile.close();
-		}
+		TRACE_ERROR(Live, "Error in NetworkedBatchAction::commit(): %s", e.what());
 	}
 }
 
@@ -192,23 +153,13 @@ void NetworkedBatchAction::undo() {
 		}
 		
 		// Log that we're broadcasting changes from undo
-		std::ofstream logFile((wxStandardPaths::Get().GetUserDataDir() + wxFileName::GetPathSeparator() + "action_broadcast.log").ToStdString(), std::ios::app);
-		if (logFile.is_open()) {
-			wxDateTime now = wxDateTime::Now();
-			logFile << now.FormatISOCombined() << ": Broadcasting changes from undo, owner: " << dirty_list.owner << "\n";
-			logFile.close();
-		}
+		TRACE_DEBUG(Live, "Broadcasting changes from undo, owner: %u", dirty_list.owner);
 		
 		// Broadcast changes to all clients!
 		queue.broadcast(dirty_list);
 	} catch (const std::exception& e) {
 		// Log error but don't crash
-		std::ofstream logFile((wxStandardPaths::Get().GetUserDataDir() + wxFileName::GetPathSeparator() + "action_error.log").ToStdString(), std::ios::app);
-		if (logFile.is_open()) {
-			wxDateTime now = wxDateTime::Now();
-			logFile << now.FormatISOCombined() << ": Error in NetworkedBatchAction::undo(): " << e.what() << "\n";
-			logFile.close();
-		}
+		TRACE_ERROR(Live, "Error in NetworkedBatchAction::undo(): %s", e.what());
 	}
 }
 
@@ -217,12 +168,7 @@ void NetworkedBatchAction::redo() {
 		commit();
 	} catch (const std::exception& e) {
 		// Log error but don't crash
-		std::ofstream logFile((wxStandardPaths::Get().GetUserDataDir() + wxFileName::GetPathSeparator() + "action_error.log").ToStdString(), std::ios::app);
-		if (logFile.is_open()) {
-			wxDateTime now = wxDateTime::Now();
-			logFile << now.FormatISOCombined() << ": Error in NetworkedBatchAction::redo(): " << e.what() << "\n";
-			logFile.close();
-		}
+		TRACE_ERROR(Live, "Error in NetworkedBatchAction::redo(): %s", e.what());
 	}
 }
 
@@ -250,12 +196,7 @@ void NetworkedBatchAction::commitChanges(Action* action) {
 		action->commit(type != ACTION_SELECT ? &dirty_list : nullptr);
 		
 		// Log that we're broadcasting changes from commitChanges
-		std::ofstream logFile((wxStandardPaths::Get().GetUserDataDir() + wxFileName::GetPathSeparator() + "action_broadcast.log").ToStdString(), std::ios::app);
-		if (logFile.is_open()) {
-			wxDateTime now = wxDateTime::Now();
-			logFile << now.FormatISOCombined() << ": Broadcasting changes from commitChanges, owner: " << dirty_list.owner << "\n";
-			logFile.close();
-		}
+		TRACE_DEBUG(Live, "Broadcasting changes from commitChanges, owner: %u", dirty_list.owner);
 		
 		// Broadcast changes to all clients!
 		queue.broadcast(dirty_list);
@@ -265,12 +206,7 @@ void NetworkedBatchAction::commitChanges(Action* action) {
 	}
 	catch (const std::exception& e) {
 		// Log error but don't crash
-		std::ofstream logFile((wxStandardPaths::Get().GetUserDataDir() + wxFileName::GetPathSeparator() + "action_error.log").ToStdString(), std::ios::app);
-		if (logFile.is_open()) {
-			wxDateTime now = wxDateTime::Now();
-			logFile << now.FormatISOCombined() << ": Error in commitChanges: " << e.what() << "\n";
-			logFile.close();
-		}
+		TRACE_ERROR(Live, "Error in commitChanges: %s", e.what());
 		
 		// Try to clean up action if possible
 		try {
@@ -298,12 +234,7 @@ Action* NetworkedActionQueue::createAction(ActionIdentifier ident) {
 		return action;
 	} catch (const std::exception& e) {
 		// Log error but don't crash
-		std::ofstream logFile((wxStandardPaths::Get().GetUserDataDir() + wxFileName::GetPathSeparator() + "action_error.log").ToStdString(), std::ios::app);
-		if (logFile.is_open()) {
-			wxDateTime now = wxDateTime::Now();
-			logFile << now.FormatISOCombined() << ": Error creating NetworkedAction: " << e.what() << "\n";
-			logFile.close();
-		}
+		TRACE_ERROR(Live, "Error creating NetworkedAction: %s", e.what());
 		return nullptr;
 	}
 }
@@ -314,12 +245,7 @@ BatchAction* NetworkedActionQueue::createBatch(ActionIdentifier ident) {
 		return batch;
 	} catch (const std::exception& e) {
 		// Log error but don't crash
-		std::ofstream logFile((wxStandardPaths::Get().GetUserDataDir() + wxFileName::GetPathSeparator() + "action_error.log").ToStdString(), std::ios::app);
-		if (logFile.is_open()) {
-			wxDateTime now = wxDateTime::Now();
-			logFile << now.FormatISOCombined() << ": Error creating NetworkedBatchAction: " << e.what() << "\n";
-			logFile.close();
-		}
+		TRACE_ERROR(Live, "Error creating NetworkedBatchAction: %s", e.what());
 		return nullptr;
 	}
 }
@@ -345,12 +271,7 @@ void NetworkedActionQueue::commitChanges(Action* action) {
 		delete batch;
 	} catch (const std::exception& e) {
 		// Log error but don't crash
-		std::ofstream logFile((wxStandardPaths::Get().GetUserDataDir() + wxFileName::GetPathSeparator() + "action_error.log").ToStdString(), std::ios::app);
-		if (logFile.is_open()) {
-			wxDateTime now = wxDateTime::Now();
-			logFile << now.FormatISOCombined() << ": Error in NetworkedActionQueue::commitChanges: " << e.what() << "\n";
-			logFile.close();
-		}
+		TRACE_ERROR(Live, "Error in NetworkedActionQueue::commitChanges: %s", e.what());
 		
 		// Try to clean up action if possible
 		try {
@@ -21,9 +21,9 @@
 #include "live_tab.h"
 #include "live_action.h"
 #include "editor.h"
+#include "trace.h"
 
 #include <wx/event.h>
-#include <fstream>
 
 LiveClient::LiveClient() :
 	LiveSocket(),
@@ -32,14 +32,8 @@ LiveClient::LiveClient() :
 	// Initialize buffer with minimum size to prevent "size 0" errors
 	readMessage.buffer.resize(1024);
 	readMessage.position = 0;
-	
-	// Log initialization to file only to help with debugging
-	std::ofstream logFile((GetAppDir() + wxFileName::GetPathSeparator() + "client_init.log").ToStdString(), std::ios::app);
-	if (logFile.is_open()) {
-		wxDateTime now = wxDateTime::Now();
-		logFile << now.FormatISOCombined() << ": LiveClient initialized\n";
-		logFile.close();
-	}
+
+	TRACE_INFO(Live, "LiveClient initialized");
 }
 
 LiveClient::~LiveClient() {
@@ -275,7 +269,7 @@ void LiveClient::receiveHeader() {
 	}
 	
 	try {
-		logMessage("[Client]: Waiting for incoming packet header...");
+		TRACE_DEBUG(Live, "Waiting for incoming packet header");
 		
 		boost::asio::async_read(*socket, boost::asio::buffer(readMessage.buffer, 4), 
 			[this](const boost::system::error_code& error, size_t bytesReceived) -> void {
@@ -315,7 +309,7 @@ void LiveClient::receiveHeader() {
 				} else {
 					// Successfully received header, now receive the packet
 					uint32_t packetSize = readMessage.read<uint32_t>();
-					logMessage(wxString::Format("[Client]: Received header, packet size: %u bytes", packetSize));
+					TRACE_DEBUG(Live, "Received header, packet size: %u bytes", packetSize);
 					
 					// Check for zero packet size
 					if (packetSize == 0) {
@@ -345,7 +339,7 @@ void LiveClient::receive(uint32_t packetSize) {
 	// Resize buffer to accommodate the incoming packet
 	readMessage.buffer.resize(readMessage.position + packetSize);
 	
-	logMessage(wxString::Format("[Client]: Reading packet body (%u bytes)", packetSize));
+	TRACE_DEBUG(Live, "Reading packet body (%u bytes)", packetSize);
 	
 	boost::asio::async_read(*socket, boost::asio::buffer(&readMessage.buffer[readMessage.position], packetSize), 
 	[this, packetSize](const boost::system::error_code& error, size_t bytesReceived) -> void {
@@ -388,7 +382,7 @@ void LiveClient::receive(uint32_t packetSize) {
 			});
 		} else {
 			// Successfully received the complete packet
-			logMessage(wxString::Format("[Client]: Successfully received complete packet (%zu bytes)", bytesReceived));
+			TRACE_DEBUG(Live, "Received complete packet (%zu bytes)", bytesReceived);
 			
 			wxTheApp->CallAfter([this]() {
 				parsePacket(std::move(readMessage));
@@ -409,8 +403,7 @@ void LiveClient::send(NetworkMessage& message) {
 	memcpy(&message.buffer[0], &message.size, 4);
 	
 	// Log the message we're sending
-	logMessage(wxString::Format("[Client]: Sending packet to server (size: %zu bytes)", 
-		message.size + 4));
+	TRACE_DEBUG(Live, "Sending packet to server (size: %zu bytes)", message.size + 4);
 	
 	try {
 		boost::asio::async_write(*socket, 
@@ -423,8 +416,7 @@ void LiveClient::send(NetworkMessage& message) {
 					logMessage(wxString::Format("[Client]: Incomplete packet sent to server [sent: %zu, expected: %zu]", 
 						bytesTransferred, msgSize + 4));
 				} else {
-					logMessage(wxString::Format("[Client]: Successfully sent packet to server (%zu bytes)", 
-						bytesTransferred));
+					TRACE_DEBUG(Live, "Sent packet to server (%zu bytes)", bytesTransferred);
 				}
 			}
 		);
@@ -634,8 +626,7 @@ void LiveClient::parsePacket(NetworkMessage message) {
 			}
 			
 			packetType = message.read<uint8_t>();
-			logMessage(wxString::Format("[Client]: Parsing packet type 0x%02X at position %zu", 
-				packetType, packetStart));
+			TRACE_DEBUG(Live, "Parsing packet type 0x%02X at position %zu", packetType, packetStart);
 				
 			try {
 				switch (packetType) {
@@ -708,55 +699,28 @@ void LiveClient::parseKick(NetworkMessage& message) {
 
 void LiveClient::parseClientAccepted(NetworkMessage& message) {
 	try {
-		// Write to a diagnostic file instead of UI logging to prevent crashes
-		std::ofstream logFile((GetAppDir() + wxFileName::GetPathSeparator() + "client_status.log").ToStdString(), std::ios::app);
-		if (logFile.is_open()) {
-			wxDateTime now = wxDateTime::Now();
-			logFile << now.FormatISOCombined() << ": Client accepted, setting up cursor\n";
-		}
-		
+		TRACE_INFO(Live, "Client accepted, setting up cursor");
+
 		// Initialize the host's cursor when we're accepted
 		LiveCursor hostCursor;
 		hostCursor.id = 0; // Host is always ID 0
 		hostCursor.color = wxColor(255, 0, 0); // Default red color for host
 		hostCursor.pos = Position(); // Default position
 		cursors[0] = hostCursor; // Add host cursor to our list
-		
-		if (logFile.is_open()) {
-			logFile << "Host cursor initialized\n";
-		}
-		
+
 		// Set flag indicating we're fully connected and ready to draw - with extra safety
 		wxTheApp->CallAfter([this]() {
 			// Set the ready flag in a deferred way to ensure all initialization is complete
 			if (!stopped) {
 				isDrawingReady = true;
-				
-				// Write to diagnostic file
-				std::ofstream logFile((GetAppDir() + wxFileName::GetPathSeparator() + "client_status.log").ToStdString(), std::ios::app);
-				if (logFile.is_open()) {
-					wxDateTime now = wxDateTime::Now();
-					logFile << now.FormatISOCombined() << ": Drawing ready flag set to true\n";
-					logFile.close();
-				}
+				TRACE_INFO(Live, "Drawing ready flag set");
 			}
 		});
-		
-		if (logFile.is_open()) {
-			logFile << "Ready flag setup queued\n";
-			logFile.close();
-		}
-		
+
 		sendReady();
 	}
 	catch (const std::exception& e) {
-		// Log error to file
-		std::ofstream logFile((GetAppDir() + wxFileName::GetPathSeparator() + "client_error.log").ToStdString(), std::ios::app);
-		if (logFile.is_open()) {
-			wxDateTime now = wxDateTime::Now();
-			logFile << now.FormatISOCombined() << ": Error in parseClientAccepted: " << e.what() << "\n";
-			logFile.close();
-		}
+		TRACE_ERROR(Live, "Error in parseClientAccepted: %s", e.what());
 	}
 }
 
@@ -790,9 +754,7 @@ void LiveClient::parseNode(NetworkMessage& message) {
 		int32_t ndy = (nodeid >> 4) & 0x3FFF;
 		bool underground = (nodeid & 1) == 1;
 
-		// Log node reception for debugging
-		logMessage(wxString::Format("[Client]: Received node update [%d,%d,%s]", 
-			ndx, ndy, underground ? "underground" : "surface"));
+		TRACE_DEBUG(Live, "Received node update [%d,%d,%s]", ndx, ndy, underground ? "underground" : "surface");
 
 		// Queue the node processing on the main thread to avoid threading issues
 		wxTheApp->CallAfter([this, message = std::move(message), ndx, ndy, underground]() mutable {
@@ -812,9 +774,7 @@ void LiveClient::parseNode(NetworkMessage& message) {
 				g_gui.RefreshView();
 				g_gui.UpdateMinimap();
 
-				logMessage(wxString::Format("[Client]: Applying node update [%d,%d,%s]", 
-					ndx, ndy, underground ? "underground" : "surface"));
-				logMessage("[Client]: Node update applied successfully.");
+				TRACE_DEBUG(Live, "Applied node update [%d,%d,%s]", ndx, ndy, underground ? "underground" : "surface");
 			} else {
 				// Use proper action destruction
 				
@@ -23,6 +23,7 @@
 #include "live_action.h"
 
 #include "editor.h"
+#include "trace.h"
 
 LivePeer::LivePeer(LiveServer* server, boost::asio::ip::tcp::socket socket) :
 	LiveSocket(),
@@ -88,8 +89,7 @@ void LivePeer::receiveHeader() {
 		} else {
 			// Successfully received header
 			uint32_t packetSize = readMessage.read<uint32_t>();
-			logMessage(wxString::Format("[Client %s]: Received header, packet size: %u bytes", 
-				getHostName(), packetSize));
+			TRACE_DEBUG(Live, "Received header from %s, packet size: %u bytes", getHostName().c_str(), packetSize);
 				
 			// Prevent empty packet errors
 			if (packetSize == 0) {
@@ -157,8 +157,7 @@ void LivePeer::receive(uint32_t packetSize) {
 			}
 		} else {
 			// Successfully received the complete packet
-			logMessage(wxString::Format("[Client %s]: Successfully received complete packet (%zu bytes)", 
-				getHostName(), bytesReceived));
+			TRACE_DEBUG(Live, "Received complete packet from %s (%zu bytes)", getHostName().c_str(), bytesReceived);
 				
 			wxTheApp->CallAfter([this]() {
 				if (connected) {
@@ -185,8 +184,7 @@ void LivePeer::send(NetworkMessage& message) {
 	// Only log non-cursor packets to reduce excessive logging
 	bool isCursorPacket = message.buffer.size() > 0 && message.buffer[4] == PACKET_CURSOR_UPDATE;
 	if (!isCursorPacket) {
-		logMessage(wxString::Format("[Server]: Sending packet to %s (size: %zu bytes, type: 0x%02X)", 
-			getHostName(), message.size + 4, message.buffer[4]));
+		TRACE_DEBUG(Live, "Sending packet to %s (size: %zu bytes, type: 0x%02X)", getHostName().c_str(), message.size + 4, message.buffer[4]);
 	}
 	
 	try {
@@ -201,8 +199,7 @@ void LivePeer::send(NetworkMessage& message) {
 						getHostName(), bytesTransferred, msgSize + 4));
 				} else if (!isCursorPacket) {
 					// Only log successful sends for non-cursor packets
-					logMessage(wxString::Format("[Server]: Successfully sent packet to %s (%zu bytes)", 
-						getHostName(), bytesTransferred));
+					TRACE_DEBUG(Live, "Sent packet to %s (%zu bytes)", getHostName().c_str(), bytesTransferred);
 				}
 			}
 		);
@@ -23,9 +23,7 @@
 #include "live_action.h"
 
 #include "editor.h"
-
-#include <fstream>
-#include <wx/filename.h>
+#include "trace.h"
 
 LiveServer::LiveServer(Editor& editor) :
 	LiveSocket(),
@@ -34,25 +32,12 @@ LiveServer::LiveServer(Editor& editor) :
 	// Initialize with a safe color
 	usedColor = wxColor(255, 0, 0); // Red for host
 	
-	// Log server initialization to file
-	std::ofstream logFile((GetAppDir() + wxFileName::GetPathSeparator() + "server_init.log").ToStdString(), std::ios::app);
-	if (logFile.is_open()) {
-		wxDateTime now = wxDateTime::Now();
-		logFile << now.FormatISOCombined() << ": LiveServer initialized\n";
-		logFile.close();
-	}
-	
+	TRACE_INFO(Live, "LiveServer initialized");
+
 	// Set the drawing ready flag after a short delay to ensure all initialization is complete
 	wxTheApp->CallAfter([this]() {
 		drawingReady = true;
-		
-		// Log to file
-		std::ofstream logFile((GetAppDir() + wxFileName::GetPathSeparator() + "server_status.log").ToStdString(), std::ios::app);
-		if (logFile.is_open()) {
-			wxDateTime now = wxDateTime::Now();
-			logFile << now.FormatISOCombined() << ": Server drawing ready flag set\n";
-			logFile.close();
-		}
+		TRACE_INFO(Live, "Server drawing ready flag set");
 	});
 }
 
@@ -138,14 +123,8 @@ void LiveServer::close() {
 	// Also disable drawing operations
 	drawingReady = false;
 	
-	// Log server shutdown to file
-	std::ofstream logFile((GetAppDir() + wxFileName::GetPathSeparator() + "server_status.log").ToStdString(), std::ios::app);
-	if (logFile.is_open()) {
-		wxDateTime now = wxDateTime::Now();
-		logFile << now.FormatISOCombined() << ": Server shutting down\n";
-		logFile.close();
-	}
-	
+	TRACE_INFO(Live, "Server shutting down");
+
 	// Then proceed with normal shutdown
 	for (auto& clientEntry : clients) {
 		delete clientEntry.second;
@@ -297,13 +276,7 @@ std::string LiveServer::getHostName() const {
 void LiveServer::broadcastNodes(DirtyList& dirtyList) {
 	// Skip if we're not ready for drawing operations
 	if (!drawingReady || stopped) {
-		// Log to file instead of UI
-		std::ofstream logFile((GetAppDir() + wxFileName::GetPathSeparator() + "server_status.log").ToStdString(), std::ios::app);
-		if (logFile.is_open()) {
-			wxDateTime now = wxDateTime::Now();
-			logFile << now.FormatISOCombined() << ": Skipped broadcast, drawing not ready\n";
-			logFile.close();
-		}
+		TRACE_DEBUG(Live, "Skipped broadcast, drawing not ready");
 		return;
 	}
 
@@ -312,18 +285,14 @@ void LiveServer::broadcastNodes(DirtyList& dirtyList) {
 		return;
 	}
 
-	// Log to file rather than UI
-	std::ofstream logFile((GetAppDir() + wxFileName::GetPathSeparator() + "server_ops.log").ToStdString(), std::ios::app);
-	if (logFile.is_open()) {
-		wxDateTime now = wxDateTime::Now();
-		logFile << now.FormatISOCombined() << ": Broadcasting changes to " << clients.size() << " clients\n";
-	}
+	TRACE_DEBUG(Live, "Broadcasting changes to %zu clients", clients.size());
 
 	// Extract the change information to a struct we can capture in our lambda
 	struct BroadcastData {
 		uint32_t owner;
 		std::vector<Change*> changes;  // Changed from ChangeList to std::vector<Change*>
-		std::vector<DirtyList::ValueType> positions;  // Use the existing type from DirtyList
+		// Changed nodes grouped by block, each block goes to a client as one message
+		std::vector<DirtyList::NodeList> groups;
 	};
 
 	std::shared_ptr<BroadcastData> broadcastData = std::make_shared<BroadcastData>();
@@ -350,17 +319,12 @@ void LiveServer::broadcastNodes(DirtyList& dirtyList) {
 			}
 		}
 		
-		// Get position list - need to copy the positions manually
-		DirtyList::SetType& positionList = dirtyList.GetPosList();
-		for (const auto& pos : positionList) {
-			broadcastData->positions.push_back(pos);
-		}
+		// The dirty list is gone by the time the broadcast runs
+		dirtyList.ForEachGroup(BroadcastGroupLevel, [&broadcastData](int, int, const DirtyList::ValueType* first, const DirtyList::ValueType* last) {
+			broadcastData->groups.emplace_back(first, last);
+		});
 		
-		// Safe logging of the node count
-		if (logFile.is_open()) {
-			logFile << "Changes: " << broadcastData->changes.size() << ", Positions: " << broadcastData->positions.size() << "\n";
-			logFile << "Change owner: " << broadcastData->owner << "\n";
-		}
+		TRACE_DEBUG(Live, "Changes: %zu, node groups: %zu, owner: %u", broadcastData->changes.size(), broadcastData->groups.size(), broadcastData->owner);
 		
 		// Use a safer approach with CallAfter
 		wxTheApp->CallAfter([this, broadcastData]() {
@@ -385,101 +349,58 @@ void LiveServer::broadcastNodes(DirtyList& dirtyList) {
 					}
 				}
 
-				// Now handle the network broadcasting
-				// Create a vector of all the work we need to do
-				struct BroadcastWork {
-					LivePeer* peer;
-					QTreeNode* node;
-					int32_t ndx;
-					int32_t ndy;
-					uint32_t floors;
-					uint32_t clientId;
-				};
-				
-				std::vector<BroadcastWork> workItems;
+				// Now handle the network broadcasting, one message per client and node group
+				size_t messages = 0;
+				size_t nodes = 0;
+				for (auto& clientEntry : clients) {
+					LivePeer* peer = clientEntry.second;
+					if (!peer) continue;
 
-				// First gather all the work without doing any actual sending
-				for (const auto& ind : broadcastData->positions) {
-					int32_t ndx = ind.pos >> 18;
-					int32_t ndy = (ind.pos >> 4) & 0x3FFF;
-					uint32_t floors = ind.floors;
+					const uint32_t clientId = peer->getClientId();
 
-					QTreeNode* node = editor->map.getLeaf(ndx * 4, ndy * 4);
-					if (!node) continue;
+					// Skip sending changes back to the client that made them
+					if (broadcastData->owner != 0 && clientId == broadcastData->owner) {
+						continue;
+					}
 
-					for (auto& clientEntry : clients) {
-						LivePeer* peer = clientEntry.second;
-						if (!peer) continue;
+					for (const DirtyList::NodeList& group : broadcastData->groups) {
+						NetworkMessage message;
+						for (const auto& ind : group) {
+							int32_t ndx = ind.getNodeX();
+							int32_t ndy = ind.getNodeY();
 
-						const uint32_t clientId = peer->getClientId();
-						
-						// Skip sending changes back to the client that made them
-						if (broadcastData->owner != 0 && clientId == broadcastData->owner) {
-							continue;
-						}
-						
-						// Always broadcast to all clients, regardless of visibility
-						// This ensures all clients see all changes
-						workItems.push_back({peer, node, ndx, ndy, floors, clientId});
-						
-						// Mark the node as visible to this client to ensure future updates are sent
-						node->setVisible(clientId, true, true);
-						node->setVisible(clientId, false, true);
-					}
-				}
+							QTreeNode* node = editor->map.getLeaf(ndx * 4, ndy * 4);
+							if (!node) continue;
 
-				// If we have work to do, process it all in a single batch
-				if (!workItems.empty()) {
-					// Process work items in batches to avoid overwhelming the network
-					const size_t batchSize = 100; // Process 100 work items at a time
-					
-					for (size_t startIdx = 0; startIdx < workItems.size(); startIdx += batchSize) {
-						size_t endIdx = std::min(startIdx + batchSize, workItems.size());
-						
-						for (size_t i = startIdx; i < endIdx; ++i) {
-							const auto& work = workItems[i];
-							if (work.peer && work.node) {
-								sendNode(work.clientId, work.node, work.ndx, work.ndy, work.floors);
+							// Always broadcast to all clients, regardless of visibility
+							// This ensures all clients see all changes
+							// Mark the node as visible to this client to ensure future updates are sent
+							node->setVisible(clientId, true, true);
+							node->setVisible(clientId, false, true);
+
+							if (writeNode(message, clientId, node, ndx, ndy, ind.floors)) {
+								++nodes;
 							}
 						}
-					}
-					
-					// Log completion to file
-					std::ofstream logFile((GetAppDir() + wxFileName::GetPathSeparator() + "server_ops.log").ToStdString(), std::ios::app);
-					if (logFile.is_open()) {
-						wxDateTime now = wxDateTime::Now();
-						logFile << now.FormatISOCombined() << ": Broadcast completed, sent " << workItems.size() << " node updates\n";
-						logFile.close();
+
+						if (message.size > 0) {
+							peer->send(message);
+							++messages;
+						}
 					}
 				}
-			} catch (std::exception& e) {
-				// Log error to file
-				std::ofstream logFile((GetAppDir() + wxFileName::GetPathSeparator() + "server_error.log").ToStdString(), std::ios::app);
-				if (logFile.is_open()) {
-					wxDateTime now = wxDateTime::Now();
-					logFile << now.FormatISOCombined() << ": Error broadcasting nodes: " << e.what() << "\n";
-					logFile.close();
+
+				if (nodes > 0) {
+					TRACE_DEBUG(Live, "Broadcast completed, sent %zu node updates in %zu messages", nodes, messages);
 				}
+			} catch (std::exception& e) {
+				TRACE_ERROR(Live, "Error broadcasting nodes: %s", e.what());
 			}
 		});
 		
-		if (logFile.is_open()) {
-			logFile << "Broadcast queued to main thread\n";
-			logFile.close();
-		}
+		TRACE_DEBUG(Live, "Broadcast queued to main thread");
 	} catch (std::exception& e) {
-		// Log error to file
-		if (logFile.is_open()) {
-			logFile << "Error preparing broadcast: " << e.what() << "\n";
-			logFile.close();
-		} else {
-			std::ofstream errorLog((GetAppDir() + wxFileName::GetPathSeparator() + "server_error.log").ToStdString(), std::ios::app);
-			if (errorLog.is_open()) {
-				wxDateTime now = wxDateTime::Now();
-				errorLog << now.FormatISOCombined() << ": Error preparing broadcast: " << e.what() << "\n";
-				errorLog.close();
-			}
-		}
+		TRACE_ERROR(Live, "Error preparing broadcast: %s", e.what());
 	}
 }
 
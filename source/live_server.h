@@ -85,6 +85,9 @@ public:
 	}
 
 protected:
+	// Changed nodes are broadcast in blocks of 2^level x 2^level nodes, one message per block
+	static constexpr int BroadcastGroupLevel = 2;
+
 	std::unordered_map<uint32_t, LivePeer*> clients;
 
 	std::shared_ptr<boost::asio::ip::tcp::acceptor> acceptor;
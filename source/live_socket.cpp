@@ -21,6 +21,7 @@
 #include "iomap_otbm.h"
 #include "live_tab.h"
 #include "editor.h"
+#include "trace.h"
 
 LiveSocket::LiveSocket() :
 	cursors(), mapReader(nullptr, 0), mapWriter(),
@@ -113,10 +114,17 @@ void LiveSocket::receiveNode(NetworkMessage& message, Editor& editor, Action* ac
 }
 
 void LiveSocket::sendNode(uint32_t clientId, QTreeNode* node, int32_t ndx, int32_t ndy, uint32_t floorMask) {
+	NetworkMessage message;
+	if (writeNode(message, clientId, node, ndx, ndy, floorMask)) {
+		send(message);
+	}
+}
+
+bool LiveSocket::writeNode(NetworkMessage& message, uint32_t clientId, QTreeNode* node, int32_t ndx, int32_t ndy, uint32_t floorMask) {
 	// Safety check
 	if (!node) {
 		logMessage(wxString::Format("Warning: Attempted to send null node at %d,%d", ndx * 4, ndy * 4));
-		return;
+		return false;
 	}
 
 	bool underground;
@@ -133,9 +141,9 @@ void LiveSocket::sendNode(uint32_t clientId, QTreeNode* node, int32_t ndx, int32
 	// Mark the node as visible to this client
 	node->setVisible(clientId, underground, true);
 
+	const size_t position = message.position;
+	const size_t size = message.size;
 	try {
-		// Prepare the message
-		NetworkMessage message;
 		message.write<uint8_t>(PACKET_NODE);
 		message.write<uint32_t>((ndx << 18) | (ndy << 4) | ((floorMask & 0xFF00) ? 1 : 0));
 
@@ -164,12 +172,14 @@ void LiveSocket::sendNode(uint32_t clientId, QTreeNode* node, int32_t ndx, int32
 			}
 		}
 
-		// Send the message
-		logMessage(wxString::Format("Sending node [%d,%d,%s] with floor mask 0x%04X", 
-			ndx, ndy, underground ? "underground" : "surface", sendMask));
-		send(message);
+		TRACE_DEBUG(Live, "Sending node [%d,%d,%s] with floor mask 0x%04X", ndx, ndy, underground ? "underground" : "surface", sendMask);
+		return true;
 	} catch (std::exception& e) {
+		// Drop the partly written packet, the packets before it stay intact
+		message.position = position;
+		message.size = size;
 		logMessage(wxString::Format("Error sending node [%d,%d]: %s", ndx, ndy, e.what()));
+		return false;
 	}
 }
 
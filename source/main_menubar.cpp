@@ -26,7 +26,7 @@
 	 * - tile.h/cpp: Contains borderize() and wallize() methods that apply automatic borders/walls
 	 * - ground_brush.cpp: Implements GroundBrush::doBorders() which handles automatic borders
 	 * - wall_brush.cpp: Implements WallBrush::doWalls() which handles automatic walls
-	 * - borderize_window.cpp: UI for borderizing large selections or the entire map
+	 * - tile_processor.cpp: Borderizes or wallizes large selections or the entire map in parallel
 	 * - editor.cpp: Contains borderizeSelection() and borderizeMap() methods
 	 * - copybuffer.cpp: Applies borderize to pasted content
 	 * 
@@ -47,8 +47,8 @@
 	 * - BORDERIZE_DRAG_THRESHOLD: Maximum selection size for auto-borderizing during drag
 	 * - BORDERIZE_PASTE_THRESHOLD: Maximum selection size for auto-borderizing during paste
 	 * 
-	 * The BorderizeWindow provides a UI for processing large maps in chunks to avoid
-	 * performance issues when borderizing extensive areas.
+	 * The TileProcessor splits large areas into blocks that are processed on worker
+	 * threads and commits the result as a single action.
 	 */
 
 #include "main.h"
@@ -66,6 +66,7 @@
 #include "automagic_settings.h"
 #include "find_creature_window.h"
 #include "map.h"
+#include "map_search.h"
 #include "editor.h"
 #include "gui.h"
 #include "border_editor_window.h"
@@ -76,6 +77,8 @@
 #include "add_creature_dialog.h"
 #include "doodads_filling_dialog.h"
 #include "item_editor_window.h"
+#include "render_profiler.h"
+#include "undo_store.h"
 
 #include <wx/chartype.h>
 
@@ -130,6 +133,7 @@ MainMenuBar::MainMenuBar(MainFrame* frame) :
 	MAKE_ACTION(IMPORT_MINIMAP, wxITEM_NORMAL, OnImportMinimap);
 	MAKE_ACTION(EXPORT_MINIMAP, wxITEM_NORMAL, OnExportMinimap);
 	MAKE_ACTION(EXPORT_TILESETS, wxITEM_NORMAL, OnExportTilesets);
+	MAKE_ACTION(EXPORT_MAP_RENDER, wxITEM_NORMAL, OnExportMapRender);
 
 	MAKE_ACTION(RELOAD_DATA, wxITEM_NORMAL, OnReloadDataFiles);
 	MAKE_ACTION(RELOAD_REVSCRIPTS, wxITEM_NORMAL, OnReloadRevScripts);
@@ -139,6 +143,7 @@ MainMenuBar::MainMenuBar(MainFrame* frame) :
 
 	MAKE_ACTION(UNDO, wxITEM_NORMAL, OnUndo);
 	MAKE_ACTION(REDO, wxITEM_NORMAL, OnRedo);
+	MAKE_ACTION(UNDO_HISTORY_STATS, wxITEM_NORMAL, OnUndoHistoryStats);
 
 	MAKE_ACTION(FIND_ITEM, wxITEM_NORMAL, OnSearchForItem);
 	MAKE_ACTION(REPLACE_ITEMS, wxITEM_NORMAL, OnReplaceItems);
@@ -242,6 +247,8 @@ MainMenuBar::MainMenuBar(MainFrame* frame) :
 	MAKE_ACTION(HOUSE_CUSTOM_COLORS, wxITEM_CHECK, OnChangeViewSettings);
 
 	MAKE_ACTION(EXPERIMENTAL_FOG, wxITEM_CHECK, OnChangeViewSettings); // experimental
+	MAKE_ACTION(EXPERIMENTAL_RENDER_PROFILER, wxITEM_CHECK, OnChangeViewSettings);
+	MAKE_ACTION(EXPORT_RENDER_TRACE, wxITEM_NORMAL, OnExportRenderTrace);
 
 	MAKE_ACTION(WIN_MINIMAP, wxITEM_NORMAL, OnMinimapWindow);
 	MAKE_ACTION(WIN_RECENT_BRUSHES, wxITEM_NORMAL, OnRecentBrushesWindow);
@@ -281,6 +288,7 @@ MainMenuBar::MainMenuBar(MainFrame* frame) :
 	MAKE_ACTION(FLOOR_15, wxITEM_RADIO, OnChangeFloor);
 
 	MAKE_ACTION(DEBUG_VIEW_DAT, wxITEM_NORMAL, OnDebugViewDat);
+	MAKE_ACTION(DEBUG_GRAPHICS_STATS, wxITEM_NORMAL, OnDebugGraphicsStats);
 	MAKE_ACTION(EXTENSIONS, wxITEM_NORMAL, OnListExtensions);
 	MAKE_ACTION(GOTO_WEBSITE, wxITEM_NORMAL, OnGotoWebsite);
 	MAKE_ACTION(ABOUT, wxITEM_NORMAL, OnAbout);
@@ -410,10 +418,12 @@ void MainMenuBar::Update() {
 	if (editor) {
 		EnableItem(UNDO, editor->actionQueue->canUndo());
 		EnableItem(REDO, editor->actionQueue->canRedo());
+		EnableItem(UNDO_HISTORY_STATS, true);
 		EnableItem(PASTE, editor->copybuffer.canPaste());
 	} else {
 		EnableItem(UNDO, false);
 		EnableItem(REDO, false);
+		EnableItem(UNDO_HISTORY_STATS, false);
 		EnableItem(PASTE, false);
 	}
 
@@ -434,6 +444,7 @@ void MainMenuBar::Update() {
 	EnableItem(IMPORT_MINIMAP, false);
 	EnableItem(EXPORT_MINIMAP, is_local);
 	EnableItem(EXPORT_TILESETS, loaded);
+	EnableItem(EXPORT_MAP_RENDER, is_local);
 
 	EnableItem(RELOAD_REVSCRIPTS, is_local);
 
@@ -512,6 +523,7 @@ void MainMenuBar::Update() {
 	EnableItem(ID_MENU_SERVER_CONNECT, loaded);
 
 	EnableItem(DEBUG_VIEW_DAT, loaded);
+	EnableItem(DEBUG_GRAPHICS_STATS, loaded);
 
 	UpdateFloorMenu();
 }
@@ -581,6 +593,7 @@ void MainMenuBar::LoadValues() {
 	CheckItem(HOUSE_CUSTOM_COLORS, g_settings.getBoolean(Config::HOUSE_CUSTOM_COLORS));
 
 	CheckItem(EXPERIMENTAL_FOG, g_settings.getBoolean(Config::EXPERIMENTAL_FOG));
+	CheckItem(EXPERIMENTAL_RENDER_PROFILER, g_settings.getBoolean(Config::SHOW_RENDER_PROFILER));
 }
 
 void MainMenuBar::LoadRecentFiles() {
@@ -917,12 +930,71 @@ void MainMenuBar::OnExportTilesets(wxCommandEvent& WXUNUSED(event)) {
 	}
 }
 
+void MainMenuBar::OnExportMapRender(wxCommandEvent& WXUNUSED(event)) {
+	if (g_gui.GetCurrentEditor() && g_gui.GetCurrentMapTab()) {
+		ExportMapRenderWindow dlg(frame, *g_gui.GetCurrentEditor(), *g_gui.GetCurrentMapTab()->GetCanvas());
+		dlg.ShowModal();
+		dlg.Destroy();
+	}
+}
+
 void MainMenuBar::OnDebugViewDat(wxCommandEvent& WXUNUSED(event)) {
 	wxDialog dlg(frame, wxID_ANY, "Debug .dat file", wxDefaultPosition, wxDefaultSize, wxDEFAULT_DIALOG_STYLE | wxRESIZE_BORDER);
 	new DatDebugView(&dlg);
 	dlg.ShowModal();
 }
 
+void MainMenuBar::OnDebugGraphicsStats(wxCommandEvent& WXUNUSED(event)) {
+	const GraphicManager::TextureStats textures = g_gui.gfx.getTextureStats();
+	const GraphicManager::TemplateCacheStats templates = g_gui.gfx.getTemplateCacheStats();
+	const uint64_t template_lookups = templates.hits + templates.misses;
+
+	std::ostringstream os;
+	os.setf(std::ios::fixed, std::ios::floatfield);
+	os.precision(1);
+	os << "GPU textures:\n";
+	os << "\tResident textures: " << textures.resident << " / " << textures.budget << "\n";
+	os << "\tResident memory: " << (textures.resident_bytes / 1024) << " KB\n";
+	os << "\tUploads: " << textures.uploads << "\n";
+	os << "\tRe-uploads after eviction: " << textures.reuploads << "\n";
+	os << "\tEvictions: " << textures.evictions << "\n";
+	os << "Outfit template cache:\n";
+	os << "\tCached templates: " << templates.size << " / " << templates.budget << "\n";
+	os << "\tHits: " << templates.hits << "\n";
+	os << "\tMisses: " << templates.misses << "\n";
+	if (template_lookups > 0) {
+		os << "\tHit rate: " << (100.0 * templates.hits / template_lookups) << "%\n";
+	}
+	os << "\tEvictions: " << templates.evictions << "\n";
+
+	wxDialog dlg(frame, wxID_ANY, "Graphics Statistics", wxDefaultPosition, wxDefaultSize, wxRESIZE_BORDER | wxCAPTION | wxCLOSE_BOX);
+	wxSizer* topsizer = newd wxBoxSizer(wxVERTICAL);
+	wxTextCtrl* text_field = newd wxTextCtrl(&dlg, wxID_ANY, wxstr(os.str()), wxDefaultPosition, wxDefaultSize, wxTE_MULTILINE | wxTE_READONLY);
+	text_field->SetMinSize(wxSize(320, 260));
+	topsizer->Add(text_field, wxSizerFlags(5).Expand());
+	topsizer->Add(newd wxButton(&dlg, wxID_CANCEL, "OK"), wxSizerFlags(0).Center().Border(wxALL, 5));
+	dlg.SetSizerAndFit(topsizer);
+	dlg.Centre(wxBOTH);
+	dlg.ShowModal();
+}
+
+void MainMenuBar::OnExportRenderTrace(wxCommandEvent& WXUNUSED(event)) {
+	if (g_render_profiler.getTraceEventCount() == 0) {
+		g_gui.PopupDialog("Export render trace", "No render events have been recorded, enable the render profiler and draw a few frames first.", wxOK);
+		return;
+	}
+
+	wxFileDialog dialog(frame, "Export render trace", "", "render_trace.json", "Chrome trace (*.json)|*.json", wxFD_SAVE | wxFD_OVERWRITE_PROMPT);
+	if (dialog.ShowModal() != wxID_OK) {
+		return;
+	}
+
+	std::string error;
+	if (!g_render_profiler.exportChromeTrace(nstr(dialog.GetPath()), error)) {
+		g_gui.PopupDialog("Error", wxstr(error), wxOK);
+	}
+}
+
 void MainMenuBar::OnReloadDataFiles(wxCommandEvent& WXUNUSED(event)) {
 	wxString error;
 	wxArrayString warnings;
@@ -957,6 +1029,40 @@ void MainMenuBar::OnRedo(wxCommandEvent& WXUNUSED(event)) {
 	g_gui.DoRedo();
 }
 
+void MainMenuBar::OnUndoHistoryStats(wxCommandEvent& WXUNUSED(event)) {
+	Editor* editor = g_gui.GetCurrentEditor();
+	if (!editor) {
+		return;
+	}
+
+	const ActionQueue& queue = *editor->actionQueue;
+	const UndoStore::Statistics& stats = queue.getUndoStore().getStatistics();
+
+	std::ostringstream os;
+	os.setf(std::ios::fixed, std::ios::floatfield);
+	os.precision(1);
+	os << "Undo history:\n";
+	os << "\tActions: " << queue.size() << " / " << g_settings.getInteger(Config::UNDO_SIZE) << "\n";
+	os << "\tIn memory: " << (queue.size() - stats.batches) << " actions, " << (queue.getMemorySize() / 1024) << " KB / " << g_settings.getInteger(Config::UNDO_MEM_SIZE) << " MB\n";
+	os << "\tOn disk: " << stats.batches << " actions, " << (stats.disk_size / 1024) << " KB / " << g_settings.getInteger(Config::UNDO_DISK_SIZE) << " MB\n";
+	if (stats.disk_size > 0) {
+		os << "\tCompression ratio: " << (double(stats.raw_size) / stats.disk_size) << "\n";
+	}
+	os << "\tSpill file size: " << (stats.file_size / 1024) << " KB\n";
+	os << "\tMoved to disk: " << stats.spills << "\n";
+	os << "\tRead back from disk: " << stats.reloads << "\n";
+
+	wxDialog dlg(frame, wxID_ANY, "Undo History Statistics", wxDefaultPosition, wxDefaultSize, wxRESIZE_BORDER | wxCAPTION | wxCLOSE_BOX);
+	wxSizer* topsizer = newd wxBoxSizer(wxVERTICAL);
+	wxTextCtrl* text_field = newd wxTextCtrl(&dlg, wxID_ANY, wxstr(os.str()), wxDefaultPosition, wxDefaultSize, wxTE_MULTILINE | wxTE_READONLY);
+	text_field->SetMinSize(wxSize(320, 200));
+	topsizer->Add(text_field, wxSizerFlags(5).Expand());
+	topsizer->Add(newd wxButton(&dlg, wxID_CANCEL, "OK"), wxSizerFlags(0).Center().Border(wxALL, 5));
+	dlg.SetSizerAndFit(topsizer);
+	dlg.Centre(wxBOTH);
+	dlg.ShowModal();
+}
+
 namespace OnSearchForItem {
 	struct Finder {
 		Finder(uint16_t itemId, uint32_t maxCount) :
@@ -985,52 +1091,30 @@ namespace OnSearchForItem {
 		}
 	};
 
-	struct RangeFinder {
-		RangeFinder(const std::vector<std::pair<uint16_t, uint16_t>>& ranges, 
-				   const std::vector<uint16_t>& ignored_ids = {},
-				   const std::vector<std::pair<uint16_t, uint16_t>>& ignored_ranges = {}) : 
-			ranges(ranges), 
-			ignored_ids(ignored_ids),
-			ignored_ranges(ignored_ranges),
-			maxCount((uint32_t)g_settings.getInteger(Config::REPLACE_SIZE)) { }
-			
-		std::vector<std::pair<uint16_t, uint16_t>> ranges;
-		std::vector<uint16_t> ignored_ids;
-		std::vector<std::pair<uint16_t, uint16_t>> ignored_ranges;
-		uint32_t maxCount;
-		std::vector<std::pair<Tile*, Item*>> result;
-		
-		bool limitReached() const {
-			return maxCount > 0 && result.size() >= size_t(maxCount);
-		}
-		
-		void operator()(Map& map, Tile* tile, Item* item, long long done) {
-			if(limitReached()) return;
-			
-			if(done % 0x8000 == 0) {
-				g_gui.SetLoadDone((unsigned int)(100 * done / map.getTileCount()));
-			}
-			
-			uint16_t itemId = item->getID();
-			
-			// Check if item should be ignored
-			for(const auto& id : ignored_ids) {
-				if(itemId == id) return;
-			}
-			
-			for(const auto& range : ignored_ranges) {
-				if(itemId >= range.first && itemId <= range.second) return;
-			}
-			
-			// Check if item is in search ranges
-			for(const auto& range : ranges) {
-				if(itemId >= range.first && itemId <= range.second) {
-					result.push_back(std::make_pair(tile, item));
-					break;
-				}
+	// Scans the map on worker threads and feeds the matches into the search
+	// window as they come in, the load bar can cancel the search. first_id
+	// (which should start out as 0) receives the id of the first match.
+	size_t StreamSearch(Map& map, const MapSearch::Predicate& predicate, bool selected_only, SearchResultWindow* window, const wxString& message, uint16_t* first_id = nullptr) {
+		const size_t max_results = size_t(std::max(0, g_settings.getInteger(Config::REPLACE_SIZE)));
+
+		g_gui.CreateLoadBar(message, true);
+		MapSearch search(map);
+		const size_t found = search.run(predicate, max_results, selected_only, [&](const std::vector<MapSearch::Match>& batch, int progress) {
+			if (first_id && *first_id == 0 && !batch.empty()) {
+				*first_id = batch.front().second->getID();
 			}
+			window->AddItems(batch);
+			return g_gui.SetLoadDone(progress);
+		});
+		g_gui.DestroyLoadBar();
+
+		if (max_results > 0 && found >= max_results) {
+			wxString msg;
+			msg << "The configured limit has been reached. Only " << max_results << " results will be displayed.";
+			g_gui.PopupDialog("Notice", msg, wxOK);
 		}
-	};
+		return found;
+	}
 }
 
 void MainMenuBar::OnSearchForItem(wxCommandEvent& WXUNUSED(event)) {
@@ -1044,67 +1128,41 @@ void MainMenuBar::OnSearchForItem(wxCommandEvent& WXUNUSED(event)) {
         if (dialog.getUseRange()) {
             auto ranges = dialog.ParseRangeString(dialog.GetRangeInput());
             if (!ranges.empty()) {
-                // Parse ignored IDs if enabled
-                std::vector<uint16_t> ignored_ids;
-                std::vector<std::pair<uint16_t, uint16_t>> ignored_ranges;
-                if(dialog.IsIgnoreIdsEnabled()) {
-                    ignored_ids = dialog.GetIgnoredIds();
-                    ignored_ranges = dialog.ParseRangeString(dialog.GetIgnoreIdsText());
-                }
-                
-                OnSearchForItem::RangeFinder finder(ranges, ignored_ids, ignored_ranges);
-                g_gui.CreateLoadBar("Searching map...");
-                
-                foreach_ItemOnMap(g_gui.GetCurrentMap(), finder, false);
-                std::vector<std::pair<Tile*, Item*>>& result = finder.result;
-                
-                g_gui.DestroyLoadBar();
-                
-                if (finder.limitReached()) {
-                    wxString msg;
-                    msg << "The configured limit has been reached. Only " << finder.maxCount << " results will be displayed.";
-                    g_gui.PopupDialog("Notice", msg, wxOK);
-                }
-                
+                const MapSearch::IdSet wanted = MapSearch::makeIdSet({}, ranges) & ~dialog.GetIgnoredIdSet();
+
                 SearchResultWindow* resultWindow = g_gui.ShowSearchWindow();
                 resultWindow->Clear();
-                for (const auto& pair : result) {
-                    resultWindow->AddPosition(wxString::Format("%s (ID: %d)", 
-                        wxstr(pair.second->getName()),
-                        pair.second->getID()), pair.first->getPosition());
-                }
+                resultWindow->SetIgnoredIds(dialog.GetIgnoreIdsText(), dialog.IsIgnoreIdsEnabled());
+                OnSearchForItem::StreamSearch(g_gui.GetCurrentMap(), [&wanted](const Tile*, const Item* item) {
+                    return wanted.test(item->getID());
+                }, false, resultWindow, "Searching map...");
             }
         } else {
-            OnSearchForItem::Finder finder(dialog.getResultID(), (uint32_t)g_settings.getInteger(Config::REPLACE_SIZE));
-            g_gui.CreateLoadBar("Searching map...");
-
-            foreach_ItemOnMap(g_gui.GetCurrentMap(), finder, false);
-            std::vector<std::pair<Tile*, Item*>>& result = finder.result;
-
-            g_gui.DestroyLoadBar();
-
-            if (finder.limitReached()) {
-                wxString msg;
-                msg << "The configured limit has been reached. Only " << finder.maxCount << " results will be displayed.";
-                g_gui.PopupDialog("Notice", msg, wxOK);
-            }
+            const uint16_t item_id = dialog.getResultID();
+            Map& map = g_gui.GetCurrentMap();
 
             SearchResultWindow* window = g_gui.ShowSearchWindow();
             window->Clear();
-
-            for (std::vector<std::pair<Tile*, Item*>>::const_iterator iter = result.begin(); iter != result.end(); ++iter) {
-                Tile* tile = iter->first;
-                Item* item = iter->second;
-                
-                // Format description to include both name and ID
-                wxString description = wxString::Format("%s (ID: %d)", 
-                    wxstr(item->getName()),
-                    item->getID());
-                
-                OutputDebugStringA(wxString::Format("Adding search result: %s at pos(%d,%d,%d)\n", 
-                    description, tile->getPosition().x, tile->getPosition().y, tile->getPosition().z).c_str());
-                
-                window->AddPosition(description, tile->getPosition());
+            window->SetIgnoredIds(dialog.GetIgnoreIdsText(), dialog.IsIgnoreIdsEnabled());
+
+            // The item index only visits the areas holding the item, search the whole map until it is built
+            OnSearchForItem::Finder finder(item_id, (uint32_t)g_settings.getInteger(Config::REPLACE_SIZE));
+            std::shared_ptr<ItemIndex> index = map.getItemIndex();
+            bool indexed = index && index->findItems(map, item_id, [&finder](Tile* tile, Item* item) {
+                finder.result.push_back(std::make_pair(tile, item));
+                return !finder.limitReached();
+            });
+            if (indexed) {
+                if (finder.limitReached()) {
+                    wxString msg;
+                    msg << "The configured limit has been reached. Only " << finder.maxCount << " results will be displayed.";
+                    g_gui.PopupDialog("Notice", msg, wxOK);
+                }
+                window->AddItems(finder.result);
+            } else {
+                OnSearchForItem::StreamSearch(map, [item_id](const Tile*, const Item* item) {
+                    return item->getID() == item_id;
+                }, false, window, "Searching map...");
             }
         }
 
@@ -1402,74 +1460,37 @@ void MainMenuBar::OnSearchForItemOnSelection(wxCommandEvent& WXUNUSED(event)) {
 		if (dialog.getUseRange()) {
 			auto ranges = dialog.ParseRangeString(dialog.GetRangeInput());
 			if (!ranges.empty()) {
-				OnSearchForItem::RangeFinder finder(ranges);
-				g_gui.CreateLoadBar("Searching on selected area...");
-				
-				foreach_ItemOnMap(g_gui.GetCurrentMap(), finder, true);
-				std::vector<std::pair<Tile*, Item*>>& result = finder.result;
-				
-				g_gui.DestroyLoadBar();
-				
-				if (finder.limitReached()) {
-					wxString msg;
-					msg << "The configured limit has been reached. Only " << finder.maxCount << " results will be displayed.";
-					g_gui.PopupDialog("Notice", msg, wxOK);
-				}
-				
+				const MapSearch::IdSet wanted = MapSearch::makeIdSet({}, ranges) & ~dialog.GetIgnoredIdSet();
+
 				SearchResultWindow* resultWindow = g_gui.ShowSearchWindow();
 				resultWindow->Clear();
-				
+
 				// Pass the ignored IDs configuration from the dialog
 				resultWindow->SetIgnoredIds(dialog.GetIgnoreIdsText(), dialog.IsIgnoreIdsEnabled());
-				
+
+				uint16_t firstItemId = 0;
+				OnSearchForItem::StreamSearch(g_gui.GetCurrentMap(), [&wanted](const Tile*, const Item* item) {
+					return wanted.test(item->getID());
+				}, true, resultWindow, "Searching on selected area...", &firstItemId);
+
 				// Store search parameters for range searches to enable continuation
-				uint16_t firstItemId = result.empty() ? 0 : result[0].second->getID();
 				resultWindow->StoreSearchInfo(firstItemId, true);
-
-				for (const auto& pair : result) {
-					resultWindow->AddPosition(wxString::Format("%s (ID: %d)", 
-						wxstr(pair.second->getName()),
-						pair.second->getID()), pair.first->getPosition());
-				}
 			}
 		} else {
-			OnSearchForItem::Finder finder(dialog.getResultID(), (uint32_t)g_settings.getInteger(Config::REPLACE_SIZE));
-			g_gui.CreateLoadBar("Searching on selected area...");
-
-			foreach_ItemOnMap(g_gui.GetCurrentMap(), finder, true);
-			std::vector<std::pair<Tile*, Item*>>& result = finder.result;
-
-			g_gui.DestroyLoadBar();
-
-			if (finder.limitReached()) {
-				wxString msg;
-				msg << "The configured limit has been reached. Only " << finder.maxCount << " results will be displayed.";
-				g_gui.PopupDialog("Notice", msg, wxOK);
-			}
+			const uint16_t item_id = dialog.getResultID();
 
 			SearchResultWindow* window = g_gui.ShowSearchWindow();
 			window->Clear();
 
 			// Pass the ignored IDs configuration from the dialog
 			window->SetIgnoredIds(dialog.GetIgnoreIdsText(), dialog.IsIgnoreIdsEnabled());
-            
-            // Store search parameters for continuation
-            window->StoreSearchInfo(dialog.getResultID(), true);
-
-			for (std::vector<std::pair<Tile*, Item*>>::const_iterator iter = result.begin(); iter != result.end(); ++iter) {
-				Tile* tile = iter->first;
-				Item* item = iter->second;
-				
-				// Format description to include both name and ID
-				wxString description = wxString::Format("%s (ID: %d)", 
-					wxstr(item->getName()),
-					item->getID());
-				
-				OutputDebugStringA(wxString::Format("Adding search result: %s at pos(%d,%d,%d)\n", 
-					description, tile->getPosition().x, tile->getPosition().y, tile->getPosition().z).c_str());
-				
-				window->AddPosition(description, tile->getPosition());
-			}
+
+			OnSearchForItem::StreamSearch(g_gui.GetCurrentMap(), [item_id](const Tile*, const Item* item) {
+				return item->getID() == item_id;
+			}, true, window, "Searching on selected area...");
+
+			// Store search parameters for continuation
+			window->StoreSearchInfo(item_id, true);
 		}
 
 		g_settings.setInteger(Config::FIND_ITEM_MODE, (int)dialog.getSearchMode());
@@ -1585,7 +1606,7 @@ void MainMenuBar::OnBorderizeMap(wxCommandEvent& WXUNUSED(event)) {
     }
 
     int ret = g_gui.PopupDialog("Borderize Map", 
-        "Do you want to borderize the entire map? This will process the map in chunks.", wxYES | wxNO);
+        "Do you want to borderize the entire map? This can be undone as a single action.", wxYES | wxNO);
     if (ret == wxID_YES) {
         g_gui.GetCurrentEditor()->borderizeMap(true);
     }
@@ -1608,7 +1629,7 @@ void MainMenuBar::OnWallizeMap(wxCommandEvent& WXUNUSED(event)) {
     }
 
     int ret = g_gui.PopupDialog("Wallize Map", 
-        "Do you want to wallize the entire map? This will process the map in chunks.", wxYES | wxNO);
+        "Do you want to wallize the entire map? This can be undone as a single action.", wxYES | wxNO);
     if (ret == wxID_YES) {
         g_gui.GetCurrentEditor()->wallizeMap(true);
     }
@@ -2768,6 +2789,7 @@ void MainMenuBar::OnChangeViewSettings(wxCommandEvent& event) {
 	g_settings.setInteger(Config::HOUSE_CUSTOM_COLORS, IsItemChecked(MenuBar::HOUSE_CUSTOM_COLORS));
 
 	g_settings.setInteger(Config::EXPERIMENTAL_FOG, IsItemChecked(MenuBar::EXPERIMENTAL_FOG));
+	g_settings.setInteger(Config::SHOW_RENDER_PROFILER, IsItemChecked(MenuBar::EXPERIMENTAL_RENDER_PROFILER));
 
 	g_gui.RefreshView();
 }
@@ -3065,7 +3087,24 @@ void MainMenuBar::SearchItems(bool unique, bool action, bool container, bool wri
         searcher.uniqueRanges = uniqueRanges;
         searcher.actionRanges = actionRanges;
 
-        foreach_ItemOnMap(g_gui.GetCurrentMap(), searcher, onSelection);
+        // Plain unique or action id searches over the whole map can use the item index
+        Map& map = g_gui.GetCurrentMap();
+        std::shared_ptr<ItemIndex> index = map.getItemIndex();
+        bool indexed = false;
+        if (index && !onSelection && !container && !writable && !zones && unique != action) {
+            const std::vector<std::pair<uint16_t, uint16_t>>& ranges = unique ? uniqueRanges : actionRanges;
+            auto accept = [&searcher, &ranges](uint16_t id) {
+                return searcher.isInRanges(id, ranges);
+            };
+            auto found = [&searcher](Tile* tile, Item* item) {
+                searcher.found.push_back(std::make_pair(tile, item));
+                return true;
+            };
+            indexed = unique ? index->findUniqueIDs(map, accept, found) : index->findActionIDs(map, accept, found);
+        }
+        if (!indexed) {
+            foreach_ItemOnMap(map, searcher, onSelection);
+        }
         searcher.sort();
         std::vector<std::pair<Tile*, Item*>>& found = searcher.found;
 
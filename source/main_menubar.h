@@ -38,6 +38,7 @@ namespace MenuBar {
 		IMPORT_MINIMAP,
 		EXPORT_MINIMAP,
 		EXPORT_TILESETS,
+		EXPORT_MAP_RENDER,
 		RELOAD_DATA,
 		RELOAD_REVSCRIPTS,
 		RECENT_FILES,
@@ -45,6 +46,7 @@ namespace MenuBar {
 		EXIT,
 		UNDO,
 		REDO,
+		UNDO_HISTORY_STATS,
 		FIND_ITEM,
 		FIND_CREATURE,
 		REPLACE_ITEMS,
@@ -168,6 +170,7 @@ namespace MenuBar {
 		FLOOR_14,
 		FLOOR_15,
 		DEBUG_VIEW_DAT,
+		DEBUG_GRAPHICS_STATS,
 		EXTENSIONS,
 		GOTO_WEBSITE,
 		ABOUT,
@@ -175,6 +178,8 @@ namespace MenuBar {
 		ID_MENU_SERVER_CONNECT,
 
 		EXPERIMENTAL_FOG,
+		EXPERIMENTAL_RENDER_PROFILER,
+		EXPORT_RENDER_TRACE,
 		MAP_REMOVE_DUPLICATES,
 		SHOW_HOTKEYS,
 			SHOW_MONSTER_MAKER,
@@ -241,12 +246,14 @@ public:
 	void OnImportMinimap(wxCommandEvent& event);
 	void OnExportMinimap(wxCommandEvent& event);
 	void OnExportTilesets(wxCommandEvent& event);
+	void OnExportMapRender(wxCommandEvent& event);
 	void OnReloadDataFiles(wxCommandEvent& event);
 	void OnReloadRevScripts(wxCommandEvent& event);
 
 	// Edit Menu
 	void OnUndo(wxCommandEvent& event);
 	void OnRedo(wxCommandEvent& event);
+	void OnUndoHistoryStats(wxCommandEvent& event);
 	void OnBorderizeSelection(wxCommandEvent& event);
 	void OnBorderizeMap(wxCommandEvent& event);
 	void OnWallizeSelection(wxCommandEvent& event);
@@ -339,6 +346,8 @@ public:
 
 	// About Menu
 	void OnDebugViewDat(wxCommandEvent& event);
+	void OnDebugGraphicsStats(wxCommandEvent& event);
+	void OnExportRenderTrace(wxCommandEvent& event);
 	void OnListExtensions(wxCommandEvent& event);
 	void OnGotoWebsite(wxCommandEvent& event);
 	void OnAbout(wxCommandEvent& event);
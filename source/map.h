@@ -26,6 +26,8 @@
 #include "complexitem.h"
 #include "waypoints.h"
 #include "templates.h"
+#include "minimap_exporter.h"
+#include "item_index.h"
 
 // Add this struct before the Map class definition
 struct PropertyFlags {
@@ -89,8 +91,10 @@ public:
 	uint32_t validateZoneConsistency(bool showdialog = false);
 	void fixInconsistentZones();
 
-	// Save a bmp image of the minimap
+	// Save a minimap image of a floor, bmp or png depending on the extension
 	bool exportMinimap(FileName filename, int floor = GROUND_LAYER, bool showdialog = false);
+	// Exports several floors at once, see MinimapExporter
+	bool exportMinimap(const std::vector<MinimapExporter::Job>& jobs, bool showdialog = false);
 	//
 	bool convert(MapVersion to, bool showdialog = false);
 	bool convert(const ConversionMap& cm, bool showdialog = false);
@@ -223,6 +227,47 @@ public:
 	Waypoints waypoints;
 };
 
+// Visits the item and then everything stored in it, breadth first like
+// foreach_ItemOnMap. Stops and returns false once visit returns false.
+template <typename VisitType>
+inline bool foreach_ItemInItem(Item* item, VisitType& visit) {
+	if (!visit(item)) {
+		return false;
+	}
+
+	Container* container = item->getContainer();
+	if (!container) {
+		return true;
+	}
+
+	std::vector<Container*> containers(1, container);
+	for (size_t i = 0; i < containers.size(); ++i) {
+		for (Item* content : containers[i]->getVector()) {
+			if (!visit(content)) {
+				return false;
+			}
+			if (Container* inner = content->getContainer()) {
+				containers.push_back(inner);
+			}
+		}
+	}
+	return true;
+}
+
+// Visits every item of the tile, ground first, in the order foreach_ItemOnMap uses
+template <typename VisitType>
+inline bool foreach_ItemOnTile(Tile* tile, VisitType& visit) {
+	if (tile->ground && !foreach_ItemInItem(tile->ground, visit)) {
+		return false;
+	}
+	for (Item* item : tile->items) {
+		if (!foreach_ItemInItem(item, visit)) {
+			return false;
+		}
+	}
+	return true;
+}
+
 template <typename ForeachType>
 inline void foreach_ItemOnMap(Map& map, ForeachType& foreach, bool selectedTiles) {
 	MapIterator tileiter = map.begin();
@@ -322,6 +367,7 @@ inline int64_t RemoveItemOnMap(Map& map, RemoveIfType& condition, bool selectedO
 
 		if (tile->ground) {
 			if (condition(map, tile->ground, removed, done)) {
+				map.onItemRemoved(tile->getPosition(), tile->ground);
 				delete tile->ground;
 				tile->ground = nullptr;
 				++removed;
@@ -331,6 +377,7 @@ inline int64_t RemoveItemOnMap(Map& map, RemoveIfType& condition, bool selectedO
 		for (auto iit = tile->items.begin(); iit != tile->items.end();) {
 			Item* item = *iit;
 			if (condition(map, item, removed, done)) {
+				map.onItemRemoved(tile->getPosition(), item);
 				iit = tile->items.erase(iit);
 				delete item;
 				++removed;
@@ -47,6 +47,8 @@
 #include "browse_tile_window.h"
 
 #include "minimap_window.h"
+#include "render_profiler.h"
+#include "trace.h"
 
 #include "doodad_brush.h"
 #include "house_exit_brush.h"
@@ -219,6 +221,9 @@ void MapCanvas::GetViewBox(int* view_scroll_x, int* view_scroll_y, int* screensi
 void MapCanvas::OnPaint(wxPaintEvent& event) {
 	SetCurrent(*g_gui.GetGLContext(this));
 
+	g_render_profiler.setEnabled(g_settings.getBoolean(Config::SHOW_RENDER_PROFILER));
+	g_render_profiler.beginFrame();
+
 	if (g_gui.IsRenderingEnabled()) {
 		DrawingOptions& options = drawer->getOptions();
 		if (screenshot_buffer) {
@@ -256,6 +261,7 @@ void MapCanvas::OnPaint(wxPaintEvent& event) {
 			options.extended_house_shader = g_settings.getBoolean(Config::EXT_HOUSE_SHADER);
 
 			options.experimental_fog = g_settings.getBoolean(Config::EXPERIMENTAL_FOG);
+			options.show_profiler = g_render_profiler.isEnabled();
 		}
 
 		options.dragging = boundbox_selection;
@@ -266,8 +272,11 @@ void MapCanvas::OnPaint(wxPaintEvent& event) {
 			animation_timer->Stop();
 		}
 
-		drawer->SetupVars();
-		drawer->SetupGL();
+		{
+			RenderProfiler::Scope scope(g_render_profiler, RenderProfiler::STAGE_SETUP);
+			drawer->SetupVars();
+			drawer->SetupGL();
+		}
 		drawer->Draw();
 
 		if (screenshot_buffer) {
@@ -278,10 +287,18 @@ void MapCanvas::OnPaint(wxPaintEvent& event) {
 	}
 
 	// Clean unused textures
-	g_gui.gfx.garbageCollection();
+	{
+		RenderProfiler::Scope scope(g_render_profiler, RenderProfiler::STAGE_TEXTURE_CLEANUP);
+		g_gui.gfx.garbageCollection();
+	}
 
 	// Swap buffer
-	SwapBuffers();
+	{
+		RenderProfiler::Scope scope(g_render_profiler, RenderProfiler::STAGE_SWAP_BUFFERS);
+		SwapBuffers();
+	}
+
+	g_render_profiler.endFrame();
 
 	// Send newd node requests
 	editor.SendNodeRequests();
@@ -466,6 +483,8 @@ void MapCanvas::UpdateZoomStatus() {
 }
 
 void MapCanvas::OnMouseMove(wxMouseEvent& event) {
+	RenderProfiler::Scope profile_scope(g_render_profiler, RenderProfiler::STAGE_MOUSE_MOVE);
+
 	if (screendragging) {
 		static_cast<MapWindow*>(GetParent())->ScrollRelative(int(g_settings.getFloat(Config::SCROLL_SPEED) * zoom * (event.GetX() - cursor_x)), int(g_settings.getFloat(Config::SCROLL_SPEED) * zoom * (event.GetY() - cursor_y)));
 		Refresh();
@@ -501,10 +520,7 @@ void MapCanvas::OnMouseMove(wxMouseEvent& event) {
 			int move_z = drag_start_z - floor;
 			
 			// Add debugging output for drag calculations
-			char debug_msg[512];
-			sprintf(debug_msg, "DEBUG DRAG: Dragging detected - start_pos=(%d,%d,%d), mouse_pos=(%d,%d,%d), move_offset=(%d,%d,%d)\n", 
-				drag_start_x, drag_start_y, drag_start_z, mouse_map_x, mouse_map_y, floor, move_x, move_y, move_z);
-			OutputDebugStringA(debug_msg);
+			TRACE_DEBUG(Selection, "Dragging detected - start_pos=(%d,%d,%d), mouse_pos=(%d,%d,%d), move_offset=(%d,%d,%d)", drag_start_x, drag_start_y, drag_start_z, mouse_map_x, mouse_map_y, floor, move_x, move_y, move_z);
 			
 			ss << "Dragging " << -move_x << "," << -move_y << "," << -move_z;
 			g_gui.SetStatusText(ss);
@@ -608,10 +624,14 @@ void MapCanvas::OnMouseMove(wxMouseEvent& event) {
 }
 
 void MapCanvas::OnMouseLeftRelease(wxMouseEvent& event) {
+	RenderProfiler::Scope profile_scope(g_render_profiler, RenderProfiler::STAGE_MOUSE_RELEASE);
+
 	OnMouseActionRelease(event);
 }
 
 void MapCanvas::OnMouseLeftClick(wxMouseEvent& event) {
+	RenderProfiler::Scope profile_scope(g_render_profiler, RenderProfiler::STAGE_MOUSE_CLICK);
+
 	OnMouseActionClick(event);
 }
 
@@ -653,6 +673,8 @@ void MapCanvas::OnMouseLeftDoubleClick(wxMouseEvent& event) {
 }
 
 void MapCanvas::OnMouseCenterClick(wxMouseEvent& event) {
+	RenderProfiler::Scope profile_scope(g_render_profiler, RenderProfiler::STAGE_MOUSE_CLICK);
+
 	if (g_settings.getInteger(Config::SWITCH_MOUSEBUTTONS)) {
 		OnMousePropertiesClick(event);
 	} else {
@@ -661,6 +683,8 @@ void MapCanvas::OnMouseCenterClick(wxMouseEvent& event) {
 }
 
 void MapCanvas::OnMouseCenterRelease(wxMouseEvent& event) {
+	RenderProfiler::Scope profile_scope(g_render_profiler, RenderProfiler::STAGE_MOUSE_RELEASE);
+
 	if (g_settings.getInteger(Config::SWITCH_MOUSEBUTTONS)) {
 		OnMousePropertiesRelease(event);
 	} else {
@@ -669,6 +693,8 @@ void MapCanvas::OnMouseCenterRelease(wxMouseEvent& event) {
 }
 
 void MapCanvas::OnMouseRightClick(wxMouseEvent& event) {
+	RenderProfiler::Scope profile_scope(g_render_profiler, RenderProfiler::STAGE_MOUSE_CLICK);
+
 	if (g_settings.getInteger(Config::SWITCH_MOUSEBUTTONS)) {
 		OnMouseCameraClick(event);
 	} else {
@@ -677,6 +703,8 @@ void MapCanvas::OnMouseRightClick(wxMouseEvent& event) {
 }
 
 void MapCanvas::OnMouseRightRelease(wxMouseEvent& event) {
+	RenderProfiler::Scope profile_scope(g_render_profiler, RenderProfiler::STAGE_MOUSE_RELEASE);
+
 	if (g_settings.getInteger(Config::SWITCH_MOUSEBUTTONS)) {
 		OnMouseCameraRelease(event);
 	} else {
@@ -966,24 +994,17 @@ void MapCanvas::OnMouseActionRelease(wxMouseEvent& event) {
 	int move_z = last_click_map_z - floor;
 	
 	// Add debugging output for mouse action release
-	char debug_msg[512];
-	sprintf(debug_msg, "DEBUG DRAG: OnMouseActionRelease - mouse_pos=(%d,%d), last_click=(%d,%d,%d), move_offset=(%d,%d,%d)\n", 
-		mouse_map_x, mouse_map_y, last_click_map_x, last_click_map_y, last_click_map_z, move_x, move_y, move_z);
-	OutputDebugStringA(debug_msg);
+	TRACE_DEBUG(Selection, "OnMouseActionRelease - mouse_pos=(%d,%d), last_click=(%d,%d,%d), move_offset=(%d,%d,%d)", mouse_map_x, mouse_map_y, last_click_map_x, last_click_map_y, last_click_map_z, move_x, move_y, move_z);
 
 	if (g_gui.IsSelectionMode()) {
 		if (dragging && (move_x != 0 || move_y != 0 || move_z != 0)) {
-			sprintf(debug_msg, "DEBUG DRAG: Calling editor.moveSelection with Position(%d,%d,%d), dragging=%d\n", 
-				move_x, move_y, move_z, dragging);
-			OutputDebugStringA(debug_msg);
+			TRACE_DEBUG(Selection, "Calling editor.moveSelection with Position(%d,%d,%d), dragging=%d", move_x, move_y, move_z, dragging);
 			
 			editor.moveSelection(Position(move_x, move_y, move_z));
 			
-			OutputDebugStringA("DEBUG DRAG: editor.moveSelection completed\n");
+			TRACE_DEBUG(Selection, "editor.moveSelection completed");
 		} else {
-			sprintf(debug_msg, "DEBUG DRAG: Not moving selection - dragging=%d, move_offset=(%d,%d,%d)\n", 
-				dragging, move_x, move_y, move_z);
-			OutputDebugStringA(debug_msg);
+			TRACE_DEBUG(Selection, "Not moving selection - dragging=%d, move_offset=(%d,%d,%d)", dragging, move_x, move_y, move_z);
 			
 			if (boundbox_selection) {
 				if (mouse_map_x == last_click_map_x && mouse_map_y == last_click_map_y && event.ControlDown()) {
@@ -1012,9 +1033,6 @@ void MapCanvas::OnMouseActionRelease(wxMouseEvent& event) {
 						last_click_map_y = tmp;
 					}
 
-					int numtiles = 0;
-					int threadcount = std::max(g_settings.getInteger(Config::WORKER_THREADS), 1);
-
 					int start_x = 0, start_y = 0, start_z = 0;
 					int end_x = 0, end_y = 0, end_z = 0;
 
@@ -1042,8 +1060,6 @@ void MapCanvas::OnMouseActionRelease(wxMouseEvent& event) {
 								end_x -= (floor < GROUND_LAYER ? GROUND_LAYER - floor : 0);
 								end_y -= (floor < GROUND_LAYER ? GROUND_LAYER - floor : 0);
 							}
-
-							numtiles = (start_z - end_z) * (end_x - start_x) * (end_y - start_y);
 							break;
 						}
 						case SELECT_VISIBLE_FLOORS: {
@@ -1069,53 +1085,8 @@ void MapCanvas::OnMouseActionRelease(wxMouseEvent& event) {
 						}
 					}
 
-					if (numtiles < 500) {
-						// No point in threading for such a small set.
-						threadcount = 1;
-					}
-					// Subdivide the selection area
-					// We know it's a square, just split it into several areas
-					int width = end_x - start_x;
-					if (width < threadcount) {
-						threadcount = min(1, width);
-					}
-					
-					// CRITICAL FIX: Prevent division by zero
-					if (threadcount <= 0) {
-						char debug_msg[256];
-						sprintf(debug_msg, "DEBUG DRAG: CRITICAL ERROR! threadcount=%d, width=%d - FORCING threadcount to 1\n", threadcount, width);
-						OutputDebugStringA(debug_msg);
-						threadcount = 1;
-					}
-					
-					// Let's divide!
-					int remainder = width;
-					int cleared = 0;
-					std::vector<SelectionThread*> threads;
-					if (width == 0) {
-						threads.push_back(newd SelectionThread(editor, Position(start_x, start_y, start_z), Position(start_x, end_y, end_z)));
-					} else {
-						for (int i = 0; i < threadcount; ++i) {
-							int chunksize = width / threadcount;
-							// The last threads takes all the remainder
-							if (i == threadcount - 1) {
-								chunksize = remainder;
-							}
-							threads.push_back(newd SelectionThread(editor, Position(start_x + cleared, start_y, start_z), Position(start_x + cleared + chunksize, end_y, end_z)));
-							cleared += chunksize;
-							remainder -= chunksize;
-						}
-					}
-					ASSERT(cleared == width);
-					ASSERT(remainder == 0);
-
 					editor.selection.start(); // Start a selection session
-					for (std::vector<SelectionThread*>::iterator iter = threads.begin(); iter != threads.end(); ++iter) {
-						(*iter)->Execute();
-					}
-					for (std::vector<SelectionThread*>::iterator iter = threads.begin(); iter != threads.end(); ++iter) {
-						editor.selection.join(*iter);
-					}
+					editor.selection.addArea(Position(start_x, start_y, start_z), Position(end_x, end_y, end_z), g_settings.getInteger(Config::COMPENSATED_SELECT));
 					editor.selection.finish(); // Finish the selection session
 					editor.selection.updateSelectionCount();
 				}
@@ -1169,17 +1140,13 @@ void MapCanvas::OnMouseActionRelease(wxMouseEvent& event) {
 				// CRITICAL FIX: Prevent division by zero in spawn size calculation
 				int raw_width = (end_map_x - start_map_x) / 2 + (end_map_y - start_map_y) / 2;
 				if (raw_width <= 0) {
-					char debug_msg[256];
-					sprintf(debug_msg, "DEBUG DRAG: WARNING! Spawn calculation resulted in width %d - FORCING TO 1\n", raw_width);
-					OutputDebugStringA(debug_msg);
+					TRACE_WARNING(Selection, "Spawn calculation resulted in width %d - FORCING TO 1", raw_width);
 					raw_width = 1;
 				}
 				
 				int width = min(g_settings.getInteger(Config::MAX_SPAWN_RADIUS), raw_width / 2);
 				if (width <= 0) {
-					char debug_msg[256];
-					sprintf(debug_msg, "DEBUG DRAG: WARNING! Final spawn width %d - FORCING TO 1\n", width);
-					OutputDebugStringA(debug_msg);
+					TRACE_WARNING(Selection, "Final spawn width %d - FORCING TO 1", width);
 					width = 1;
 				}
 				
@@ -1389,10 +1356,10 @@ void MapCanvas::OnMousePropertiesRelease(wxMouseEvent& event) {
 	ScreenToMap(event.GetX(), event.GetY(), &mouse_map_x, &mouse_map_y);
 
 #ifdef __WXDEBUG__
-	printf("DEBUG: Right-click release at map position %d,%d,%d\n", mouse_map_x, mouse_map_y, floor);
+	TRACE_DEBUG(Selection, "Right-click release at map position %d,%d,%d", mouse_map_x, mouse_map_y, floor);
 	Tile* tile = editor.map.getTile(mouse_map_x, mouse_map_y, floor);
 	if (tile && tile->ground) {
-		printf("DEBUG: Tile has ground at %p\n", tile->ground);
+		TRACE_DEBUG(Selection, "Tile has ground at %p", tile->ground);
 	}
 #endif
 
@@ -1537,11 +1504,9 @@ void MapCanvas::OnMousePropertiesRelease(wxMouseEvent& event) {
 	ScreenToMap(event.GetX(), event.GetY(), &debug_mouse_x, &debug_mouse_y);
 	Tile* debug_tile = editor.map.getTile(debug_mouse_x, debug_mouse_y, floor);
 	
-	printf("DEBUG: Before popup menu - Tile at %d,%d,%d: %p\n", 
-		debug_mouse_x, debug_mouse_y, floor, debug_tile);
+	TRACE_DEBUG(Selection, "Before popup menu - Tile at %d,%d,%d: %p", debug_mouse_x, debug_mouse_y, floor, debug_tile);
 	if (debug_tile && debug_tile->ground) {
-		printf("DEBUG: Before popup menu - Tile has ground %p (ID:%d)\n", 
-			debug_tile->ground, debug_tile->ground->getID());
+		TRACE_DEBUG(Selection, "Before popup menu - Tile has ground %p (ID:%d)", debug_tile->ground, debug_tile->ground->getID());
 	}
 #endif
 
@@ -1550,11 +1515,9 @@ void MapCanvas::OnMousePropertiesRelease(wxMouseEvent& event) {
 #ifdef __WXDEBUG__
 	// Debug the state of the tiles after showing popup menu
 	debug_tile = editor.map.getTile(debug_mouse_x, debug_mouse_y, floor);
-	printf("DEBUG: After popup menu - Tile at %d,%d,%d: %p\n", 
-		debug_mouse_x, debug_mouse_y, floor, debug_tile);
+	TRACE_DEBUG(Selection, "After popup menu - Tile at %d,%d,%d: %p", debug_mouse_x, debug_mouse_y, floor, debug_tile);
 	if (debug_tile && debug_tile->ground) {
-		printf("DEBUG: After popup menu - Tile has ground %p (ID:%d)\n", 
-			debug_tile->ground, debug_tile->ground->getID());
+		TRACE_DEBUG(Selection, "After popup menu - Tile has ground %p (ID:%d)", debug_tile->ground, debug_tile->ground->getID());
 	}
 #endif
 
@@ -1570,6 +1533,8 @@ void MapCanvas::OnMousePropertiesRelease(wxMouseEvent& event) {
 }
 
 void MapCanvas::OnWheel(wxMouseEvent& event) {
+	RenderProfiler::Scope profile_scope(g_render_profiler, RenderProfiler::STAGE_MOUSE_WHEEL);
+
 	if (event.ControlDown()) {
 		static double diff = 0.0;
 		diff += event.GetWheelRotation();
@@ -1640,6 +1605,8 @@ void MapCanvas::OnGainMouse(wxMouseEvent& event) {
 }
 
 void MapCanvas::OnKeyDown(wxKeyEvent& event) {
+	RenderProfiler::Scope profile_scope(g_render_profiler, RenderProfiler::STAGE_KEY_DOWN);
+
 	// char keycode = event.GetKeyCode();
 	//  std::cout << "Keycode " << keycode << std::endl;
 	switch (event.GetKeyCode()) {
@@ -1959,16 +1926,12 @@ void MapCanvas::OnKeyUp(wxKeyEvent& event) {
 			
 			// CRITICAL FIX: Prevent zero-sized brushes after movement
 			if (width <= 0) {
-				char debug_msg[256];
-				sprintf(debug_msg, "DEBUG DRAG: WARNING! Movement resulted in width %d - FORCING TO 1\n", width);
-				OutputDebugStringA(debug_msg);
+				TRACE_WARNING(Selection, "Movement resulted in width %d - FORCING TO 1", width);
 				width = 1;
 			}
 			
 			if (height <= 0) {
-				char debug_msg[256];
-				sprintf(debug_msg, "DEBUG DRAG: WARNING! Movement resulted in height %d - FORCING TO 1\n", height);
-				OutputDebugStringA(debug_msg);
+				TRACE_WARNING(Selection, "Movement resulted in height %d - FORCING TO 1", height);
 				height = 1;
 			}
 			
@@ -2258,7 +2221,7 @@ void MapCanvas::OnBrowseTile(wxCommandEvent& WXUNUSED(event)) {
 	
 #ifdef __WXDEBUG__
 	if (tile->ground) {
-		printf("DEBUG: Original tile %p has ground %p before deepCopy\n", tile, tile->ground);
+		TRACE_DEBUG(Selection, "Original tile %p has ground %p before deepCopy", tile, tile->ground);
 	}
 #endif
 
@@ -2266,7 +2229,7 @@ void MapCanvas::OnBrowseTile(wxCommandEvent& WXUNUSED(event)) {
 
 #ifdef __WXDEBUG__
 	if (new_tile->ground) {
-		printf("DEBUG: New tile %p has ground %p after deepCopy\n", new_tile, new_tile->ground);
+		TRACE_DEBUG(Selection, "New tile %p has ground %p after deepCopy", new_tile, new_tile->ground);
 	}
 #endif
 
@@ -3050,22 +3013,19 @@ void MapCanvas::getTilesToDraw(int mouse_map_x, int mouse_map_y, int floor, Posi
 			int brush_height = g_gui.GetBrushHeight();
 			
 			// Add debugging output for brush dimensions
-			char debug_msg[512];
-			sprintf(debug_msg, "DEBUG DRAG: Initial brush dimensions - width=%d, height=%d\n", brush_width, brush_height);
-			OutputDebugStringA(debug_msg);
+			TRACE_DEBUG(Selection, "Initial brush dimensions - width=%d, height=%d", brush_width, brush_height);
 			
 			// Make sure we have valid non-zero dimensions
 			if (brush_width <= 0) {
-				OutputDebugStringA("DEBUG DRAG: WARNING! brush_width <= 0, forcing to 1\n");
+				TRACE_WARNING(Selection, "brush_width <= 0, forcing to 1");
 				brush_width = 1;
 			}
 			if (brush_height <= 0) {
-				OutputDebugStringA("DEBUG DRAG: WARNING! brush_height <= 0, forcing to 1\n");
+				TRACE_WARNING(Selection, "brush_height <= 0, forcing to 1");
 				brush_height = 1;
 			}
 			
-			sprintf(debug_msg, "DEBUG DRAG: Corrected brush dimensions - width=%d, height=%d\n", brush_width, brush_height);
-			OutputDebugStringA(debug_msg);
+			TRACE_DEBUG(Selection, "Corrected brush dimensions - width=%d, height=%d", brush_width, brush_height);
 			
 			// For even-sized brushes, we need to adjust the offset
 			int width_offset = (brush_width % 2 == 0) ? 0 : 1;
@@ -3089,9 +3049,7 @@ void MapCanvas::getTilesToDraw(int mouse_map_x, int mouse_map_y, int floor, Posi
 			int border_end_x = end_x + 1;
 			int border_end_y = end_y + 1;
 			
-			sprintf(debug_msg, "DEBUG DRAG: Calculated bounds - start_x=%d, start_y=%d, end_x=%d, end_y=%d\n", 
-				start_x, start_y, end_x, end_y);
-			OutputDebugStringA(debug_msg);
+			TRACE_DEBUG(Selection, "Calculated bounds - start_x=%d, start_y=%d, end_x=%d, end_y=%d", start_x, start_y, end_x, end_y);
 				
 			// Draw with a 1-tile margin around the brush for the border/preview
 			for (int y = border_start_y; y <= border_end_y; y++) {
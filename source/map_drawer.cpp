@@ -44,6 +44,8 @@
 #include "table_brush.h"
 #include "waypoint_brush.h"
 #include "light_drawer.h"
+#include "render_profiler.h"
+#include "trace.h"
 #include "string_utils.h" // For parseIdRangesString, isIdInRanges
 
 // InvisibleItemsColorManager static members
@@ -273,6 +275,7 @@ void DrawingOptions::SetDefault() {
 	show_preview = false;
 	show_hooks = false;
 	hide_items_when_zoomed = true;
+	show_profiler = false;
 }
 
 void DrawingOptions::SetIngame() {
@@ -306,6 +309,7 @@ void DrawingOptions::SetIngame() {
 	show_preview = false;
 	show_hooks = false;
 	hide_items_when_zoomed = false;
+	show_profiler = false;
 }
 
 bool DrawingOptions::isDrawLight() const noexcept {
@@ -313,7 +317,7 @@ bool DrawingOptions::isDrawLight() const noexcept {
 }
 
 MapDrawer::MapDrawer(MapCanvas* canvas) :
-	canvas(canvas), editor(canvas->editor) {
+	canvas(canvas), editor(canvas->editor), offscreen(false) {
 	light_drawer = std::make_shared<LightDrawer>();
 	
 	// Load invisible items color settings
@@ -324,6 +328,14 @@ MapDrawer::~MapDrawer() {
 	Release();
 }
 
+inline int getFloorAdjustment(int floor) {
+	if (floor > GROUND_LAYER) { // Underground
+		return 0; // No adjustment
+	} else {
+		return TileSize * (GROUND_LAYER - floor);
+	}
+}
+
 void MapDrawer::SetupVars() {
 	canvas->MouseToMap(&mouse_map_x, &mouse_map_y);
 	canvas->GetViewBox(&view_scroll_x, &view_scroll_y, &screensize_x, &screensize_y);
@@ -334,7 +346,32 @@ void MapDrawer::SetupVars() {
 	zoom = (float)canvas->GetZoom();
 	tile_size = int(TileSize / zoom); // after zoom
 	floor = canvas->GetFloor();
+	offscreen = false;
+
+	SetupRange();
+}
+
+void MapDrawer::SetupOffscreenVars(int map_x, int map_y, int width, int height, int floor) {
+	// Keep the mouse away from the rendered area
+	mouse_map_x = -1;
+	mouse_map_y = -1;
+	view_scroll_x = map_x * TileSize - getFloorAdjustment(floor);
+	view_scroll_y = map_y * TileSize - getFloorAdjustment(floor);
+	screensize_x = width;
+	screensize_y = height;
+
+	dragging = false;
+	dragging_draw = false;
+
+	zoom = 1.0f;
+	tile_size = TileSize;
+	this->floor = floor;
+	offscreen = true;
 
+	SetupRange();
+}
+
+void MapDrawer::SetupRange() {
 	if (options.show_all_floors) {
 		if (floor <= GROUND_LAYER) {
 			start_z = GROUND_LAYER;
@@ -397,27 +434,65 @@ void MapDrawer::Release() {
 }
 
 void MapDrawer::Draw() {
-	DrawBackground();
-	DrawMap();
+	typedef RenderProfiler::Scope ProfileScope;
+
+	{
+		ProfileScope scope(g_render_profiler, RenderProfiler::STAGE_BACKGROUND);
+		DrawBackground();
+	}
+	{
+		ProfileScope scope(g_render_profiler, RenderProfiler::STAGE_MAP);
+		DrawMap();
+	}
 	if (options.isDrawLight()) {
+		ProfileScope scope(g_render_profiler, RenderProfiler::STAGE_LIGHT);
 		DrawLight();
 	}
-	DrawDraggingShadow();
-	DrawHigherFloors();
+	{
+		ProfileScope scope(g_render_profiler, RenderProfiler::STAGE_DRAGGING_SHADOW);
+		DrawDraggingShadow();
+	}
+	{
+		ProfileScope scope(g_render_profiler, RenderProfiler::STAGE_HIGHER_FLOORS);
+		DrawHigherFloors();
+	}
 	if (options.dragging) {
+		ProfileScope scope(g_render_profiler, RenderProfiler::STAGE_SELECTION_BOX);
 		DrawSelectionBox();
 	}
-	DrawLiveCursors();
-	DrawBrush();
+	{
+		ProfileScope scope(g_render_profiler, RenderProfiler::STAGE_LIVE_CURSORS);
+		DrawLiveCursors();
+	}
+	{
+		ProfileScope scope(g_render_profiler, RenderProfiler::STAGE_BRUSH);
+		DrawBrush();
+	}
 	if (options.show_grid) {
+		ProfileScope scope(g_render_profiler, RenderProfiler::STAGE_GRID);
 		DrawGrid();
 	}
 	if (options.show_ingame_box) {
+		ProfileScope scope(g_render_profiler, RenderProfiler::STAGE_INGAME_BOX);
 		DrawIngameBox();
 	}
 	if (options.show_tooltips) {
+		ProfileScope scope(g_render_profiler, RenderProfiler::STAGE_TOOLTIPS);
 		DrawTooltips();
 	}
+	if (options.show_profiler) {
+		ProfileScope scope(g_render_profiler, RenderProfiler::STAGE_OVERLAY);
+		DrawProfilerOverlay();
+	}
+}
+
+void MapDrawer::DrawOffscreen() {
+	DrawBackground();
+	DrawMap();
+	if (options.isDrawLight()) {
+		DrawLight();
+	}
+	DrawHigherFloors();
 }
 
 void MapDrawer::DrawBackground() {
@@ -434,14 +509,6 @@ void MapDrawer::DrawBackground() {
 	// glEnable(GL_ALPHA_TEST);
 }
 
-inline int getFloorAdjustment(int floor) {
-	if (floor > GROUND_LAYER) { // Underground
-		return 0; // No adjustment
-	} else {
-		return TileSize * (GROUND_LAYER - floor);
-	}
-}
-
 void MapDrawer::DrawMap() {
 	int center_x = start_x + int(screensize_x * zoom / 64);
 	int center_y = start_y + int(screensize_y * zoom / 64);
@@ -541,41 +608,7 @@ void MapDrawer::DrawMap() {
 					}
 				}
 			}
-			for (auto& itZonePos : zoneTiles) {
-				ZoneFinder finder(itZonePos.second);
-				auto zones = finder.findZones();
-
-				for (const auto& itZone : zones) {
-					const FinderPosition center = finder.findClosestToCenter(itZone);
-
-					QTreeNode* nd = editor.getMap().getLeaf(center.x, center.y);
-					TileLocation* location = nd->getTile(center.x, center.y, center.z);
-
-					const Tile* tile = location->get();
-
-					std::ostringstream tooltip;
-					tooltip << "zone id: ";
-					size_t zones = tile->getZoneIds().size();
-					for (const auto& zoneId : tile->getZoneIds()) {
-						tooltip << zoneId;
-						if (--zones > 0) {
-							tooltip << "/";
-						}
-					}
-
-					int offset;
-					if (map_z <= GROUND_LAYER) {
-						offset = (GROUND_LAYER - map_z) * TileSize;
-					}
-					else {
-						offset = TileSize * (floor - map_z);
-					}
-
-					int draw_x = ((tile->getX() * TileSize) - view_scroll_x) - offset;
-					int draw_y = ((tile->getY() * TileSize) - view_scroll_y) - offset;
-					MakeTooltip(draw_x, draw_y + 8, tooltip.str());
-				}
-			}
+			DrawZoneLabels(map_z);
 		}
 
 		if (only_colors) {
@@ -583,7 +616,7 @@ void MapDrawer::DrawMap() {
 		}
 
 		// Draws the doodad preview or the paste preview (or import preview)
-		if (g_gui.secondary_map != nullptr && !options.ingame) {
+		if (g_gui.secondary_map != nullptr && !options.ingame && !offscreen) {
 			Position normalPos;
 			Position to(mouse_map_x, mouse_map_y, floor);
 
@@ -797,10 +830,7 @@ void MapDrawer::DrawDraggingShadow() {
 	// Draw dragging shadow
 	if (!editor.selection.isBusy() && dragging && !options.ingame) {
 		// Add debugging output for dragging shadow drawing
-		char debug_msg[512];
-		sprintf(debug_msg, "DEBUG DRAG: DrawDraggingShadow started - selection_size=%zu, dragging=%d\n", 
-			editor.selection.size(), dragging);
-		OutputDebugStringA(debug_msg);
+		TRACE_DEBUG(Drawing, "DrawDraggingShadow started - selection_size=%zu, dragging=%d", editor.selection.size(), dragging);
 		
 		for (TileSet::iterator tit = editor.selection.begin(); tit != editor.selection.end(); tit++) {
 			Tile* tile = *tit;
@@ -811,17 +841,14 @@ void MapDrawer::DrawDraggingShadow() {
 			move_y = canvas->drag_start_y - mouse_map_y;
 			move_z = canvas->drag_start_z - floor;
 			
-			sprintf(debug_msg, "DEBUG DRAG: Processing tile at pos=(%d,%d,%d), move_offset=(%d,%d,%d)\n", 
-				pos.x, pos.y, pos.z, move_x, move_y, move_z);
-			OutputDebugStringA(debug_msg);
+			TRACE_DEBUG(Drawing, "Processing tile at pos=(%d,%d,%d), move_offset=(%d,%d,%d)", pos.x, pos.y, pos.z, move_x, move_y, move_z);
 
 			pos.x -= move_x;
 			pos.y -= move_y;
 			pos.z -= move_z;
 
 			if (pos.z < 0 || pos.z >= MAP_LAYERS) {
-				sprintf(debug_msg, "DEBUG DRAG: Skipping tile - invalid z coordinate: %d\n", pos.z);
-				OutputDebugStringA(debug_msg);
+				TRACE_DEBUG(Drawing, "Skipping tile - invalid z coordinate: %d", pos.z);
 				continue;
 			}
 
@@ -834,20 +861,16 @@ void MapDrawer::DrawDraggingShadow() {
 					offset = TileSize * (floor - pos.z);
 				}
 				
-				sprintf(debug_msg, "DEBUG DRAG: Calculating offset - pos.z=%d, GROUND_LAYER=%d, floor=%d, TileSize=%d, offset=%d\n", 
-					pos.z, GROUND_LAYER, floor, TileSize, offset);
-				OutputDebugStringA(debug_msg);
+				TRACE_DEBUG(Drawing, "Calculating offset - pos.z=%d, GROUND_LAYER=%d, floor=%d, TileSize=%d, offset=%d", pos.z, GROUND_LAYER, floor, TileSize, offset);
 
 				int draw_x = ((pos.x * TileSize) - view_scroll_x) - offset;
 				int draw_y = ((pos.y * TileSize) - view_scroll_y) - offset;
 				
-				sprintf(debug_msg, "DEBUG DRAG: Calculated draw position - draw_x=%d, draw_y=%d\n", draw_x, draw_y);
-				OutputDebugStringA(debug_msg);
+				TRACE_DEBUG(Drawing, "Calculated draw position - draw_x=%d, draw_y=%d", draw_x, draw_y);
 
 				// save performance when moving large chunks unzoomed
 				ItemVector toRender = tile->getSelectedItems(zoom > 3.0);
-				sprintf(debug_msg, "DEBUG DRAG: Got %zu items to render for tile\n", toRender.size());
-				OutputDebugStringA(debug_msg);
+				TRACE_DEBUG(Drawing, "Got %zu items to render for tile", toRender.size());
 				
 				Tile* desttile = editor.map.getTile(pos);
 				for (ItemVector::const_iterator iit = toRender.begin(); iit != toRender.end(); iit++) {
@@ -861,24 +884,20 @@ void MapDrawer::DrawDraggingShadow() {
 				// save performance when moving large chunks unzoomed
 				if (zoom <= 3.0) {
 					if (tile->creature && tile->creature->isSelected() && options.show_creatures) {
-						sprintf(debug_msg, "DEBUG DRAG: Drawing creature at (%d,%d)\n", draw_x, draw_y);
-						OutputDebugStringA(debug_msg);
+						TRACE_DEBUG(Drawing, "Drawing creature at (%d,%d)", draw_x, draw_y);
 						BlitCreature(draw_x, draw_y, tile->creature);
 					}
 					if (tile->spawn && tile->spawn->isSelected()) {
-						sprintf(debug_msg, "DEBUG DRAG: Drawing spawn at (%d,%d)\n", draw_x, draw_y);
-						OutputDebugStringA(debug_msg);
+						TRACE_DEBUG(Drawing, "Drawing spawn at (%d,%d)", draw_x, draw_y);
 						BlitSpriteType(draw_x, draw_y, SPRITE_SPAWN, 160, 160, 160, 160);
 					}
 				}
 			} else {
-				sprintf(debug_msg, "DEBUG DRAG: Tile not on screen or not moving - pos=(%d,%d,%d), bounds=(%d,%d,%d,%d), move=(%d,%d,%d)\n", 
-					pos.x, pos.y, pos.z, start_x, start_y, end_x, end_y, move_x, move_y, move_z);
-				OutputDebugStringA(debug_msg);
+				TRACE_DEBUG(Drawing, "Tile not on screen or not moving - pos=(%d,%d,%d), bounds=(%d,%d,%d,%d), move=(%d,%d,%d)", pos.x, pos.y, pos.z, start_x, start_y, end_x, end_y, move_x, move_y, move_z);
 			}
 		}
 		
-		OutputDebugStringA("DEBUG DRAG: DrawDraggingShadow completed\n");
+		TRACE_DEBUG(Drawing, "DrawDraggingShadow completed");
 	}
 
 	glDisable(GL_TEXTURE_2D);
@@ -1234,10 +1253,7 @@ void MapDrawer::DrawBrush() {
 						float height_half = height / 2.0f;
 						
 						if (width_half <= 0.0f || height_half <= 0.0f) {
-							char debug_msg[512];
-							sprintf(debug_msg, "DEBUG DRAG: CRITICAL ERROR! Division by zero prevented in circle calc - width=%d, height=%d, width_half=%f, height_half=%f\n", 
-								width, height, width_half, height_half);
-							OutputDebugStringA(debug_msg);
+							TRACE_ERROR(Drawing, "Division by zero prevented in circle calc - width=%d, height=%d, width_half=%f, height_half=%f", width, height, width_half, height_half);
 							
 							// Force to minimum safe values
 							if (width_half <= 0.0f) width_half = 0.5f;
@@ -1785,6 +1801,8 @@ void MapDrawer::BlitSquare(int sx, int sy, int red, int green, int blue, int alp
 		return;
 	}
 
+	g_render_profiler.countTextureBind();
+	g_render_profiler.countDrawCall();
 	glBindTexture(GL_TEXTURE_2D, texnum);
 	glColor4ub(uint8_t(red), uint8_t(green), uint8_t(blue), uint8_t(alpha));
 	glBegin(GL_QUADS);
@@ -1923,12 +1941,7 @@ void MapDrawer::WriteTooltip(Tile* tile, Item* item, std::ostringstream& stream,
 
 	if (!zoneIds.empty()) {
 		for (auto& zoneId : zoneIds) {
-			auto itZone = zoneTiles.find(zoneId);
-			if (itZone == zoneTiles.end()) {
-				zoneTiles.emplace(zoneId, std::vector<FinderPosition>({ FinderPosition(tile->getX(), tile->getY(), tile->getZ()) }));
-			} else {
-				itZone->second.push_back(FinderPosition(tile->getX(), tile->getY(), tile->getZ()));
-			}
+			zoneTiles[zoneId].push_back(tile->getPosition());
 		}
 	} else {
 		if (g_settings.getBoolean(Config::TOOLTIP_SHOW_ITEMID)) {
@@ -1985,6 +1998,8 @@ void MapDrawer::DrawTile(TileLocation* location) {
 		return;
 	}
 
+	g_render_profiler.countTile();
+
 	int map_x = location->getX();
 	int map_y = location->getY();
 	int map_z = location->getZ();
@@ -2430,6 +2445,93 @@ void MapDrawer::DrawLight() {
 	light_drawer->draw(start_x, start_y, end_x, end_y, view_scroll_x, view_scroll_y, options.experimental_fog);
 }
 
+void MapDrawer::DrawProfilerOverlay() {
+	const RenderProfiler::FrameStats& frame = g_render_profiler.getLastFrame();
+	const std::vector<double> history = g_render_profiler.getFrameHistory();
+
+	// The projection is scaled by the zoom, the overlay keeps a fixed screen size.
+	const float scale = zoom;
+	const float line_height = 14.0f * scale;
+	const float margin = 8.0f * scale;
+	const float panel_width = 300.0f * scale;
+	const float graph_height = 60.0f * scale;
+	// Bars above this height are clipped, 30 FPS fills the graph
+	const double graph_max_ms = 1000.0 / 30.0;
+
+	std::vector<std::string> lines;
+	char buffer[128];
+
+	const double frame_ms = frame.stage_ms[RenderProfiler::STAGE_FRAME];
+	const double average_ms = g_render_profiler.getAverage(RenderProfiler::STAGE_FRAME);
+	snprintf(buffer, sizeof(buffer), "Frame %.2f ms (avg %.2f ms, %.0f FPS, worst %.2f ms)", frame_ms, average_ms, average_ms > 0.0 ? 1000.0 / average_ms : 0.0, g_render_profiler.getWorstFrame());
+	lines.push_back(buffer);
+	snprintf(buffer, sizeof(buffer), "Draw calls %u, binds %u, uploads %u, tiles %u", frame.draw_calls, frame.texture_binds, frame.texture_uploads, frame.tiles_visited);
+	lines.push_back(buffer);
+	for (int i = RenderProfiler::STAGE_SETUP; i < RenderProfiler::STAGE_COUNT; ++i) {
+		RenderProfiler::Stage stage = static_cast<RenderProfiler::Stage>(i);
+		// Skip stages that have not been hit recently
+		if (frame.stage_ms[stage] < 0.005 && g_render_profiler.getAverage(stage) < 0.005) {
+			continue;
+		}
+		snprintf(buffer, sizeof(buffer), "%-16s %7.2f  %7.2f", RenderProfiler::getStageName(stage), frame.stage_ms[stage], g_render_profiler.getAverage(stage));
+		lines.push_back(buffer);
+	}
+
+	const float panel_height = (lines.size() + 1) * line_height + graph_height + margin;
+
+	glDisable(GL_TEXTURE_2D);
+
+	// background
+	glColor4ub(0, 0, 0, 160);
+	glBegin(GL_QUADS);
+	glVertex2f(margin, margin);
+	glVertex2f(margin + panel_width, margin);
+	glVertex2f(margin + panel_width, margin + panel_height);
+	glVertex2f(margin, margin + panel_height);
+	glEnd();
+
+	// text
+	float y = margin + line_height;
+	glColor4ub(255, 255, 255, 255);
+	for (const std::string& line : lines) {
+		glRasterPos2f(margin + 4.0f * scale, y);
+		for (const char c : line) {
+			glutBitmapCharacter(GLUT_BITMAP_HELVETICA_12, c);
+		}
+		y += line_height;
+	}
+
+	// frame time histogram, newest frame on the right
+	const float graph_bottom = margin + panel_height - margin / 2.0f;
+	const float bar_width = panel_width / RenderProfiler::HistorySize;
+	float x = margin + panel_width - history.size() * bar_width;
+	glBegin(GL_QUADS);
+	for (double ms : history) {
+		const float height = static_cast<float>(std::min(ms / graph_max_ms, 1.0)) * graph_height;
+		if (ms > 1000.0 / 30.0) {
+			glColor4ub(230, 60, 60, 220);
+		} else if (ms > 1000.0 / 60.0) {
+			glColor4ub(230, 200, 60, 220);
+		} else {
+			glColor4ub(80, 200, 80, 220);
+		}
+		glVertex2f(x, graph_bottom - height);
+		glVertex2f(x + bar_width, graph_bottom - height);
+		glVertex2f(x + bar_width, graph_bottom);
+		glVertex2f(x, graph_bottom);
+		x += bar_width;
+	}
+	glEnd();
+
+	// 60 FPS reference line
+	const float target_y = graph_bottom - static_cast<float>((1000.0 / 60.0) / graph_max_ms) * graph_height;
+	glColor4ub(255, 255, 255, 120);
+	glBegin(GL_LINES);
+	glVertex2f(margin, target_y);
+	glVertex2f(margin + panel_width, target_y);
+	glEnd();
+}
+
 void MapDrawer::MakeTooltip(int screenx, int screeny, const std::string& text, uint8_t r, uint8_t g, uint8_t b) {
 	if (zoom > g_settings.getInteger(Config::TOOLTIP_MAX_ZOOM) || text.empty()) {
 		return;
@@ -2440,6 +2542,71 @@ void MapDrawer::MakeTooltip(int screenx, int screeny, const std::string& text, u
 	tooltips.push_back(tooltip);
 }
 
+void MapDrawer::DrawZoneLabels(int map_z) {
+	size_t tile_count = 0;
+	for (const auto& zone : zoneTiles) {
+		tile_count += zone.second.size();
+	}
+
+	// Every connected area of a zone is labelled once, on the tile closest to
+	// its centre. The areas are only searched again once the map, the view or
+	// the gathered tiles changed since the last frame.
+	ZoneLabelCache& cache = zone_labels[map_z];
+	const uint64_t revision = editor.getMap().getRevision();
+	if (!cache.valid || cache.revision != revision || cache.view_scroll_x != view_scroll_x || cache.view_scroll_y != view_scroll_y
+		|| cache.screensize_x != screensize_x || cache.screensize_y != screensize_y || cache.zoom != zoom || cache.floor != floor
+		|| cache.tile_count != tile_count) {
+		cache.labels.clear();
+		for (const auto& zone : zoneTiles) {
+			zone_labeller.clear();
+			for (const Position& position : zone.second) {
+				zone_labeller.add(position.x, position.y);
+			}
+
+			for (const ComponentLabeller::Component& component : zone_labeller.label()) {
+				const Tile* tile = editor.getMap().getTile(component.anchor_x, component.anchor_y, map_z);
+				if (!tile) {
+					continue;
+				}
+
+				std::ostringstream tooltip;
+				tooltip << "zone id: ";
+				size_t zones = tile->getZoneIds().size();
+				for (const auto& zoneId : tile->getZoneIds()) {
+					tooltip << zoneId;
+					if (--zones > 0) {
+						tooltip << "/";
+					}
+				}
+				cache.labels.push_back({ tile->getPosition(), tooltip.str() });
+			}
+		}
+
+		cache.valid = true;
+		cache.revision = revision;
+		cache.view_scroll_x = view_scroll_x;
+		cache.view_scroll_y = view_scroll_y;
+		cache.screensize_x = screensize_x;
+		cache.screensize_y = screensize_y;
+		cache.zoom = zoom;
+		cache.floor = floor;
+		cache.tile_count = tile_count;
+	}
+
+	int offset;
+	if (map_z <= GROUND_LAYER) {
+		offset = (GROUND_LAYER - map_z) * TileSize;
+	} else {
+		offset = TileSize * (floor - map_z);
+	}
+
+	for (const ZoneLabel& label : cache.labels) {
+		int draw_x = ((label.position.x * TileSize) - view_scroll_x) - offset;
+		int draw_y = ((label.position.y * TileSize) - view_scroll_y) - offset;
+		MakeTooltip(draw_x, draw_y + 8, label.text);
+	}
+}
+
 void MapDrawer::AddLight(TileLocation* location) {
 	if (!options.isDrawLight() || !location || zoom > g_settings.getInteger(Config::LIGHT_ZOOM_THRESHOLD)) {
 		return;
@@ -2495,6 +2662,8 @@ void MapDrawer::TakeScreenshot(uint8_t* screenshot_buffer) {
 
 void MapDrawer::glBlitTexture(int sx, int sy, int texture_number, int red, int green, int blue, int alpha) {
 	if (texture_number != 0) {
+		g_render_profiler.countTextureBind();
+		g_render_profiler.countDrawCall();
 		glBindTexture(GL_TEXTURE_2D, texture_number);
 		glColor4ub(uint8_t(red), uint8_t(green), uint8_t(blue), uint8_t(alpha));
 		glBegin(GL_QUADS);
@@ -2515,6 +2684,7 @@ void MapDrawer::glBlitSquare(int sx, int sy, int red, int green, int blue, int a
 		size = TileSize;
 	}
 
+	g_render_profiler.countDrawCall();
 	glColor4ub(uint8_t(red), uint8_t(green), uint8_t(blue), uint8_t(alpha));
 	glBegin(GL_QUADS);
 	glVertex2f(sx, sy);
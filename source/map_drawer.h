@@ -24,6 +24,8 @@
 #include <unordered_map>
 #include <memory>
 
+#include "component_labeller.h"
+
 class GameSprite;
 
 struct MapTooltip {
@@ -92,116 +94,12 @@ struct DrawingOptions {
 	bool extended_house_shader;
 
 	bool experimental_fog;
+	bool show_profiler;
 };
 
 class MapCanvas;
 class LightDrawer;
 
-struct FinderPosition {
-	FinderPosition() { }
-	FinderPosition(int _x, int _y, int _z) :
-		x(_x), y(_y), z(_z) { }
-	int x, y, z;
-
-	bool operator==(const FinderPosition& other) const {
-		return x == other.x && y == other.y && z == other.z;
-	}
-
-	double distance(const FinderPosition& b) const {
-		return std::sqrt(std::pow(x - b.x, 2) + std::pow(y - b.y, 2));
-	}
-
-	struct Hash {
-		size_t operator()(const FinderPosition& p) const {
-			return p.x ^ p.y ^ p.z;
-		}
-	};
-};
-
-class ZoneFinder {
-private:
-	std::unordered_set<FinderPosition, FinderPosition::Hash> positions;
-	std::vector<std::vector<FinderPosition>> zones;
-	std::unordered_set<FinderPosition, FinderPosition::Hash> visited;
-
-	bool isValid(const FinderPosition& pos) {
-		return positions.find(pos) != positions.end() && visited.find(pos) == visited.end();
-	}
-
-	void dfs(const FinderPosition& pos, std::vector<FinderPosition>& zone) {
-		if (visited.find(pos) != visited.end()) {
-			return;
-		}
-
-		visited.insert(pos);
-		zone.push_back(pos);
-
-		std::vector<FinderPosition> neighbors = {
-			{ pos.x + 1, pos.y, pos.z },
-			{ pos.x - 1, pos.y, pos.z },
-			{ pos.x, pos.y + 1, pos.z },
-			{ pos.x, pos.y - 1, pos.z }
-		};
-
-		for (const auto& next : neighbors) {
-			if (isValid(next)) {
-				dfs(next, zone);
-			}
-		}
-	}
-
-public:
-	ZoneFinder(const std::vector<FinderPosition>& inputPositions) :
-		positions(inputPositions.begin(), inputPositions.end()) { }
-
-	std::vector<std::vector<FinderPosition>> findZones() {
-		for (const auto& pos : positions) {
-			if (visited.find(pos) == visited.end()) {
-				std::vector<FinderPosition> zone;
-				dfs(pos, zone);
-				zones.push_back(zone);
-			}
-		}
-
-		return zones;
-	}
-
-	FinderPosition findClosestToCenter(const std::vector<FinderPosition>& zone) {
-		// CRITICAL FIX: Prevent division by zero when zone is empty
-		if (zone.empty()) {
-			// Return a default position if zone is empty
-			return { 0, 0, 0 };
-		}
-		
-		FinderPosition centroid = { 0, 0, 0 };
-		for (const auto& pos : zone) {
-			centroid.x += pos.x;
-			centroid.y += pos.y;
-			centroid.z += pos.z;
-		}
-
-		// Safe division with size check
-		size_t zone_size = zone.size();
-		if (zone_size > 0) {
-			centroid.x /= zone_size;
-			centroid.y /= zone_size;
-			centroid.z /= zone_size;
-		}
-
-		double minDistance = std::numeric_limits<double>::max();
-		FinderPosition closestPosition = zone[0]; // Use first position as default
-		for (const auto& pos : zone) {
-			const double dist = pos.distance(centroid);
-			if (dist < minDistance) {
-				minDistance = dist;
-				closestPosition = pos;
-			}
-		}
-
-		return closestPosition;
-	}
-};
-
 // Manages custom colors for invisible items
 class InvisibleItemsColorManager {
 public:
@@ -258,9 +156,32 @@ class MapDrawer {
 	int screensize_x, screensize_y;
 	int tile_size;
 	int floor;
+	// Rendering a region for an export instead of the canvas
+	bool offscreen;
 
 protected:
-	std::unordered_map<uint16_t, std::vector<FinderPosition>> zoneTiles;
+	// Tiles of every zone drawn on the current floor, gathered by DrawTile
+	std::unordered_map<uint16_t, std::vector<Position>> zoneTiles;
+
+	// Zone labels of a floor, found once and kept until the map, the view or
+	// the gathered tiles change
+	struct ZoneLabel {
+		Position position;
+		std::string text;
+	};
+	struct ZoneLabelCache {
+		bool valid = false;
+		uint64_t revision = 0;
+		int view_scroll_x = 0, view_scroll_y = 0;
+		int screensize_x = 0, screensize_y = 0;
+		float zoom = 0.0f;
+		int floor = 0;
+		size_t tile_count = 0;
+		std::vector<ZoneLabel> labels;
+	};
+	ZoneLabelCache zone_labels[MAP_LAYERS];
+	ComponentLabeller zone_labeller;
+
 	std::vector<MapTooltip*> tooltips;
 	std::ostringstream tooltip;
 
@@ -272,10 +193,15 @@ public:
 	bool dragging_draw;
 
 	void SetupVars();
+	// Renders a width x height pixel area at 1:1 scale instead of the canvas
+	// view, map tile (map_x, map_y) of the floor is drawn at the top left
+	void SetupOffscreenVars(int map_x, int map_y, int width, int height, int floor);
 	void SetupGL();
 	void Release();
 
 	void Draw();
+	// Only the map itself, without brushes, selection or any overlay
+	void DrawOffscreen();
 	void DrawBackground();
 	void DrawMap();
 	void DrawDraggingShadow();
@@ -287,6 +213,7 @@ public:
 	void DrawGrid();
 	void DrawTooltips();
 	void DrawLight();
+	void DrawProfilerOverlay();
 
 
 
@@ -297,6 +224,7 @@ public:
 	}
 
 protected:
+	void SetupRange();
 	void BlitItem(int& screenx, int& screeny, const Tile* tile, Item* item, bool ephemeral = false, int red = 255, int green = 255, int blue = 255, int alpha = 255);
 	void BlitItem(int& screenx, int& screeny, const Position& pos, Item* item, bool ephemeral = false, int red = 255, int green = 255, int blue = 255, int alpha = 255, const Tile* tile = nullptr);
 	void BlitSpriteType(int screenx, int screeny, uint32_t spriteid, int red = 255, int green = 255, int blue = 255, int alpha = 255);
@@ -311,6 +239,7 @@ protected:
 	void WriteTooltip(Tile* tile, Item* item, std::ostringstream& stream, bool isHouseTile);
 	void WriteTooltip(Waypoint* item, std::ostringstream& stream);
 	void MakeTooltip(int screenx, int screeny, const std::string& text, uint8_t r = 255, uint8_t g = 255, uint8_t b = 255);
+	void DrawZoneLabels(int map_z);
 	void AddLight(TileLocation* location);
 
 	enum BrushColor {
@@ -150,8 +150,7 @@ void MapGeneratorDialog::OnGenerate(wxCommandEvent& event) {
                 loadBarCreated = true;
                 generated = MapGenerator::Generate(options, [&](int done, int total) {
                         const int percent = total > 0 ? static_cast<int>((done * 100) / total) : 100;
-                        const bool abort = g_gui.SetLoadDone(percent, wxString::Format("Generating (%d/%d)", done, total));
-                        return !abort;
+                        return g_gui.SetLoadDone(percent, wxString::Format("Generating (%d/%d)", done, total));
                 });
         } catch (const std::runtime_error& e) {
                 if (std::string(e.what()) == "generation_cancelled") {
@@ -21,6 +21,7 @@
 #include "basemap.h"
 #include "position.h"
 #include "tile.h"
+#include "minimap_store.h"
 
 //**************** Tile Location **********************
 
@@ -107,6 +108,20 @@ QTreeNode* QTreeNode::getLeaf(int x, int y) {
 	return nullptr;
 }
 
+QTreeNode* QTreeNode::getNode(int x, int y, int size) {
+	QTreeNode* node = this;
+	uint32_t cx = x, cy = y;
+	int node_size = 0x10000;
+	while (node && !node->isLeaf && node_size > size) {
+		uint32_t index = ((cx & 0xC000) >> 14) | ((cy & 0xC000) >> 12);
+		node = node->child[index];
+		cx <<= 2;
+		cy <<= 2;
+		node_size >>= 2;
+	}
+	return node;
+}
+
 QTreeNode* QTreeNode::getLeafForce(int x, int y) {
 	QTreeNode* node = this;
 	uint32_t cx = x, cy = y;
@@ -235,6 +250,11 @@ Tile* QTreeNode::setTile(int x, int y, int z, Tile* newtile) {
 	TileLocation* tmp = &f->locs[offset_x * 4 + offset_y];
 	Tile* oldtile = tmp->tile;
 	tmp->tile = newtile;
+	map.onTileChanged(Position(x, y, z), oldtile, newtile);
+
+	if (map.minimap_store) {
+		map.minimap_store->setColor(x, y, z, newtile ? newtile->getMiniMapColor() : 0);
+	}
 
 	if (newtile && !oldtile) {
 		++map.tilecount;
@@ -253,6 +273,12 @@ void QTreeNode::clearTile(int x, int y, int z) {
 	int offset_y = y & 3;
 
 	TileLocation* tmp = &f->locs[offset_x * 4 + offset_y];
-	delete tmp->tile;
+	Tile* oldtile = tmp->tile;
 	tmp->tile = map.allocator(tmp);
+	map.onTileChanged(Position(x, y, z), oldtile, tmp->tile);
+	delete oldtile;
+
+	if (map.minimap_store) {
+		map.minimap_store->setColor(x, y, z, 0);
+	}
 }
@@ -127,6 +127,9 @@ public:
 
 	QTreeNode* getLeaf(int x, int y); // Might return nullptr
 	QTreeNode* getLeafForce(int x, int y); // Will never return nullptr, it will create the node if it's not there
+	// The node covering the size x size area holding (x, y), size being a power
+	// of 4. A leaf (4x4 tiles) is returned for smaller sizes. Might return nullptr
+	QTreeNode* getNode(int x, int y, int size);
 
 	// Coordinates are NOT relative
 	TileLocation* createTile(int x, int y, int z);
@@ -0,0 +1,613 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+
+#include "main.h"
+
+#include "map_render_exporter.h"
+#include "map_display.h"
+#include "map_drawer.h"
+#include "png_writer.h"
+#include "gui.h"
+
+#include <memory>
+#include <wx/filename.h>
+#include <wx/image.h>
+
+#if defined(__APPLE__)
+	#include <dlfcn.h>
+#elif !defined(__WINDOWS__)
+	#include <GL/glx.h>
+#endif
+
+#ifndef APIENTRY
+	#define APIENTRY
+#endif
+
+// Framebuffer and pixel buffer objects are not part of OpenGL 1.1, the
+// constants are defined here and the functions looked up at runtime
+#ifndef GL_FRAMEBUFFER
+	#define GL_FRAMEBUFFER 0x8D40
+	#define GL_RENDERBUFFER 0x8D41
+	#define GL_COLOR_ATTACHMENT0 0x8CE0
+	#define GL_FRAMEBUFFER_COMPLETE 0x8CD5
+#endif
+#ifndef GL_PIXEL_PACK_BUFFER
+	#define GL_PIXEL_PACK_BUFFER 0x88EB
+	#define GL_STREAM_READ 0x88E1
+	#define GL_READ_ONLY 0x88B8
+#endif
+
+static_assert(MapRenderExporter::RenderHeight == MapRenderExporter::PyramidTileSize, "a row of rendered tiles must be a row of pyramid tiles");
+static_assert(MapRenderExporter::RenderWidth % MapRenderExporter::PyramidTileSize == 0, "rendered tiles must hold whole pyramid tiles");
+static_assert(MapRenderExporter::PyramidTileSize % TileSize == 0, "pyramid tiles must hold whole map tiles");
+
+namespace {
+	void* getGLProcAddress(const char* name) {
+#if defined(__WINDOWS__)
+		void* proc = reinterpret_cast<void*>(wglGetProcAddress(name));
+		// Some drivers return small values instead of null for missing functions
+		const intptr_t value = reinterpret_cast<intptr_t>(proc);
+		return (value >= -1 && value <= 3) ? nullptr : proc;
+#elif defined(__APPLE__)
+		return dlsym(RTLD_DEFAULT, name);
+#else
+		return reinterpret_cast<void*>(glXGetProcAddressARB(reinterpret_cast<const GLubyte*>(name)));
+#endif
+	}
+
+	struct OffscreenFunctions {
+		typedef void(APIENTRY* GenObjects)(GLsizei, GLuint*);
+		typedef void(APIENTRY* DeleteObjects)(GLsizei, const GLuint*);
+		typedef void(APIENTRY* BindObject)(GLenum, GLuint);
+		typedef GLenum(APIENTRY* CheckFramebufferStatus)(GLenum);
+		typedef void(APIENTRY* FramebufferRenderbuffer)(GLenum, GLenum, GLenum, GLuint);
+		typedef void(APIENTRY* RenderbufferStorage)(GLenum, GLenum, GLsizei, GLsizei);
+		typedef void(APIENTRY* BufferData)(GLenum, ptrdiff_t, const void*, GLenum);
+		typedef void*(APIENTRY* MapBuffer)(GLenum, GLenum);
+		typedef GLboolean(APIENTRY* UnmapBuffer)(GLenum);
+
+		GenObjects genFramebuffers = nullptr;
+		DeleteObjects deleteFramebuffers = nullptr;
+		BindObject bindFramebuffer = nullptr;
+		CheckFramebufferStatus checkFramebufferStatus = nullptr;
+		FramebufferRenderbuffer framebufferRenderbuffer = nullptr;
+		GenObjects genRenderbuffers = nullptr;
+		DeleteObjects deleteRenderbuffers = nullptr;
+		BindObject bindRenderbuffer = nullptr;
+		RenderbufferStorage renderbufferStorage = nullptr;
+
+		GenObjects genBuffers = nullptr;
+		DeleteObjects deleteBuffers = nullptr;
+		BindObject bindBuffer = nullptr;
+		BufferData bufferData = nullptr;
+		MapBuffer mapBuffer = nullptr;
+		UnmapBuffer unmapBuffer = nullptr;
+
+		// Needs a current context
+		void load() {
+			load(genFramebuffers, "glGenFramebuffers", "glGenFramebuffersEXT");
+			load(deleteFramebuffers, "glDeleteFramebuffers", "glDeleteFramebuffersEXT");
+			load(bindFramebuffer, "glBindFramebuffer", "glBindFramebufferEXT");
+			load(checkFramebufferStatus, "glCheckFramebufferStatus", "glCheckFramebufferStatusEXT");
+			load(framebufferRenderbuffer, "glFramebufferRenderbuffer", "glFramebufferRenderbufferEXT");
+			load(genRenderbuffers, "glGenRenderbuffers", "glGenRenderbuffersEXT");
+			load(deleteRenderbuffers, "glDeleteRenderbuffers", "glDeleteRenderbuffersEXT");
+			load(bindRenderbuffer, "glBindRenderbuffer", "glBindRenderbufferEXT");
+			load(renderbufferStorage, "glRenderbufferStorage", "glRenderbufferStorageEXT");
+
+			load(genBuffers, "glGenBuffers", "glGenBuffersARB");
+			load(deleteBuffers, "glDeleteBuffers", "glDeleteBuffersARB");
+			load(bindBuffer, "glBindBuffer", "glBindBufferARB");
+			load(bufferData, "glBufferData", "glBufferDataARB");
+			load(mapBuffer, "glMapBuffer", "glMapBufferARB");
+			load(unmapBuffer, "glUnmapBuffer", "glUnmapBufferARB");
+		}
+
+		bool hasFramebuffers() const noexcept {
+			return genFramebuffers && deleteFramebuffers && bindFramebuffer && checkFramebufferStatus && framebufferRenderbuffer
+				&& genRenderbuffers && deleteRenderbuffers && bindRenderbuffer && renderbufferStorage;
+		}
+
+		bool hasPixelBuffers() const noexcept {
+			return genBuffers && deleteBuffers && bindBuffer && bufferData && mapBuffer && unmapBuffer;
+		}
+
+	private:
+		template <typename Function>
+		static void load(Function& function, const char* name, const char* extension_name) {
+			void* proc = getGLProcAddress(name);
+			if (!proc) {
+				proc = getGLProcAddress(extension_name);
+			}
+			function = reinterpret_cast<Function>(proc);
+		}
+	};
+
+	// The framebuffer tiles are drawn in and two read back slots, a tile is
+	// read into one slot while the previous tile is taken out of the other.
+	// With pixel buffer objects the read does not wait for the tile to be
+	// drawn, so drawing the next tile overlaps writing the previous one.
+	class TileTarget {
+	public:
+		TileTarget() :
+			framebuffer(0), renderbuffer(0), buffers { 0, 0 }, width(0), height(0) {
+			functions.load();
+		}
+
+		~TileTarget() {
+			if (buffers[0]) {
+				functions.bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+				functions.deleteBuffers(2, buffers);
+			}
+			if (framebuffer) {
+				functions.bindFramebuffer(GL_FRAMEBUFFER, 0);
+				functions.deleteFramebuffers(1, &framebuffer);
+				functions.deleteRenderbuffers(1, &renderbuffer);
+			}
+		}
+
+		TileTarget(const TileTarget&) = delete;
+		TileTarget& operator=(const TileTarget&) = delete;
+
+		// Returns false if tiles have to be drawn in the back buffer
+		bool createFramebuffer(int width, int height) {
+			if (!functions.hasFramebuffers()) {
+				return false;
+			}
+
+			functions.genRenderbuffers(1, &renderbuffer);
+			functions.bindRenderbuffer(GL_RENDERBUFFER, renderbuffer);
+			functions.renderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+			functions.bindRenderbuffer(GL_RENDERBUFFER, 0);
+
+			functions.genFramebuffers(1, &framebuffer);
+			functions.bindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+			functions.framebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, renderbuffer);
+			const bool complete = functions.checkFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+			functions.bindFramebuffer(GL_FRAMEBUFFER, 0);
+
+			if (!complete) {
+				functions.deleteFramebuffers(1, &framebuffer);
+				functions.deleteRenderbuffers(1, &renderbuffer);
+				framebuffer = 0;
+				renderbuffer = 0;
+			}
+			return complete;
+		}
+
+		void createSlots(int width, int height) {
+			this->width = width;
+			this->height = height;
+
+			const size_t size = size_t(width) * height * 4;
+			if (functions.hasPixelBuffers()) {
+				functions.genBuffers(2, buffers);
+				for (GLuint buffer : buffers) {
+					functions.bindBuffer(GL_PIXEL_PACK_BUFFER, buffer);
+					functions.bufferData(GL_PIXEL_PACK_BUFFER, ptrdiff_t(size), nullptr, GL_STREAM_READ);
+				}
+				functions.bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+			} else {
+				for (std::vector<uint8_t>& pixels : slot_pixels) {
+					pixels.resize(size);
+				}
+			}
+		}
+
+		// The framebuffer must not stay bound while the canvas can paint
+		void bind() {
+			if (framebuffer) {
+				functions.bindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+			}
+		}
+
+		void unbind() {
+			if (framebuffer) {
+				functions.bindFramebuffer(GL_FRAMEBUFFER, 0);
+			}
+		}
+
+		// Starts reading the tile that was just drawn, the target must be bound
+		void startRead(int slot) {
+			glReadBuffer(framebuffer ? GL_COLOR_ATTACHMENT0 : GL_BACK);
+			glPixelStorei(GL_PACK_ALIGNMENT, 1);
+			if (buffers[slot]) {
+				functions.bindBuffer(GL_PIXEL_PACK_BUFFER, buffers[slot]);
+				glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+				functions.bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+			} else {
+				glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, slot_pixels[slot].data());
+			}
+		}
+
+		// RGBA rows of the tile read into slot, bottom row first. Returns
+		// nullptr if the pixels are not available, either way finishRead has
+		// to be called afterwards.
+		const uint8_t* waitRead(int slot) {
+			if (!buffers[slot]) {
+				return slot_pixels[slot].data();
+			}
+			functions.bindBuffer(GL_PIXEL_PACK_BUFFER, buffers[slot]);
+			return static_cast<const uint8_t*>(functions.mapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY));
+		}
+
+		void finishRead(int slot) {
+			if (buffers[slot]) {
+				functions.unmapBuffer(GL_PIXEL_PACK_BUFFER);
+				functions.bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+			}
+		}
+
+	private:
+		OffscreenFunctions functions;
+		GLuint framebuffer;
+		GLuint renderbuffer;
+		GLuint buffers[2];
+		std::vector<uint8_t> slot_pixels[2];
+		int width;
+		int height;
+	};
+
+	std::string getPyramidTilePath(const std::string& path, int level, int column, int row) {
+		wxFileName file(wxstr(path), wxString::Format("%d_%d.png", column, row));
+		file.AppendDir(wxString::Format("%d", level));
+		return nstr(file.GetFullPath());
+	}
+
+	bool createPyramidLevel(const std::string& path, int level, std::string& error) {
+		wxFileName directory(wxstr(getPyramidTilePath(path, level, 0, 0)));
+		if (!directory.DirExists() && !directory.Mkdir(wxS_DIR_DEFAULT, wxPATH_MKDIR_FULL)) {
+			error = "Could not create the folder " + nstr(directory.GetPath()) + ".";
+			return false;
+		}
+		return true;
+	}
+
+	int getTileCount(int size) {
+		return (size + MapRenderExporter::PyramidTileSize - 1) / MapRenderExporter::PyramidTileSize;
+	}
+
+	// Tiles above level 0
+	int getPyramidTileCount(int width, int height) {
+		int count = 0;
+		while (width > MapRenderExporter::PyramidTileSize || height > MapRenderExporter::PyramidTileSize) {
+			width = (width + 1) / 2;
+			height = (height + 1) / 2;
+			count += getTileCount(width) * getTileCount(height);
+		}
+		return count;
+	}
+
+	bool writeRGB(const std::string& filename, const uint8_t* pixels, int width, int height, std::string& error) {
+		PngWriter png(filename);
+		if (!png.begin(width, height, PngWriter::COLOR_RGB) || !png.writeRows(pixels, height) || !png.finish()) {
+			error = (png.getError().empty() ? std::string("Could not write to file.") : png.getError()) + " (" + filename + ")";
+			return false;
+		}
+		return true;
+	}
+
+	// Copies a width x height area of an RGBA tile as read back by OpenGL
+	// into top to bottom RGB rows
+	void copyPixels(const uint8_t* tile, int tile_width, int tile_height, int x, int width, int height, uint8_t* out, size_t out_stride) {
+		for (int row = 0; row < height; ++row) {
+			const uint8_t* in = tile + (size_t(tile_height - 1 - row) * tile_width + x) * 4;
+			uint8_t* to = out + out_stride * row;
+			for (int column = 0; column < width; ++column) {
+				to[0] = in[0];
+				to[1] = in[1];
+				to[2] = in[2];
+				to += 3;
+				in += 4;
+			}
+		}
+	}
+}
+
+// Receives the rendered tiles row by row, left to right
+class MapRenderExporter::Sink {
+public:
+	Sink(int width, int height, int tile_width, int tile_height) :
+		width(width), height(height), tile_width(tile_width), tile_height(tile_height) { }
+	virtual ~Sink() = default;
+
+	virtual bool begin() = 0;
+	virtual bool addTile(int column, int row, const uint8_t* pixels) = 0;
+	virtual bool finish() = 0;
+
+	const std::string& getError() const noexcept {
+		return error;
+	}
+
+protected:
+	int width, height;
+	int tile_width, tile_height;
+	std::string error;
+};
+
+// Collects a row of tiles and appends it to the image
+class MapRenderExporter::PngSink : public Sink {
+public:
+	PngSink(const std::string& filename, int width, int height, int tile_width, int tile_height) :
+		Sink(width, height, tile_width, tile_height), png(filename) { }
+
+	bool begin() override {
+		if (!png.begin(width, height, PngWriter::COLOR_RGB)) {
+			error = png.getError();
+			return false;
+		}
+		strip.resize(size_t(width) * tile_height * 3);
+		return true;
+	}
+
+	bool addTile(int column, int row, const uint8_t* pixels) override {
+		const int x = column * tile_width;
+		const int rows = std::min(tile_height, height - row * tile_height);
+		copyPixels(pixels, tile_width, tile_height, 0, std::min(tile_width, width - x), rows, &strip[size_t(x) * 3], size_t(width) * 3);
+
+		if (x + tile_width >= width && !png.writeRows(strip.data(), rows)) {
+			error = "Could not write to file.";
+			return false;
+		}
+		return true;
+	}
+
+	bool finish() override {
+		if (!png.finish()) {
+			error = png.getError();
+			return false;
+		}
+		return true;
+	}
+
+private:
+	PngWriter png;
+	std::vector<uint8_t> strip;
+};
+
+// Cuts the tiles into level 0 of the pyramid
+class MapRenderExporter::PyramidSink : public Sink {
+public:
+	PyramidSink(const std::string& path, int width, int height, int tile_width, int tile_height) :
+		Sink(width, height, tile_width, tile_height), path(path) { }
+
+	bool begin() override {
+		if (!createPyramidLevel(path, 0, error)) {
+			return false;
+		}
+		pixels.resize(size_t(PyramidTileSize) * PyramidTileSize * 3);
+		return true;
+	}
+
+	bool addTile(int column, int row, const uint8_t* tile) override {
+		const int rows = std::min(PyramidTileSize, height - row * PyramidTileSize);
+		for (int x = 0; x < tile_width; x += PyramidTileSize) {
+			const int left = column * tile_width + x;
+			if (left >= width) {
+				break;
+			}
+
+			const int columns = std::min(PyramidTileSize, width - left);
+			copyPixels(tile, tile_width, tile_height, x, columns, rows, pixels.data(), size_t(columns) * 3);
+			if (!writeRGB(getPyramidTilePath(path, 0, left / PyramidTileSize, row), pixels.data(), columns, rows, error)) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool finish() override {
+		return true;
+	}
+
+private:
+	std::string path;
+	std::vector<uint8_t> pixels;
+};
+
+MapRenderExporter::MapRenderExporter(MapCanvas& canvas) :
+	canvas(canvas) {
+	////
+}
+
+bool MapRenderExporter::exportRegion(const Region& region, Format format, const std::string& path, std::string& error, const std::function<bool(int)>& progress) {
+	if (region.width <= 0 || region.height <= 0) {
+		error = "The area to render is empty.";
+		return false;
+	}
+	if (region.floor < 0 || region.floor > MAP_MAX_LAYER) {
+		error = "Invalid floor.";
+		return false;
+	}
+
+	const int width = region.width * TileSize;
+	const int height = region.height * TileSize;
+
+	canvas.SetCurrent(*g_gui.GetGLContext(&canvas));
+
+	TileTarget target;
+	int tile_width = RenderWidth;
+	int tile_height = RenderHeight;
+	if (!target.createFramebuffer(tile_width, tile_height)) {
+		// Draw in the back buffer, tiles can be at most as large as the canvas
+		int view_x, view_y, screen_width, screen_height;
+		canvas.GetViewBox(&view_x, &view_y, &screen_width, &screen_height);
+		tile_width = std::min(RenderWidth, screen_width / PyramidTileSize * PyramidTileSize);
+		if (tile_width == 0 || screen_height < tile_height) {
+			error = "Offscreen rendering is not supported by the video driver, the map window has to be at least " + i2s(PyramidTileSize) + " pixels wide and high to render in it instead.";
+			return false;
+		}
+	}
+	target.createSlots(tile_width, tile_height);
+
+	std::unique_ptr<Sink> sink;
+	if (format == FORMAT_PYRAMID) {
+		sink.reset(newd PyramidSink(path, width, height, tile_width, tile_height));
+	} else {
+		sink.reset(newd PngSink(path, width, height, tile_width, tile_height));
+	}
+
+	if (!sink->begin()) {
+		error = sink->getError();
+		return false;
+	}
+
+	const int columns = (width + tile_width - 1) / tile_width;
+	const int rows = (height + tile_height - 1) / tile_height;
+	const int tile_count = columns * rows;
+	const int total = tile_count + (format == FORMAT_PYRAMID ? getPyramidTileCount(width, height) : 0);
+	int done = 0;
+
+	MapDrawer drawer(&canvas);
+	drawer.getOptions().SetIngame();
+
+	bool ok = true;
+	bool cancelled = false;
+	// Tile index is drawn while tile index - 1 is written
+	for (int index = 0; index <= tile_count && ok && !cancelled; ++index) {
+		if (index < tile_count) {
+			const int column = index % columns;
+			const int row = index / columns;
+
+			target.bind();
+			drawer.SetupOffscreenVars(region.x + column * tile_width / TileSize, region.y + row * tile_height / TileSize, tile_width, tile_height, region.floor);
+			drawer.SetupGL();
+			drawer.DrawOffscreen();
+			target.startRead(index & 1);
+			drawer.Release();
+			target.unbind();
+
+			// Sprites are uploaded as the tiles need them, let go of the
+			// ones no longer drawn so the export does not hold the whole map
+			g_gui.gfx.garbageCollection();
+		}
+
+		if (index > 0) {
+			const int previous = index - 1;
+			const uint8_t* pixels = target.waitRead(previous & 1);
+			if (!pixels) {
+				error = "Could not read the rendered image back from the video driver.";
+				ok = false;
+			} else if (!sink->addTile(previous % columns, previous / columns, pixels)) {
+				error = sink->getError();
+				ok = false;
+			}
+			target.finishRead(previous & 1);
+
+			++done;
+			if (ok && progress && !progress(done * 100 / total)) {
+				cancelled = true;
+			}
+		}
+	}
+
+	if (ok && !cancelled && !sink->finish()) {
+		error = sink->getError();
+		ok = false;
+	}
+	sink.reset();
+
+	if (ok && !cancelled && format == FORMAT_PYRAMID) {
+		ok = buildPyramidLevels(path, width, height, done, total, cancelled, error, progress);
+	}
+
+	canvas.Refresh();
+
+	if (cancelled) {
+		error = "The export was cancelled.";
+		ok = false;
+	}
+	if (!ok && format == FORMAT_PNG) {
+		wxRemoveFile(wxstr(path));
+	}
+	return ok;
+}
+
+bool MapRenderExporter::buildPyramidLevels(const std::string& path, int width, int height, int& done, int total, bool& cancelled, std::string& error, const std::function<bool(int)>& progress) const {
+	const int half = PyramidTileSize / 2;
+	std::vector<uint8_t> pixels(size_t(PyramidTileSize) * PyramidTileSize * 3);
+
+	for (int level = 1; width > PyramidTileSize || height > PyramidTileSize; ++level) {
+		const int child_columns = getTileCount(width);
+		const int child_rows = getTileCount(height);
+		width = (width + 1) / 2;
+		height = (height + 1) / 2;
+		if (!createPyramidLevel(path, level, error)) {
+			return false;
+		}
+
+		for (int row = 0; row < getTileCount(height); ++row) {
+			for (int column = 0; column < getTileCount(width); ++column) {
+				const int tile_width = std::min(PyramidTileSize, width - column * PyramidTileSize);
+				const int tile_height = std::min(PyramidTileSize, height - row * PyramidTileSize);
+
+				// Every pixel is the average of a 2x2 square of the level below,
+				// squares cut by the edge of the image average what is left
+				for (int quarter = 0; quarter < 4; ++quarter) {
+					const int child_column = column * 2 + (quarter & 1);
+					const int child_row = row * 2 + (quarter >> 1);
+					if (child_column >= child_columns || child_row >= child_rows) {
+						continue;
+					}
+
+					wxImage child;
+					const wxString child_path = wxstr(getPyramidTilePath(path, level - 1, child_column, child_row));
+					if (!child.LoadFile(child_path, wxBITMAP_TYPE_PNG)) {
+						error = "Could not read " + nstr(child_path) + ".";
+						return false;
+					}
+
+					const int child_width = child.GetWidth();
+					const int child_height = child.GetHeight();
+					const uint8_t* in = child.GetData();
+					for (int y = 0; y < (child_height + 1) / 2; ++y) {
+						uint8_t* out = &pixels[(size_t((quarter >> 1) * half + y) * tile_width + (quarter & 1) * half) * 3];
+						for (int x = 0; x < (child_width + 1) / 2; ++x) {
+							int sum[3] = { 0, 0, 0 };
+							int count = 0;
+							for (int sy = y * 2; sy < std::min(y * 2 + 2, child_height); ++sy) {
+								for (int sx = x * 2; sx < std::min(x * 2 + 2, child_width); ++sx) {
+									const uint8_t* pixel = in + (size_t(sy) * child_width + sx) * 3;
+									sum[0] += pixel[0];
+									sum[1] += pixel[1];
+									sum[2] += pixel[2];
+									++count;
+								}
+							}
+							out[0] = uint8_t(sum[0] / count);
+							out[1] = uint8_t(sum[1] / count);
+							out[2] = uint8_t(sum[2] / count);
+							out += 3;
+						}
+					}
+				}
+
+				if (!writeRGB(getPyramidTilePath(path, level, column, row), pixels.data(), tile_width, tile_height, error)) {
+					return false;
+				}
+
+				++done;
+				if (progress && !progress(done * 100 / total)) {
+					cancelled = true;
+					return true;
+				}
+			}
+		}
+	}
+	return true;
+}
@@ -0,0 +1,76 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+
+#ifndef RME_MAP_RENDER_EXPORTER_H_
+#define RME_MAP_RENDER_EXPORTER_H_
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+class MapCanvas;
+
+// Renders a rectangle of the map at 1:1 sprite scale and streams it to disk.
+// The rectangle is drawn one offscreen tile at a time, the pixels of a tile
+// are read back while the next one renders and go straight to the output, so
+// memory use only depends on the width of the render.
+//
+// Without framebuffer objects the tiles are drawn in the back buffer of the
+// canvas instead, which limits their size to the size of the canvas.
+class MapRenderExporter {
+public:
+	// Size of a rendered tile in pixels, pyramid tiles are PyramidTileSize wide
+	static constexpr int RenderWidth = 2048;
+	static constexpr int RenderHeight = 256;
+	static constexpr int PyramidTileSize = 256;
+
+	enum Format {
+		// A single RGB PNG image
+		FORMAT_PNG,
+		// A folder of PNG tiles, <level>/<column>_<row>.png. Level 0 is the
+		// full size render and every further level halves it, the last level
+		// fits in one tile.
+		FORMAT_PYRAMID,
+	};
+
+	// In map tiles
+	struct Region {
+		int x, y;
+		int width, height;
+		int floor;
+	};
+
+	explicit MapRenderExporter(MapCanvas& canvas);
+
+	// Must be called on the GUI thread. progress gets values from 0 to 100
+	// and cancels the export by returning false.
+	bool exportRegion(const Region& region, Format format, const std::string& path, std::string& error, const std::function<bool(int)>& progress = nullptr);
+
+private:
+	class Sink;
+	class PngSink;
+	class PyramidSink;
+
+	// Halves level 0 until it fits in one tile, reading back the tiles written
+	bool buildPyramidLevels(const std::string& path, int width, int height, int& done, int total, bool& cancelled, std::string& error, const std::function<bool(int)>& progress) const;
+
+	MapCanvas& canvas;
+};
+
+#endif
@@ -0,0 +1,152 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+
+#include "main.h"
+
+#include "map_search.h"
+#include "map.h"
+#include "map_region.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+MapSearch::MapSearch(Map& map) :
+	map(map) {
+	////
+}
+
+MapSearch::IdSet MapSearch::makeIdSet(const std::vector<uint16_t>& ids, const std::vector<std::pair<uint16_t, uint16_t>>& ranges) {
+	IdSet set;
+	for (uint16_t id : ids) {
+		set.set(id);
+	}
+	for (const auto& range : ranges) {
+		for (uint32_t id = range.first; id <= range.second; ++id) {
+			set.set(id);
+		}
+	}
+	return set;
+}
+
+size_t MapSearch::run(const Predicate& predicate, size_t max_results, bool selected_only, const BatchCallback& callback) {
+	// Blocks without a single leaf are skipped before the workers start
+	std::vector<Position> blocks;
+	const int width = std::min(map.getWidth(), MAP_MAX_WIDTH + 1);
+	const int height = std::min(map.getHeight(), MAP_MAX_HEIGHT + 1);
+	for (int y = 0; y < height; y += BlockSize) {
+		for (int x = 0; x < width; x += BlockSize) {
+			if (map.getNode(x, y, BlockSize)) {
+				blocks.emplace_back(x, y, 0);
+			}
+		}
+	}
+
+	std::vector<std::vector<Match>> results(blocks.size());
+	std::vector<bool> finished(blocks.size(), false);
+	std::mutex mutex;
+	std::condition_variable block_done;
+	std::atomic<size_t> next_block(0);
+	std::atomic<bool> stop(false);
+
+	auto scanBlock = [&](const Position& block, std::vector<Match>& matches) {
+		for (int leaf_y = block.y; leaf_y < block.y + BlockSize && !stop; leaf_y += 4) {
+			for (int leaf_x = block.x; leaf_x < block.x + BlockSize; leaf_x += 4) {
+				QTreeNode* leaf = map.getLeaf(leaf_x, leaf_y);
+				if (!leaf) {
+					continue;
+				}
+				for (int z = 0; z < MAP_LAYERS; ++z) {
+					Floor* floor = leaf->getFloor(z);
+					if (!floor) {
+						continue;
+					}
+					for (TileLocation& location : floor->locs) {
+						Tile* tile = location.get();
+						if (!tile || (selected_only && !tile->isSelected())) {
+							continue;
+						}
+						auto visit = [&](Item* item) {
+							if (predicate(tile, item)) {
+								matches.emplace_back(tile, item);
+							}
+							return true;
+						};
+						foreach_ItemOnTile(tile, visit);
+					}
+				}
+			}
+		}
+	};
+
+	auto worker = [&]() {
+		for (size_t i = next_block++; i < blocks.size() && !stop; i = next_block++) {
+			scanBlock(blocks[i], results[i]);
+			std::lock_guard<std::mutex> lock(mutex);
+			finished[i] = true;
+			block_done.notify_one();
+		}
+	};
+
+	const int thread_count = std::max(1, std::min<int>(std::max(1u, std::thread::hardware_concurrency()), blocks.size()));
+	std::vector<std::thread> threads;
+	for (int i = 0; i < thread_count; ++i) {
+		threads.emplace_back(worker);
+	}
+
+	// Hand the blocks over in order, waking up at least every 50ms so the
+	// callback can keep the interface alive and cancel
+	size_t delivered_blocks = 0;
+	size_t delivered = 0;
+	std::vector<Match> batch;
+	while (delivered_blocks < blocks.size()) {
+		batch.clear();
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			if (!finished[delivered_blocks]) {
+				block_done.wait_for(lock, std::chrono::milliseconds(50));
+			}
+			for (; delivered_blocks < blocks.size() && finished[delivered_blocks]; ++delivered_blocks) {
+				std::vector<Match>& matches = results[delivered_blocks];
+				batch.insert(batch.end(), matches.begin(), matches.end());
+				std::vector<Match>().swap(matches);
+			}
+		}
+
+		bool limit_reached = false;
+		if (max_results > 0 && delivered + batch.size() >= max_results) {
+			batch.resize(max_results - delivered);
+			limit_reached = true;
+		}
+		delivered += batch.size();
+
+		const int progress = std::min<int>(99, delivered_blocks * 100 / blocks.size());
+		if (!callback(batch, progress) || limit_reached) {
+			break;
+		}
+	}
+
+	stop = true;
+	for (std::thread& thread : threads) {
+		thread.join();
+	}
+	return delivered;
+}
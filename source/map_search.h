@@ -0,0 +1,62 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+
+#ifndef RME_MAP_SEARCH_H_
+#define RME_MAP_SEARCH_H_
+
+#include <bitset>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+class Map;
+class Tile;
+class Item;
+
+// Searches every item on the map with a predicate on worker threads. The map
+// is split in blocks of BlockSize x BlockSize tiles, idle workers take the
+// next block and matches are handed back to the calling thread in block order
+// while the search is still running, so results can be shown as they come in.
+class MapSearch {
+public:
+	static constexpr int BlockShift = 8;
+	static constexpr int BlockSize = 1 << BlockShift;
+
+	typedef std::bitset<0x10000> IdSet;
+	typedef std::pair<Tile*, Item*> Match;
+	// Called on the worker threads, must not touch anything but the tile and item
+	typedef std::function<bool(const Tile*, const Item*)> Predicate;
+	// Called on the calling thread with the matches found since the last call
+	// (possibly none) and the progress from 0 to 100, returning false cancels
+	typedef std::function<bool(const std::vector<Match>&, int)> BatchCallback;
+
+	explicit MapSearch(Map& map);
+
+	// Sets every id and every id of the ranges (inclusive pairs)
+	static IdSet makeIdSet(const std::vector<uint16_t>& ids, const std::vector<std::pair<uint16_t, uint16_t>>& ranges = {});
+
+	// The map must not be modified until this returns. Stops after max_results
+	// matches when it is not 0, returns the number of matches delivered.
+	size_t run(const Predicate& predicate, size_t max_results, bool selected_only, const BatchCallback& callback);
+
+private:
+	Map& map;
+};
+
+#endif
@@ -0,0 +1,170 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+
+#include "main.h"
+
+#include "map_statistics.h"
+#include "map.h"
+#include "map_region.h"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+MapStatistics::Counts::Counts() :
+	items(0x10000, 0),
+	item_total(0),
+	floor_tiles(),
+	house_tiles(0),
+	spawns(0),
+	tile_memory(0) {
+	////
+}
+
+void MapStatistics::Counts::addTile(Tile* tile, int z, uint64_t delta) {
+	floor_tiles[z] += delta;
+	if (tile->getHouseID() != 0) {
+		house_tiles += delta;
+	}
+	if (tile->spawn) {
+		spawns += delta;
+	}
+	tile_memory += delta * tile->memsize();
+
+	auto add = [&](Item* item) {
+		items[item->getID()] += delta;
+		item_total += delta;
+		return true;
+	};
+	foreach_ItemOnTile(tile, add);
+}
+
+void MapStatistics::Counts::addItem(Item* item, uint64_t delta) {
+	tile_memory += delta * item->memsize();
+
+	auto add = [&](Item* nested) {
+		items[nested->getID()] += delta;
+		item_total += delta;
+		return true;
+	};
+	foreach_ItemInItem(item, add);
+}
+
+void MapStatistics::Counts::merge(const Counts& other) {
+	for (size_t id = 0; id < items.size(); ++id) {
+		items[id] += other.items[id];
+	}
+	item_total += other.item_total;
+	for (int z = 0; z < MAP_LAYERS; ++z) {
+		floor_tiles[z] += other.floor_tiles[z];
+	}
+	house_tiles += other.house_tiles;
+	spawns += other.spawns;
+	tile_memory += other.tile_memory;
+}
+
+MapStatistics::MapStatistics() :
+	ready(false) {
+	////
+}
+
+void MapStatistics::build(BaseMap& map) {
+	invalidate();
+
+	std::vector<Position> blocks;
+	for (int y = 0; y <= MAP_MAX_HEIGHT; y += BlockSize) {
+		for (int x = 0; x <= MAP_MAX_WIDTH; x += BlockSize) {
+			if (map.getNode(x, y, BlockSize)) {
+				blocks.emplace_back(x, y, 0);
+			}
+		}
+	}
+
+	// Every thread counts into its own totals, they are added up at the end
+	const int thread_count = std::max(1, std::min<int>(std::max(1u, std::thread::hardware_concurrency()), blocks.size()));
+	std::vector<Counts> partial(thread_count);
+	std::atomic<size_t> next_block(0);
+	auto worker = [&](Counts& totals) {
+		for (size_t i = next_block++; i < blocks.size(); i = next_block++) {
+			const Position& block = blocks[i];
+			for (int leaf_y = block.y; leaf_y < block.y + BlockSize; leaf_y += 4) {
+				for (int leaf_x = block.x; leaf_x < block.x + BlockSize; leaf_x += 4) {
+					QTreeNode* leaf = map.getLeaf(leaf_x, leaf_y);
+					if (!leaf) {
+						continue;
+					}
+					for (int z = 0; z < MAP_LAYERS; ++z) {
+						Floor* floor = leaf->getFloor(z);
+						if (!floor) {
+							continue;
+						}
+						for (TileLocation& location : floor->locs) {
+							if (Tile* tile = location.get()) {
+								totals.addTile(tile, z, 1);
+							}
+						}
+					}
+				}
+			}
+		}
+	};
+
+	std::vector<std::thread> threads;
+	for (int i = 1; i < thread_count; ++i) {
+		threads.emplace_back(worker, std::ref(partial[i]));
+	}
+	worker(partial[0]);
+	for (std::thread& thread : threads) {
+		thread.join();
+	}
+
+	for (const Counts& totals : partial) {
+		counts.merge(totals);
+	}
+	ready = true;
+}
+
+void MapStatistics::invalidate() {
+	counts = Counts();
+	ready = false;
+}
+
+void MapStatistics::onTileChanged(const Position& pos, Tile* oldtile, Tile* newtile) {
+	if (!ready) {
+		return;
+	}
+	if (oldtile) {
+		counts.addTile(oldtile, pos.z, uint64_t(-1));
+	}
+	if (newtile) {
+		counts.addTile(newtile, pos.z, 1);
+	}
+}
+
+void MapStatistics::onItemRemoved(Item* item) {
+	if (ready) {
+		counts.addItem(item, uint64_t(-1));
+	}
+}
+
+void MapStatistics::onItemIdChanged(uint16_t old_id, uint16_t new_id) {
+	if (ready) {
+		--counts.items[old_id];
+		++counts.items[new_id];
+	}
+}
@@ -0,0 +1,99 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+
+#ifndef RME_MAP_STATISTICS_H_
+#define RME_MAP_STATISTICS_H_
+
+#include "position.h"
+
+#include <cstdint>
+#include <vector>
+
+class BaseMap;
+class Tile;
+class Item;
+
+// Counts of the whole map: items per id (contents of containers included),
+// tiles per floor, house tiles, spawns and the memory held by the tiles. They
+// are counted once on worker threads when first needed and follow every tile
+// swapped in or out of the map afterwards, so reading them costs nothing.
+class MapStatistics {
+public:
+	static constexpr int BlockSize = 256;
+
+	MapStatistics();
+
+	MapStatistics(const MapStatistics&) = delete;
+	MapStatistics& operator=(const MapStatistics&) = delete;
+
+	bool isReady() const noexcept {
+		return ready;
+	}
+	// Counts the whole map, the map must not be modified until this returns
+	void build(BaseMap& map);
+	// Drops the counts, the next build starts from scratch
+	void invalidate();
+
+	// Called whenever the tile at pos is replaced, either tile may be null
+	void onTileChanged(const Position& pos, Tile* oldtile, Tile* newtile);
+	// An item (and its contents) was taken off a tile in place
+	void onItemRemoved(Item* item);
+	// An item got another id in place
+	void onItemIdChanged(uint16_t old_id, uint16_t new_id);
+
+	uint64_t getItemCount(uint16_t id) const {
+		return counts.items[id];
+	}
+	uint64_t getItemTotal() const noexcept {
+		return counts.item_total;
+	}
+	uint64_t getTileCount(int z) const {
+		return counts.floor_tiles[z];
+	}
+	uint64_t getHouseTileCount() const noexcept {
+		return counts.house_tiles;
+	}
+	uint64_t getSpawnCount() const noexcept {
+		return counts.spawns;
+	}
+	uint64_t getTileMemory() const noexcept {
+		return counts.tile_memory;
+	}
+
+private:
+	// Deltas are added modulo 2^64, the totals are never negative
+	struct Counts {
+		Counts();
+
+		void addTile(Tile* tile, int z, uint64_t delta);
+		void addItem(Item* item, uint64_t delta);
+		void merge(const Counts& other);
+
+		std::vector<uint64_t> items;
+		uint64_t item_total;
+		uint64_t floor_tiles[MAP_LAYERS];
+		uint64_t house_tiles;
+		uint64_t spawns;
+		uint64_t tile_memory;
+	};
+
+	bool ready;
+	Counts counts;
+};
+
+#endif
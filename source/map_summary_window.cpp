@@ -22,9 +22,9 @@
 #include "tile.h"
 #include "item.h"
 #include "items.h"
+#include "map_statistics.h"
 #include "string_utils.h"
 #include <algorithm>
-#include <map>
 
 BEGIN_EVENT_TABLE(MapSummaryWindow, wxPanel)
 EVT_LISTBOX(wxID_ANY, MapSummaryWindow::OnClickResult)
@@ -33,13 +33,22 @@ EVT_BUTTON(wxID_CLEAR, MapSummaryWindow::OnClickClear)
 EVT_BUTTON(wxID_REFRESH, MapSummaryWindow::OnClickSummarize)
 EVT_TEXT(wxID_FIND, MapSummaryWindow::OnFilterText)
 EVT_BUTTON(wxID_SORT_ASCENDING, MapSummaryWindow::OnClickSort)
+EVT_TIMER(wxID_ANY, MapSummaryWindow::OnRefreshTimer)
 END_EVENT_TABLE()
 
 MapSummaryWindow::MapSummaryWindow(wxWindow* parent) :
-	wxPanel(parent, wxID_ANY) {
+	wxPanel(parent, wxID_ANY),
+	refresh_timer(this),
+	sort_mode(SORT_BY_COUNT),
+	summarized_map(nullptr),
+	summarized_revision(0) {
 	
 	wxSizer* main_sizer = new wxBoxSizer(wxVERTICAL);
 
+	// Map wide totals
+	totals_text = new wxStaticText(this, wxID_ANY, "");
+	main_sizer->Add(totals_text, 0, wxEXPAND | wxALL, 5);
+
 	// Filter section
 	wxSizer* filter_sizer = new wxBoxSizer(wxHORIZONTAL);
 	filter_sizer->Add(new wxStaticText(this, wxID_ANY, "Filter:"), 0, wxALIGN_CENTER_VERTICAL | wxALL, 5);
@@ -70,6 +79,9 @@ MapSummaryWindow::MapSummaryWindow(wxWindow* parent) :
 	button_sizer->Add(new wxButton(this, wxID_CLEAR, "Clear"), 0, wxALL, 5);
 	
 	main_sizer->Add(button_sizer, 0, wxCENTER | wxALL, 5);
+
+	auto_refresh_checkbox = new wxCheckBox(this, wxID_ANY, "Refresh while editing");
+	main_sizer->Add(auto_refresh_checkbox, 0, wxLEFT | wxRIGHT | wxBOTTOM, 10);
 	
 	SetSizerAndFit(main_sizer);
 	
@@ -77,6 +89,9 @@ MapSummaryWindow::MapSummaryWindow(wxWindow* parent) :
 	Bind(wxEVT_BUTTON, &MapSummaryWindow::OnClickSort, this, wxID_SORT_ASCENDING);
 	Bind(wxEVT_BUTTON, &MapSummaryWindow::OnClickSort, this, wxID_SORT_ASCENDING + 1);
 	Bind(wxEVT_BUTTON, &MapSummaryWindow::OnClickSort, this, wxID_SORT_ASCENDING + 2);
+
+	// Cheap as long as nothing changed, the statistics follow every edit
+	refresh_timer.Start(1000);
 }
 
 MapSummaryWindow::~MapSummaryWindow() {
@@ -86,90 +101,104 @@ MapSummaryWindow::~MapSummaryWindow() {
 void MapSummaryWindow::Clear() {
 	result_list->Clear();
 	item_summaries.clear();
+	totals_text->SetLabel("");
+	summarized_map = nullptr;
 }
 
 void MapSummaryWindow::SummarizeMap(Map& map) {
 	Clear();
-	
-	// Count all items on the map
-	std::map<uint16_t, uint32_t> item_counts;
-	
-	g_gui.CreateLoadBar("Summarizing map items...");
-	
-	uint64_t total_tiles = map.getTileCount();
-	uint64_t processed = 0;
-	
-	for (MapIterator mit = map.begin(); mit != map.end(); ++mit) {
-		Tile* tile = (*mit)->get();
-		if (!tile) {
-			processed++;
+
+	map.enableStatistics();
+	std::shared_ptr<MapStatistics> statistics = map.getStatistics();
+	if (!statistics->isReady()) {
+		// Only needed once per map, the counts are kept up to date afterwards
+		g_gui.CreateLoadBar("Summarizing map items...");
+		statistics->build(map);
+		g_gui.DestroyLoadBar();
+	}
+
+	ReadStatistics(map);
+
+	wxString statusMsg = wxString::Format("Map summarized: %zu unique item types found", item_summaries.size());
+	g_gui.SetStatusText(statusMsg);
+}
+
+void MapSummaryWindow::ReadStatistics(Map& map) {
+	std::shared_ptr<MapStatistics> statistics = map.getStatistics();
+	ASSERT(statistics && statistics->isReady());
+
+	item_summaries.clear();
+	for (uint32_t itemId = 0; itemId <= 0xFFFF; ++itemId) {
+		const uint64_t count = statistics->getItemCount(itemId);
+		if (count == 0) {
 			continue;
 		}
-		
-		// Update progress bar every 1000 tiles
-		if (processed % 1000 == 0) {
-			g_gui.SetLoadDone((uint32_t)(100 * processed / total_tiles));
-		}
-		
-		// Count ground items
-		if (tile->ground) {
-			item_counts[tile->ground->getID()]++;
-		}
-		
-		// Count items on tile
-		for (Item* item : tile->items) {
-			if (item) {
-				item_counts[item->getID()]++;
-				
-				// Count items in containers recursively
-				if (Container* container = dynamic_cast<Container*>(item)) {
-					CountContainerItems(container, item_counts);
-				}
-			}
-		}
-		
-		processed++;
-	}
-	
-	g_gui.DestroyLoadBar();
-	
-	// Convert to our internal format and add to list
-	for (const auto& pair : item_counts) {
-		uint16_t itemId = pair.first;
-		uint32_t count = pair.second;
-		
+
 		ItemType& itemType = g_items[itemId];
 		wxString itemName = wxstr(itemType.name);
 		if (itemName.empty()) {
 			itemName = wxString::Format("Unknown Item %d", itemId);
 		}
-		
 		item_summaries.emplace_back(itemId, itemName, count);
 	}
-	
-	// Sort by count (descending) by default
-	SortByCount();
+
+	wxString floors;
+	for (int z = 0; z < MAP_LAYERS; ++z) {
+		if (const uint64_t tiles = statistics->getTileCount(z)) {
+			floors << (floors.empty() ? "" : ", ") << z << ": " << wxString::Format("%llu", (unsigned long long)tiles);
+		}
+	}
+
+	uint64_t tiles = 0;
+	for (int z = 0; z < MAP_LAYERS; ++z) {
+		tiles += statistics->getTileCount(z);
+	}
+
+	totals_text->SetLabel(wxString::Format(
+		"Items: %llu (%zu types)\nTiles: %llu (floors %s)\nHouses: %u (%llu tiles), spawns: %llu\nTile memory: %.1f MB",
+		(unsigned long long)statistics->getItemTotal(), item_summaries.size(),
+		(unsigned long long)tiles, floors.empty() ? wxString("none") : floors,
+		map.houses.count(), (unsigned long long)statistics->getHouseTileCount(),
+		(unsigned long long)statistics->getSpawnCount(),
+		statistics->getTileMemory() / (1024.0 * 1024.0)
+	));
+	Layout();
+
+	summarized_map = &map;
+	summarized_revision = map.getRevision();
+
+	Sort();
 	RefreshList();
-	
-	wxString statusMsg = wxString::Format("Map summarized: %zu unique item types found", item_summaries.size());
-	g_gui.SetStatusText(statusMsg);
 }
 
-void MapSummaryWindow::CountContainerItems(Container* container, std::map<uint16_t, uint32_t>& item_counts) {
-	const ItemVector& items = container->getVector();
-	for (Item* item : items) {
-		if (item) {
-			item_counts[item->getID()]++;
-			
-			// Recursively count items in nested containers
-			if (Container* nested_container = dynamic_cast<Container*>(item)) {
-				CountContainerItems(nested_container, item_counts);
-			}
+void MapSummaryWindow::OnRefreshTimer(wxTimerEvent& WXUNUSED(event)) {
+	// Nothing is shown before the first Summarize or after Clear
+	if (!summarized_map || !auto_refresh_checkbox->GetValue() || !IsShownOnScreen() || !g_gui.IsEditorOpen()) {
+		return;
+	}
+
+	// Never builds the statistics on its own, that is left to the Summarize button
+	Map& map = g_gui.GetCurrentMap();
+	std::shared_ptr<MapStatistics> statistics = map.getStatistics();
+	if (!statistics || !statistics->isReady()) {
+		return;
+	}
+	if (&map == summarized_map && map.getRevision() == summarized_revision) {
+		return;
+	}
+
+	// Keep the selected row selected across the refresh
+	const wxString selected = result_list->GetStringSelection();
+	ReadStatistics(map);
+	if (!selected.empty()) {
+		const int index = result_list->FindString(selected);
+		if (index != wxNOT_FOUND) {
+			result_list->SetSelection(index);
 		}
 	}
 }
 
-void MapSummaryWindow::AddItemCount(uint16_t itemId, const wxString& itemName, uint32_t count) {
+void MapSummaryWindow::AddItemCount(uint16_t itemId, const wxString& itemName, uint64_t count) {
 	item_summaries.emplace_back(itemId, itemName, count);
 	RefreshList();
 }
@@ -194,12 +223,26 @@ void MapSummaryWindow::RefreshList() {
 			}
 		}
 		
-		wxString display_text = wxString::Format("%s [ID: %d] - Count: %u", 
-			summary.itemName, summary.itemId, summary.count);
+		wxString display_text = wxString::Format("%s [ID: %d] - Count: %llu", 
+			summary.itemName, summary.itemId, (unsigned long long)summary.count);
 		result_list->Append(display_text);
 	}
 }
 
+void MapSummaryWindow::Sort() {
+	switch (sort_mode) {
+		case SORT_BY_ID:
+			SortByID();
+			break;
+		case SORT_BY_NAME:
+			SortByName();
+			break;
+		default:
+			SortByCount();
+			break;
+	}
+}
+
 void MapSummaryWindow::SortByCount() {
 	std::sort(item_summaries.begin(), item_summaries.end(), 
 		[](const ItemSummary& a, const ItemSummary& b) {
@@ -252,8 +295,8 @@ void MapSummaryWindow::OnClickExport(wxCommandEvent& WXUNUSED(event)) {
 					}
 				}
 				
-				wxString line = wxString::Format("%s [ID: %d] - Count: %u\n", 
-					summary.itemName, summary.itemId, summary.count);
+				wxString line = wxString::Format("%s [ID: %d] - Count: %llu\n", 
+					summary.itemName, summary.itemId, (unsigned long long)summary.count);
 				file.Write(line);
 			}
 			
@@ -287,14 +330,15 @@ void MapSummaryWindow::OnClickSort(wxCommandEvent& event) {
 	
 	if (id == wxID_SORT_ASCENDING) {
 		// Sort by count
-		SortByCount();
+		sort_mode = SORT_BY_COUNT;
 	} else if (id == wxID_SORT_ASCENDING + 1) {
 		// Sort by ID
-		SortByID();
+		sort_mode = SORT_BY_ID;
 	} else if (id == wxID_SORT_ASCENDING + 2) {
 		// Sort by name
-		SortByName();
+		sort_mode = SORT_BY_NAME;
 	}
 	
+	Sort();
 	RefreshList(); 
 } 
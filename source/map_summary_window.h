@@ -24,7 +24,6 @@
 
 // Forward declarations
 class Map;
-class Container;
 
 class MapSummaryWindow : public wxPanel {
 public:
@@ -33,7 +32,7 @@ public:
 
 	void Clear();
 	void SummarizeMap(Map& map);
-	void AddItemCount(uint16_t itemId, const wxString& itemName, uint32_t count);
+	void AddItemCount(uint16_t itemId, const wxString& itemName, uint64_t count);
 	void SetFilter(const wxString& filter);
 
 	// Event handlers
@@ -42,22 +41,31 @@ public:
 	void OnClickClear(wxCommandEvent& event);
 	void OnClickSummarize(wxCommandEvent& event);
 	void OnFilterText(wxCommandEvent& event);
+	void OnRefreshTimer(wxTimerEvent& event);
 
 protected:
 	struct ItemSummary {
 		uint16_t itemId;
 		wxString itemName;
-		uint32_t count;
+		uint64_t count;
 		
-		ItemSummary(uint16_t id, const wxString& name, uint32_t c) 
+		ItemSummary(uint16_t id, const wxString& name, uint64_t c) 
 			: itemId(id), itemName(name), count(c) {}
 	};
 
+	enum SortMode {
+		SORT_BY_COUNT,
+		SORT_BY_ID,
+		SORT_BY_NAME,
+	};
+
 	void RefreshList();
+	void Sort();
 	void SortByCount();
 	void SortByID();
 	void SortByName();
-	void CountContainerItems(Container* container, std::map<uint16_t, uint32_t>& item_counts);
+	// Fills the list from the map statistics, which have to be built
+	void ReadStatistics(Map& map);
 	void OnClickSort(wxCommandEvent& event);
 
 	wxListBox* result_list;
@@ -66,9 +74,18 @@ protected:
 	wxButton* sort_count_button;
 	wxButton* sort_id_button;
 	wxButton* sort_name_button;
+	wxStaticText* totals_text;
+	wxCheckBox* auto_refresh_checkbox;
+	wxTimer refresh_timer;
 	
 	std::vector<ItemSummary> item_summaries;
 	wxString current_filter;
+	SortMode sort_mode;
+
+	// Map shown and its revision at that time, the map is only compared
+	// against the current one and never dereferenced
+	const Map* summarized_map;
+	uint64_t summarized_revision;
 
 	DECLARE_EVENT_TABLE()
 };
@@ -0,0 +1,336 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#include "main.h"
+
+#include "minimap_exporter.h"
+#include "minimap_rasterizer.h"
+#include "minimap_store.h"
+#include "filehandle.h"
+#include "png_writer.h"
+#include "graphics.h"
+#include "map.h"
+
+#include <limits>
+#include <memory>
+#include <thread>
+
+namespace {
+	class ImageWriter {
+	public:
+		virtual ~ImageWriter() = default;
+
+		virtual bool begin(int width, int height) = 0;
+		// Rows are passed top to bottom
+		virtual bool writeRows(const uint8_t* rows, int count) = 0;
+		virtual bool finish() = 0;
+
+		const std::string& getError() const noexcept {
+			return error;
+		}
+
+	protected:
+		std::string error;
+	};
+
+	// 8-bit BMP with the OT minimap palette. The height is stored negative so
+	// rows can be written top-down as they are produced.
+	class BmpWriter : public ImageWriter {
+	public:
+		explicit BmpWriter(const std::string& filename) :
+			file(filename), width(0) { }
+
+		bool begin(int width, int height) override {
+			if (!file.isOpen()) {
+				error = "Could not open file for writing.";
+				return false;
+			}
+
+			this->width = width;
+			const uint64_t header_size = 14 + 40 + 256 * 4;
+			const uint64_t file_size = header_size + uint64_t((width + 3) & ~3) * height;
+			if (file_size > 0xFFFFFFFFULL) {
+				error = "The floor is too large for a BMP file, export it as PNG instead.";
+				return false;
+			}
+
+			file.addRAW("BM");
+			file.addU32(uint32_t(file_size));
+			file.addU16(0);
+			file.addU16(0);
+			file.addU32(uint32_t(header_size));
+
+			file.addU32(40);
+			file.addU32(uint32_t(width));
+			file.addU32(uint32_t(-height));
+			file.addU16(1);
+			file.addU16(8);
+			file.addU32(0);
+			file.addU32(0);
+			file.addU32(4000);
+			file.addU32(4000);
+			file.addU32(256);
+			file.addU32(0);
+
+			for (int i = 0; i < 256; ++i) {
+				file.addU32(uint32_t(minimap_color[i]));
+			}
+			return file.isOk();
+		}
+
+		bool writeRows(const uint8_t* rows, int count) override {
+			static const uint8_t padding[3] = { 0, 0, 0 };
+			const int padding_size = (4 - (width & 3)) & 3;
+			for (int y = 0; y < count; ++y) {
+				file.addRAW(rows + size_t(y) * width, width);
+				if (padding_size > 0) {
+					file.addRAW(padding, padding_size);
+				}
+			}
+			return file.isOk();
+		}
+
+		bool finish() override {
+			if (!file.isOk()) {
+				error = "Could not write to file.";
+				return false;
+			}
+			file.close();
+			return true;
+		}
+
+	private:
+		FileWriteHandle file;
+		int width;
+	};
+
+	// Indexed PNG with the OT minimap palette
+	class IndexedPngWriter : public ImageWriter {
+	public:
+		explicit IndexedPngWriter(const std::string& filename) :
+			png(filename) { }
+
+		bool begin(int width, int height) override {
+			uint8_t palette[256 * 3];
+			for (int i = 0; i < 256; ++i) {
+				palette[i * 3] = minimap_color[i].red;
+				palette[i * 3 + 1] = minimap_color[i].green;
+				palette[i * 3 + 2] = minimap_color[i].blue;
+			}
+			if (!png.begin(width, height, PngWriter::COLOR_INDEXED, palette)) {
+				error = png.getError();
+				return false;
+			}
+			return true;
+		}
+
+		bool writeRows(const uint8_t* rows, int count) override {
+			return png.writeRows(rows, count);
+		}
+
+		bool finish() override {
+			if (!png.finish()) {
+				error = png.getError();
+				return false;
+			}
+			return true;
+		}
+
+	private:
+		PngWriter png;
+	};
+
+	std::unique_ptr<ImageWriter> createWriter(const std::string& filename) {
+		const size_t dot = filename.find_last_of('.');
+		std::string extension = dot == std::string::npos ? std::string() : filename.substr(dot + 1);
+		to_lower_str(extension);
+		if (extension == "bmp") {
+			return std::unique_ptr<ImageWriter>(newd BmpWriter(filename));
+		}
+		return std::unique_ptr<ImageWriter>(newd IndexedPngWriter(filename));
+	}
+}
+
+MinimapExporter::MinimapExporter(Map& map) :
+	map(map) {
+	////
+}
+
+bool MinimapExporter::getBounds(int floor, Bounds& bounds) const {
+	std::shared_ptr<MinimapStore> store = map.getMinimapStore();
+	if (!store) {
+		// Without the colour store there is nothing cheap to find the coloured area with
+		bounds = { 0, 0, map.getWidth(), map.getHeight() };
+		return bounds.width > 0 && bounds.height > 0;
+	}
+
+	int min_bx = MinimapStore::BlocksPerSide, min_by = MinimapStore::BlocksPerSide;
+	int max_bx = -1, max_by = -1;
+	for (int by = 0; by < MinimapStore::BlocksPerSide; ++by) {
+		for (int bx = 0; bx < MinimapStore::BlocksPerSide; ++bx) {
+			if (store->hasBlock(bx, by, floor)) {
+				min_bx = std::min(min_bx, bx);
+				min_by = std::min(min_by, by);
+				max_bx = std::max(max_bx, bx);
+				max_by = std::max(max_by, by);
+			}
+		}
+	}
+	if (max_bx < 0) {
+		return false;
+	}
+
+	// Only the blocks on the edge of the area can move the exact bounds
+	const int block_size = MinimapStore::BlockSize;
+	int min_x = std::numeric_limits<int>::max(), min_y = std::numeric_limits<int>::max();
+	int max_x = -1, max_y = -1;
+	std::vector<uint8_t> pixels(block_size * block_size);
+	for (int by = min_by; by <= max_by; ++by) {
+		for (int bx = min_bx; bx <= max_bx; ++bx) {
+			if (bx != min_bx && bx != max_bx && by != min_by && by != max_by) {
+				continue;
+			}
+			if (!store->hasBlock(bx, by, floor) || store->readBlock(bx, by, floor, pixels.data()) == 0) {
+				continue;
+			}
+			for (int y = 0; y < block_size; ++y) {
+				for (int x = 0; x < block_size; ++x) {
+					if (pixels[y * block_size + x] != 0) {
+						min_x = std::min(min_x, bx * block_size + x);
+						min_y = std::min(min_y, by * block_size + y);
+						max_x = std::max(max_x, bx * block_size + x);
+						max_y = std::max(max_y, by * block_size + y);
+					}
+				}
+			}
+		}
+	}
+	if (max_x < 0) {
+		return false;
+	}
+
+	bounds = { min_x, min_y, max_x - min_x + 1, max_y - min_y + 1 };
+	return true;
+}
+
+void MinimapExporter::rasterizeBand(int floor, const Bounds& bounds, int y, int rows, uint8_t* band, int thread_count) const {
+	const int tiles = (bounds.width + TileWidth - 1) / TileWidth;
+	std::atomic<int> next(0);
+
+	auto worker = [&]() {
+		std::vector<uint8_t> pixels(size_t(TileWidth) * rows);
+		for (int tile = next++; tile < tiles; tile = next++) {
+			const int x = tile * TileWidth;
+			const int width = std::min(TileWidth, bounds.width - x);
+			MinimapRasterizer::rasterize(map, bounds.x + x, y, floor, width, rows, pixels.data());
+			for (int row = 0; row < rows; ++row) {
+				std::copy_n(&pixels[size_t(row) * width], width, band + size_t(row) * bounds.width + x);
+			}
+		}
+	};
+
+	std::vector<std::thread> threads;
+	for (int i = 1; i < std::min(thread_count, tiles); ++i) {
+		threads.emplace_back(worker);
+	}
+	worker();
+	for (std::thread& thread : threads) {
+		thread.join();
+	}
+}
+
+bool MinimapExporter::exportFloor(const Job& job, const Bounds& bounds, int thread_count, std::atomic<size_t>& bands_done, std::string& error) const {
+	std::unique_ptr<ImageWriter> writer = createWriter(job.filename);
+	bool ok = writer->begin(bounds.width, bounds.height);
+
+	std::vector<uint8_t> band(size_t(bounds.width) * BandHeight);
+	for (int y = 0; y < bounds.height; y += BandHeight) {
+		if (ok) {
+			const int rows = std::min(BandHeight, bounds.height - y);
+			rasterizeBand(job.floor, bounds, bounds.y + y, rows, band.data(), thread_count);
+			ok = writer->writeRows(band.data(), rows);
+		}
+		// Failed floors still count their bands so the progress reaches the end
+		++bands_done;
+	}
+
+	ok = ok && writer->finish();
+	if (!ok) {
+		error = "Could not export floor " + std::to_string(job.floor) + " to \"" + job.filename + "\": ";
+		error += writer->getError().empty() ? "Could not write to file." : writer->getError();
+	}
+	return ok;
+}
+
+bool MinimapExporter::exportFloors(const std::vector<Job>& jobs, std::string& error, const std::function<void(int)>& progress) {
+	struct FloorExport {
+		Bounds bounds;
+		bool empty;
+		bool ok;
+		std::string error;
+	};
+
+	std::vector<FloorExport> floors(jobs.size());
+	size_t total_bands = 0;
+	for (size_t i = 0; i < jobs.size(); ++i) {
+		FloorExport& floor = floors[i];
+		floor.empty = !getBounds(jobs[i].floor, floor.bounds);
+		floor.ok = true;
+		if (!floor.empty) {
+			total_bands += (floor.bounds.height + BandHeight - 1) / BandHeight;
+		}
+	}
+
+	// One thread per floor, the remaining hardware threads help rasterising the bands
+	const int hardware_threads = std::max(1u, std::thread::hardware_concurrency());
+	const int floor_threads = std::max(1, std::min<int>(hardware_threads, jobs.size()));
+	const int band_threads = std::max(1, hardware_threads / floor_threads);
+
+	std::atomic<size_t> next_job(0);
+	std::atomic<size_t> bands_done(0);
+	std::atomic<int> running(floor_threads);
+	auto worker = [&]() {
+		for (size_t i = next_job++; i < jobs.size(); i = next_job++) {
+			if (!floors[i].empty) {
+				floors[i].ok = exportFloor(jobs[i], floors[i].bounds, band_threads, bands_done, floors[i].error);
+			}
+		}
+		--running;
+	};
+
+	std::vector<std::thread> threads;
+	for (int i = 0; i < floor_threads; ++i) {
+		threads.emplace_back(worker);
+	}
+	while (running > 0) {
+		if (progress && total_bands > 0) {
+			progress(int(bands_done * 100 / total_bands));
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(100));
+	}
+	for (std::thread& thread : threads) {
+		thread.join();
+	}
+
+	for (const FloorExport& floor : floors) {
+		if (!floor.ok) {
+			error = floor.error;
+			return false;
+		}
+	}
+	return true;
+}
@@ -0,0 +1,64 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#ifndef RME_MINIMAP_EXPORTER_H_
+#define RME_MINIMAP_EXPORTER_H_
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+class Map;
+
+// Writes minimap images of whole floors. An image covers the coloured part of
+// its floor and is produced in bands of BandHeight rows: worker threads
+// rasterise the map leaves of a band, the band is appended to the file and its
+// buffer reused, so memory use does not depend on the size of the map.
+// Several floors are exported at the same time.
+class MinimapExporter {
+public:
+	static constexpr int BandHeight = 64;
+	static constexpr int TileWidth = 1024;
+
+	struct Job {
+		int floor;
+		// Written as an 8-bit BMP if the extension is .bmp, as an indexed PNG otherwise
+		std::string filename;
+	};
+
+	explicit MinimapExporter(Map& map);
+
+	// The map must not be modified until this returns. progress is called on
+	// the calling thread with values from 0 to 100 while the workers run.
+	// Floors without any coloured tile produce no file.
+	bool exportFloors(const std::vector<Job>& jobs, std::string& error, const std::function<void(int)>& progress = nullptr);
+
+private:
+	struct Bounds {
+		int x, y, width, height;
+	};
+
+	bool getBounds(int floor, Bounds& bounds) const;
+	bool exportFloor(const Job& job, const Bounds& bounds, int thread_count, std::atomic<size_t>& bands_done, std::string& error) const;
+	void rasterizeBand(int floor, const Bounds& bounds, int y, int rows, uint8_t* band, int thread_count) const;
+
+	Map& map;
+};
+
+#endif
@@ -0,0 +1,444 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#include "main.h"
+
+#include "minimap_pyramid.h"
+
+#include <fstream>
+#include <wx/filename.h>
+#include <wx/wfstream.h>
+#include <wx/zstream.h>
+
+namespace {
+	const uint32_t CacheMagic = 0x504D4D52; // "RMMP"
+	const uint32_t CacheVersion = 1;
+	const int TilePixels = MinimapPyramid::TileSize * MinimapPyramid::TileSize;
+
+	// Most frequent coloured pixel of a 2x2 square, ties go to the first one.
+	// Averaging would invent colours that are not in the palette.
+	inline uint8_t reduce(uint8_t a, uint8_t b, uint8_t c, uint8_t d) {
+		const uint8_t pixels[4] = { a, b, c, d };
+		uint8_t best = 0;
+		int best_count = 0;
+		for (uint8_t pixel : pixels) {
+			if (pixel == 0) {
+				continue;
+			}
+			const int count = (pixel == a) + (pixel == b) + (pixel == c) + (pixel == d);
+			if (count > best_count) {
+				best = pixel;
+				best_count = count;
+			}
+		}
+		return best;
+	}
+
+	bool readExact(wxInputStream& stream, void* buffer, size_t size) {
+		stream.Read(buffer, size);
+		return stream.LastRead() == size;
+	}
+
+	bool writeExact(wxOutputStream& stream, const void* buffer, size_t size) {
+		stream.Write(buffer, size);
+		return stream.LastWrite() == size;
+	}
+}
+
+MinimapPyramid::MinimapPyramid(std::shared_ptr<MinimapStore> store) :
+	store(std::move(store)),
+	revision(0),
+	running(false),
+	save_pending(false) {
+	////
+}
+
+MinimapPyramid::~MinimapPyramid() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		running = false;
+	}
+	wakeup.notify_all();
+	if (builder.joinable()) {
+		builder.join();
+	}
+}
+
+MinimapPyramid::VersionMap MinimapPyramid::snapshotVersions() const {
+	std::vector<MinimapStore::BlockVersion> versions;
+	store->collectBlockVersions(versions);
+
+	VersionMap snapshot;
+	snapshot.reserve(versions.size());
+	for (const MinimapStore::BlockVersion& block : versions) {
+		snapshot[MinimapStore::makeKey(block.key.bx, block.key.by, block.key.z)] = block.version;
+	}
+	return snapshot;
+}
+
+void MinimapPyramid::start(const std::string& map_filename, const std::string& cache_filename) {
+	ASSERT(!builder.joinable());
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		this->map_filename = map_filename;
+		this->cache_filename = cache_filename;
+		if (!map_filename.empty()) {
+			file_versions = snapshotVersions();
+		}
+		running = true;
+	}
+	builder = std::thread(&MinimapPyramid::run, this);
+}
+
+void MinimapPyramid::onMapSaved(const std::string& map_filename, const std::string& cache_filename) {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		this->map_filename = map_filename;
+		this->cache_filename = cache_filename;
+		file_versions = snapshotVersions();
+		save_pending = true;
+	}
+	wakeup.notify_all();
+}
+
+bool MinimapPyramid::readTile(int level, int tx, int ty, int z, uint8_t* indices) const {
+	if (level == 0) {
+		return store->readBlock(tx, ty, z, indices) > 0;
+	}
+
+	const int tiles_per_side = MinimapStore::BlocksPerSide >> level;
+	if (level < 0 || level >= LevelCount || tx < 0 || ty < 0 || tx >= tiles_per_side || ty >= tiles_per_side || z < 0 || z >= MAP_LAYERS) {
+		std::fill(indices, indices + TilePixels, 0);
+		return false;
+	}
+
+	std::lock_guard<std::mutex> lock(tiles_mutex);
+	auto it = tiles.find(makeTileKey(level, tx, ty, z));
+	if (it == tiles.end()) {
+		std::fill(indices, indices + TilePixels, 0);
+		return false;
+	}
+	std::copy(it->second.begin(), it->second.end(), indices);
+	return true;
+}
+
+void MinimapPyramid::run() {
+	std::string filename;
+	std::string cache;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		filename = map_filename;
+		cache = cache_filename;
+	}
+
+	// Level 1 tiles that have to be rebuilt, their parents follow automatically
+	std::unordered_set<uint32_t> dirty;
+	uint64_t file_hash = filename.empty() ? 0 : hashFile(filename);
+	bool write_pending = file_hash != 0 && !cache.empty();
+
+	std::vector<uint32_t> journal;
+	if (write_pending && loadCache(cache, file_hash, journal)) {
+		// The cached tiles show the map file, except for the journal blocks
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			built_versions = file_versions;
+		}
+		for (uint32_t key : journal) {
+			const MinimapStore::BlockKey block = MinimapStore::splitKey(key);
+			built_versions.erase(key);
+			dirty.insert(makeTileKey(1, block.bx / 2, block.by / 2, block.z));
+		}
+		write_pending = !journal.empty();
+		revision.fetch_add(1, std::memory_order_release);
+	}
+
+	std::vector<MinimapStore::BlockVersion> versions;
+	uint64_t seen_version = 0;
+	bool scanned = false;
+	while (true) {
+		const uint64_t version = store->getVersion();
+		if (!scanned || version != seen_version) {
+			scanned = true;
+			seen_version = version;
+			versions.clear();
+			store->collectBlockVersions(versions);
+			for (const MinimapStore::BlockVersion& block : versions) {
+				uint32_t& built = built_versions[MinimapStore::makeKey(block.key.bx, block.key.by, block.key.z)];
+				if (built != block.version) {
+					built = block.version;
+					dirty.insert(makeTileKey(1, block.key.bx / 2, block.key.by / 2, block.key.z));
+				}
+			}
+		}
+
+		if (!dirty.empty()) {
+			rebuild(std::move(dirty));
+			dirty.clear();
+		}
+
+		std::unique_lock<std::mutex> lock(mutex);
+		if (save_pending) {
+			save_pending = false;
+			filename = map_filename;
+			cache = cache_filename;
+			lock.unlock();
+			file_hash = filename.empty() ? 0 : hashFile(filename);
+			write_pending = file_hash != 0 && !cache.empty();
+			lock.lock();
+		}
+		if (write_pending && running) {
+			lock.unlock();
+			writeCache(cache, file_hash);
+			write_pending = false;
+			lock.lock();
+		}
+
+		wakeup.wait_for(lock, std::chrono::milliseconds(250), [this]() { return !running || save_pending; });
+		if (!running) {
+			break;
+		}
+	}
+}
+
+void MinimapPyramid::rebuild(std::unordered_set<uint32_t> dirty) {
+	for (int level = 1; level < LevelCount && !dirty.empty(); ++level) {
+		const std::vector<uint32_t> keys(dirty.begin(), dirty.end());
+		std::atomic<size_t> next(0);
+
+		// Tiles of one level only read the level below, so they can be built in any order
+		auto worker = [&]() {
+			std::vector<uint8_t> pixels;
+			for (size_t index = next++; index < keys.size(); index = next++) {
+				buildTile(keys[index], pixels);
+				std::lock_guard<std::mutex> lock(tiles_mutex);
+				if (pixels.empty()) {
+					tiles.erase(keys[index]);
+				} else {
+					tiles[keys[index]].swap(pixels);
+				}
+			}
+		};
+
+		const size_t thread_count = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()), (keys.size() + 3) / 4);
+		std::vector<std::thread> threads;
+		for (size_t i = 1; i < thread_count; ++i) {
+			threads.emplace_back(worker);
+		}
+		worker();
+		for (std::thread& thread : threads) {
+			thread.join();
+		}
+
+		std::unordered_set<uint32_t> parents;
+		for (uint32_t key : keys) {
+			const int tx = key & 0xFF;
+			const int ty = (key >> 8) & 0xFF;
+			const int z = (key >> 16) & 0xFF;
+			parents.insert(makeTileKey(level + 1, tx / 2, ty / 2, z));
+		}
+		dirty.swap(parents);
+	}
+
+	revision.fetch_add(1, std::memory_order_release);
+}
+
+void MinimapPyramid::buildTile(uint32_t key, std::vector<uint8_t>& out) const {
+	const int tx = key & 0xFF;
+	const int ty = (key >> 8) & 0xFF;
+	const int z = (key >> 16) & 0xFF;
+	const int level = key >> 24;
+
+	std::vector<uint8_t> children[4];
+	bool empty = true;
+	for (int quadrant = 0; quadrant < 4; ++quadrant) {
+		const int cx = tx * 2 + (quadrant & 1);
+		const int cy = ty * 2 + (quadrant >> 1);
+		std::vector<uint8_t>& child = children[quadrant];
+		if (level == 1) {
+			if (store->hasBlock(cx, cy, z)) {
+				child.resize(TilePixels);
+				if (store->readBlock(cx, cy, z, child.data()) == 0) {
+					child.clear();
+				}
+			}
+		} else {
+			std::lock_guard<std::mutex> lock(tiles_mutex);
+			auto it = tiles.find(makeTileKey(level - 1, cx, cy, z));
+			if (it != tiles.end()) {
+				child = it->second;
+			}
+		}
+		empty = empty && child.empty();
+	}
+
+	out.clear();
+	if (empty) {
+		return;
+	}
+
+	const int half = TileSize / 2;
+	out.assign(TilePixels, 0);
+	for (int quadrant = 0; quadrant < 4; ++quadrant) {
+		const std::vector<uint8_t>& child = children[quadrant];
+		if (child.empty()) {
+			continue;
+		}
+
+		const int ox = (quadrant & 1) * half;
+		const int oy = (quadrant >> 1) * half;
+		for (int y = 0; y < half; ++y) {
+			const uint8_t* top = &child[(y * 2) * TileSize];
+			const uint8_t* bottom = top + TileSize;
+			uint8_t* dest = &out[(oy + y) * TileSize + ox];
+			for (int x = 0; x < half; ++x) {
+				dest[x] = reduce(top[x * 2], top[x * 2 + 1], bottom[x * 2], bottom[x * 2 + 1]);
+			}
+		}
+	}
+}
+
+uint64_t MinimapPyramid::hashFile(const std::string& filename) {
+	std::ifstream file(filename, std::ios::in | std::ios::binary);
+	if (!file.is_open()) {
+		return 0;
+	}
+
+	// 64-bit FNV-1a
+	uint64_t hash = 0xCBF29CE484222325ULL;
+	std::vector<char> buffer(1 << 20);
+	while (file) {
+		file.read(buffer.data(), buffer.size());
+		const std::streamsize count = file.gcount();
+		for (std::streamsize i = 0; i < count; ++i) {
+			hash ^= uint8_t(buffer[i]);
+			hash *= 0x100000001B3ULL;
+		}
+	}
+	return hash;
+}
+
+bool MinimapPyramid::loadCache(const std::string& cache_filename, uint64_t file_hash, std::vector<uint32_t>& journal) {
+	wxFileInputStream file(wxstr(cache_filename));
+	if (!file.IsOk()) {
+		return false;
+	}
+
+	uint32_t magic, version;
+	uint64_t hash;
+	if (!readExact(file, &magic, sizeof(magic)) || !readExact(file, &version, sizeof(version)) || !readExact(file, &hash, sizeof(hash))) {
+		return false;
+	}
+	if (magic != CacheMagic || version != CacheVersion || hash != file_hash) {
+		return false;
+	}
+
+	wxZlibInputStream zlib(file, wxZLIB_ZLIB);
+	uint32_t journal_count;
+	if (!readExact(zlib, &journal_count, sizeof(journal_count))) {
+		return false;
+	}
+	journal.resize(journal_count);
+	if (journal_count > 0 && !readExact(zlib, journal.data(), journal_count * sizeof(uint32_t))) {
+		return false;
+	}
+
+	uint32_t tile_count;
+	if (!readExact(zlib, &tile_count, sizeof(tile_count))) {
+		return false;
+	}
+
+	std::unordered_map<uint32_t, std::vector<uint8_t>> loaded;
+	loaded.reserve(tile_count);
+	for (uint32_t i = 0; i < tile_count; ++i) {
+		uint32_t key;
+		if (!readExact(zlib, &key, sizeof(key))) {
+			return false;
+		}
+		const int level = key >> 24;
+		if (level < 1 || level >= LevelCount || ((key >> 16) & 0xFF) >= MAP_LAYERS) {
+			return false;
+		}
+
+		std::vector<uint8_t>& pixels = loaded[key];
+		pixels.resize(TilePixels);
+		if (!readExact(zlib, pixels.data(), pixels.size())) {
+			return false;
+		}
+	}
+
+	std::lock_guard<std::mutex> lock(tiles_mutex);
+	tiles.swap(loaded);
+	return true;
+}
+
+bool MinimapPyramid::writeCache(const std::string& cache_filename, uint64_t file_hash) {
+	// Blocks whose tiles were built from anything but the map file on disk
+	std::vector<uint32_t> journal;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		for (const auto& block : built_versions) {
+			auto it = file_versions.find(block.first);
+			if (it == file_versions.end() || it->second != block.second) {
+				journal.push_back(block.first);
+			}
+		}
+		for (const auto& block : file_versions) {
+			if (built_versions.find(block.first) == built_versions.end()) {
+				journal.push_back(block.first);
+			}
+		}
+	}
+
+	const wxString path = wxstr(cache_filename);
+	const wxString temp_path = path + ".tmp";
+	wxFileName::Mkdir(wxFileName(path).GetPath(), wxS_DIR_DEFAULT, wxPATH_MKDIR_FULL);
+
+	bool ok;
+	{
+		wxFileOutputStream file(temp_path);
+		if (!file.IsOk()) {
+			return false;
+		}
+
+		ok = writeExact(file, &CacheMagic, sizeof(CacheMagic)) && writeExact(file, &CacheVersion, sizeof(CacheVersion)) && writeExact(file, &file_hash, sizeof(file_hash));
+
+		wxZlibOutputStream zlib(file, wxZ_BEST_SPEED, wxZLIB_ZLIB);
+		const uint32_t journal_count = journal.size();
+		ok = ok && writeExact(zlib, &journal_count, sizeof(journal_count));
+		ok = ok && (journal.empty() || writeExact(zlib, journal.data(), journal.size() * sizeof(uint32_t)));
+
+		// Tiles only change while the builder runs rebuild(), which is this thread
+		const uint32_t tile_count = tiles.size();
+		ok = ok && writeExact(zlib, &tile_count, sizeof(tile_count));
+		for (const auto& tile : tiles) {
+			if (!ok) {
+				break;
+			}
+			ok = writeExact(zlib, &tile.first, sizeof(tile.first)) && writeExact(zlib, tile.second.data(), tile.second.size());
+		}
+
+		ok = zlib.Close() && ok;
+		ok = file.Close() && ok;
+	}
+
+	if (!ok || !wxRenameFile(temp_path, path, true)) {
+		wxRemoveFile(temp_path);
+		return false;
+	}
+	return true;
+}
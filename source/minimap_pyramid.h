@@ -0,0 +1,107 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#ifndef RME_MINIMAP_PYRAMID_H_
+#define RME_MINIMAP_PYRAMID_H_
+
+#include "minimap_store.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Zoomed out minimap tiles of every floor. Level 0 is the colour store itself,
+// every further level halves the resolution so a tile of level L covers
+// TileSize << L map tiles per side and the last level shows the whole map in
+// one tile. The levels are built on a background thread from the colour store
+// and kept up to date as blocks change.
+//
+// The tiles are cached on disk together with a hash of the map file they were
+// built from and a journal of the blocks that differed from that file when the
+// cache was written. Reopening the same file only rebuilds the journal blocks.
+class MinimapPyramid {
+public:
+	static constexpr int TileSize = MinimapStore::BlockSize;
+	static constexpr int LevelCount = 9;
+
+	explicit MinimapPyramid(std::shared_ptr<MinimapStore> store);
+	~MinimapPyramid();
+
+	MinimapPyramid(const MinimapPyramid&) = delete;
+	MinimapPyramid& operator=(const MinimapPyramid&) = delete;
+
+	// Starts the background builder. The store is expected to hold exactly the
+	// contents of map_filename at this point. Either path may be empty, in that
+	// case the pyramid is built but never cached.
+	void start(const std::string& map_filename, const std::string& cache_filename);
+	// The map was written to map_filename, the cache is rewritten for that file
+	void onMapSaved(const std::string& map_filename, const std::string& cache_filename);
+
+	// Copies a tile (row major palette indices), returns false if it has no
+	// coloured pixels. Can be called from any thread.
+	bool readTile(int level, int tx, int ty, int z, uint8_t* indices) const;
+	// Bumped whenever tiles of level 1 or above changed
+	uint32_t getRevision() const noexcept { return revision.load(std::memory_order_acquire); }
+
+private:
+	typedef std::unordered_map<uint32_t, uint32_t> VersionMap;
+
+	void run();
+	void rebuild(std::unordered_set<uint32_t> dirty);
+	void buildTile(uint32_t key, std::vector<uint8_t>& out) const;
+	bool loadCache(const std::string& cache_filename, uint64_t file_hash, std::vector<uint32_t>& journal);
+	bool writeCache(const std::string& cache_filename, uint64_t file_hash);
+	VersionMap snapshotVersions() const;
+
+	static uint64_t hashFile(const std::string& filename);
+
+	static uint32_t makeTileKey(int level, int tx, int ty, int z) {
+		return (uint32_t(level) << 24) | (uint32_t(z) << 16) | (uint32_t(ty) << 8) | uint32_t(tx);
+	}
+
+	std::shared_ptr<MinimapStore> store;
+
+	// Tiles of level 1 and above, empty tiles are not stored (guarded by tiles_mutex)
+	mutable std::mutex tiles_mutex;
+	std::unordered_map<uint32_t, std::vector<uint8_t>> tiles;
+	std::atomic<uint32_t> revision;
+
+	// Block versions the tiles were built from, only touched by the builder
+	VersionMap built_versions;
+
+	// Requests for the builder (guarded by mutex)
+	std::mutex mutex;
+	std::condition_variable wakeup;
+	bool running;
+	bool save_pending;
+	std::string map_filename;
+	std::string cache_filename;
+	// Block versions of the map file on disk, blocks built from anything else
+	// end up in the journal
+	VersionMap file_versions;
+
+	std::thread builder;
+};
+
+#endif
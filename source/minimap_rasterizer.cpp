@@ -0,0 +1,113 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#include "main.h"
+
+#include "minimap_rasterizer.h"
+#include "basemap.h"
+#include "map_region.h"
+#include "graphics.h"
+#include "tile.h"
+
+namespace {
+	struct ColorTable {
+		uint8_t rgb[256][3];
+
+		ColorTable() {
+			for (int i = 0; i < 256; ++i) {
+				rgb[i][0] = minimap_color[i].red;
+				rgb[i][1] = minimap_color[i].green;
+				rgb[i][2] = minimap_color[i].blue;
+			}
+		}
+	};
+
+	const ColorTable& getColorTable() {
+		static const ColorTable table;
+		return table;
+	}
+}
+
+size_t MinimapRasterizer::rasterize(BaseMap& map, int start_x, int start_y, int floor, int width, int height, uint8_t* indices) {
+	if (width <= 0 || height <= 0) {
+		return 0;
+	}
+
+	std::fill(indices, indices + size_t(width) * height, EmptyColor);
+	if (floor < 0 || floor > MAP_MAX_LAYER) {
+		return 0;
+	}
+
+	const int clip_start_x = std::max(start_x, 0);
+	const int clip_start_y = std::max(start_y, 0);
+	const int clip_end_x = std::min(start_x + width, MAP_MAX_WIDTH + 1);
+	const int clip_end_y = std::min(start_y + height, MAP_MAX_HEIGHT + 1);
+
+	size_t colored = 0;
+	for (int leaf_y = clip_start_y & ~3; leaf_y < clip_end_y; leaf_y += 4) {
+		const int y0 = std::max(leaf_y, clip_start_y);
+		const int y1 = std::min(leaf_y + 4, clip_end_y);
+
+		for (int leaf_x = clip_start_x & ~3; leaf_x < clip_end_x; leaf_x += 4) {
+			QTreeNode* leaf = map.getLeaf(leaf_x, leaf_y);
+			if (!leaf) {
+				continue;
+			}
+
+			Floor* tiles = leaf->getFloor(floor);
+			if (!tiles) {
+				continue;
+			}
+
+			const int x0 = std::max(leaf_x, clip_start_x);
+			const int x1 = std::min(leaf_x + 4, clip_end_x);
+			for (int x = x0; x < x1; ++x) {
+				const TileLocation* column = &tiles->locs[(x & 3) * 4];
+				for (int y = y0; y < y1; ++y) {
+					const Tile* tile = column[y & 3].get();
+					if (!tile) {
+						continue;
+					}
+
+					const uint8_t color = tile->getMiniMapColor();
+					if (color != EmptyColor) {
+						indices[size_t(y - start_y) * width + (x - start_x)] = color;
+						++colored;
+					}
+				}
+			}
+		}
+	}
+	return colored;
+}
+
+void MinimapRasterizer::expandRGB(const uint8_t* indices, size_t count, uint8_t* rgb) {
+	const ColorTable& table = getColorTable();
+	for (size_t i = 0; i < count; ++i) {
+		const uint8_t* color = table.rgb[indices[i]];
+		rgb[0] = color[0];
+		rgb[1] = color[1];
+		rgb[2] = color[2];
+		rgb += 3;
+	}
+}
+
+wxImage MinimapRasterizer::toImage(const uint8_t* indices, int width, int height) {
+	wxImage image(width, height, false);
+	expandRGB(indices, size_t(width) * height, image.GetData());
+	return image;
+}
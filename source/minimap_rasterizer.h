@@ -0,0 +1,45 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#ifndef RME_MINIMAP_RASTERIZER_H_
+#define RME_MINIMAP_RASTERIZER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <wx/image.h>
+
+class BaseMap;
+
+// Converts map areas to minimap pixels. The map is walked one leaf (4x4 tiles)
+// at a time instead of doing a tree lookup per pixel, and colours are written
+// as palette indices which are expanded to RGB in a single pass.
+namespace MinimapRasterizer {
+	// Palette index of positions without a tile or without a minimap colour
+	const uint8_t EmptyColor = 0;
+
+	// Writes the minimap colour index of every position inside the rectangle
+	// to indices (row major, width pixels per row). Positions outside of the
+	// map are left empty. Returns the number of coloured pixels.
+	size_t rasterize(BaseMap& map, int start_x, int start_y, int floor, int width, int height, uint8_t* indices);
+
+	// Expands palette indices to packed 24-bit RGB
+	void expandRGB(const uint8_t* indices, size_t count, uint8_t* rgb);
+
+	wxImage toImage(const uint8_t* indices, int width, int height);
+}
+
+#endif
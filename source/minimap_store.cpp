@@ -0,0 +1,211 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#include "main.h"
+
+#include "minimap_store.h"
+
+MinimapStore::Block::Block() :
+	queued(false),
+	version(0) {
+	for (std::atomic<uint8_t>& pixel : pixels) {
+		pixel.store(0, std::memory_order_relaxed);
+	}
+}
+
+MinimapStore::MinimapStore() :
+	version(0),
+	queue(newd uint32_t[QueueCapacity]),
+	queue_head(0),
+	queue_tail(0),
+	queue_overflow(false) {
+	for (std::atomic<BlockSlot*>& floor : floors) {
+		floor.store(nullptr, std::memory_order_relaxed);
+	}
+}
+
+MinimapStore::~MinimapStore() {
+	for (std::atomic<BlockSlot*>& floor : floors) {
+		BlockSlot* slots = floor.load(std::memory_order_relaxed);
+		if (!slots) {
+			continue;
+		}
+		for (int i = 0; i < BlocksPerSide * BlocksPerSide; ++i) {
+			delete slots[i].load(std::memory_order_relaxed);
+		}
+		delete[] slots;
+	}
+}
+
+const MinimapStore::Block* MinimapStore::findBlock(int bx, int by, int z) const {
+	if (bx < 0 || by < 0 || bx >= BlocksPerSide || by >= BlocksPerSide || z < 0 || z >= MAP_LAYERS) {
+		return nullptr;
+	}
+
+	const BlockSlot* slots = floors[z].load(std::memory_order_acquire);
+	if (!slots) {
+		return nullptr;
+	}
+	return slots[by * BlocksPerSide + bx].load(std::memory_order_acquire);
+}
+
+MinimapStore::Block* MinimapStore::getOrCreateBlock(int bx, int by, int z) {
+	// Only the writer allocates, readers observe the pointers through acquire loads
+	BlockSlot* slots = floors[z].load(std::memory_order_relaxed);
+	if (!slots) {
+		slots = newd BlockSlot[BlocksPerSide * BlocksPerSide];
+		for (int i = 0; i < BlocksPerSide * BlocksPerSide; ++i) {
+			slots[i].store(nullptr, std::memory_order_relaxed);
+		}
+		floors[z].store(slots, std::memory_order_release);
+	}
+
+	BlockSlot& slot = slots[by * BlocksPerSide + bx];
+	Block* block = slot.load(std::memory_order_relaxed);
+	if (!block) {
+		block = newd Block();
+		slot.store(block, std::memory_order_release);
+	}
+	return block;
+}
+
+void MinimapStore::setColor(int x, int y, int z, uint8_t color) {
+	if (x < 0 || y < 0 || x >= BlocksPerSide * BlockSize || y >= BlocksPerSide * BlockSize || z < 0 || z >= MAP_LAYERS) {
+		return;
+	}
+
+	const int bx = x / BlockSize;
+	const int by = y / BlockSize;
+	Block* block;
+	if (color == 0) {
+		// Clearing a pixel never needs a new block
+		block = const_cast<Block*>(findBlock(bx, by, z));
+		if (!block) {
+			return;
+		}
+	} else {
+		block = getOrCreateBlock(bx, by, z);
+	}
+
+	std::atomic<uint8_t>& pixel = block->pixels[(y % BlockSize) * BlockSize + (x % BlockSize)];
+	if (pixel.load(std::memory_order_relaxed) == color) {
+		return;
+	}
+	pixel.store(color, std::memory_order_relaxed);
+	block->version.fetch_add(1, std::memory_order_release);
+	version.fetch_add(1, std::memory_order_release);
+
+	// The acq_rel exchange pairs with the one in popDirtyBlocks, a consumer that
+	// clears the flag afterwards is guaranteed to see the new pixel.
+	if (!block->queued.exchange(true, std::memory_order_acq_rel)) {
+		pushDirty(makeKey(bx, by, z));
+	}
+}
+
+void MinimapStore::pushDirty(uint32_t key) {
+	const size_t tail = queue_tail.load(std::memory_order_relaxed);
+	const size_t head = queue_head.load(std::memory_order_acquire);
+	if (tail - head >= QueueCapacity) {
+		queue_overflow.store(true, std::memory_order_release);
+		return;
+	}
+
+	queue[tail % QueueCapacity] = key;
+	queue_tail.store(tail + 1, std::memory_order_release);
+}
+
+uint8_t MinimapStore::getColor(int x, int y, int z) const {
+	if (x < 0 || y < 0) {
+		return 0;
+	}
+
+	const Block* block = findBlock(x / BlockSize, y / BlockSize, z);
+	if (!block) {
+		return 0;
+	}
+	return block->pixels[(y % BlockSize) * BlockSize + (x % BlockSize)].load(std::memory_order_relaxed);
+}
+
+size_t MinimapStore::readBlock(int bx, int by, int z, uint8_t* indices) const {
+	const Block* block = findBlock(bx, by, z);
+	if (!block) {
+		std::fill(indices, indices + BlockSize * BlockSize, 0);
+		return 0;
+	}
+
+	size_t colored = 0;
+	for (int i = 0; i < BlockSize * BlockSize; ++i) {
+		const uint8_t color = block->pixels[i].load(std::memory_order_relaxed);
+		indices[i] = color;
+		colored += color != 0;
+	}
+	return colored;
+}
+
+bool MinimapStore::hasBlock(int bx, int by, int z) const {
+	return findBlock(bx, by, z) != nullptr;
+}
+
+void MinimapStore::collectBlockVersions(std::vector<BlockVersion>& versions) const {
+	for (int z = 0; z < MAP_LAYERS; ++z) {
+		const BlockSlot* slots = floors[z].load(std::memory_order_acquire);
+		if (!slots) {
+			continue;
+		}
+		for (int i = 0; i < BlocksPerSide * BlocksPerSide; ++i) {
+			if (const Block* block = slots[i].load(std::memory_order_acquire)) {
+				versions.push_back({ { i % BlocksPerSide, i / BlocksPerSide, z }, block->version.load(std::memory_order_acquire) });
+			}
+		}
+	}
+}
+
+bool MinimapStore::popDirtyBlocks(std::vector<BlockKey>& blocks) {
+	const bool overflow = queue_overflow.exchange(false, std::memory_order_acq_rel);
+
+	size_t head = queue_head.load(std::memory_order_relaxed);
+	const size_t tail = queue_tail.load(std::memory_order_acquire);
+	for (; head != tail; ++head) {
+		const uint32_t key = queue[head % QueueCapacity];
+		const BlockKey block_key = splitKey(key);
+		if (Block* block = const_cast<Block*>(findBlock(block_key.bx, block_key.by, block_key.z))) {
+			block->queued.exchange(false, std::memory_order_acq_rel);
+		}
+		if (!overflow) {
+			blocks.push_back(block_key);
+		}
+	}
+	queue_head.store(head, std::memory_order_release);
+
+	if (overflow) {
+		// Some blocks were dropped from the queue while still flagged, re-arm
+		// every flag so later changes are announced again.
+		for (int z = 0; z < MAP_LAYERS; ++z) {
+			const BlockSlot* slots = floors[z].load(std::memory_order_acquire);
+			if (!slots) {
+				continue;
+			}
+			for (int i = 0; i < BlocksPerSide * BlocksPerSide; ++i) {
+				if (Block* block = slots[i].load(std::memory_order_acquire)) {
+					block->queued.exchange(false, std::memory_order_acq_rel);
+				}
+			}
+		}
+		return false;
+	}
+	return true;
+}
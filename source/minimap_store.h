@@ -0,0 +1,102 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#ifndef RME_MINIMAP_STORE_H_
+#define RME_MINIMAP_STORE_H_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Minimap colours of a map, split in blocks per floor. The map writes into it
+// whenever a tile is placed or its colour changes (GUI thread only) and any
+// number of threads may read from it at the same time without touching the
+// map itself. Changed blocks are announced through a lock-free queue that a
+// single consumer drains, other readers can compare block versions instead.
+class MinimapStore {
+public:
+	static constexpr int BlockSize = 256;
+	static constexpr int BlocksPerSide = 65536 / BlockSize;
+	static constexpr size_t QueueCapacity = 4096;
+
+	struct BlockKey {
+		int bx, by, z;
+	};
+	struct BlockVersion {
+		BlockKey key;
+		uint32_t version;
+	};
+
+	MinimapStore();
+	~MinimapStore();
+
+	MinimapStore(const MinimapStore&) = delete;
+	MinimapStore& operator=(const MinimapStore&) = delete;
+
+	// Writer side
+	void setColor(int x, int y, int z, uint8_t color);
+
+	// Reader side
+	uint8_t getColor(int x, int y, int z) const;
+	// Copies the colours of a block (row major), returns the number of coloured pixels
+	size_t readBlock(int bx, int by, int z, uint8_t* indices) const;
+	bool hasBlock(int bx, int by, int z) const;
+
+	// Bumped on every colour change, a reader that loaded a version is
+	// guaranteed to see at least the pixels written before it.
+	uint64_t getVersion() const noexcept { return version.load(std::memory_order_acquire); }
+	// Appends the current version of every allocated block
+	void collectBlockVersions(std::vector<BlockVersion>& versions) const;
+
+	static uint32_t makeKey(int bx, int by, int z) {
+		return (uint32_t(z) << 16) | (uint32_t(by) << 8) | uint32_t(bx);
+	}
+	static BlockKey splitKey(uint32_t key) {
+		return { int(key & 0xFF), int((key >> 8) & 0xFF), int(key >> 16) };
+	}
+
+	// Consumer side, a single thread. Appends the blocks changed since the last
+	// call. Returns false when the queue overflowed, in that case the caller has
+	// to consider every block dirty.
+	bool popDirtyBlocks(std::vector<BlockKey>& blocks);
+
+private:
+	struct Block {
+		std::atomic<uint8_t> pixels[BlockSize * BlockSize];
+		std::atomic<bool> queued;
+		std::atomic<uint32_t> version;
+
+		Block();
+	};
+	typedef std::atomic<Block*> BlockSlot;
+
+	const Block* findBlock(int bx, int by, int z) const;
+	Block* getOrCreateBlock(int bx, int by, int z);
+	void pushDirty(uint32_t key);
+
+	// Block tables are allocated per floor on first use
+	std::atomic<BlockSlot*> floors[MAP_LAYERS];
+	std::atomic<uint64_t> version;
+
+	std::unique_ptr<uint32_t[]> queue;
+	std::atomic<size_t> queue_head; // owned by the consumer
+	std::atomic<size_t> queue_tail; // owned by the writer
+	std::atomic<bool> queue_overflow;
+};
+
+#endif
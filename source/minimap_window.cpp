@@ -60,6 +60,10 @@ RELEVANT CODE SECTIONS:
 #include "gui.h"
 #include "map_display.h"
 #include "minimap_window.h"
+#include "minimap_rasterizer.h"
+#include "minimap_store.h"
+#include "minimap_pyramid.h"
+#include "trace.h"
 
 #include <thread>
 #include <mutex>
@@ -69,10 +73,13 @@ RELEVANT CODE SECTIONS:
 #include <wx/dir.h>
 #include <wx/ffile.h>
 
+static_assert(MinimapWindow::BLOCK_SIZE == MinimapStore::BlockSize, "minimap blocks must match the colour store");
+
 BEGIN_EVENT_TABLE(MinimapWindow, wxPanel)
 	EVT_PAINT(MinimapWindow::OnPaint)
 	EVT_ERASE_BACKGROUND(MinimapWindow::OnEraseBackground)
 	EVT_LEFT_DOWN(MinimapWindow::OnMouseClick)
+	EVT_MOUSEWHEEL(MinimapWindow::OnMouseWheel)
 	EVT_KEY_DOWN(MinimapWindow::OnKey)
 	EVT_SIZE(MinimapWindow::OnSize)
 	EVT_CLOSE(MinimapWindow::OnClose)
@@ -92,12 +99,12 @@ MinimapWindow::MinimapWindow(wxWindow* parent) :
 	last_start_x(0),
 	last_start_y(0),
 	is_resizing(false),
-	empty_tile_atlas_initialized(false)
+	empty_tile_atlas_initialized(false),
+	minimap_zoom(0),
+	render_floor(GROUND_LAYER),
+	render_zoom(0),
+	apply_pending(false)
 {
-	for (int i = 0; i < 256; ++i) {
-		pens[i] = newd wxPen(wxColor(minimap_color[i].red, minimap_color[i].green, minimap_color[i].blue));
-	}
-	
 	// Initialize the update timer
 	update_timer.SetOwner(this, ID_MINIMAP_UPDATE);
 	
@@ -137,9 +144,6 @@ MinimapWindow::MinimapWindow(wxWindow* parent) :
 
 MinimapWindow::~MinimapWindow() {
 	StopRenderThread();
-	for (int i = 0; i < 256; ++i) {
-		delete pens[i];
-	}
 }
 
 void MinimapWindow::StartRenderThread() {
@@ -155,111 +159,108 @@ void MinimapWindow::StopRenderThread() {
 }
 
 void MinimapWindow::RenderThreadFunction() {
-	while(thread_running) {
-		if(needs_update && g_gui.IsEditorOpen()) {
-			Editor& editor = *g_gui.GetCurrentEditor();
-			MapCanvas* canvas = g_gui.GetCurrentMapTab()->GetCanvas();
-			
-			int center_x, center_y;
-			canvas->GetScreenCenter(&center_x, &center_y);
-			int floor = g_gui.GetCurrentFloor();
-			
-			// Force update if floor changed
-			if(floor != last_floor) {
-				// Clear the buffer when floor changes
-				std::lock_guard<std::mutex> lock(buffer_mutex);
-				buffer = wxBitmap(GetSize().GetWidth(), GetSize().GetHeight());
-				
-				// Clear block cache
-				std::lock_guard<std::mutex> blockLock(m_mutex);
-				m_blocks.clear();
-			}
-			
-			// Always update if floor changed or position changed
-			if(center_x != last_center_x || 
-			   center_y != last_center_y || 
-			   floor != last_floor) {
-				
-				int window_width = GetSize().GetWidth();
-				int window_height = GetSize().GetHeight();
-				
-				// Create temporary bitmap
-				wxBitmap temp_buffer(window_width, window_height);
-				wxMemoryDC dc(temp_buffer);
-				
-				dc.SetBackground(*wxBLACK_BRUSH);
-				dc.Clear();
-				
-				// CRITICAL FIX: Prevent division by zero in minimap rendering
-				if (window_width <= 0 || window_height <= 0) {
-					char debug_msg[256];
-					sprintf(debug_msg, "DEBUG DRAG: CRITICAL ERROR! Minimap window dimensions are zero: width=%d, height=%d\n", 
-						window_width, window_height);
-					OutputDebugStringA(debug_msg);
-					return; // Exit early to prevent division by zero
-				}
-				
-				int start_x = center_x - window_width / 2;
-				int start_y = center_y - window_height / 2;
-				
-				// Batch drawing by color
-				std::vector<std::vector<wxPoint>> colorPoints(256);
-				
-				for(int y = 0; y < window_height; ++y) {
-					for(int x = 0; x < window_width; ++x) {
-						int map_x = start_x + x;
-						int map_y = start_y + y;
-						
-						if(map_x >= 0 && map_y >= 0 && 
-						   map_x < editor.map.getWidth() && 
-						   map_y < editor.map.getHeight()) {
-							
-							Tile* tile = editor.map.getTile(map_x, map_y, floor);
-							if(tile) {
-								uint8_t color = tile->getMiniMapColor();
-								if(color) {
-									colorPoints[color].push_back(wxPoint(x, y));
-								}
-							}
-						}
-					}
+	// Only the colour store is read here, never the live map, so the GUI thread
+	// can keep committing actions while blocks are being rebuilt.
+	std::vector<MinimapStore::BlockKey> dirty;
+	std::vector<uint8_t> indices(BLOCK_SIZE * BLOCK_SIZE);
+	uint32_t pyramid_revision = 0;
+
+	while (thread_running) {
+		std::shared_ptr<MinimapStore> current;
+		std::shared_ptr<MinimapPyramid> current_pyramid;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			current = store;
+			current_pyramid = pyramid;
+		}
+
+		if (current) {
+			dirty.clear();
+			const bool complete = current->popDirtyBlocks(dirty);
+			const int floor = render_floor;
+
+			std::vector<RenderedBlock> rendered;
+			rendered.reserve(dirty.size());
+			for (const MinimapStore::BlockKey& key : dirty) {
+				RenderedBlock block { { key.bx, key.by, key.z }, {} };
+				// Blocks of other floors are only dropped, they are rebuilt when shown
+				if (key.z == floor && current->readBlock(key.bx, key.by, key.z, indices.data()) > 0) {
+					block.indices = indices;
 				}
-				
-				// Draw points by color
-				for(int color = 0; color < 256; ++color) {
-					if(!colorPoints[color].empty()) {
-						dc.SetPen(*pens[color]);
-						for(const wxPoint& pt : colorPoints[color]) {
-							dc.DrawPoint(pt.x, pt.y);
-						}
+				rendered.push_back(std::move(block));
+			}
+
+			if (!complete || !rendered.empty()) {
+				{
+					std::lock_guard<std::mutex> lock(m_mutex);
+					if (current == store) {
+						rendered_reset = rendered_reset || !complete;
+						std::move(rendered.begin(), rendered.end(), std::back_inserter(rendered_blocks));
 					}
 				}
-				
-				// Update buffer safely
-				{
-					std::lock_guard<std::mutex> lock(buffer_mutex);
-					buffer = temp_buffer;
+				if (!apply_pending.exchange(true)) {
+					CallAfter(&MinimapWindow::ApplyRenderedBlocks);
 				}
-				
-				// Store current state
-				last_center_x = center_x;
-				last_center_y = center_y;
-				last_floor = floor;
-				
-				// Request refresh of the window
-				wxCommandEvent evt(wxEVT_COMMAND_BUTTON_CLICKED);
-				evt.SetId(ID_MINIMAP_UPDATE);
-				wxPostEvent(this, evt);
 			}
-			
-			needs_update = false;
 		}
-		
+
+		// Zoomed out levels are drawn straight from the pyramid, a repaint is enough
+		if (current_pyramid && render_zoom > 0 && current_pyramid->getRevision() != pyramid_revision) {
+			pyramid_revision = current_pyramid->getRevision();
+			if (!apply_pending.exchange(true)) {
+				CallAfter(&MinimapWindow::ApplyRenderedBlocks);
+			}
+		}
+
 		// Sleep to prevent excessive CPU usage
 		std::this_thread::sleep_for(std::chrono::milliseconds(50));
 	}
 }
 
+void MinimapWindow::ApplyRenderedBlocks() {
+	apply_pending = false;
+
+	std::vector<RenderedBlock> blocks;
+	bool reset;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		blocks.swap(rendered_blocks);
+		reset = rendered_reset;
+		rendered_reset = false;
+	}
+
+	if (reset) {
+		block_cache.clear();
+	}
+	for (const RenderedBlock& block : blocks) {
+		if (block.indices.empty()) {
+			block_cache.erase(block.key);
+		} else {
+			block_cache[block.key] = wxBitmap(MinimapRasterizer::toImage(block.indices.data(), BLOCK_SIZE, BLOCK_SIZE));
+		}
+	}
+	Refresh();
+}
+
+void MinimapWindow::UpdateStore(Editor& editor) {
+	std::shared_ptr<MinimapStore> current = editor.map.getMinimapStore();
+	std::shared_ptr<MinimapPyramid> current_pyramid = editor.getMinimapPyramid();
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	if (current != store) {
+		// Another map is shown, nothing cached so far belongs to it
+		store = current;
+		rendered_blocks.clear();
+		rendered_reset = false;
+		block_cache.clear();
+	}
+	if (current_pyramid != pyramid) {
+		pyramid = current_pyramid;
+		zoom_cache.clear();
+		zoom_cache_level = -1;
+	}
+}
+
 void MinimapWindow::OnSize(wxSizeEvent& event) {
 	// Get the new size
 	wxSize newSize = event.GetSize();
@@ -278,12 +279,6 @@ void MinimapWindow::OnSize(wxSizeEvent& event) {
 		resize_timer.Stop();
 	}
 	
-	// Create a new buffer at the new size
-	{
-		std::lock_guard<std::mutex> lock(buffer_mutex);
-		buffer = wxBitmap(newSize.GetWidth(), newSize.GetHeight());
-	}
-	
 	// Clear the block cache since we're changing size
 	{
 		std::lock_guard<std::mutex> lock(m_mutex);
@@ -361,6 +356,10 @@ void MinimapWindow::OnPaint(wxPaintEvent& event) {
 	int centerX, centerY;
 	canvas->GetScreenCenter(&centerX, &centerY);
 	int floor = minimap_floor;
+
+	UpdateStore(editor);
+	render_floor = floor;
+	render_zoom = minimap_zoom;
 	
 	// Store current state
 	last_center_x = centerX;
@@ -373,10 +372,7 @@ void MinimapWindow::OnPaint(wxPaintEvent& event) {
 	
 	// CRITICAL FIX: Prevent division by zero in minimap OnPaint
 	if (windowWidth <= 0 || windowHeight <= 0) {
-		char debug_msg[256];
-		sprintf(debug_msg, "DEBUG DRAG: CRITICAL ERROR! Minimap OnPaint dimensions are zero: width=%d, height=%d\n", 
-			windowWidth, windowHeight);
-		OutputDebugStringA(debug_msg);
+		TRACE_ERROR(Drawing, "Minimap OnPaint dimensions are zero: width=%d, height=%d", windowWidth, windowHeight);
 		return; // Exit early to prevent division by zero
 	}
 	
@@ -393,8 +389,8 @@ void MinimapWindow::OnPaint(wxPaintEvent& event) {
 	font.SetPointSize(9);
 	dc.SetFont(font);
 	
-	wxString mapInfo = wxString::Format("Floor: %d | Position: %d,%d", 
-		floor, centerX, centerY);
+	wxString mapInfo = wxString::Format("Floor: %d | Position: %d,%d | 1:%d", 
+		floor, centerX, centerY, 1 << minimap_zoom);
 	dc.DrawText(mapInfo, 10, 8);
 
 	// Draw separator after position
@@ -477,36 +473,42 @@ void MinimapWindow::OnPaint(wxPaintEvent& event) {
 		save_cache_checkbox->Show();
 	}
 	
-	// Draw minimap using cached blocks
-	int padding = 10;
-	int startX = std::max(0, centerX - (windowWidth / 2) - padding);
-	int startY = std::max(0, centerY - ((windowHeight - headerHeight) / 2) - padding);
-	int endX = std::min(editor.map.getWidth(), startX + windowWidth + padding * 2);
-	int endY = std::min(editor.map.getHeight(), startY + (windowHeight - headerHeight) + padding * 2);
-	int blockStartX = startX / BLOCK_SIZE;
-	int blockEndX = (endX + BLOCK_SIZE - 1) / BLOCK_SIZE;
-	int blockStartY = startY / BLOCK_SIZE;
-	int blockEndY = (endY + BLOCK_SIZE - 1) / BLOCK_SIZE;
-	for (int by = blockStartY; by < blockEndY; ++by) {
-		for (int bx = blockStartX; bx < blockEndX; ++bx) {
-			BlockKey key{bx, by, floor};
-			wxBitmap* bmp = nullptr;
-			auto it = block_cache.find(key);
-			if (it != block_cache.end()) {
-				bmp = &it->second;
-			} else if (IsBlockFilled(bx, by, floor)) {
-				wxBitmap rendered = RenderBlock(bx, by, floor);
-				block_cache[key] = rendered;
-				bmp = &block_cache[key];
-			}
-			if (bmp) {
-				int drawX = bx * BLOCK_SIZE - startX;
-				int drawY = by * BLOCK_SIZE - startY + headerHeight;
-				dc.DrawBitmap(*bmp, drawX, drawY, false);
+	if (minimap_zoom > 0) {
+		DrawZoomedTiles(dc, centerX, centerY, floor, windowWidth, windowHeight, headerHeight);
+	} else {
+		// Draw minimap using cached blocks
+		int padding = 10;
+		int startX = std::max(0, centerX - (windowWidth / 2) - padding);
+		int startY = std::max(0, centerY - ((windowHeight - headerHeight) / 2) - padding);
+		int endX = std::min(editor.map.getWidth(), startX + windowWidth + padding * 2);
+		int endY = std::min(editor.map.getHeight(), startY + (windowHeight - headerHeight) + padding * 2);
+		int blockStartX = startX / BLOCK_SIZE;
+		int blockEndX = (endX + BLOCK_SIZE - 1) / BLOCK_SIZE;
+		int blockStartY = startY / BLOCK_SIZE;
+		int blockEndY = (endY + BLOCK_SIZE - 1) / BLOCK_SIZE;
+		for (int by = blockStartY; by < blockEndY; ++by) {
+			for (int bx = blockStartX; bx < blockEndX; ++bx) {
+				BlockKey key{bx, by, floor};
+				wxBitmap* bmp = nullptr;
+				auto it = block_cache.find(key);
+				if (it != block_cache.end()) {
+					bmp = &it->second;
+				} else {
+					wxBitmap rendered;
+					if (RenderBlock(bx, by, floor, rendered)) {
+						bmp = &(block_cache[key] = rendered);
+					}
+				}
+				if (bmp) {
+					int drawX = bx * BLOCK_SIZE - startX;
+					int drawY = by * BLOCK_SIZE - startY + headerHeight;
+					dc.DrawBitmap(*bmp, drawX, drawY, false);
+				}
 			}
 		}
-	}
 	
+	}
+
 	// Draw center marker
 	dc.SetPen(wxPen(wxColour(255, 0, 0), 2));
 	int centerDrawX = windowWidth / 2;
@@ -588,10 +590,7 @@ void MinimapWindow::OnMouseClick(wxMouseEvent& event) {
 	
 	// CRITICAL FIX: Prevent division by zero in minimap click handling
 	if (windowWidth <= 0 || windowHeight <= 0) {
-		char debug_msg[256];
-		sprintf(debug_msg, "DEBUG DRAG: CRITICAL ERROR! Minimap click dimensions are zero: width=%d, height=%d\n", 
-			windowWidth, windowHeight);
-		OutputDebugStringA(debug_msg);
+		TRACE_ERROR(Drawing, "Minimap click dimensions are zero: width=%d, height=%d", windowWidth, windowHeight);
 		return; // Exit early to prevent division by zero
 	}
 	
@@ -599,8 +598,9 @@ void MinimapWindow::OnMouseClick(wxMouseEvent& event) {
 	int clickX = event.GetX();
 	int clickY = event.GetY() - headerHeight; // Adjust for header
 	
-	int mapX = centerX - (windowWidth / 2) + clickX;
-	int mapY = centerY - ((windowHeight - headerHeight) / 2) + clickY;
+	const int scale = 1 << minimap_zoom;
+	int mapX = centerX + (clickX - windowWidth / 2) * scale;
+	int mapY = centerY + (clickY - (windowHeight - headerHeight) / 2) * scale;
 	
 	// Only process clicks below the header
 	if (event.GetY() > headerHeight) {
@@ -610,6 +610,20 @@ void MinimapWindow::OnMouseClick(wxMouseEvent& event) {
 	}
 }
 
+void MinimapWindow::OnMouseWheel(wxMouseEvent& event) {
+	int zoom;
+	if (event.GetWheelRotation() < 0) {
+		zoom = std::min(minimap_zoom + 1, MinimapPyramid::LevelCount - 1);
+	} else {
+		zoom = std::max(minimap_zoom - 1, 0);
+	}
+
+	if (zoom != minimap_zoom) {
+		minimap_zoom = zoom;
+		Refresh();
+	}
+}
+
 void MinimapWindow::OnKey(wxKeyEvent& event) {
 	if (g_gui.GetCurrentTab() != nullptr) {
 		g_gui.GetCurrentMapTab()->GetEventHandler()->AddPendingEvent(event);
@@ -639,42 +653,13 @@ void MinimapWindow::updateBlock(BlockPtr block, int startX, int startY, int floo
 	
 	if (!block->needsUpdate) return;
 	
-	wxBitmap bitmap(BLOCK_SIZE, BLOCK_SIZE);
-	wxMemoryDC dc(bitmap);
-	dc.SetBackground(*wxBLACK_BRUSH);
-	dc.Clear();
-	
 	// Store the floor this block was rendered for
 	block->floor = floor;
-	
-	// Batch drawing by color like OTClient
-	std::vector<std::vector<wxPoint>> colorPoints(256);
-	
-	for (int y = 0; y < BLOCK_SIZE; ++y) {
-		for (int x = 0; x < BLOCK_SIZE; ++x) {
-			int mapX = startX + x;
-			int mapY = startY + y;
-			
-			Tile* tile = editor.map.getTile(mapX, mapY, floor);
-			if (tile) {
-				uint8_t color = tile->getMiniMapColor();
-				if (color != 255) {  // Not transparent
-					colorPoints[color].push_back(wxPoint(x, y));
-				}
-			}
-		}
-	}
-	
-	// Draw all points of same color at once
-	for (int color = 0; color < 256; ++color) {
-		if (!colorPoints[color].empty()) {
-			dc.SetPen(*pens[color]);
-			for (const wxPoint& pt : colorPoints[color]) {
-				dc.DrawPoint(pt);
-			}
-		}
-	}
-	
+
+	std::vector<uint8_t> indices(BLOCK_SIZE * BLOCK_SIZE);
+	MinimapRasterizer::rasterize(editor.map, startX, startY, floor, BLOCK_SIZE, BLOCK_SIZE, indices.data());
+	wxBitmap bitmap(MinimapRasterizer::toImage(indices.data(), BLOCK_SIZE, BLOCK_SIZE));
+
 	block->bitmap = bitmap;
 	block->needsUpdate = false;
 	block->wasSeen = true;
@@ -686,7 +671,7 @@ void MinimapWindow::ClearCache() {
 }
 
 void MinimapWindow::UpdateDrawnTiles(const PositionVector& positions) {
-	// Just refresh the entire minimap - it's faster than checking which tiles need updating
+	// Changed blocks reach the render thread through the map's colour store
 	Refresh();
 }
 
@@ -815,8 +800,8 @@ void MinimapWindow::CacheFilledBlocksForFloor(int floor) {
 	block_cache.clear();
 	for (int by = 0; by < numBlocksY; ++by) {
 		for (int bx = 0; bx < numBlocksX; ++bx) {
-			if (IsBlockFilled(bx, by, floor)) {
-				wxBitmap bmp = RenderBlock(bx, by, floor);
+			wxBitmap bmp;
+			if (RenderBlock(bx, by, floor, bmp)) {
 				block_cache[{bx, by, floor}] = bmp;
 			}
 			doneBlocks++;
@@ -828,38 +813,22 @@ void MinimapWindow::CacheFilledBlocksForFloor(int floor) {
 }
 
 void MinimapWindow::SaveBlockCacheToDisk(int floor) {
+	if (!store) return;
 	wxString dataDir = g_gui.GetDataDirectory();
 	wxString mapName = GetCurrentMapName();
 	wxString cacheDir = dataDir + wxFileName::GetPathSeparator() + "cachedmaps" + wxFileName::GetPathSeparator() + mapName;
 	wxFileName::Mkdir(cacheDir, wxS_DIR_DEFAULT, wxPATH_MKDIR_FULL);
+	// The palette indices are taken from the colour store rather than mapping
+	// the cached bitmap colours back to the palette
+	std::vector<uint8_t> indices(BLOCK_SIZE * BLOCK_SIZE);
 	for (const auto& pair : block_cache) {
 		if (pair.first.z != floor) continue;
 		wxString fileName = wxString::Format("block_%d_%d_%d.bin", pair.first.bx, pair.first.by, pair.first.z);
 		wxString filePath = cacheDir + wxFileName::GetPathSeparator() + fileName;
 		wxFFile file(filePath, "wb");
 		if (!file.IsOpened()) continue;
-		wxImage img = pair.second.ConvertToImage();
-		for (int y = 0; y < BLOCK_SIZE; ++y) {
-			for (int x = 0; x < BLOCK_SIZE; ++x) {
-				unsigned char r = img.GetRed(x, y);
-				unsigned char g = img.GetGreen(x, y);
-				unsigned char b = img.GetBlue(x, y);
-				// Find closest minimap color index
-				uint8_t best = 0;
-				int bestDist = 256*256*3;
-				for (int i = 0; i < 256; ++i) {
-					int dr = int(minimap_color[i].red) - r;
-					int dg = int(minimap_color[i].green) - g;
-					int db = int(minimap_color[i].blue) - b;
-					int dist = dr*dr + dg*dg + db*db;
-					if (dist < bestDist) {
-						bestDist = dist;
-						best = i;
-					}
-				}
-				file.Write(&best, 1);
-			}
-		}
+		store->readBlock(pair.first.bx, pair.first.by, floor, indices.data());
+		file.Write(indices.data(), indices.size());
 		file.Close();
 	}
 }
@@ -879,14 +848,7 @@ void MinimapWindow::LoadBlockCacheFromDisk(int floor) {
 		if (file.Read(buffer.data(), buffer.size()) == buffer.size()) {
 			int bx = 0, by = 0, z = 0;
 			if (sscanf(filename.mb_str(), "block_%d_%d_%d.bin", &bx, &by, &z) == 3) {
-				wxImage img(BLOCK_SIZE, BLOCK_SIZE);
-				for (int y = 0; y < BLOCK_SIZE; ++y) {
-					for (int x = 0; x < BLOCK_SIZE; ++x) {
-						uint8_t idx = buffer[y * BLOCK_SIZE + x];
-						img.SetRGB(x, y, minimap_color[idx].red, minimap_color[idx].green, minimap_color[idx].blue);
-					}
-				}
-				block_cache[{bx, by, z}] = wxBitmap(img);
+				block_cache[{bx, by, z}] = wxBitmap(MinimapRasterizer::toImage(buffer.data(), BLOCK_SIZE, BLOCK_SIZE));
 			}
 		}
 		file.Close();
@@ -894,44 +856,54 @@ void MinimapWindow::LoadBlockCacheFromDisk(int floor) {
 	}
 }
 
-bool MinimapWindow::IsBlockFilled(int bx, int by, int floor) {
-	if (!g_gui.IsEditorOpen()) return false;
-	Editor& editor = *g_gui.GetCurrentEditor();
-	int startX = bx * BLOCK_SIZE;
-	int startY = by * BLOCK_SIZE;
-	for (int y = 0; y < BLOCK_SIZE; ++y) {
-		for (int x = 0; x < BLOCK_SIZE; ++x) {
-			Tile* tile = editor.map.getTile(startX + x, startY + y, floor);
-			if (tile && tile->getMiniMapColor()) {
-				return true;
-			}
-		}
+bool MinimapWindow::RenderBlock(int bx, int by, int floor, wxBitmap& bitmap) {
+	if (!store || !store->hasBlock(bx, by, floor)) return false;
+	std::vector<uint8_t> indices(BLOCK_SIZE * BLOCK_SIZE);
+	if (store->readBlock(bx, by, floor, indices.data()) == 0) {
+		return false;
 	}
-	return false;
+	bitmap = wxBitmap(MinimapRasterizer::toImage(indices.data(), BLOCK_SIZE, BLOCK_SIZE));
+	return true;
 }
 
-wxBitmap MinimapWindow::RenderBlock(int bx, int by, int floor) {
-	if (!g_gui.IsEditorOpen()) return wxBitmap(BLOCK_SIZE, BLOCK_SIZE);
-	Editor& editor = *g_gui.GetCurrentEditor();
-	wxBitmap bitmap(BLOCK_SIZE, BLOCK_SIZE);
-	wxMemoryDC dc(bitmap);
-	dc.SetBackground(*wxBLACK_BRUSH);
-	dc.Clear();
-	int startX = bx * BLOCK_SIZE;
-	int startY = by * BLOCK_SIZE;
-	for (int y = 0; y < BLOCK_SIZE; ++y) {
-		for (int x = 0; x < BLOCK_SIZE; ++x) {
-			Tile* tile = editor.map.getTile(startX + x, startY + y, floor);
-			if (tile) {
-				uint8_t color = tile->getMiniMapColor();
-				if (color) {
-					dc.SetPen(*pens[color]);
-					dc.DrawPoint(x, y);
+void MinimapWindow::DrawZoomedTiles(wxDC& dc, int centerX, int centerY, int floor, int windowWidth, int windowHeight, int headerHeight) {
+	if (!pyramid) return;
+
+	const int level = minimap_zoom;
+	const uint32_t revision = pyramid->getRevision();
+	if (level != zoom_cache_level || revision != zoom_cache_revision) {
+		zoom_cache.clear();
+		zoom_cache_level = level;
+		zoom_cache_revision = revision;
+	}
+
+	// View origin in pixels of the shown level, one pixel covers (1 << level) map tiles
+	const int startX = (centerX >> level) - windowWidth / 2;
+	const int startY = (centerY >> level) - (windowHeight - headerHeight) / 2;
+	const int tilesPerSide = MinimapStore::BlocksPerSide >> level;
+	const int tileStartX = std::max(0, startX / BLOCK_SIZE);
+	const int tileStartY = std::max(0, startY / BLOCK_SIZE);
+	const int tileEndX = std::min(tilesPerSide, (startX + windowWidth + BLOCK_SIZE - 1) / BLOCK_SIZE);
+	const int tileEndY = std::min(tilesPerSide, (startY + windowHeight - headerHeight + BLOCK_SIZE - 1) / BLOCK_SIZE);
+
+	std::vector<uint8_t> indices(BLOCK_SIZE * BLOCK_SIZE);
+	for (int ty = tileStartY; ty < tileEndY; ++ty) {
+		for (int tx = tileStartX; tx < tileEndX; ++tx) {
+			BlockKey key{tx, ty, floor};
+			auto it = zoom_cache.find(key);
+			if (it == zoom_cache.end()) {
+				// Empty tiles are cached as invalid bitmaps so they are not read again
+				wxBitmap bitmap;
+				if (pyramid->readTile(level, tx, ty, floor, indices.data())) {
+					bitmap = wxBitmap(MinimapRasterizer::toImage(indices.data(), BLOCK_SIZE, BLOCK_SIZE));
 				}
+				it = zoom_cache.emplace(key, bitmap).first;
+			}
+			if (it->second.IsOk()) {
+				dc.DrawBitmap(it->second, tx * BLOCK_SIZE - startX, ty * BLOCK_SIZE - startY + headerHeight, false);
 			}
 		}
 	}
-	return bitmap;
 }
 
 wxString MinimapWindow::GetCurrentMapName() const {
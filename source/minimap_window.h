@@ -33,6 +33,10 @@
 #include <wx/xml/xml.h>
 #include <wx/checkbox.h>
 
+class Editor;
+class MinimapStore;
+class MinimapPyramid;
+
 class MinimapWindow : public wxPanel {
 public:
 	enum {
@@ -46,6 +50,7 @@ public:
 	void OnPaint(wxPaintEvent&);
 	void OnEraseBackground(wxEraseEvent&) { }
 	void OnMouseClick(wxMouseEvent&);
+	void OnMouseWheel(wxMouseEvent&);
 	void OnSize(wxSizeEvent&);
 	void OnClose(wxCloseEvent&);
 	void OnResizeTimer(wxTimerEvent&);
@@ -122,6 +127,8 @@ private:
 
 	// Minimap floor (separate from editor floor)
 	int minimap_floor;
+	// Pyramid level shown, every level halves the scale (0 is 1:1)
+	int minimap_zoom;
 
 	// Button rectangles for header UI
 	wxRect btn_cache;
@@ -140,8 +147,6 @@ private:
 	BlockPtr getBlock(int x, int y);
 	void updateBlock(BlockPtr block, int startX, int startY, int floor);
 
-	wxBitmap buffer;
-	std::mutex buffer_mutex;
 	std::thread render_thread;
 	std::atomic<bool> thread_running;
 	
@@ -158,7 +163,6 @@ private:
 	int last_center_y;
 	int last_floor;
 
-	wxPen* pens[256];
 	wxTimer update_timer;
 	int last_start_x;
 	int last_start_y;
@@ -183,6 +187,31 @@ private:
 	};
 	std::map<BlockKey, wxBitmap> block_cache;
 
+	// Colour store of the shown map, shared with the render thread (guarded by m_mutex)
+	std::shared_ptr<MinimapStore> store;
+	std::shared_ptr<MinimapPyramid> pyramid;
+	std::atomic<int> render_floor;
+	std::atomic<int> render_zoom;
+
+	// Bitmaps of the zoomed out level currently shown, dropped whenever the
+	// pyramid changes
+	std::map<BlockKey, wxBitmap> zoom_cache;
+	int zoom_cache_level = -1;
+	uint32_t zoom_cache_revision = 0;
+
+	// Blocks rebuilt by the render thread, an empty indices vector means the
+	// block no longer has anything to draw (guarded by m_mutex)
+	struct RenderedBlock {
+		BlockKey key;
+		std::vector<uint8_t> indices;
+	};
+	std::vector<RenderedBlock> rendered_blocks;
+	bool rendered_reset = false;
+	std::atomic<bool> apply_pending;
+
+	void UpdateStore(Editor& editor);
+	void ApplyRenderedBlocks();
+
 	// UI: Save cache to disk checkbox
 	wxCheckBox* save_cache_checkbox = nullptr;
 	bool save_cache_to_disk = false;
@@ -192,8 +221,9 @@ private:
 	void SaveBlockCacheToDisk(int floor);
 	void LoadBlockCacheFromDisk(int floor);
 	void ClearBlockCache();
-	bool IsBlockFilled(int bx, int by, int floor);
-	wxBitmap RenderBlock(int bx, int by, int floor);
+	// Returns false without touching bitmap when the block has no coloured tiles
+	bool RenderBlock(int bx, int by, int floor, wxBitmap& bitmap);
+	void DrawZoomedTiles(wxDC& dc, int centerX, int centerY, int floor, int windowWidth, int windowHeight, int headerHeight);
 	wxString GetCurrentMapName() const;
 
 	DECLARE_EVENT_TABLE()
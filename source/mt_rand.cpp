@@ -106,16 +106,26 @@ mt_set(void* vstate, unsigned long int s) {
 	state->mti = i;
 }
 
-static mt_state_t mt_state;
+/* Every thread draws from a generator of its own, a thread that never called
+   mt_seed starts from the default seed */
+static thread_local mt_state_t mt_state;
+static thread_local bool mt_seeded = false;
 
 void mt_seed(unsigned long s) {
 	mt_set(&mt_state, s);
+	mt_seeded = true;
 }
 
 unsigned long mt_randi() {
+	if (!mt_seeded) {
+		mt_seed(0);
+	}
 	return mt_get(&mt_state);
 }
 
 double mt_randd() {
+	if (!mt_seeded) {
+		mt_seed(0);
+	}
 	return mt_get_double(&mt_state);
 }
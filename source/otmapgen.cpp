@@ -22,6 +22,7 @@
 #include "item.h"
 #include "items.h"
 #include "map.h"
+#include "component_labeller.h"
 
 #include <cmath>
 #include <algorithm>
@@ -1264,75 +1265,13 @@ void OTMapGenerator::removeIsolatedPixels(std::vector<std::vector<uint16_t>>& te
 }
 
 void OTMapGenerator::removeSmallPatches(std::vector<std::vector<uint16_t>>& terrainLayer, int width, int height, const IslandConfig& config, uint16_t target_id, int min_size) {
-    std::vector<std::vector<bool>> visited(height, std::vector<bool>(width, false));
-    
-    for (int y = 0; y < height; ++y) {
-        for (int x = 0; x < width; ++x) {
-            if (!visited[y][x] && terrainLayer[y][x] == target_id) {
-                // Found an unvisited patch, measure its size
-                uint16_t temp_id = 9999; // Temporary ID for flood fill
-                int patch_size = floodFillCount(terrainLayer, x, y, width, height, target_id, temp_id);
-                
-                if (patch_size < min_size) {
-                    // Patch is too small, convert it to water
-                    for (int py = 0; py < height; ++py) {
-                        for (int px = 0; px < width; ++px) {
-                            if (terrainLayer[py][px] == temp_id) {
-                                terrainLayer[py][px] = target_id == config.ground_id ? config.water_id : config.ground_id;
-                                visited[py][px] = true;
-                            }
-                        }
-                    }
-                } else {
-                    // Patch is large enough, restore original ID
-                    for (int py = 0; py < height; ++py) {
-                        for (int px = 0; px < width; ++px) {
-                            if (terrainLayer[py][px] == temp_id) {
-                                terrainLayer[py][px] = target_id;
-                                visited[py][px] = true;
-                            }
-                        }
-                    }
-                }
-            }
-        }
-    }
+    // Patches that are too small turn into whatever surrounds them
+    uint16_t replacement_id = target_id == config.ground_id ? config.water_id : config.ground_id;
+    replaceSmallComponents(terrainLayer, width, height, target_id, replacement_id, min_size - 1);
 }
 
 void OTMapGenerator::fillSmallHoles(std::vector<std::vector<uint16_t>>& terrainLayer, int width, int height, uint16_t target_id, uint16_t fill_id, int max_hole_size) {
-    std::vector<std::vector<bool>> visited(height, std::vector<bool>(width, false));
-    
-    for (int y = 0; y < height; ++y) {
-        for (int x = 0; x < width; ++x) {
-            if (!visited[y][x] && terrainLayer[y][x] == target_id) {
-                // Found an unvisited hole, measure its size
-                uint16_t temp_id = 9998; // Temporary ID for flood fill
-                int hole_size = floodFillCount(terrainLayer, x, y, width, height, target_id, temp_id);
-                
-                if (hole_size <= max_hole_size) {
-                    // Hole is small enough to fill
-                    for (int py = 0; py < height; ++py) {
-                        for (int px = 0; px < width; ++px) {
-                            if (terrainLayer[py][px] == temp_id) {
-                                terrainLayer[py][px] = fill_id;
-                                visited[py][px] = true;
-                            }
-                        }
-                    }
-                } else {
-                    // Hole is too large, restore original ID
-                    for (int py = 0; py < height; ++py) {
-                        for (int px = 0; px < width; ++px) {
-                            if (terrainLayer[py][px] == temp_id) {
-                                terrainLayer[py][px] = target_id;
-                                visited[py][px] = true;
-                            }
-                        }
-                    }
-                }
-            }
-        }
-    }
+    replaceSmallComponents(terrainLayer, width, height, target_id, fill_id, max_hole_size);
 }
 
 void OTMapGenerator::smoothTerrain(std::vector<std::vector<uint16_t>>& terrainLayer, int width, int height, const IslandConfig& config) {
@@ -1370,33 +1309,29 @@ void OTMapGenerator::smoothTerrain(std::vector<std::vector<uint16_t>>& terrainLa
     terrainLayer = temp;
 }
 
-int OTMapGenerator::floodFillCount(std::vector<std::vector<uint16_t>>& terrainLayer, int x, int y, int width, int height, uint16_t target_id, uint16_t replacement_id) {
-    if (x < 0 || x >= width || y < 0 || y >= height) return 0;
-    if (terrainLayer[y][x] != target_id) return 0;
-    
-    // Use iterative flood fill to avoid stack overflow
-    std::vector<std::pair<int, int>> stack;
-    stack.push_back({x, y});
-    int count = 0;
-    
-    while (!stack.empty()) {
-        auto [cx, cy] = stack.back();
-        stack.pop_back();
-        
-        if (cx < 0 || cx >= width || cy < 0 || cy >= height) continue;
-        if (terrainLayer[cy][cx] != target_id) continue;
-        
-        terrainLayer[cy][cx] = replacement_id;
-        count++;
-        
-        // Add neighbors to stack
-        stack.push_back({cx + 1, cy});
-        stack.push_back({cx - 1, cy});
-        stack.push_back({cx, cy + 1});
-        stack.push_back({cx, cy - 1});
+void OTMapGenerator::replaceSmallComponents(std::vector<std::vector<uint16_t>>& terrainLayer, int width, int height, uint16_t target_id, uint16_t replacement_id, int max_size) {
+    // All patches are measured in one labelling pass instead of a flood fill
+    // and a full rescan of the layer per patch
+    ComponentLabeller labeller;
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            if (terrainLayer[y][x] == target_id) {
+                labeller.add(x, y);
+            }
+        }
+    }
+    if (labeller.empty()) {
+        return;
+    }
+
+    const std::vector<ComponentLabeller::Component>& components = labeller.label();
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            if (terrainLayer[y][x] == target_id && components[labeller.getComponent(x, y)].size <= max_size) {
+                terrainLayer[y][x] = replacement_id;
+            }
+        }
     }
-    
-    return count;
 }
 
 std::vector<std::vector<uint16_t>> OTMapGenerator::generateIslandLayerBatch(const IslandConfig& config, int width, int height, const std::string& seed, int offsetX, int offsetY, int totalWidth, int totalHeight) {
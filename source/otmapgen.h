@@ -312,7 +312,8 @@ public:
     void removeSmallPatches(std::vector<std::vector<uint16_t>>& terrainLayer, int width, int height, const IslandConfig& config, uint16_t target_id, int min_size);
     void fillSmallHoles(std::vector<std::vector<uint16_t>>& terrainLayer, int width, int height, uint16_t target_id, uint16_t fill_id, int max_hole_size);
     void smoothTerrain(std::vector<std::vector<uint16_t>>& terrainLayer, int width, int height, const IslandConfig& config);
-    int floodFillCount(std::vector<std::vector<uint16_t>>& terrainLayer, int x, int y, int width, int height, uint16_t target_id, uint16_t replacement_id);
+    // Replaces every 4-connected patch of target_id with at most max_size tiles
+    void replaceSmallComponents(std::vector<std::vector<uint16_t>>& terrainLayer, int width, int height, uint16_t target_id, uint16_t replacement_id, int max_size);
     
     // Helper methods for multi-floor generation
     void fillColumn(std::vector<std::vector<std::vector<uint16_t>>>& layers, 
@@ -0,0 +1,170 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+
+#include "main.h"
+
+#include "png_writer.h"
+
+#include <wx/stream.h>
+#include <wx/zstream.h>
+
+namespace {
+	void putU32(uint8_t* out, uint32_t value) {
+		out[0] = uint8_t(value >> 24);
+		out[1] = uint8_t(value >> 16);
+		out[2] = uint8_t(value >> 8);
+		out[3] = uint8_t(value);
+	}
+
+	uint32_t updateCrc(uint32_t crc, const uint8_t* data, size_t size) {
+		static const std::vector<uint32_t> table = []() {
+			std::vector<uint32_t> table(256);
+			for (uint32_t n = 0; n < 256; ++n) {
+				uint32_t c = n;
+				for (int k = 0; k < 8; ++k) {
+					c = (c & 1) ? 0xEDB88320U ^ (c >> 1) : c >> 1;
+				}
+				table[n] = c;
+			}
+			return table;
+		}();
+
+		for (size_t i = 0; i < size; ++i) {
+			crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+		}
+		return crc;
+	}
+}
+
+class PngWriter::IdatStream : public wxOutputStream {
+public:
+	explicit IdatStream(PngWriter& writer) :
+		writer(writer) { }
+
+protected:
+	size_t OnSysWrite(const void* buffer, size_t size) override {
+		const uint8_t* bytes = static_cast<const uint8_t*>(buffer);
+		writer.pending.insert(writer.pending.end(), bytes, bytes + size);
+		if (writer.pending.size() >= ChunkSize) {
+			writer.flushIdat();
+		}
+		return size;
+	}
+
+private:
+	PngWriter& writer;
+};
+
+PngWriter::PngWriter(const std::string& filename) :
+	file(filename),
+	idat(newd IdatStream(*this)),
+	width(0),
+	pixel_size(1) {
+	////
+}
+
+PngWriter::~PngWriter() = default;
+
+bool PngWriter::begin(int width, int height, ColorType type, const uint8_t* palette) {
+	if (!file.isOpen()) {
+		error = "Could not open file for writing.";
+		return false;
+	}
+
+	this->width = width;
+	pixel_size = (type == COLOR_RGB ? 3 : 1);
+	row.resize(1 + size_t(width) * pixel_size);
+
+	static const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+	file.addRAW(signature, sizeof(signature));
+
+	uint8_t header[13];
+	putU32(header, uint32_t(width));
+	putU32(header + 4, uint32_t(height));
+	header[8] = 8; // bit depth
+	header[9] = uint8_t(type);
+	header[10] = 0; // deflate
+	header[11] = 0; // adaptive filtering
+	header[12] = 0; // no interlace
+	writeChunk("IHDR", header, sizeof(header));
+
+	if (type == COLOR_INDEXED) {
+		ASSERT(palette);
+		writeChunk("PLTE", palette, 256 * 3);
+	}
+
+	zlib.reset(newd wxZlibOutputStream(*idat, wxZ_BEST_SPEED, wxZLIB_ZLIB));
+	return file.isOk();
+}
+
+bool PngWriter::writeRows(const uint8_t* rows, int count) {
+	const size_t row_size = size_t(width) * pixel_size;
+	for (int y = 0; y < count; ++y) {
+		const uint8_t* in = rows + row_size * y;
+		if (pixel_size == 1) {
+			// Palette indices do not gain from filtering, store them as they are
+			row[0] = 0;
+			std::copy(in, in + row_size, row.begin() + 1);
+		} else {
+			// Sub filter, every byte is stored as the difference to the same
+			// channel of the pixel on its left
+			row[0] = 1;
+			std::copy(in, in + pixel_size, row.begin() + 1);
+			for (size_t i = pixel_size; i < row_size; ++i) {
+				row[1 + i] = uint8_t(in[i] - in[i - pixel_size]);
+			}
+		}
+		zlib->Write(row.data(), row.size());
+	}
+	return zlib->IsOk() && file.isOk();
+}
+
+bool PngWriter::finish() {
+	const bool closed = zlib->Close();
+	zlib.reset();
+	flushIdat();
+	writeChunk("IEND", nullptr, 0);
+	if (!closed || !file.isOk()) {
+		error = "Could not write to file.";
+		return false;
+	}
+	file.close();
+	return true;
+}
+
+void PngWriter::writeChunk(const char type[4], const uint8_t* data, size_t size) {
+	uint8_t value[4];
+	putU32(value, uint32_t(size));
+	file.addRAW(value, 4);
+	file.addRAW(reinterpret_cast<const uint8_t*>(type), 4);
+	if (size > 0) {
+		file.addRAW(data, size);
+	}
+
+	uint32_t crc = updateCrc(0xFFFFFFFFU, reinterpret_cast<const uint8_t*>(type), 4);
+	crc = updateCrc(crc, data, size);
+	putU32(value, crc ^ 0xFFFFFFFFU);
+	file.addRAW(value, 4);
+}
+
+void PngWriter::flushIdat() {
+	if (!pending.empty()) {
+		writeChunk("IDAT", pending.data(), pending.size());
+		pending.clear();
+	}
+}
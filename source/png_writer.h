@@ -0,0 +1,77 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+
+#ifndef RME_PNG_WRITER_H_
+#define RME_PNG_WRITER_H_
+
+#include "filehandle.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+class wxZlibOutputStream;
+
+// Streams a PNG to disk row by row. The image data is deflated as it is
+// written and flushed in IDAT chunks of a fixed size, so memory use does not
+// depend on the size of the image.
+class PngWriter {
+public:
+	static const size_t ChunkSize = 1 << 18;
+
+	enum ColorType {
+		COLOR_RGB = 2,
+		COLOR_INDEXED = 3,
+	};
+
+	explicit PngWriter(const std::string& filename);
+	~PngWriter();
+
+	PngWriter(const PngWriter&) = delete;
+	PngWriter& operator=(const PngWriter&) = delete;
+
+	// palette holds 256 RGB triplets and is only used by indexed images
+	bool begin(int width, int height, ColorType type, const uint8_t* palette = nullptr);
+	// Rows are passed top to bottom, one byte per pixel for indexed images and
+	// three for RGB
+	bool writeRows(const uint8_t* rows, int count);
+	bool finish();
+
+	const std::string& getError() const noexcept {
+		return error;
+	}
+
+private:
+	class IdatStream;
+
+	void writeChunk(const char type[4], const uint8_t* data, size_t size);
+	void flushIdat();
+
+	FileWriteHandle file;
+	std::unique_ptr<IdatStream> idat;
+	std::unique_ptr<wxZlibOutputStream> zlib;
+	std::vector<uint8_t> pending;
+	// Filtered copy of the row being written
+	std::vector<uint8_t> row;
+	int width;
+	int pixel_size;
+	std::string error;
+};
+
+#endif
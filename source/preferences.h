@@ -58,6 +58,7 @@ protected:
 	wxCheckBox* enable_tileset_editing_chkbox;
 	wxSpinCtrl* undo_size_spin;
 	wxSpinCtrl* undo_mem_size_spin;
+	wxSpinCtrl* undo_disk_size_spin;
 	wxSpinCtrl* worker_threads_spin;
 	wxSpinCtrl* replace_size_spin;
 	wxRadioBox* position_format;
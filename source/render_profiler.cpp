@@ -0,0 +1,205 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#include "main.h"
+
+#include "render_profiler.h"
+#include "gui.h"
+
+#include <fstream>
+
+RenderProfiler g_render_profiler;
+
+namespace {
+	// Weight of the newest frame in the moving averages
+	const double AverageWeight = 0.1;
+
+	const char* const stage_names[RenderProfiler::STAGE_COUNT] = {
+		"Frame",
+		"Setup",
+		"Background",
+		"Map",
+		"Light",
+		"Dragging shadow",
+		"Higher floors",
+		"Selection box",
+		"Live cursors",
+		"Brush",
+		"Grid",
+		"Ingame box",
+		"Tooltips",
+		"Profiler overlay",
+		"Texture cleanup",
+		"Swap buffers",
+		"Mouse move",
+		"Mouse click",
+		"Mouse release",
+		"Mouse wheel",
+		"Key down",
+	};
+
+	const char* getStageCategory(RenderProfiler::Stage stage) {
+		if (stage >= RenderProfiler::STAGE_MOUSE_MOVE) {
+			return "input";
+		}
+		return "render";
+	}
+}
+
+RenderProfiler::RenderProfiler() :
+	enabled(false),
+	epoch(Clock::now()),
+	frame_start(epoch),
+	uploads_at_frame_start(0),
+	history_head(0),
+	history_count(0),
+	trace_head(0),
+	trace_count(0) {
+	std::fill(std::begin(average), std::end(average), 0.0);
+	std::fill(std::begin(history), std::end(history), 0.0);
+}
+
+void RenderProfiler::setEnabled(bool enabled) {
+	if (this->enabled == enabled) {
+		return;
+	}
+
+	this->enabled = enabled;
+	if (enabled) {
+		trace.resize(TraceCapacity);
+		reset();
+	} else {
+		std::vector<TraceEvent>().swap(trace);
+		trace_head = 0;
+		trace_count = 0;
+	}
+}
+
+void RenderProfiler::reset() {
+	current = FrameStats();
+	last = FrameStats();
+	std::fill(std::begin(average), std::end(average), 0.0);
+	history_head = 0;
+	history_count = 0;
+	trace_head = 0;
+	trace_count = 0;
+}
+
+void RenderProfiler::beginFrame() {
+	if (!enabled) {
+		return;
+	}
+
+	frame_start = Clock::now();
+	uploads_at_frame_start = g_gui.gfx.getTextureStats().uploads;
+}
+
+void RenderProfiler::endFrame() {
+	if (!enabled) {
+		current = FrameStats();
+		return;
+	}
+
+	record(STAGE_FRAME, frame_start, Clock::now());
+	current.texture_uploads = static_cast<uint32_t>(g_gui.gfx.getTextureStats().uploads - uploads_at_frame_start);
+
+	for (int stage = 0; stage < STAGE_COUNT; ++stage) {
+		average[stage] += (current.stage_ms[stage] - average[stage]) * AverageWeight;
+	}
+
+	history[history_head] = current.stage_ms[STAGE_FRAME];
+	history_head = (history_head + 1) % HistorySize;
+	history_count = std::min(history_count + 1, HistorySize);
+
+	last = current;
+	current = FrameStats();
+}
+
+void RenderProfiler::record(Stage stage, Clock::time_point start, Clock::time_point end) {
+	const auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+	current.stage_ms[stage] += duration / 1000.0;
+
+	if (trace.empty()) {
+		return;
+	}
+
+	TraceEvent& event = trace[trace_head];
+	event.start_us = std::chrono::duration_cast<std::chrono::microseconds>(start - epoch).count();
+	event.duration_us = duration;
+	event.stage = stage;
+	trace_head = (trace_head + 1) % trace.size();
+	trace_count = std::min(trace_count + 1, trace.size());
+}
+
+std::vector<double> RenderProfiler::getFrameHistory() const {
+	std::vector<double> frames;
+	frames.reserve(history_count);
+	size_t index = (history_head + HistorySize - history_count) % HistorySize;
+	for (size_t i = 0; i < history_count; ++i) {
+		frames.push_back(history[index]);
+		index = (index + 1) % HistorySize;
+	}
+	return frames;
+}
+
+double RenderProfiler::getWorstFrame() const {
+	double worst = 0.0;
+	for (size_t i = 0; i < history_count; ++i) {
+		worst = std::max(worst, history[i]);
+	}
+	return worst;
+}
+
+const char* RenderProfiler::getStageName(Stage stage) {
+	if (stage < 0 || stage >= STAGE_COUNT) {
+		return "Unknown";
+	}
+	return stage_names[stage];
+}
+
+bool RenderProfiler::exportChromeTrace(const std::string& path, std::string& error) const {
+	std::ofstream file(path, std::ios::out | std::ios::trunc);
+	if (!file.is_open()) {
+		error = "Could not open file \"" + path + "\" for writing.";
+		return false;
+	}
+
+	file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+	file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"GUI\"}}";
+
+	// Events are stored in the order they finished, nested stages therefore
+	// come before their parent frame. The viewer sorts them by timestamp.
+	size_t index = trace.empty() ? 0 : (trace_head + trace.size() - trace_count) % trace.size();
+	for (size_t i = 0; i < trace_count; ++i) {
+		const TraceEvent& event = trace[index];
+		file << ",\n{\"name\":\"" << getStageName(event.stage) << "\""
+			 << ",\"cat\":\"" << getStageCategory(event.stage) << "\""
+			 << ",\"ph\":\"X\",\"pid\":1,\"tid\":1"
+			 << ",\"ts\":" << event.start_us
+			 << ",\"dur\":" << event.duration_us << "}";
+		index = (index + 1) % trace.size();
+	}
+
+	file << "\n]}\n";
+	file.close();
+
+	if (file.fail()) {
+		error = "Could not write trace to \"" + path + "\".";
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,152 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#ifndef RME_RENDER_PROFILER_H_
+#define RME_RENDER_PROFILER_H_
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Collects per-stage timings and counters for the map canvas. Everything runs
+// on the GUI thread. When the profiler is disabled a scope costs a single
+// branch, counters are still bumped but never read.
+class RenderProfiler {
+public:
+	enum Stage {
+		STAGE_FRAME,
+		STAGE_SETUP,
+		STAGE_BACKGROUND,
+		STAGE_MAP,
+		STAGE_LIGHT,
+		STAGE_DRAGGING_SHADOW,
+		STAGE_HIGHER_FLOORS,
+		STAGE_SELECTION_BOX,
+		STAGE_LIVE_CURSORS,
+		STAGE_BRUSH,
+		STAGE_GRID,
+		STAGE_INGAME_BOX,
+		STAGE_TOOLTIPS,
+		STAGE_OVERLAY,
+		STAGE_TEXTURE_CLEANUP,
+		STAGE_SWAP_BUFFERS,
+		STAGE_MOUSE_MOVE,
+		STAGE_MOUSE_CLICK,
+		STAGE_MOUSE_RELEASE,
+		STAGE_MOUSE_WHEEL,
+		STAGE_KEY_DOWN,
+
+		STAGE_COUNT
+	};
+
+	typedef std::chrono::steady_clock Clock;
+
+	class Scope {
+	public:
+		Scope(RenderProfiler& profiler, Stage stage) :
+			profiler(profiler.enabled ? &profiler : nullptr), stage(stage) {
+			if (this->profiler) {
+				start = Clock::now();
+			}
+		}
+		~Scope() {
+			if (profiler) {
+				profiler->record(stage, start, Clock::now());
+			}
+		}
+
+		Scope(const Scope&) = delete;
+		Scope& operator=(const Scope&) = delete;
+
+	private:
+		RenderProfiler* profiler;
+		Stage stage;
+		Clock::time_point start;
+	};
+
+	struct FrameStats {
+		double stage_ms[STAGE_COUNT] = {};
+		uint32_t draw_calls = 0;
+		uint32_t texture_binds = 0;
+		uint32_t texture_uploads = 0;
+		uint32_t tiles_visited = 0;
+	};
+
+	static constexpr size_t HistorySize = 240;
+	static constexpr size_t TraceCapacity = 1 << 16;
+
+	RenderProfiler();
+
+	bool isEnabled() const noexcept { return enabled; }
+	void setEnabled(bool enabled);
+	void reset();
+
+	// Called by the canvas around every paint, the counters collected in
+	// between belong to that frame. Event handler time spent since the previous
+	// frame is accounted to the next one.
+	void beginFrame();
+	void endFrame();
+
+	void countDrawCall() noexcept { ++current.draw_calls; }
+	void countTextureBind() noexcept { ++current.texture_binds; }
+	void countTile() noexcept { ++current.tiles_visited; }
+
+	const FrameStats& getLastFrame() const noexcept { return last; }
+	// Exponential moving average of the stage times, smooths out single spikes
+	double getAverage(Stage stage) const noexcept { return average[stage]; }
+	// Frame times in milliseconds, oldest first
+	std::vector<double> getFrameHistory() const;
+	double getWorstFrame() const;
+	size_t getTraceEventCount() const noexcept { return trace_count; }
+
+	static const char* getStageName(Stage stage);
+
+	// Writes the buffered events in Chrome trace-event format, the file can be
+	// loaded in chrome://tracing or ui.perfetto.dev.
+	bool exportChromeTrace(const std::string& path, std::string& error) const;
+
+private:
+	struct TraceEvent {
+		int64_t start_us;
+		int64_t duration_us;
+		Stage stage;
+	};
+
+	void record(Stage stage, Clock::time_point start, Clock::time_point end);
+
+	bool enabled;
+	Clock::time_point epoch;
+	Clock::time_point frame_start;
+	uint64_t uploads_at_frame_start;
+
+	FrameStats current;
+	FrameStats last;
+	double average[STAGE_COUNT];
+
+	double history[HistorySize];
+	size_t history_head;
+	size_t history_count;
+
+	std::vector<TraceEvent> trace;
+	size_t trace_head;
+	size_t trace_count;
+};
+
+extern RenderProfiler g_render_profiler;
+
+#endif
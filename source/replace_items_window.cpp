@@ -26,6 +26,7 @@
 #include "ground_brush.h"
 #include "wall_brush.h"
 #include "doodad_brush.h"
+#include "item_replacer.h"
 #include <wx/dir.h>
 #include <wx/tokenzr.h>
 
@@ -569,39 +570,25 @@ void ReplaceItemsDialog::OnExecuteButtonClicked(wxCommandEvent& WXUNUSED(event))
 	Editor* editor = tab->GetEditor();
 	bool isReversed = swap_checkbox->GetValue();
 
-	int done = 0;
+	// All rules are applied in one pass over the map and undone as one action
+	ItemReplacer replacer(*editor);
 	for (const ReplacingItem& info : items) {
 		// If reversed, swap the IDs for the search
-		uint16_t searchId = isReversed ? info.withId : info.replaceId;
-		uint16_t replaceWithId = isReversed ? info.replaceId : info.withId;
-		
-		ItemFinder finder(searchId, (uint32_t)g_settings.getInteger(Config::REPLACE_SIZE));
-
-		// search on map
-		foreach_ItemOnMap(editor->map, finder, selectionOnly);
-
-		uint32_t total = 0;
-		std::vector<std::pair<Tile*, Item*>>& result = finder.result;
-
-		if (!result.empty()) {
-			Action* action = editor->actionQueue->createAction(ACTION_REPLACE_ITEMS);
-			for (std::vector<std::pair<Tile*, Item*>>::const_iterator rit = result.begin(); rit != result.end(); ++rit) {
-				Tile* new_tile = rit->first->deepCopy(editor->map);
-				int index = rit->first->getIndexOf(rit->second);
-				ASSERT(index != wxNOT_FOUND);
-				Item* item = new_tile->getItemAt(index);
-				ASSERT(item && item->getID() == rit->second->getID());
-				transformItem(item, replaceWithId, new_tile);
-				action->addChange(new Change(new_tile));
-				total++;
-			}
-			editor->actionQueue->addAction(action);
+		if (isReversed) {
+			replacer.addRule(info.withId, info.replaceId);
+		} else {
+			replacer.addRule(info.replaceId, info.withId);
 		}
+	}
+
+	const size_t limit = size_t(std::max(0, g_settings.getInteger(Config::REPLACE_SIZE)));
+	replacer.run(selectionOnly, limit, [this](int percent) {
+		progress->SetValue(std::clamp<int>(percent, 0, 100));
+	});
+	progress->SetValue(100);
 
-		done++;
-		const int value = static_cast<int>((done / items.size()) * 100);
-		progress->SetValue(std::clamp<int>(value, 0, 100));
-		list->MarkAsComplete(info, total);
+	for (const ReplacingItem& info : items) {
+		list->MarkAsComplete(info, replacer.getReplacedCount(isReversed ? info.withId : info.replaceId));
 	}
 
 	// Re-enable all buttons
@@ -370,7 +370,17 @@ void SearchResultWindow::ContinueSearch() {
 	ContinuedFinder finder(last_search_itemid, existingPositions, 
 		(uint32_t)g_settings.getInteger(Config::REPLACE_SIZE));
 	
-	foreach_ItemOnMap(g_gui.GetCurrentMap(), finder, last_search_on_selection);
+	Map& map = g_gui.GetCurrentMap();
+	std::shared_ptr<ItemIndex> index = map.getItemIndex();
+	bool indexed = !last_search_on_selection && index && index->findItems(map, finder.itemId, [&finder](Tile* tile, Item* item) {
+		if (!finder.isPositionAlreadyFound(tile->getPosition())) {
+			finder.result.push_back(std::make_pair(tile, item));
+		}
+		return !finder.limitReached();
+	});
+	if (!indexed) {
+		foreach_ItemOnMap(map, finder, last_search_on_selection);
+	}
 	std::vector<std::pair<Tile*, Item*>>& result = finder.result;
 	
 	g_gui.DestroyLoadBar();
@@ -399,6 +409,19 @@ void SearchResultWindow::ContinueSearch() {
 	}
 }
 
+void SearchResultWindow::AddItems(const std::vector<std::pair<Tile*, Item*>>& items) {
+	if (items.empty()) {
+		return;
+	}
+
+	result_list->Freeze();
+	for (const auto& pair : items) {
+		Item* item = pair.second;
+		AddPosition(wxString::Format("%s (ID: %d)", wxstr(item->getName()), item->getID()), pair.first->getPosition());
+	}
+	result_list->Thaw();
+}
+
 void SearchResultWindow::SetIgnoredIds(const wxString& ignored_ids_str, bool enable) {
 	use_ignored_ids = enable;
 	last_ignored_ids_text = ignored_ids_str;
@@ -23,6 +23,8 @@
 // Forward declarations
 class Position;
 class Map;
+class Tile;
+class Item;
 
 // Constant for Next search button ID
 #define SEARCH_RESULT_NEXT_BUTTON 1001
@@ -37,6 +39,8 @@ public:
 
 	void Clear();
 	void AddPosition(wxString description, Position pos);
+	// Adds "name (ID: id)" entries for a batch of found items at once
+	void AddItems(const std::vector<std::pair<Tile*, Item*>>& items);
 	void SetIgnoredIds(const wxString& ignored_ids_str, bool enable);
 	
 	// Get all found positions for continuation search
@@ -20,15 +20,22 @@
 #include "selection.h"
 #include "tile.h"
 #include "creature.h"
+#include "spawn.h"
 #include "item.h"
 #include "editor.h"
+#include "map_region.h"
 #include "gui.h"
+#include "filehandle.h"
+
+#include <atomic>
+#include <thread>
 
 Selection::Selection(Editor& editor) :
 	busy(false),
 	editor(editor),
 	session(nullptr),
-	subsession(nullptr) {
+	subsession(nullptr),
+	pending(nullptr) {
 	////
 }
 
@@ -71,6 +78,158 @@ Position Selection::maxPosition() const {
 	return maxPos;
 }
 
+size_t SelectionChangeList::addTile(const Tile* tile) {
+	Entry entry;
+	entry.position = tile->getPosition();
+	entry.offset = uint32_t(words.size());
+	entry.bits = uint32_t(FirstItemBit + tile->items.size());
+	entries.push_back(entry);
+	words.resize(words.size() + (entry.bits + 63) / 64, 0);
+
+	const size_t index = entries.size() - 1;
+	setFlag(index, GroundBit, tile->ground && tile->ground->isSelected());
+	setFlag(index, SpawnBit, tile->spawn && tile->spawn->isSelected());
+	setFlag(index, CreatureBit, tile->creature && tile->creature->isSelected());
+	for (size_t i = 0; i < tile->items.size(); ++i) {
+		setFlag(index, FirstItemBit + i, tile->items[i]->isSelected());
+	}
+	return index;
+}
+
+void SelectionChangeList::setFlag(size_t entry, size_t bit, bool selected) {
+	ASSERT(bit < entries[entry].bits);
+	uint64_t& word = words[entries[entry].offset + bit / 64];
+	if (selected) {
+		word |= uint64_t(1) << (bit % 64);
+	} else {
+		word &= ~(uint64_t(1) << (bit % 64));
+	}
+}
+
+void SelectionChangeList::setAll(size_t entry, bool selected) {
+	const Entry& e = entries[entry];
+	for (size_t i = 0; i < (e.bits + 63) / 64; ++i) {
+		words[e.offset + i] = selected ? ~uint64_t(0) : 0;
+	}
+}
+
+void SelectionChangeList::setItem(size_t entry, const Tile* tile, const Item* item, bool selected) {
+	if (item == tile->ground) {
+		setFlag(entry, GroundBit, selected);
+		return;
+	}
+	auto it = std::find(tile->items.begin(), tile->items.end(), item);
+	if (it != tile->items.end()) {
+		setFlag(entry, FirstItemBit + (it - tile->items.begin()), selected);
+	}
+}
+
+void SelectionChangeList::setGround(size_t entry, const Tile* tile, bool selected) {
+	if (tile->ground) {
+		setFlag(entry, GroundBit, selected);
+	}
+	for (size_t i = 0; i < tile->items.size() && tile->items[i]->isBorder(); ++i) {
+		setFlag(entry, FirstItemBit + i, selected);
+	}
+}
+
+void SelectionChangeList::swap(size_t entry, Tile* tile) {
+	const Entry& e = entries[entry];
+	auto exchange = [&](size_t bit, auto* object) {
+		if (!object || bit >= e.bits) {
+			return;
+		}
+		const bool selected = (words[e.offset + bit / 64] >> (bit % 64)) & 1;
+		setFlag(entry, bit, object->isSelected());
+		if (selected) {
+			object->select();
+		} else {
+			object->deselect();
+		}
+	};
+	exchange(GroundBit, tile->ground);
+	exchange(SpawnBit, tile->spawn);
+	exchange(CreatureBit, tile->creature);
+	for (size_t i = 0; i < tile->items.size(); ++i) {
+		exchange(FirstItemBit + i, tile->items[i]);
+	}
+}
+
+void SelectionChangeList::append(const SelectionChangeList& other) {
+	const uint32_t offset = uint32_t(words.size());
+	words.insert(words.end(), other.words.begin(), other.words.end());
+	entries.reserve(entries.size() + other.entries.size());
+	for (Entry entry : other.entries) {
+		entry.offset += offset;
+		entries.push_back(entry);
+	}
+}
+
+size_t SelectionChangeList::memsize() const {
+	return sizeof(*this) + entries.capacity() * sizeof(Entry) + words.capacity() * sizeof(uint64_t);
+}
+
+void SelectionChangeList::serialize(NodeFileWriteHandle& writer) const {
+	writer.addU32(uint32_t(entries.size()));
+	for (const Entry& entry : entries) {
+		writer.addU16(entry.position.x);
+		writer.addU16(entry.position.y);
+		writer.addU8(entry.position.z);
+		writer.addU32(entry.offset);
+		writer.addU32(entry.bits);
+	}
+	writer.addU32(uint32_t(words.size()));
+	for (uint64_t word : words) {
+		writer.addU64(word);
+	}
+}
+
+bool SelectionChangeList::unserialize(BinaryNode* node) {
+	entries.clear();
+	words.clear();
+
+	uint32_t count;
+	if (!node->getU32(count)) {
+		return false;
+	}
+	entries.resize(count);
+	for (Entry& entry : entries) {
+		uint16_t x, y;
+		uint8_t z;
+		if (!node->getU16(x) || !node->getU16(y) || !node->getU8(z) || !node->getU32(entry.offset) || !node->getU32(entry.bits)) {
+			return false;
+		}
+		entry.position = Position(x, y, z);
+	}
+
+	if (!node->getU32(count)) {
+		return false;
+	}
+	words.resize(count);
+	for (uint64_t& word : words) {
+		if (!node->getU64(word)) {
+			return false;
+		}
+	}
+
+	for (const Entry& entry : entries) {
+		if (size_t(entry.offset) + (entry.bits + 63) / 64 > words.size()) {
+			return false;
+		}
+	}
+	return true;
+}
+
+SelectionChangeList& Selection::getChanges() {
+	ASSERT(subsession);
+	if (!pending) {
+		Change* change = Change::Create(SelectionChangeList());
+		pending = reinterpret_cast<SelectionChangeList*>(change->getData());
+		subsession->addChange(change);
+	}
+	return *pending;
+}
+
 void Selection::add(Tile* tile, Item* item) {
 	ASSERT(subsession);
 	ASSERT(tile);
@@ -80,18 +239,15 @@ void Selection::add(Tile* tile, Item* item) {
 		return;
 	}
 
-	// Make a copy of the tile with the item selected
-	item->select();
-	Tile* new_tile = tile->deepCopy(editor.map);
-	item->deselect();
+	SelectionChangeList& changes = getChanges();
+	const size_t entry = changes.addTile(tile);
+	changes.setItem(entry, tile, item, true);
 
 	if (g_settings.getInteger(Config::BORDER_IS_GROUND)) {
 		if (item->isBorder()) {
-			new_tile->selectGround();
+			changes.setGround(entry, tile, true);
 		}
 	}
-
-	subsession->addChange(newd Change(new_tile));
 }
 
 void Selection::add(Tile* tile, Spawn* spawn) {
@@ -103,12 +259,8 @@ void Selection::add(Tile* tile, Spawn* spawn) {
 		return;
 	}
 
-	// Make a copy of the tile with the item selected
-	spawn->select();
-	Tile* new_tile = tile->deepCopy(editor.map);
-	spawn->deselect();
-
-	subsession->addChange(newd Change(new_tile));
+	SelectionChangeList& changes = getChanges();
+	changes.setFlag(changes.addTile(tile), SelectionChangeList::SpawnBit, true);
 }
 
 void Selection::add(Tile* tile, Creature* creature) {
@@ -120,22 +272,103 @@ void Selection::add(Tile* tile, Creature* creature) {
 		return;
 	}
 
-	// Make a copy of the tile with the item selected
-	creature->select();
-	Tile* new_tile = tile->deepCopy(editor.map);
-	creature->deselect();
-
-	subsession->addChange(newd Change(new_tile));
+	SelectionChangeList& changes = getChanges();
+	changes.setFlag(changes.addTile(tile), SelectionChangeList::CreatureBit, true);
 }
 
 void Selection::add(Tile* tile) {
 	ASSERT(subsession);
 	ASSERT(tile);
 
-	Tile* new_tile = tile->deepCopy(editor.map);
-	new_tile->select();
+	SelectionChangeList& changes = getChanges();
+	changes.setAll(changes.addTile(tile), true);
+}
+
+void Selection::addArea(const Position& start, const Position& end, bool compensated) {
+	ASSERT(subsession);
+
+	struct FloorArea {
+		int z;
+		int start_x, start_y;
+		int end_x, end_y;
+	};
 
-	subsession->addChange(newd Change(new_tile));
+	std::vector<FloorArea> floors;
+	int offset = 0;
+	for (int z = start.z; z >= end.z; --z) {
+		floors.push_back({ z, start.x + offset, start.y + offset, end.x + offset, end.y + offset });
+		if (z <= GROUND_LAYER && compensated) {
+			++offset;
+		}
+	}
+
+	const int min_x = std::max(0, start.x);
+	const int min_y = std::max(0, start.y);
+	const int max_x = std::min(MAP_MAX_WIDTH, end.x + offset);
+	const int max_y = std::min(MAP_MAX_HEIGHT, end.y + offset);
+	if (floors.empty() || min_x > max_x || min_y > max_y) {
+		return;
+	}
+
+	// Only blocks holding at least one leaf are handed to the workers
+	std::vector<Position> blocks;
+	for (int y = min_y & ~(AreaBlockSize - 1); y <= max_y; y += AreaBlockSize) {
+		for (int x = min_x & ~(AreaBlockSize - 1); x <= max_x; x += AreaBlockSize) {
+			if (editor.map.getNode(x, y, AreaBlockSize)) {
+				blocks.emplace_back(x, y, 0);
+			}
+		}
+	}
+
+	// Every block records its tiles in a list of its own, the lists are
+	// appended in block order so the result does not depend on the timing
+	std::vector<SelectionChangeList> results(blocks.size());
+	std::atomic<size_t> next_block(0);
+	auto worker = [&]() {
+		for (size_t i = next_block++; i < blocks.size(); i = next_block++) {
+			const Position& block = blocks[i];
+			SelectionChangeList& changes = results[i];
+			const int leaf_end_x = std::min(block.x + AreaBlockSize - 1, max_x);
+			const int leaf_end_y = std::min(block.y + AreaBlockSize - 1, max_y);
+			for (int leaf_y = std::max(block.y, min_y & ~3); leaf_y <= leaf_end_y; leaf_y += 4) {
+				for (int leaf_x = std::max(block.x, min_x & ~3); leaf_x <= leaf_end_x; leaf_x += 4) {
+					QTreeNode* leaf = editor.map.getLeaf(leaf_x, leaf_y);
+					if (!leaf) {
+						continue;
+					}
+					for (const FloorArea& area : floors) {
+						Floor* floor = leaf->getFloor(area.z);
+						if (!floor || leaf_x + 3 < area.start_x || leaf_x > area.end_x || leaf_y + 3 < area.start_y || leaf_y > area.end_y) {
+							continue;
+						}
+						for (int x = std::max(leaf_x, area.start_x); x <= std::min(leaf_x + 3, area.end_x); ++x) {
+							for (int y = std::max(leaf_y, area.start_y); y <= std::min(leaf_y + 3, area.end_y); ++y) {
+								Tile* tile = floor->locs[(x & 3) * 4 + (y & 3)].get();
+								if (tile) {
+									changes.setAll(changes.addTile(tile), true);
+								}
+							}
+						}
+					}
+				}
+			}
+		}
+	};
+
+	const int thread_count = std::max(1, std::min<int>(g_settings.getInteger(Config::WORKER_THREADS), blocks.size()));
+	std::vector<std::thread> threads;
+	for (int i = 1; i < thread_count; ++i) {
+		threads.emplace_back(worker);
+	}
+	worker();
+	for (std::thread& thread : threads) {
+		thread.join();
+	}
+
+	SelectionChangeList& changes = getChanges();
+	for (const SelectionChangeList& result : results) {
+		changes.append(result);
+	}
 }
 
 void Selection::remove(Tile* tile, Item* item) {
@@ -143,17 +376,13 @@ void Selection::remove(Tile* tile, Item* item) {
 	ASSERT(tile);
 	ASSERT(item);
 
-	bool tmp = item->isSelected();
-	item->deselect();
-	Tile* new_tile = tile->deepCopy(editor.map);
-	if (tmp) {
-		item->select();
-	}
+	SelectionChangeList& changes = getChanges();
+	const size_t entry = changes.addTile(tile);
+	changes.setItem(entry, tile, item, false);
+
 	if (item->isBorder() && g_settings.getInteger(Config::BORDER_IS_GROUND)) {
-		new_tile->deselectGround();
+		changes.setGround(entry, tile, false);
 	}
-
-	subsession->addChange(newd Change(new_tile));
 }
 
 void Selection::remove(Tile* tile, Spawn* spawn) {
@@ -161,14 +390,8 @@ void Selection::remove(Tile* tile, Spawn* spawn) {
 	ASSERT(tile);
 	ASSERT(spawn);
 
-	bool tmp = spawn->isSelected();
-	spawn->deselect();
-	Tile* new_tile = tile->deepCopy(editor.map);
-	if (tmp) {
-		spawn->select();
-	}
-
-	subsession->addChange(newd Change(new_tile));
+	SelectionChangeList& changes = getChanges();
+	changes.setFlag(changes.addTile(tile), SelectionChangeList::SpawnBit, false);
 }
 
 void Selection::remove(Tile* tile, Creature* creature) {
@@ -176,23 +399,15 @@ void Selection::remove(Tile* tile, Creature* creature) {
 	ASSERT(tile);
 	ASSERT(creature);
 
-	bool tmp = creature->isSelected();
-	creature->deselect();
-	Tile* new_tile = tile->deepCopy(editor.map);
-	if (tmp) {
-		creature->select();
-	}
-
-	subsession->addChange(newd Change(new_tile));
+	SelectionChangeList& changes = getChanges();
+	changes.setFlag(changes.addTile(tile), SelectionChangeList::CreatureBit, false);
 }
 
 void Selection::remove(Tile* tile) {
 	ASSERT(subsession);
 
-	Tile* new_tile = tile->deepCopy(editor.map);
-	new_tile->deselect();
-
-	subsession->addChange(newd Change(new_tile));
+	SelectionChangeList& changes = getChanges();
+	changes.setAll(changes.addTile(tile), false);
 }
 
 void Selection::addInternal(Tile* tile) {
@@ -208,10 +423,9 @@ void Selection::removeInternal(Tile* tile) {
 
 void Selection::clear() {
 	if (session) {
+		SelectionChangeList& changes = getChanges();
 		for (TileSet::iterator it = tiles.begin(); it != tiles.end(); it++) {
-			Tile* new_tile = (*it)->deepCopy(editor.map);
-			new_tile->deselect();
-			subsession->addChange(newd Change(new_tile));
+			changes.setAll(changes.addTile(*it), false);
 		}
 	} else {
 		for (TileSet::iterator it = tiles.begin(); it != tiles.end(); it++) {
@@ -223,12 +437,9 @@ void Selection::clear() {
 
 void Selection::start(SessionFlags flags) {
 	if (!(flags & INTERNAL)) {
-		if (flags & SUBTHREAD) {
-			;
-		} else {
-			session = editor.actionQueue->createBatch(ACTION_SELECT);
-		}
+		session = editor.actionQueue->createBatch(ACTION_SELECT);
 		subsession = editor.actionQueue->createAction(ACTION_SELECT);
+		pending = nullptr;
 	}
 	busy = true;
 }
@@ -245,28 +456,25 @@ void Selection::commit() {
 
 		// Create a newd action for subsequent selects
 		subsession = editor.actionQueue->createAction(ACTION_SELECT);
+		pending = nullptr;
 		session = tmp;
 	}
 }
 
 void Selection::finish(SessionFlags flags) {
 	if (!(flags & INTERNAL)) {
-		if (flags & SUBTHREAD) {
-			ASSERT(subsession);
-			subsession = nullptr;
-		} else {
-			ASSERT(session);
-			ASSERT(subsession);
-			// We need to exit the session before we do the action, else peril awaits us!
-			BatchAction* tmp = session;
-			session = nullptr;
+		ASSERT(session);
+		ASSERT(subsession);
+		// We need to exit the session before we do the action, else peril awaits us!
+		BatchAction* tmp = session;
+		session = nullptr;
 
-			tmp->addAndCommitAction(subsession);
-			editor.addBatch(tmp, 2);
+		tmp->addAndCommitAction(subsession);
+		editor.addBatch(tmp, 2);
 
-			session = nullptr;
-			subsession = nullptr;
-		}
+		session = nullptr;
+		subsession = nullptr;
+		pending = nullptr;
 	}
 	busy = false;
 }
@@ -282,58 +490,3 @@ void Selection::updateSelectionCount() {
 		g_gui.SetStatusText(ss);
 	}
 }
-
-void Selection::join(SelectionThread* thread) {
-	thread->Wait();
-
-	ASSERT(session);
-	session->addAction(thread->result);
-	thread->selection.subsession = nullptr;
-
-	delete thread;
-}
-
-SelectionThread::SelectionThread(Editor& editor, Position start, Position end) :
-	wxThread(wxTHREAD_JOINABLE),
-	editor(editor),
-	start(start),
-	end(end),
-	selection(editor),
-	result(nullptr) {
-	////
-}
-
-SelectionThread::~SelectionThread() {
-	////
-}
-
-void SelectionThread::Execute() {
-	Create();
-	Run();
-}
-
-wxThread::ExitCode SelectionThread::Entry() {
-	selection.start(Selection::SUBTHREAD);
-	for (int z = start.z; z >= end.z; --z) {
-		for (int x = start.x; x <= end.x; ++x) {
-			for (int y = start.y; y <= end.y; ++y) {
-				Tile* tile = editor.map.getTile(x, y, z);
-				if (!tile) {
-					continue;
-				}
-
-				selection.add(tile);
-			}
-		}
-		if (z <= GROUND_LAYER && g_settings.getInteger(Config::COMPENSATED_SELECT)) {
-			++start.x;
-			++start.y;
-			++end.x;
-			++end.y;
-		}
-	}
-	result = selection.subsession;
-	selection.finish(Selection::SUBTHREAD);
-
-	return nullptr;
-}
@@ -23,8 +23,58 @@
 class Action;
 class Editor;
 class BatchAction;
+class NodeFileWriteHandle;
+class BinaryNode;
+
+// Selection flags of tiles changed in place, used for the undo history of
+// selections instead of copies of the tiles. Every entry holds the flags of
+// one tile packed in bits: GroundBit, SpawnBit, CreatureBit and FirstItemBit
+// + i for the item at index i. Applying an entry exchanges its flags with
+// those of the tile, so the same entry undoes it.
+class SelectionChangeList {
+public:
+	static constexpr size_t GroundBit = 0;
+	static constexpr size_t SpawnBit = 1;
+	static constexpr size_t CreatureBit = 2;
+	static constexpr size_t FirstItemBit = 3;
+
+	size_t size() const {
+		return entries.size();
+	}
+	const Position& getPosition(size_t entry) const {
+		return entries[entry].position;
+	}
+
+	// Appends an entry holding the current flags of the tile and returns it
+	size_t addTile(const Tile* tile);
+	void setFlag(size_t entry, size_t bit, bool selected);
+	void setAll(size_t entry, bool selected);
+	void setItem(size_t entry, const Tile* tile, const Item* item, bool selected);
+	// The ground and the borders right above it, see Tile::selectGround
+	void setGround(size_t entry, const Tile* tile, bool selected);
 
-class SelectionThread;
+	// Items above the stack size the entry was added with are left alone
+	void swap(size_t entry, Tile* tile);
+	// Appends the entries of other after those of this list
+	void append(const SelectionChangeList& other);
+
+	size_t memsize() const;
+
+	// Stored in the node of the undo spill file, unserialize returns false on
+	// malformed data
+	void serialize(NodeFileWriteHandle& writer) const;
+	bool unserialize(BinaryNode* node);
+
+private:
+	struct Entry {
+		Position position;
+		uint32_t offset;
+		uint32_t bits;
+	};
+
+	std::vector<Entry> entries;
+	std::vector<uint64_t> words;
+};
 
 class Selection {
 public:
@@ -37,6 +87,10 @@ public:
 	void add(Tile* tile, Spawn* spawn);
 	void add(Tile* tile, Creature* creature);
 	void add(Tile* tile);
+	// Selects every tile of the box from start to end, start.z being the
+	// deepest floor. When compensated the box moves one tile down-right for
+	// every floor above the ground it passes, like the drawn floors do.
+	void addArea(const Position& start, const Position& end, bool compensated);
 	void remove(Tile* tile, Item* item);
 	void remove(Tile* tile, Spawn* spawn);
 	void remove(Tile* tile, Creature* creature);
@@ -60,23 +114,15 @@ public:
 
 	// This manages a "selection session"
 	// Internal session doesn't store the result (eg. no undo)
-	// Subthread means the session doesn't create a complete
-	// action, just part of one to be merged with the main thread
-	// later.
 	enum SessionFlags {
 		NONE,
 		INTERNAL = 1,
-		SUBTHREAD = 2,
 	};
 
 	void start(SessionFlags flags = NONE);
 	void commit();
 	void finish(SessionFlags flags = NONE);
 
-	// Joins the selection instance in this thread with this instance
-	// This deletes the thread
-	void join(SelectionThread* thread);
-
 	size_t size() {
 		return tiles.size();
 	}
@@ -99,30 +145,20 @@ public:
 	}
 
 private:
+	// addArea hands blocks of this size to the worker threads, a power of 4
+	static constexpr int AreaBlockSize = 64;
+
+	// The flags of the tile after the change are recorded in the subsession
+	SelectionChangeList& getChanges();
+
 	bool busy;
 	Editor& editor;
 	BatchAction* session;
 	Action* subsession;
+	// Owned by the last change of the subsession
+	SelectionChangeList* pending;
 
 	TileSet tiles;
-
-	friend class SelectionThread;
-};
-
-class SelectionThread : public wxThread {
-public:
-	SelectionThread(Editor& editor, Position start, Position end);
-	virtual ~SelectionThread();
-
-	void Execute(); // Calls "Create" and then "Run"
-protected:
-	virtual ExitCode Entry();
-	Editor& editor;
-	Position start, end;
-	Selection selection;
-	Action* result;
-
-	friend class Selection;
 };
 
 #endif
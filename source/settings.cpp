@@ -244,11 +244,13 @@ void Settings::IO(IOMode mode) {
 
 	section("Editor");
 	String(RECENT_FILES, "");
-	Int(WORKER_THREADS, 1);
+	Int(WORKER_THREADS, std::max(1, wxThread::GetCPUCount()));
+	Int(TRACE_CATEGORIES, -1);
 	Int(MERGE_MOVE, 0);
 	Int(MERGE_PASTE, 0);
 	Int(UNDO_SIZE, 40);
 	Int(UNDO_MEM_SIZE, 64);
+	Int(UNDO_DISK_SIZE, 1024);
 	Int(GROUP_ACTIONS, 1);
 	Int(SELECTION_TYPE, SELECT_CURRENT_FLOOR);
 	Int(COMPENSATED_SELECT, 1);
@@ -298,6 +300,7 @@ void Settings::IO(IOMode mode) {
 	Int(TEXTURE_CLEAN_THRESHOLD, 2500);
 	Int(SOFTWARE_CLEAN_THRESHOLD, 1800);
 	Int(SOFTWARE_CLEAN_SIZE, 500);
+	Int(TEMPLATE_TEXTURE_BUDGET, 2048);
 	Int(ICON_BACKGROUND, 0);
 	Int(HARD_REFRESH_RATE, 200);
 	Int(HIDE_ITEMS_WHEN_ZOOMED, 1);
@@ -359,6 +362,7 @@ void Settings::IO(IOMode mode) {
 	// experimental
 	section("experimental");
 	Int(EXPERIMENTAL_FOG, 0);
+	Int(SHOW_RENDER_PROFILER, 0);
 
 	// Network settings
 	section("Network");
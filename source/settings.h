@@ -39,6 +39,7 @@ namespace Config {
 		USE_MEMCACHED_SPRITES_TO_SAVE,
 		SOFTWARE_CLEAN_THRESHOLD,
 		SOFTWARE_CLEAN_SIZE,
+		TEMPLATE_TEXTURE_BUDGET,
 		TRANSPARENT_FLOORS,
 		TRANSPARENT_ITEMS,
 		SHOW_INGAME_BOX,
@@ -66,6 +67,7 @@ namespace Config {
 		ZOOM_SPEED,
 		UNDO_SIZE,
 		UNDO_MEM_SIZE,
+		UNDO_DISK_SIZE,
 		MERGE_PASTE,
 		SELECTION_TYPE,
 		COMPENSATED_SELECT,
@@ -134,6 +136,7 @@ namespace Config {
 		LISTBOX_EATS_ALL_EVENTS,
 		RAW_LIKE_SIMONE,
 		WORKER_THREADS,
+		TRACE_CATEGORIES,
 		COPY_POSITION_FORMAT,
 
 		GOTO_WEBSITE_ON_BOOT,
@@ -185,6 +188,7 @@ namespace Config {
 		SHOW_WAYPOINTS,
 
 		EXPERIMENTAL_FOG,
+		SHOW_RENDER_PROFILER,
 
 		SHOW_TOWNS,
 		ALWAYS_SHOW_ZONES,
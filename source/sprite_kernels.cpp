@@ -0,0 +1,468 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#include "main.h"
+
+#include "sprite_kernels.h"
+
+#include <atomic>
+#include <cstring>
+
+#if defined(_M_X64) || defined(__x86_64__) || defined(_M_IX86) || defined(__i386__)
+	#define RME_KERNELS_X86
+	#include <immintrin.h>
+	#ifdef _MSC_VER
+		#include <intrin.h>
+		#define RME_TARGET_SSE2
+		#define RME_TARGET_AVX2
+	#else
+		#define RME_TARGET_SSE2 __attribute__((target("sse2")))
+		#define RME_TARGET_AVX2 __attribute__((target("avx2")))
+	#endif
+#endif
+
+namespace {
+	// Per pixel multipliers, index 0 is the identity (pixel not covered by the template)
+	struct Multipliers {
+		alignas(16) float mul[5][4];
+	};
+
+	// Maps (red != 0) | (green != 0) << 1 | (blue != 0) << 2 of a template pixel to its part
+	// 0 = none, 1 = head (yellow), 2 = body (red), 3 = legs (green), 4 = feet (blue)
+	const uint8_t template_part[8] = { 0, 2, 3, 1, 4, 0, 0, 0 };
+
+	inline int getTemplatePart(const uint8_t* t) {
+		return template_part[(t[0] != 0) | (t[1] != 0) << 1 | (t[2] != 0) << 2];
+	}
+
+	void buildMultipliers(const uint32_t colors[4], Multipliers& m) {
+		for (int c = 0; c < 4; ++c) {
+			m.mul[0][c] = 1.f;
+		}
+		for (int part = 0; part < 4; ++part) {
+			// Must stay ro / 255.f so the result matches the original per pixel float math
+			const uint8_t ro = (colors[part] & 0xFF0000) >> 16;
+			const uint8_t go = (colors[part] & 0xFF00) >> 8;
+			const uint8_t bo = (colors[part] & 0xFF);
+			m.mul[part + 1][0] = ro / 255.f;
+			m.mul[part + 1][1] = go / 255.f;
+			m.mul[part + 1][2] = bo / 255.f;
+			m.mul[part + 1][3] = 1.f;
+		}
+	}
+
+	// Reads a 16 bit run length, a truncated header counts as an empty run
+	inline int readRunLength(const uint8_t* dump, int& read, int size) {
+		if (read + 1 >= size) {
+			read = size;
+			return 0;
+		}
+		const int length = dump[read] | dump[read + 1] << 8;
+		read += 2;
+		return length;
+	}
+
+	// ========================================================================
+	// Scalar reference kernels
+
+	void fillMagentaScalar(uint8_t* dst, int count) {
+		for (int i = 0; i < count; ++i) {
+			dst[i * 3 + 0] = 0xFF; // red
+			dst[i * 3 + 1] = 0x00; // green
+			dst[i * 3 + 2] = 0xFF; // blue
+		}
+	}
+
+	void copyRGBAToRGBScalar(uint8_t* dst, const uint8_t* src, int count) {
+		for (int i = 0; i < count; ++i) {
+			dst[i * 3 + 0] = src[i * 4 + 0];
+			dst[i * 3 + 1] = src[i * 4 + 1];
+			dst[i * 3 + 2] = src[i * 4 + 2];
+		}
+	}
+
+	void copyRGBToRGBAScalar(uint8_t* dst, const uint8_t* src, int count) {
+		for (int i = 0; i < count; ++i) {
+			dst[i * 4 + 0] = src[i * 3 + 0];
+			dst[i * 4 + 1] = src[i * 3 + 1];
+			dst[i * 4 + 2] = src[i * 3 + 2];
+			dst[i * 4 + 3] = 0xFF;
+		}
+	}
+
+	template <int bpp>
+	void colorizeScalar(uint8_t* data, const uint8_t* template_rgb, const Multipliers& m) {
+		for (int i = 0; i < SPRITE_PIXELS_SIZE; ++i) {
+			const int part = getTemplatePart(template_rgb + i * 3);
+			if (part != 0) {
+				uint8_t* px = data + i * bpp;
+				px[0] = (uint8_t)(px[0] * m.mul[part][0]);
+				px[1] = (uint8_t)(px[1] * m.mul[part][1]);
+				px[2] = (uint8_t)(px[2] * m.mul[part][2]);
+			}
+		}
+	}
+
+#ifdef RME_KERNELS_X86
+	// 16 magenta pixels, the three 16 byte vectors repeat every 48 bytes
+	alignas(32) const uint8_t magenta_pattern[96] = {
+		0xFF, 0x00, 0xFF, 0xFF, 0x00, 0xFF, 0xFF, 0x00, 0xFF, 0xFF, 0x00, 0xFF, 0xFF, 0x00, 0xFF, 0xFF,
+		0x00, 0xFF, 0xFF, 0x00, 0xFF, 0xFF, 0x00, 0xFF, 0xFF, 0x00, 0xFF, 0xFF, 0x00, 0xFF, 0xFF, 0x00,
+		0xFF, 0xFF, 0x00, 0xFF, 0xFF, 0x00, 0xFF, 0xFF, 0x00, 0xFF, 0xFF, 0x00, 0xFF, 0xFF, 0x00, 0xFF,
+		0xFF, 0x00, 0xFF, 0xFF, 0x00, 0xFF, 0xFF, 0x00, 0xFF, 0xFF, 0x00, 0xFF, 0xFF, 0x00, 0xFF, 0xFF,
+		0x00, 0xFF, 0xFF, 0x00, 0xFF, 0xFF, 0x00, 0xFF, 0xFF, 0x00, 0xFF, 0xFF, 0x00, 0xFF, 0xFF, 0x00,
+		0xFF, 0xFF, 0x00, 0xFF, 0xFF, 0x00, 0xFF, 0xFF, 0x00, 0xFF, 0xFF, 0x00, 0xFF, 0xFF, 0x00, 0xFF
+	};
+
+	// ========================================================================
+	// SSE2 kernels
+
+	RME_TARGET_SSE2 void fillMagentaSSE2(uint8_t* dst, int count) {
+		const __m128i p0 = _mm_load_si128(reinterpret_cast<const __m128i*>(magenta_pattern));
+		const __m128i p1 = _mm_load_si128(reinterpret_cast<const __m128i*>(magenta_pattern + 16));
+		const __m128i p2 = _mm_load_si128(reinterpret_cast<const __m128i*>(magenta_pattern + 32));
+		int i = 0;
+		for (; i + 16 <= count; i += 16) {
+			uint8_t* out = dst + i * 3;
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(out), p0);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(out + 16), p1);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(out + 32), p2);
+		}
+		fillMagentaScalar(dst + i * 3, count - i);
+	}
+
+	void copyRGBToRGBAWords(uint8_t* dst, const uint8_t* src, int count) {
+		// Reads 4 bytes per pixel, the extra byte belongs to the next pixel of the run
+		int i = 0;
+		for (; i + 1 < count; ++i) {
+			uint32_t pixel;
+			memcpy(&pixel, src + i * 3, sizeof(pixel));
+			pixel |= 0xFF000000; // alpha, x86 is little endian
+			memcpy(dst + i * 4, &pixel, sizeof(pixel));
+		}
+		copyRGBToRGBAScalar(dst + i * 4, src + i * 3, count - i);
+	}
+
+	// Classifies 16 template pixels at once, a zero byte compare of the 48 bytes
+	// yields 3 bits per pixel laid out exactly like the scalar lookup expects
+	RME_TARGET_SSE2 uint64_t getTemplateMask16(const uint8_t* t) {
+		const __m128i zero = _mm_setzero_si128();
+		const uint64_t m0 = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(t)), zero));
+		const uint64_t m1 = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(t + 16)), zero));
+		const uint64_t m2 = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(t + 32)), zero));
+		return ~(m0 | m1 << 16 | m2 << 32) & 0xFFFFFFFFFFFFULL;
+	}
+
+	// Colorizes 16 RGBA pixels with the template mask of the same block
+	RME_TARGET_SSE2 void colorizeBlockSSE2(uint8_t* rgba, uint64_t mask, const Multipliers& m) {
+		const __m128i zero = _mm_setzero_si128();
+		for (int j = 0; j < 16; j += 4) {
+			const int p0 = template_part[(mask >> (j * 3)) & 7];
+			const int p1 = template_part[(mask >> (j * 3 + 3)) & 7];
+			const int p2 = template_part[(mask >> (j * 3 + 6)) & 7];
+			const int p3 = template_part[(mask >> (j * 3 + 9)) & 7];
+			if ((p0 | p1 | p2 | p3) == 0) {
+				continue;
+			}
+
+			__m128i* out = reinterpret_cast<__m128i*>(rgba + j * 4);
+			const __m128i px = _mm_loadu_si128(out);
+			const __m128i lo = _mm_unpacklo_epi8(px, zero);
+			const __m128i hi = _mm_unpackhi_epi8(px, zero);
+
+			const __m128 f0 = _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero)), _mm_load_ps(m.mul[p0]));
+			const __m128 f1 = _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero)), _mm_load_ps(m.mul[p1]));
+			const __m128 f2 = _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero)), _mm_load_ps(m.mul[p2]));
+			const __m128 f3 = _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero)), _mm_load_ps(m.mul[p3]));
+
+			const __m128i w01 = _mm_packs_epi32(_mm_cvttps_epi32(f0), _mm_cvttps_epi32(f1));
+			const __m128i w23 = _mm_packs_epi32(_mm_cvttps_epi32(f2), _mm_cvttps_epi32(f3));
+			_mm_storeu_si128(out, _mm_packus_epi16(w01, w23));
+		}
+	}
+
+	RME_TARGET_SSE2 void colorizeRGBASSE2(uint8_t* rgba, const uint8_t* template_rgb, const Multipliers& m) {
+		for (int i = 0; i < SPRITE_PIXELS_SIZE; i += 16) {
+			const uint64_t mask = getTemplateMask16(template_rgb + i * 3);
+			if (mask != 0) {
+				colorizeBlockSSE2(rgba + i * 4, mask, m);
+			}
+		}
+	}
+
+	// RGB pixels are widened a block at a time so the same multiplies apply
+	RME_TARGET_SSE2 void colorizeRGBSSE2(uint8_t* rgb, const uint8_t* template_rgb, const Multipliers& m) {
+		alignas(16) uint8_t block[16 * 4];
+		for (int i = 0; i < SPRITE_PIXELS_SIZE; i += 16) {
+			const uint64_t mask = getTemplateMask16(template_rgb + i * 3);
+			if (mask != 0) {
+				copyRGBToRGBAWords(block, rgb + i * 3, 16);
+				colorizeBlockSSE2(block, mask, m);
+				copyRGBAToRGBScalar(rgb + i * 3, block, 16);
+			}
+		}
+	}
+
+	// ========================================================================
+	// AVX2 kernels
+
+	RME_TARGET_AVX2 void fillMagentaAVX2(uint8_t* dst, int count) {
+		const __m256i p0 = _mm256_load_si256(reinterpret_cast<const __m256i*>(magenta_pattern));
+		const __m256i p1 = _mm256_load_si256(reinterpret_cast<const __m256i*>(magenta_pattern + 32));
+		const __m256i p2 = _mm256_load_si256(reinterpret_cast<const __m256i*>(magenta_pattern + 64));
+		int i = 0;
+		for (; i + 32 <= count; i += 32) {
+			uint8_t* out = dst + i * 3;
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(out), p0);
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 32), p1);
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 64), p2);
+		}
+		fillMagentaSSE2(dst + i * 3, count - i);
+	}
+
+	RME_TARGET_AVX2 void copyRGBAToRGBAVX2(uint8_t* dst, const uint8_t* src, int count) {
+		const __m128i drop_alpha = _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+		int i = 0;
+		// Every store writes 4 padding bytes that the next store overwrites,
+		// keep two pixels of slack so the padding never leaves the run
+		for (; i + 10 <= count; i += 8) {
+			const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4));
+			const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4 + 16));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 3), _mm_shuffle_epi8(a, drop_alpha));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 3 + 12), _mm_shuffle_epi8(b, drop_alpha));
+		}
+		copyRGBAToRGBScalar(dst + i * 3, src + i * 4, count - i);
+	}
+
+	RME_TARGET_AVX2 void copyRGBToRGBAAVX2(uint8_t* dst, const uint8_t* src, int count) {
+		const __m256i expand = _mm256_setr_epi8(
+			0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1,
+			0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1
+		);
+		const __m256i alpha = _mm256_set1_epi32((int)0xFF000000);
+		int i = 0;
+		// Each 16 byte load reads 4 bytes past its 4 pixels, stay inside the run
+		for (; i + 10 <= count; i += 8) {
+			const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 3));
+			const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 3 + 12));
+			const __m256i v = _mm256_inserti128_si256(_mm256_castsi128_si256(a), b, 1);
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i * 4), _mm256_or_si256(_mm256_shuffle_epi8(v, expand), alpha));
+		}
+		copyRGBToRGBAWords(dst + i * 4, src + i * 3, count - i);
+	}
+
+	RME_TARGET_AVX2 void colorizeBlockAVX2(uint8_t* rgba, uint64_t mask, const Multipliers& m) {
+		// packs/packus work per 128 bit lane, this puts the pixels back in order
+		const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+		for (int j = 0; j < 16; j += 8) {
+			const uint64_t group = mask >> (j * 3);
+			if ((group & 0xFFFFFF) == 0) {
+				continue;
+			}
+
+			uint8_t* out = rgba + j * 4;
+			__m256i r[4];
+			for (int k = 0; k < 4; ++k) {
+				const int p0 = template_part[(group >> (k * 6)) & 7];
+				const int p1 = template_part[(group >> (k * 6 + 3)) & 7];
+				const __m128i two = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(out + k * 8));
+				const __m256 mul = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_load_ps(m.mul[p0])), _mm_load_ps(m.mul[p1]), 1);
+				r[k] = _mm256_cvttps_epi32(_mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(two)), mul));
+			}
+			const __m256i packed = _mm256_packus_epi16(_mm256_packs_epi32(r[0], r[1]), _mm256_packs_epi32(r[2], r[3]));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(out), _mm256_permutevar8x32_epi32(packed, order));
+		}
+	}
+
+	RME_TARGET_AVX2 void colorizeRGBAAVX2(uint8_t* rgba, const uint8_t* template_rgb, const Multipliers& m) {
+		for (int i = 0; i < SPRITE_PIXELS_SIZE; i += 16) {
+			const uint64_t mask = getTemplateMask16(template_rgb + i * 3);
+			if (mask != 0) {
+				colorizeBlockAVX2(rgba + i * 4, mask, m);
+			}
+		}
+	}
+
+	RME_TARGET_AVX2 void colorizeRGBAVX2(uint8_t* rgb, const uint8_t* template_rgb, const Multipliers& m) {
+		alignas(32) uint8_t block[16 * 4];
+		for (int i = 0; i < SPRITE_PIXELS_SIZE; i += 16) {
+			const uint64_t mask = getTemplateMask16(template_rgb + i * 3);
+			if (mask != 0) {
+				copyRGBToRGBAAVX2(block, rgb + i * 3, 16);
+				colorizeBlockAVX2(block, mask, m);
+				copyRGBAToRGBAVX2(rgb + i * 3, block, 16);
+			}
+		}
+	}
+#endif
+
+	struct Kernels {
+		void (*fillMagenta)(uint8_t* dst, int count);
+		void (*copyRGBAToRGB)(uint8_t* dst, const uint8_t* src, int count);
+		void (*copyRGBToRGBA)(uint8_t* dst, const uint8_t* src, int count);
+		void (*colorizeRGB)(uint8_t* rgb, const uint8_t* template_rgb, const Multipliers& m);
+		void (*colorizeRGBA)(uint8_t* rgba, const uint8_t* template_rgb, const Multipliers& m);
+	};
+
+	const Kernels scalar_kernels = { fillMagentaScalar, copyRGBAToRGBScalar, copyRGBToRGBAScalar, colorizeScalar<3>, colorizeScalar<4> };
+#ifdef RME_KERNELS_X86
+	const Kernels sse2_kernels = { fillMagentaSSE2, copyRGBAToRGBScalar, copyRGBToRGBAWords, colorizeRGBSSE2, colorizeRGBASSE2 };
+	const Kernels avx2_kernels = { fillMagentaAVX2, copyRGBAToRGBAVX2, copyRGBToRGBAAVX2, colorizeRGBAVX2, colorizeRGBAAVX2 };
+#endif
+
+	SpriteKernels::InstructionSet detectInstructionSet() {
+#ifdef RME_KERNELS_X86
+	#ifdef _MSC_VER
+		int info[4];
+		__cpuid(info, 0);
+		const int max_leaf = info[0];
+		__cpuid(info, 1);
+		const bool has_sse2 = (info[3] & (1 << 26)) != 0;
+		const bool has_osxsave = (info[2] & (1 << 27)) != 0;
+		const bool has_avx = (info[2] & (1 << 28)) != 0;
+		bool has_avx2 = false;
+		if (max_leaf >= 7 && has_osxsave && has_avx && (_xgetbv(0) & 0x6) == 0x6) {
+			__cpuidex(info, 7, 0);
+			has_avx2 = (info[1] & (1 << 5)) != 0;
+		}
+	#else
+		__builtin_cpu_init();
+		const bool has_sse2 = __builtin_cpu_supports("sse2");
+		const bool has_avx2 = __builtin_cpu_supports("avx2");
+	#endif
+		if (has_avx2) {
+			return SpriteKernels::ISA_AVX2;
+		} else if (has_sse2) {
+			return SpriteKernels::ISA_SSE2;
+		}
+#endif
+		return SpriteKernels::ISA_SCALAR;
+	}
+
+	std::atomic<int> active_isa(-1);
+
+	const Kernels& getKernels() {
+		int isa = active_isa.load(std::memory_order_relaxed);
+		if (isa < 0) {
+			isa = SpriteKernels::getSupportedInstructionSet();
+			active_isa.store(isa, std::memory_order_relaxed);
+		}
+#ifdef RME_KERNELS_X86
+		if (isa == SpriteKernels::ISA_AVX2) {
+			return avx2_kernels;
+		} else if (isa == SpriteKernels::ISA_SSE2) {
+			return sse2_kernels;
+		}
+#endif
+		return scalar_kernels;
+	}
+}
+
+SpriteKernels::InstructionSet SpriteKernels::getSupportedInstructionSet() {
+	static const InstructionSet supported = detectInstructionSet();
+	return supported;
+}
+
+SpriteKernels::InstructionSet SpriteKernels::getInstructionSet() {
+	getKernels();
+	return static_cast<InstructionSet>(active_isa.load(std::memory_order_relaxed));
+}
+
+void SpriteKernels::setInstructionSet(InstructionSet isa) {
+	active_isa.store(std::min<int>(isa, getSupportedInstructionSet()), std::memory_order_relaxed);
+}
+
+const char* SpriteKernels::getInstructionSetName(InstructionSet isa) {
+	switch (isa) {
+		case ISA_AVX2:
+			return "AVX2";
+		case ISA_SSE2:
+			return "SSE2";
+		default:
+			return "Scalar";
+	}
+}
+
+void SpriteKernels::decodeRGB(const uint8_t* dump, int size, bool has_alpha, uint8_t* out) {
+	const Kernels& kernels = getKernels();
+	const int bpp = has_alpha ? 4 : 3;
+	int written = 0;
+	int read = 0;
+
+	while (read < size && written < SPRITE_PIXELS_SIZE) {
+		const int transparent = std::min(readRunLength(dump, read, size), SPRITE_PIXELS_SIZE - written);
+		kernels.fillMagenta(out + written * 3, transparent);
+		written += transparent;
+
+		int colored = readRunLength(dump, read, size);
+		colored = std::min(colored, SPRITE_PIXELS_SIZE - written);
+		colored = std::min(colored, (size - read) / bpp);
+		if (has_alpha) {
+			kernels.copyRGBAToRGB(out + written * 3, dump + read, colored);
+		} else {
+			memcpy(out + written * 3, dump + read, colored * 3);
+		}
+		written += colored;
+		read += colored * bpp;
+	}
+
+	// fill remaining pixels
+	kernels.fillMagenta(out + written * 3, SPRITE_PIXELS_SIZE - written);
+}
+
+void SpriteKernels::decodeRGBA(const uint8_t* dump, int size, bool has_alpha, uint8_t* out) {
+	const Kernels& kernels = getKernels();
+	const int bpp = has_alpha ? 4 : 3;
+	int written = 0;
+	int read = 0;
+
+	while (read < size && written < SPRITE_PIXELS_SIZE) {
+		int transparent = readRunLength(dump, read, size);
+		if (has_alpha && transparent >= SPRITE_PIXELS_SIZE) { // Corrupted sprite?
+			break;
+		}
+		transparent = std::min(transparent, SPRITE_PIXELS_SIZE - written);
+		memset(out + written * 4, 0, transparent * 4);
+		written += transparent;
+
+		int colored = readRunLength(dump, read, size);
+		colored = std::min(colored, SPRITE_PIXELS_SIZE - written);
+		colored = std::min(colored, (size - read) / bpp);
+		if (has_alpha) {
+			memcpy(out + written * 4, dump + read, colored * 4);
+		} else {
+			kernels.copyRGBToRGBA(out + written * 4, dump + read, colored);
+		}
+		written += colored;
+		read += colored * bpp;
+	}
+
+	// fill remaining pixels
+	memset(out + written * 4, 0, (SPRITE_PIXELS_SIZE - written) * 4);
+}
+
+void SpriteKernels::colorizeRGB(uint8_t* rgb, const uint8_t* template_rgb, const uint32_t colors[4]) {
+	Multipliers m;
+	buildMultipliers(colors, m);
+	getKernels().colorizeRGB(rgb, template_rgb, m);
+}
+
+void SpriteKernels::colorizeRGBA(uint8_t* rgba, const uint8_t* template_rgb, const uint32_t colors[4]) {
+	Multipliers m;
+	buildMultipliers(colors, m);
+	getKernels().colorizeRGBA(rgba, template_rgb, m);
+}
@@ -0,0 +1,57 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#ifndef RME_SPRITE_KERNELS_H_
+#define RME_SPRITE_KERNELS_H_
+
+#include <cstdint>
+
+// Pixel kernels used by GameSprite to decompress .spr dumps and to apply
+// outfit colors to template sprites. Each kernel has a scalar reference
+// implementation and SSE2 / AVX2 variants that are picked at runtime
+// depending on what the CPU supports. All variants produce bit-identical output.
+namespace SpriteKernels {
+	enum InstructionSet {
+		ISA_SCALAR,
+		ISA_SSE2,
+		ISA_AVX2,
+	};
+
+	// Best instruction set supported by this CPU (detected once)
+	InstructionSet getSupportedInstructionSet();
+	// Instruction set currently used by the kernels
+	InstructionSet getInstructionSet();
+	// Forces a specific instruction set, clamped to what the CPU supports.
+	// tools/sprite_kernel_check uses it to compare every variant.
+	void setInstructionSet(InstructionSet isa);
+	const char* getInstructionSetName(InstructionSet isa);
+
+	// Decompresses a sprite dump into SPRITE_PIXELS_SIZE RGB pixels,
+	// transparent pixels are written as magenta (0xFF00FF).
+	void decodeRGB(const uint8_t* dump, int size, bool has_alpha, uint8_t* out);
+	// Decompresses a sprite dump into SPRITE_PIXELS_SIZE RGBA pixels,
+	// transparent pixels are written as 0x00000000.
+	void decodeRGBA(const uint8_t* dump, int size, bool has_alpha, uint8_t* out);
+
+	// Multiplies the pixels masked by the template (yellow = head, red = body,
+	// green = legs, blue = feet) with the given 0xRRGGBB outfit colors.
+	// template_rgb is always a decoded RGB sprite.
+	void colorizeRGB(uint8_t* rgb, const uint8_t* template_rgb, const uint32_t colors[4]);
+	void colorizeRGBA(uint8_t* rgba, const uint8_t* template_rgb, const uint32_t colors[4]);
+}
+
+#endif
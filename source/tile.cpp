@@ -30,6 +30,7 @@
 #include "table_brush.h"
 #include "town.h"
 #include "map.h"
+#include "trace.h"
 
 static thread_local std::set<Position> wallize_processing_tiles;
 
@@ -58,21 +59,6 @@ Tile::Tile(TileLocation& loc) :
 }
 
 Tile::~Tile() {
-	bool had_items = !items.empty();
-	bool had_ground = ground != nullptr;
-	
-#ifdef __WXDEBUG__
-	if (had_ground) {
-		// Store ground info before deleting it
-		uint16_t ground_id = ground->getID();
-		void* ground_ptr = ground;
-		printf("DEBUG: Tile destructor for %p with ground %p (ID:%d)\n", this, ground_ptr, ground_id);
-		
-		// Get call stack info by adding a breakpoint variable
-		int debug_breakpoint_for_ground_deletion = 1;
-	}
-#endif
-
 	while (!items.empty()) {
 		delete items.back();
 		items.pop_back();
@@ -80,12 +66,6 @@ Tile::~Tile() {
 	delete creature;
 	delete ground;
 	delete spawn;
-	
-#ifdef __WXDEBUG__
-	if (had_ground) {
-		printf("DEBUG: Ground %p deleted\n", ground);
-	}
-#endif
 }
 
 Tile* Tile::deepCopy(BaseMap& map) {
@@ -93,11 +73,6 @@ Tile* Tile::deepCopy(BaseMap& map) {
 	copy->flags = flags;
 	copy->house_id = house_id;
 	
-#ifdef __WXDEBUG__
-	printf("DEBUG: deepCopy - Creating copy of tile %p (with ground %p)\n", 
-		this, ground);
-#endif
-	
 	if (spawn) {
 		copy->spawn = spawn->deepCopy();
 	}
@@ -106,15 +81,7 @@ Tile* Tile::deepCopy(BaseMap& map) {
 	}
 	// Spawncount & exits are not transferred on copy!
 	if (ground) {
-#ifdef __WXDEBUG__
-		printf("DEBUG: deepCopy - Copying ground %p with ID %d\n", 
-			ground, ground->getID());
-#endif
 		copy->ground = ground->deepCopy();
-#ifdef __WXDEBUG__
-		printf("DEBUG: deepCopy - Ground copied to %p with ID %d\n", 
-			copy->ground, copy->ground->getID());
-#endif
 	}
 
 	copy->setZoneIds(this);
@@ -127,10 +94,7 @@ Tile* Tile::deepCopy(BaseMap& map) {
 		++it;
 	}
 
-#ifdef __WXDEBUG__
-	printf("DEBUG: deepCopy - Created tile copy %p (with ground %p)\n", 
-		copy, copy->ground);
-#endif
+	TRACE_DEBUG(Map, "deepCopy - Created tile copy %p (with ground %p)", copy, copy->ground);
 
 	return copy;
 }
@@ -297,10 +261,7 @@ void Tile::addItem(Item* item) {
 	
 	// Handle ground tiles
 	if (item->isGroundTile()) {
-#ifdef __WXDEBUG__
-		printf("DEBUG: Adding ground tile ID %d to position %d,%d,%d\n", 
-			item->getID(), getPosition().x, getPosition().y, getPosition().z);
-#endif
+		TRACE_DEBUG(Map, "Adding ground tile ID %d to position %d,%d,%d", item->getID(), getPosition().x, getPosition().y, getPosition().z);
 		// Always delete the existing ground first
 		delete ground;
 		ground = item;
@@ -310,9 +271,7 @@ void Tile::addItem(Item* item) {
 		ItemVector::iterator it = items.begin();
 		while (it != items.end()) {
 			if ((*it)->isGroundTile() || (*it)->getGroundEquivalent() != 0) {
-#ifdef __WXDEBUG__
-				printf("DEBUG: Removing misplaced ground item with ID %d from tile items\n", (*it)->getID());
-#endif
+				TRACE_DEBUG(Map, "Removing misplaced ground item with ID %d from tile items", (*it)->getID());
 				delete *it;
 				it = items.erase(it);
 			} else {
@@ -550,10 +509,7 @@ void Tile::validateZoneConsistency() {
 	// CRITICAL FIX: Additional safety check for empty tiles with zones
 	// If the tile is completely empty but has zone data, clear zones to prevent crashes
 	if (zoneIds.size() > 0 && empty() && !ground) {
-		char debug_msg[256];
-		sprintf(debug_msg, "DEBUG DRAG: WARNING! Empty tile at (%d,%d,%d) has %zu zones - clearing to prevent crashes\n", 
-			getPosition().x, getPosition().y, getPosition().z, zoneIds.size());
-		OutputDebugStringA(debug_msg);
+		TRACE_WARNING(Map, "Empty tile at (%d,%d,%d) has %zu zones - clearing to prevent crashes", getPosition().x, getPosition().y, getPosition().z, zoneIds.size());
 		
 		clearZoneId();
 	}
@@ -633,26 +589,19 @@ void Tile::update() {
 
 void Tile::borderize(BaseMap* parent) {
 	if (!ground) {
-		OutputDebugStringA("DEBUG DRAG: borderize called on tile with no ground, skipping\n");
+		TRACE_DEBUG(Autoborder, "borderize called on tile with no ground, skipping");
 		return;
 	}
 	// Add debugging output for borderize operation
-	char debug_msg[512];
-	sprintf(debug_msg, "DEBUG DRAG: borderize called on tile at pos=(%d,%d,%d), SAME_GROUND_TYPE_BORDER=%d\n", 
-		getPosition().x, getPosition().y, getPosition().z, g_settings.getBoolean(Config::SAME_GROUND_TYPE_BORDER));
-	OutputDebugStringA(debug_msg);
+	TRACE_DEBUG(Autoborder, "borderize called on tile at pos=(%d,%d,%d), SAME_GROUND_TYPE_BORDER=%d", getPosition().x, getPosition().y, getPosition().z, g_settings.getBoolean(Config::SAME_GROUND_TYPE_BORDER));
 	
 	if (g_settings.getBoolean(Config::SAME_GROUND_TYPE_BORDER)) {
 		// Use the custom reborderize method for better border placement
-		sprintf(debug_msg, "DEBUG DRAG: Calling GroundBrush::reborderizeTile for tile at pos=(%d,%d,%d)\n", 
-			getPosition().x, getPosition().y, getPosition().z);
-		OutputDebugStringA(debug_msg);
+		TRACE_DEBUG(Autoborder, "Calling GroundBrush::reborderizeTile for tile at pos=(%d,%d,%d)", getPosition().x, getPosition().y, getPosition().z);
 		GroundBrush::reborderizeTile(parent, this);
 	} else {
 		// Standard border handling
-		sprintf(debug_msg, "DEBUG DRAG: Calling GroundBrush::doBorders for tile at pos=(%d,%d,%d)\n", 
-			getPosition().x, getPosition().y, getPosition().z);
-		OutputDebugStringA(debug_msg);
+		TRACE_DEBUG(Autoborder, "Calling GroundBrush::doBorders for tile at pos=(%d,%d,%d)", getPosition().x, getPosition().y, getPosition().z);
 		GroundBrush::doBorders(parent, this);
 	}
 }
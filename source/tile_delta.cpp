@@ -0,0 +1,494 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+
+#include "main.h"
+
+#include "tile_delta.h"
+#include "basemap.h"
+#include "tile.h"
+#include "item.h"
+#include "creature.h"
+#include "spawn.h"
+#include "iomap_otbm.h"
+#include "filehandle.h"
+
+#include <cstring>
+#include <typeinfo>
+
+namespace {
+	enum : uint8_t {
+		HAS_SPAWN = 1 << 0,
+		HAS_CREATURE = 1 << 1,
+		HAS_GROUND = 1 << 2,
+	};
+
+	enum : uint8_t {
+		// Followed by the index in the base tile (ground first), the item id
+		// and its subtype
+		ITEM_SHARED,
+		// Followed by the item pointer, owned by the delta
+		ITEM_OWNED,
+	};
+
+	class Writer {
+	public:
+		explicit Writer(std::vector<uint8_t>& buffer) :
+			buffer(buffer) { }
+
+		template <typename T>
+		void add(const T& value) {
+			const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+			buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+		}
+
+	private:
+		std::vector<uint8_t>& buffer;
+	};
+
+	class Reader {
+	public:
+		explicit Reader(const uint8_t* data) :
+			data(data) { }
+
+		template <typename T>
+		T get() {
+			T value;
+			std::memcpy(&value, data, sizeof(T));
+			data += sizeof(T);
+			return value;
+		}
+
+	private:
+		const uint8_t* data;
+	};
+
+	// Items that are rebuilt from a copy of the base item, the copy has to be
+	// identical so only plain items without attributes qualify
+	bool isShareable(const Item* item) {
+		return typeid(*item) == typeid(Item) && !item->isComplex();
+	}
+
+	bool isSameItem(const Item* a, const Item* b) {
+		return a->getID() == b->getID() && a->getSubtype() == b->getSubtype() && a->isSelected() == b->isSelected() && isShareable(b);
+	}
+
+	// The base tile as one list, ground first
+	Item* getBaseItem(const Tile* base, size_t index) {
+		if (base->ground) {
+			if (index == 0) {
+				return base->ground;
+			}
+			--index;
+		}
+		return index < base->items.size() ? base->items[index] : nullptr;
+	}
+
+	void addItem(Writer& writer, Item* item, const Tile* base, size_t hint) {
+		if (base && isShareable(item)) {
+			const size_t count = base->items.size() + (base->ground ? 1 : 0);
+			// Most edits keep the stack in place, try the same index first
+			for (size_t i = 0; i < count; ++i) {
+				const size_t index = (hint + i) % count;
+				if (isSameItem(item, getBaseItem(base, index))) {
+					writer.add(ITEM_SHARED);
+					writer.add(uint16_t(index));
+					writer.add(item->getID());
+					writer.add(item->getSubtype());
+					delete item;
+					return;
+				}
+			}
+		}
+		writer.add(ITEM_OWNED);
+		writer.add(item);
+	}
+
+	size_t getMemsize(const Item* item) {
+		return item->memsize();
+	}
+
+	size_t getMemsize(const Spawn*) {
+		return sizeof(Spawn);
+	}
+
+	size_t getMemsize(const Creature*) {
+		return sizeof(Creature);
+	}
+
+	// Calls visit with every spawn, creature and item pointer of the buffer
+	template <typename Visit>
+	void forEachOwned(const uint8_t* data, Visit& visit) {
+		Reader reader(data);
+		reader.get<uint16_t>();
+		reader.get<uint16_t>();
+		reader.get<uint32_t>();
+		for (uint16_t zones = reader.get<uint16_t>(); zones > 0; --zones) {
+			reader.get<uint16_t>();
+		}
+
+		const uint8_t contents = reader.get<uint8_t>();
+		if (contents & HAS_SPAWN) {
+			visit(reader.get<Spawn*>());
+		}
+		if (contents & HAS_CREATURE) {
+			visit(reader.get<Creature*>());
+		}
+
+		size_t count = reader.get<uint16_t>() + ((contents & HAS_GROUND) ? 1 : 0);
+		for (; count > 0; --count) {
+			if (reader.get<uint8_t>() == ITEM_OWNED) {
+				visit(reader.get<Item*>());
+			} else {
+				reader.get<uint16_t>();
+				reader.get<uint16_t>();
+				reader.get<uint16_t>();
+			}
+		}
+	}
+
+	// Item nodes of the spill file, the selection is not part of the OTBM data
+	Item* readItemNode(const IOMap& iomap, BinaryNode* node, bool selected) {
+		uint8_t type;
+		if (!node || !node->getByte(type) || type != OTBM_ITEM) {
+			return nullptr;
+		}
+		Item* item = Item::Create_OTBM(iomap, node);
+		if (item && !item->unserializeItemNode_OTBM(iomap, node)) {
+			delete item;
+			return nullptr;
+		}
+		if (item && selected) {
+			item->select();
+		}
+		return item;
+	}
+
+	Item* readItem(Reader& reader, const Tile* base) {
+		if (reader.get<uint8_t>() == ITEM_OWNED) {
+			return reader.get<Item*>();
+		}
+		const uint16_t index = reader.get<uint16_t>();
+		const uint16_t id = reader.get<uint16_t>();
+		const uint16_t subtype = reader.get<uint16_t>();
+		Item* item = base ? getBaseItem(base, index) : nullptr;
+		if (item && item->getID() == id && item->getSubtype() == subtype) {
+			return item->deepCopy();
+		}
+		// The map was changed behind the history's back, shared items are
+		// plain so the id and subtype are all there is to restore
+		return Item::Create(id, subtype);
+	}
+}
+
+TileDelta::TileDelta(const Position& position, std::vector<uint8_t>& buffer) :
+	position(position),
+	size(uint32_t(buffer.size())),
+	data(newd uint8_t[buffer.size()]) {
+	std::memcpy(data.get(), buffer.data(), buffer.size());
+}
+
+TileDelta::~TileDelta() {
+	clear();
+}
+
+TileDelta* TileDelta::Create(Tile* tile, const Tile* base) {
+	ASSERT(tile);
+
+	std::vector<uint8_t> buffer;
+	Writer writer(buffer);
+	writer.add(tile->getMapFlags());
+	writer.add(tile->getStatFlags());
+	writer.add(tile->house_id);
+
+	const std::vector<uint16_t>& zones = tile->getZoneIds();
+	writer.add(uint16_t(zones.size()));
+	for (uint16_t zone : zones) {
+		writer.add(zone);
+	}
+
+	writer.add(uint8_t((tile->spawn ? HAS_SPAWN : 0) | (tile->creature ? HAS_CREATURE : 0) | (tile->ground ? HAS_GROUND : 0)));
+	if (tile->spawn) {
+		writer.add(tile->spawn);
+	}
+	if (tile->creature) {
+		writer.add(tile->creature);
+	}
+
+	writer.add(uint16_t(tile->items.size()));
+	size_t index = 0;
+	if (tile->ground) {
+		addItem(writer, tile->ground, base, index++);
+	}
+	for (Item* item : tile->items) {
+		addItem(writer, item, base, index++);
+	}
+
+	const Position position = tile->getPosition();
+	// Everything has been moved into the buffer or deleted
+	tile->ground = nullptr;
+	tile->items.clear();
+	tile->spawn = nullptr;
+	tile->creature = nullptr;
+	delete tile;
+
+	return newd TileDelta(position, buffer);
+}
+
+Tile* TileDelta::createTile(BaseMap& map) {
+	ASSERT(data);
+
+	const Tile* base = map.getTile(position);
+	TileLocation* location = map.createTileL(position);
+	Tile* tile = map.allocator(location);
+
+	Reader reader(data.get());
+	tile->setMapFlags(reader.get<uint16_t>());
+	tile->setStatFlags(reader.get<uint16_t>());
+	tile->house_id = reader.get<uint32_t>();
+
+	for (uint16_t zones = reader.get<uint16_t>(); zones > 0; --zones) {
+		tile->addZoneId(reader.get<uint16_t>());
+	}
+
+	const uint8_t contents = reader.get<uint8_t>();
+	if (contents & HAS_SPAWN) {
+		tile->spawn = reader.get<Spawn*>();
+	}
+	if (contents & HAS_CREATURE) {
+		tile->creature = reader.get<Creature*>();
+	}
+
+	uint16_t count = reader.get<uint16_t>();
+	if (contents & HAS_GROUND) {
+		tile->ground = readItem(reader, base);
+	}
+	tile->items.reserve(count);
+	for (; count > 0; --count) {
+		Item* item = readItem(reader, base);
+		if (item) {
+			tile->items.push_back(item);
+		}
+	}
+
+	// The owned objects now belong to the tile
+	data.reset();
+	size = 0;
+	return tile;
+}
+
+void TileDelta::clear() {
+	if (data) {
+		auto remove = [](auto* object) {
+			delete object;
+		};
+		forEachOwned(data.get(), remove);
+		data.reset();
+		size = 0;
+	}
+}
+
+size_t TileDelta::memsize() const {
+	size_t mem = sizeof(*this) + size;
+	if (data) {
+		// Owned objects still count in full
+		auto count = [&mem](auto* object) {
+			mem += getMemsize(object);
+		};
+		forEachOwned(data.get(), count);
+	}
+	return mem;
+}
+
+void TileDelta::serialize(const IOMap& iomap, NodeFileWriteHandle& writer) const {
+	ASSERT(data);
+
+	writer.addU16(position.x);
+	writer.addU16(position.y);
+	writer.addU8(position.z);
+
+	Reader reader(data.get());
+	writer.addU16(reader.get<uint16_t>());
+	writer.addU16(reader.get<uint16_t>());
+	writer.addU32(reader.get<uint32_t>());
+
+	const uint16_t zones = reader.get<uint16_t>();
+	writer.addU16(zones);
+	for (uint16_t i = 0; i < zones; ++i) {
+		writer.addU16(reader.get<uint16_t>());
+	}
+
+	const uint8_t contents = reader.get<uint8_t>();
+	writer.addU8(contents);
+	if (contents & HAS_SPAWN) {
+		const Spawn* spawn = reader.get<Spawn*>();
+		writer.addU32(uint32_t(spawn->getSize()));
+		writer.addU8(spawn->isSelected());
+	}
+	if (contents & HAS_CREATURE) {
+		const Creature* creature = reader.get<Creature*>();
+		writer.addString(creature->getName());
+		writer.addU32(uint32_t(creature->getSpawnTime()));
+		writer.addU8(uint8_t(creature->getDirection()));
+		writer.addU8(creature->isSelected());
+	}
+
+	const uint16_t items = reader.get<uint16_t>();
+	writer.addU16(items);
+
+	std::vector<const Item*> owned;
+	for (size_t count = items + ((contents & HAS_GROUND) ? 1 : 0); count > 0; --count) {
+		const uint8_t tag = reader.get<uint8_t>();
+		writer.addU8(tag);
+		if (tag == ITEM_OWNED) {
+			const Item* item = reader.get<Item*>();
+			writer.addU8(item->isSelected());
+			owned.push_back(item);
+		} else {
+			writer.addU16(reader.get<uint16_t>());
+			writer.addU16(reader.get<uint16_t>());
+			writer.addU16(reader.get<uint16_t>());
+		}
+	}
+
+	for (const Item* item : owned) {
+		item->serializeItemNode_OTBM(iomap, writer);
+	}
+}
+
+TileDelta* TileDelta::Unserialize(const IOMap& iomap, BinaryNode* node) {
+	uint16_t x, y;
+	uint8_t z;
+	uint16_t mapflags, statflags, zones;
+	uint32_t house_id;
+	if (!node->getU16(x) || !node->getU16(y) || !node->getU8(z) || !node->getU16(mapflags) || !node->getU16(statflags) || !node->getU32(house_id) || !node->getU16(zones)) {
+		return nullptr;
+	}
+
+	std::vector<uint8_t> buffer;
+	Writer writer(buffer);
+	writer.add(mapflags);
+	writer.add(statflags);
+	writer.add(house_id);
+	writer.add(zones);
+	for (uint16_t i = 0; i < zones; ++i) {
+		uint16_t zone;
+		if (!node->getU16(zone)) {
+			return nullptr;
+		}
+		writer.add(zone);
+	}
+
+	uint8_t contents;
+	if (!node->getU8(contents)) {
+		return nullptr;
+	}
+	writer.add(contents);
+
+	// Spawns, creatures and items are created last so nothing leaks on malformed data
+	uint32_t spawn_size = 0;
+	uint8_t spawn_selected = 0;
+	size_t spawn_offset = 0;
+	if (contents & HAS_SPAWN) {
+		if (!node->getU32(spawn_size) || !node->getU8(spawn_selected)) {
+			return nullptr;
+		}
+		spawn_offset = buffer.size();
+		writer.add(static_cast<Spawn*>(nullptr));
+	}
+
+	std::string creature_name;
+	uint32_t spawn_time = 0;
+	uint8_t direction = 0, creature_selected = 0;
+	size_t creature_offset = 0;
+	if (contents & HAS_CREATURE) {
+		if (!node->getString(creature_name) || !node->getU32(spawn_time) || !node->getU8(direction) || !node->getU8(creature_selected)) {
+			return nullptr;
+		}
+		creature_offset = buffer.size();
+		writer.add(static_cast<Creature*>(nullptr));
+	}
+
+	uint16_t items;
+	if (!node->getU16(items)) {
+		return nullptr;
+	}
+	writer.add(items);
+
+	struct OwnedItem {
+		size_t offset;
+		bool selected;
+	};
+	std::vector<OwnedItem> owned;
+	for (size_t count = items + ((contents & HAS_GROUND) ? 1 : 0); count > 0; --count) {
+		uint8_t tag;
+		if (!node->getU8(tag)) {
+			return nullptr;
+		}
+		writer.add(tag);
+		if (tag == ITEM_OWNED) {
+			uint8_t selected;
+			if (!node->getU8(selected)) {
+				return nullptr;
+			}
+			owned.push_back({ buffer.size(), selected != 0 });
+			writer.add(static_cast<Item*>(nullptr));
+		} else if (tag == ITEM_SHARED) {
+			uint16_t index, id, subtype;
+			if (!node->getU16(index) || !node->getU16(id) || !node->getU16(subtype)) {
+				return nullptr;
+			}
+			writer.add(index);
+			writer.add(id);
+			writer.add(subtype);
+		} else {
+			return nullptr;
+		}
+	}
+
+	TileDelta* delta = newd TileDelta(Position(x, y, z), buffer);
+	uint8_t* data = delta->data.get();
+	if (contents & HAS_SPAWN) {
+		Spawn* spawn = newd Spawn(int(spawn_size));
+		if (spawn_selected) {
+			spawn->select();
+		}
+		std::memcpy(data + spawn_offset, &spawn, sizeof(spawn));
+	}
+	if (contents & HAS_CREATURE) {
+		Creature* creature = newd Creature(creature_name);
+		creature->setSpawnTime(int(spawn_time));
+		creature->setDirection(Direction(direction));
+		if (creature_selected) {
+			creature->select();
+		}
+		std::memcpy(data + creature_offset, &creature, sizeof(creature));
+	}
+
+	BinaryNode* child = owned.empty() ? nullptr : node->getChild();
+	for (const OwnedItem& entry : owned) {
+		Item* item = readItemNode(iomap, child, entry.selected);
+		if (!item) {
+			// The remaining placeholders are still null, deleting them does nothing
+			delete delta;
+			return nullptr;
+		}
+		std::memcpy(data + entry.offset, &item, sizeof(item));
+		child = child->advance();
+	}
+	return delta;
+}
@@ -0,0 +1,78 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+
+#ifndef RME_TILE_DELTA_H_
+#define RME_TILE_DELTA_H_
+
+#include "position.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+class BaseMap;
+class Tile;
+class Item;
+class IOMap;
+class NodeFileWriteHandle;
+class BinaryNode;
+
+// A tile of the undo history stored as its differences to the tile at the
+// same position of the map. Plain items equal to one of the map tile are
+// referenced by index and copied back when the tile is rebuilt; everything
+// else (complex items, items with attributes, spawns and creatures) is kept
+// as it is, without copying. The record is packed into a single buffer.
+class TileDelta {
+public:
+	// Takes over the contents of tile and deletes it. base is the tile at the
+	// same position, the map must hold the same contents when rebuilding.
+	// Without a base everything is kept and the map is not looked at.
+	static TileDelta* Create(Tile* tile, const Tile* base);
+	// Reads a delta written by serialize, nullptr on malformed data
+	static TileDelta* Unserialize(const IOMap& iomap, BinaryNode* node);
+	~TileDelta();
+
+	TileDelta(const TileDelta&) = delete;
+	TileDelta& operator=(const TileDelta&) = delete;
+
+	const Position& getPosition() const {
+		return position;
+	}
+
+	// Rebuilds the tile from the tile now at its position, the delta is left
+	// empty and should be deleted afterwards
+	Tile* createTile(BaseMap& map);
+
+	size_t memsize() const;
+
+	// Writes the record as node properties followed by the owned items as
+	// OTBM item nodes, the delta keeps its contents
+	void serialize(const IOMap& iomap, NodeFileWriteHandle& writer) const;
+
+private:
+	TileDelta(const Position& position, std::vector<uint8_t>& buffer);
+
+	// Deletes the items, spawn and creature still owned by the buffer
+	void clear();
+
+	Position position;
+	uint32_t size;
+	std::unique_ptr<uint8_t[]> data;
+};
+
+#endif
@@ -0,0 +1,198 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+
+#include "main.h"
+
+#include "tile_processor.h"
+#include "editor.h"
+#include "action.h"
+#include "settings.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+namespace {
+	bool sameItems(const Tile* a, const Tile* b) {
+		if ((a->ground ? a->ground->getID() : 0) != (b->ground ? b->ground->getID() : 0)) {
+			return false;
+		}
+		if (a->items.size() != b->items.size()) {
+			return false;
+		}
+		for (size_t i = 0; i < a->items.size(); ++i) {
+			if (a->items[i]->getID() != b->items[i]->getID()) {
+				return false;
+			}
+		}
+		return true;
+	}
+}
+
+TileProcessor::TileProcessor(Editor& editor, Operation operation) :
+	editor(editor), operation(operation), select(false) {
+	////
+}
+
+void TileProcessor::addMap() {
+	for (int y = 0; y < MAP_MAX_HEIGHT; y += PartitionSize) {
+		for (int x = 0; x < MAP_MAX_WIDTH; x += PartitionSize) {
+			if (editor.map.getNode(x, y, PartitionSize)) {
+				partitions.push_back({ Position(x, y, 0), {} });
+			}
+		}
+	}
+}
+
+void TileProcessor::addSelection() {
+	select = true;
+
+	std::vector<Tile*> tiles(editor.selection.begin(), editor.selection.end());
+	auto blockOf = [](const Tile* tile) {
+		const Position& position = tile->getPosition();
+		return std::make_pair(position.y / PartitionSize, position.x / PartitionSize);
+	};
+	std::sort(tiles.begin(), tiles.end(), [&](const Tile* a, const Tile* b) {
+		const auto block_a = blockOf(a), block_b = blockOf(b);
+		if (block_a != block_b) {
+			return block_a < block_b;
+		}
+		return a->getPosition() < b->getPosition();
+	});
+
+	for (Tile* tile : tiles) {
+		const Position& position = tile->getPosition();
+		const Position block(position.x & ~(PartitionSize - 1), position.y & ~(PartitionSize - 1), 0);
+		if (partitions.empty() || partitions.back().block != block) {
+			partitions.push_back({ block, {} });
+		}
+		partitions.back().tiles.push_back(tile);
+	}
+}
+
+void TileProcessor::collectBlock(const Position& block, std::vector<Tile*>& tiles) const {
+	for (int leaf_y = block.y; leaf_y < block.y + PartitionSize; leaf_y += 4) {
+		for (int leaf_x = block.x; leaf_x < block.x + PartitionSize; leaf_x += 4) {
+			QTreeNode* leaf = editor.map.getLeaf(leaf_x, leaf_y);
+			if (!leaf) {
+				continue;
+			}
+			for (int z = 0; z <= MAP_MAX_LAYER; ++z) {
+				Floor* floor = leaf->getFloor(z);
+				if (!floor) {
+					continue;
+				}
+				for (TileLocation& location : floor->locs) {
+					if (Tile* tile = location.get()) {
+						tiles.push_back(tile);
+					}
+				}
+			}
+		}
+	}
+}
+
+Tile* TileProcessor::process(Tile* tile) const {
+	Tile* copy = tile->deepCopy(editor.map);
+	if (operation == BORDERIZE) {
+		copy->borderize(&editor.map);
+	} else {
+		copy->wallize(&editor.map);
+	}
+
+	if (sameItems(tile, copy)) {
+		delete copy;
+		return nullptr;
+	}
+	if (select) {
+		copy->select();
+	}
+	return copy;
+}
+
+size_t TileProcessor::run(const std::function<void(int)>& progress) {
+	if (partitions.empty()) {
+		return 0;
+	}
+
+	// Every block is seeded from its position so the brush variants placed do
+	// not depend on which thread picked the block up
+	const unsigned long seed = mt_randi();
+
+	std::vector<std::vector<Tile*>> results(partitions.size());
+	const int thread_count = std::max(1, std::min<int>(g_settings.getInteger(Config::WORKER_THREADS), partitions.size()));
+	std::atomic<size_t> next_partition(0);
+	std::atomic<size_t> partitions_done(0);
+	std::atomic<int> running(thread_count);
+	auto worker = [&]() {
+		std::vector<Tile*> block_tiles;
+		for (size_t i = next_partition++; i < partitions.size(); i = next_partition++) {
+			const Partition& partition = partitions[i];
+			mt_seed(seed ^ ((unsigned long)(partition.block.x / PartitionSize) << 16 | (unsigned long)(partition.block.y / PartitionSize)));
+
+			const std::vector<Tile*>* tiles = &partition.tiles;
+			if (tiles->empty()) {
+				block_tiles.clear();
+				collectBlock(partition.block, block_tiles);
+				tiles = &block_tiles;
+			}
+			for (Tile* tile : *tiles) {
+				if (Tile* copy = process(tile)) {
+					results[i].push_back(copy);
+				}
+			}
+			++partitions_done;
+		}
+		--running;
+	};
+
+	// The calling thread only waits, its own generator is left alone
+	std::vector<std::thread> threads;
+	for (int i = 0; i < thread_count; ++i) {
+		threads.emplace_back(worker);
+	}
+	if (progress) {
+		while (running > 0) {
+			progress(int(partitions_done * 100 / partitions.size()));
+			std::this_thread::sleep_for(std::chrono::milliseconds(100));
+		}
+	}
+	for (std::thread& thread : threads) {
+		thread.join();
+	}
+	partitions.clear();
+
+	size_t changed = 0;
+	for (const std::vector<Tile*>& result : results) {
+		changed += result.size();
+	}
+	if (changed == 0) {
+		return 0;
+	}
+
+	Action* action = editor.actionQueue->createAction(operation == BORDERIZE ? ACTION_BORDERIZE : ACTION_WALLIZE);
+	for (const std::vector<Tile*>& result : results) {
+		for (Tile* copy : result) {
+			action->addChange(newd Change(copy));
+		}
+	}
+	editor.addAction(action);
+	editor.map.doChange();
+	return changed;
+}
@@ -0,0 +1,74 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+
+#ifndef RME_TILE_PROCESSOR_H_
+#define RME_TILE_PROCESSOR_H_
+
+#include "position.h"
+
+#include <functional>
+#include <vector>
+
+class Editor;
+class Tile;
+
+// Borderizes or wallizes many tiles at once. The tiles are partitioned into
+// blocks of PartitionSize x PartitionSize positions (all floors) and the
+// blocks are handed to worker threads. A worker processes copies of the tiles
+// of its block, reading the neighbours they look at (the one tile halo around
+// the block included) from the map, which is left untouched until every block
+// is done. The copies are then committed as a single action in block order,
+// so the outcome does not depend on the number of threads or their timing.
+class TileProcessor {
+public:
+	static constexpr int PartitionSize = 64;
+
+	enum Operation {
+		BORDERIZE,
+		WALLIZE,
+	};
+
+	TileProcessor(Editor& editor, Operation operation);
+
+	// Every tile of the map
+	void addMap();
+	// Every selected tile, the results are selected as a whole
+	void addSelection();
+
+	// Returns the number of tiles that changed, nothing is added to the undo
+	// queue if none did. progress is called on the calling thread with values
+	// from 0 to 100 while the workers run.
+	size_t run(const std::function<void(int)>& progress = nullptr);
+
+private:
+	struct Partition {
+		Position block;
+		// Empty when the whole block is processed
+		std::vector<Tile*> tiles;
+	};
+
+	void collectBlock(const Position& block, std::vector<Tile*>& tiles) const;
+	Tile* process(Tile* tile) const;
+
+	Editor& editor;
+	Operation operation;
+	bool select;
+	std::vector<Partition> partitions;
+};
+
+#endif
@@ -0,0 +1,204 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+
+#include "main.h"
+
+#include "trace.h"
+
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <thread>
+
+std::atomic<uint32_t> Trace::categories(0xFFFFFFFF);
+std::atomic<size_t> Trace::dropped(0);
+
+namespace {
+	// Bounded multi producer queue: a slot may be filled once its sequence
+	// equals the write position and read once it is one past it
+	struct Slot {
+		std::atomic<size_t> sequence;
+		int64_t time;
+		uint8_t level;
+		uint8_t category;
+		char text[Trace::MessageSize];
+	};
+
+	struct Ring {
+		Ring() :
+			head(0), tail(0), running(false) {
+			for (size_t i = 0; i < Trace::RingSize; ++i) {
+				slots[i].sequence.store(i, std::memory_order_relaxed);
+			}
+		}
+
+		Slot slots[Trace::RingSize];
+		std::atomic<size_t> head;
+		// Only touched by the writer
+		size_t tail;
+
+		std::atomic<bool> running;
+		std::thread writer;
+		std::ofstream file;
+	};
+
+	Ring& getRing() {
+		static Ring ring;
+		return ring;
+	}
+
+	const char* levelName(uint8_t level) {
+		switch (level) {
+			case Trace::LevelError:
+				return "error";
+			case Trace::LevelWarning:
+				return "warning";
+			case Trace::LevelInfo:
+				return "info";
+			default:
+				return "debug";
+		}
+	}
+
+	const char* categoryName(uint8_t category) {
+		static const char* names[Trace::CategoryCount] = {
+			"actions", "autoborder", "selection", "drawing", "map", "live"
+		};
+		return category < Trace::CategoryCount ? names[category] : "?";
+	}
+
+	void writeLine(Ring& ring, const Slot& slot) {
+		const time_t seconds = time_t(slot.time / 1000);
+		char stamp[32];
+		std::strftime(stamp, sizeof(stamp), "%Y-%m-%d %H:%M:%S", std::localtime(&seconds));
+
+		char line[Trace::MessageSize + 64];
+		std::snprintf(line, sizeof(line), "%s.%03d [%s] [%s] %s\n", stamp, int(slot.time % 1000), levelName(slot.level), categoryName(slot.category), slot.text);
+		if (ring.file.is_open()) {
+			ring.file << line;
+		}
+#ifdef __WINDOWS__
+		OutputDebugStringA(line);
+#endif
+	}
+
+	// Returns the number of messages written
+	size_t drain(Ring& ring) {
+		size_t count = 0;
+		for (;;) {
+			Slot& slot = ring.slots[ring.tail & (Trace::RingSize - 1)];
+			if (slot.sequence.load(std::memory_order_acquire) != ring.tail + 1) {
+				break;
+			}
+			writeLine(ring, slot);
+			slot.sequence.store(ring.tail + Trace::RingSize, std::memory_order_release);
+			++ring.tail;
+			++count;
+		}
+
+		static size_t reported_dropped = 0;
+		const size_t dropped = Trace::getDropped();
+		if (dropped != reported_dropped && ring.file.is_open()) {
+			ring.file << "... " << (dropped - reported_dropped) << " trace messages dropped\n";
+			reported_dropped = dropped;
+		}
+		if (count > 0) {
+			ring.file.flush();
+		}
+		return count;
+	}
+}
+
+void Trace::start(const std::string& filename) {
+	Ring& ring = getRing();
+	if (ring.running) {
+		return;
+	}
+
+	ring.file.open(filename, std::ios::out | std::ios::trunc);
+	ring.running = true;
+	ring.writer = std::thread([&ring]() {
+		while (ring.running) {
+			if (drain(ring) == 0) {
+				std::this_thread::sleep_for(std::chrono::milliseconds(50));
+			}
+		}
+		drain(ring);
+	});
+}
+
+void Trace::stop() {
+	Ring& ring = getRing();
+	if (!ring.running) {
+		return;
+	}
+
+	ring.running = false;
+	ring.writer.join();
+	ring.file.close();
+}
+
+void Trace::setEnabled(Category category, bool enabled) {
+	if (enabled) {
+		categories.fetch_or(1u << category, std::memory_order_relaxed);
+	} else {
+		categories.fetch_and(~(1u << category), std::memory_order_relaxed);
+	}
+}
+
+void Trace::write(Level level, Category category, const char* format, ...) {
+	Ring& ring = getRing();
+
+	size_t position = ring.head.load(std::memory_order_relaxed);
+	Slot* slot;
+	for (;;) {
+		slot = &ring.slots[position & (RingSize - 1)];
+		const size_t sequence = slot->sequence.load(std::memory_order_acquire);
+		if (sequence == position) {
+			if (ring.head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+				break;
+			}
+		} else if (sequence < position) {
+			// The writer has not caught up
+			dropped.fetch_add(1, std::memory_order_relaxed);
+			return;
+		} else {
+			position = ring.head.load(std::memory_order_relaxed);
+		}
+	}
+
+	slot->time = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+	slot->level = uint8_t(level);
+	slot->category = uint8_t(category);
+
+	va_list arguments;
+	va_start(arguments, format);
+	std::vsnprintf(slot->text, MessageSize, format, arguments);
+	va_end(arguments);
+
+	// Messages end up one per line
+	for (char* c = slot->text; *c; ++c) {
+		if (*c == '\n' || *c == '\r') {
+			*c = (c[1] == '\0') ? '\0' : ' ';
+		}
+	}
+
+	slot->sequence.store(position + 1, std::memory_order_release);
+}
@@ -0,0 +1,132 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+
+#ifndef RME_TRACE_H_
+#define RME_TRACE_H_
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// Levels compiled into the editor. Trace calls above RME_TRACE_LEVEL are
+// removed by the preprocessor, arguments included, so they cost nothing in
+// release builds.
+#define RME_TRACE_LEVEL_NONE 0
+#define RME_TRACE_LEVEL_ERROR 1
+#define RME_TRACE_LEVEL_WARNING 2
+#define RME_TRACE_LEVEL_INFO 3
+#define RME_TRACE_LEVEL_DEBUG 4
+
+#ifndef RME_TRACE_LEVEL
+	#ifdef __DEBUG__
+		#define RME_TRACE_LEVEL RME_TRACE_LEVEL_DEBUG
+	#else
+		#define RME_TRACE_LEVEL RME_TRACE_LEVEL_WARNING
+	#endif
+#endif
+
+// Trace messages of the editor. Callers format their message into a slot of a
+// fixed size ring buffer without taking a lock, a background thread writes
+// the slots to the trace file. Messages are dropped (and counted) when the
+// ring is full, tracing never blocks the caller.
+// Every category can be switched off at runtime (Config::TRACE_CATEGORIES).
+class Trace {
+public:
+	enum Level {
+		LevelError = RME_TRACE_LEVEL_ERROR,
+		LevelWarning = RME_TRACE_LEVEL_WARNING,
+		LevelInfo = RME_TRACE_LEVEL_INFO,
+		LevelDebug = RME_TRACE_LEVEL_DEBUG,
+	};
+
+	enum Category {
+		Actions,
+		Autoborder,
+		Selection,
+		Drawing,
+		Map,
+		Live,
+
+		CategoryCount
+	};
+
+	static constexpr size_t MessageSize = 240;
+	static constexpr size_t RingSize = 2048;
+
+	// Starts the writer thread, messages traced before are written too
+	static void start(const std::string& filename);
+	// Writes what is left in the ring and stops the writer thread
+	static void stop();
+
+	static bool isEnabled(Category category) {
+		return (categories.load(std::memory_order_relaxed) >> category) & 1;
+	}
+	static void setEnabled(Category category, bool enabled);
+	// Bit n enables category n
+	static void setCategories(uint32_t mask) {
+		categories.store(mask, std::memory_order_relaxed);
+	}
+
+	// printf style, the message is cut at MessageSize
+	static void write(Level level, Category category, const char* format, ...)
+#ifdef __GNUC__
+		__attribute__((format(printf, 3, 4)))
+#endif
+		;
+
+	static size_t getDropped() {
+		return dropped.load(std::memory_order_relaxed);
+	}
+
+private:
+	static std::atomic<uint32_t> categories;
+	static std::atomic<size_t> dropped;
+};
+
+#define RME_TRACE(level, category, ...)                                     \
+	do {                                                                    \
+		if (Trace::isEnabled(Trace::category)) {                            \
+			Trace::write(Trace::level, Trace::category, __VA_ARGS__);      \
+		}                                                                   \
+	} while (false)
+
+#if RME_TRACE_LEVEL >= RME_TRACE_LEVEL_ERROR
+	#define TRACE_ERROR(category, ...) RME_TRACE(LevelError, category, __VA_ARGS__)
+#else
+	#define TRACE_ERROR(category, ...) ((void)0)
+#endif
+
+#if RME_TRACE_LEVEL >= RME_TRACE_LEVEL_WARNING
+	#define TRACE_WARNING(category, ...) RME_TRACE(LevelWarning, category, __VA_ARGS__)
+#else
+	#define TRACE_WARNING(category, ...) ((void)0)
+#endif
+
+#if RME_TRACE_LEVEL >= RME_TRACE_LEVEL_INFO
+	#define TRACE_INFO(category, ...) RME_TRACE(LevelInfo, category, __VA_ARGS__)
+#else
+	#define TRACE_INFO(category, ...) ((void)0)
+#endif
+
+#if RME_TRACE_LEVEL >= RME_TRACE_LEVEL_DEBUG
+	#define TRACE_DEBUG(category, ...) RME_TRACE(LevelDebug, category, __VA_ARGS__)
+#else
+	#define TRACE_DEBUG(category, ...) ((void)0)
+#endif
+
+#endif
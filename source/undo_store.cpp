@@ -0,0 +1,462 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+
+#include "main.h"
+
+#include "undo_store.h"
+#include "action.h"
+#include "editor.h"
+#include "selection.h"
+#include "tile.h"
+#include "tile_delta.h"
+#include "filehandle.h"
+
+#include <wx/mstream.h>
+#include <wx/zstream.h>
+
+#include <iterator>
+
+namespace {
+	enum : uint8_t {
+		NODE_ROOT,
+		NODE_ACTION,
+		NODE_CHANGE,
+	};
+
+	bool compress(const uint8_t* data, size_t size, std::vector<uint8_t>& out) {
+		wxMemoryOutputStream memory;
+		{
+			wxZlibOutputStream zlib(memory, wxZ_BEST_SPEED, wxZLIB_ZLIB);
+			if (zlib.Write(data, size).LastWrite() != size || !zlib.Close()) {
+				return false;
+			}
+		}
+		out.resize(memory.GetLength());
+		return memory.CopyTo(out.data(), out.size()) == out.size();
+	}
+
+	bool decompress(const std::vector<uint8_t>& data, std::vector<uint8_t>& out) {
+		wxMemoryInputStream memory(data.data(), data.size());
+		wxZlibInputStream zlib(memory, wxZLIB_ZLIB);
+		return zlib.Read(out.data(), out.size()).LastRead() == out.size();
+	}
+
+	void writePosition(NodeFileWriteHandle& writer, const Position& position) {
+		writer.addU16(position.x);
+		writer.addU16(position.y);
+		writer.addU8(position.z);
+	}
+
+	bool readPosition(BinaryNode* node, Position& position) {
+		uint16_t x, y;
+		uint8_t z;
+		if (!node->getU16(x) || !node->getU16(y) || !node->getU8(z)) {
+			return false;
+		}
+		position = Position(x, y, z);
+		return true;
+	}
+}
+
+UndoStore::UndoStore(Editor& editor) :
+	editor(editor),
+	iomap(MapVersion(MAP_OTBM_4, CLIENT_VERSION_NONE)),
+	file_end(0) {
+	////
+}
+
+UndoStore::~UndoStore() {
+	clear();
+}
+
+bool UndoStore::open() {
+	if (file.IsOpened()) {
+		return true;
+	}
+	filename = wxFileName::CreateTempFileName("rme_undo");
+	return !filename.empty() && file.Open(filename, wxFile::read_write);
+}
+
+uint64_t UndoStore::allocate(uint32_t size) {
+	for (auto it = holes.begin(); it != holes.end(); ++it) {
+		if (it->second >= size) {
+			const uint64_t offset = it->first;
+			const uint64_t remaining = it->second - size;
+			holes.erase(it);
+			if (remaining > 0) {
+				holes[offset + size] = remaining;
+			}
+			return offset;
+		}
+	}
+	const uint64_t offset = file_end;
+	file_end += size;
+	return offset;
+}
+
+void UndoStore::release(RecordMap::iterator it) {
+	const Record record = it->second;
+	stats.disk_size -= record.size;
+	stats.raw_size -= record.raw_size;
+	records.erase(it);
+	stats.batches = records.size();
+	freeRange(record.offset, record.size);
+}
+
+void UndoStore::freeRange(uint64_t offset, uint64_t size) {
+	auto next = holes.lower_bound(offset);
+	if (next != holes.end() && offset + size == next->first) {
+		size += next->second;
+		next = holes.erase(next);
+	}
+	if (next != holes.begin()) {
+		auto previous = std::prev(next);
+		if (previous->first + previous->second == offset) {
+			offset = previous->first;
+			size += previous->second;
+			holes.erase(previous);
+		}
+	}
+
+	if (offset + size == file_end) {
+		file_end = offset;
+	} else {
+		holes[offset] = size;
+	}
+	stats.file_size = file_end;
+}
+
+bool UndoStore::spill(BatchAction* batch, uint64_t max_disk_size) {
+	ASSERT(batch && !batch->spilled);
+	if (batch->batch.empty()) {
+		return false;
+	}
+
+	MemoryNodeFileWriteHandle writer;
+	writer.addNode(NODE_ROOT);
+	for (Action* action : batch->batch) {
+		writeAction(writer, action);
+	}
+	writer.endNode();
+
+	std::vector<uint8_t> data;
+	if (writer.getSize() > 0xFFFFFFFF || !compress(writer.getMemory(), writer.getSize(), data)) {
+		return false;
+	}
+	if (data.size() > 0xFFFFFFFF || stats.disk_size + data.size() > max_disk_size || !open()) {
+		return false;
+	}
+
+	Record record;
+	record.offset = allocate(uint32_t(data.size()));
+	record.size = uint32_t(data.size());
+	record.raw_size = uint32_t(writer.getSize());
+	if (file.Seek(wxFileOffset(record.offset)) == wxInvalidOffset || file.Write(data.data(), data.size()) != data.size()) {
+		freeRange(record.offset, record.size);
+		return false;
+	}
+
+	records[batch] = record;
+	stats.batches = records.size();
+	stats.disk_size += record.size;
+	stats.raw_size += record.raw_size;
+	stats.file_size = file_end;
+	++stats.spills;
+
+	for (Action* action : batch->batch) {
+		delete action;
+	}
+	batch->batch.clear();
+	batch->spilled = true;
+	return true;
+}
+
+bool UndoStore::reload(BatchAction* batch) {
+	ASSERT(batch && batch->spilled);
+	auto it = records.find(batch);
+	if (it == records.end()) {
+		return false;
+	}
+
+	const Record record = it->second;
+	release(it);
+	batch->spilled = false;
+
+	std::vector<uint8_t> data(record.size);
+	std::vector<uint8_t> raw(record.raw_size);
+	if (file.Seek(wxFileOffset(record.offset)) == wxInvalidOffset || file.Read(data.data(), data.size()) != ssize_t(data.size()) || !decompress(data, raw)) {
+		return false;
+	}
+
+	MemoryNodeFileReadHandle reader(raw.data(), raw.size());
+	BinaryNode* root = reader.getRootNode();
+	uint8_t type;
+	if (!root || !root->getByte(type) || type != NODE_ROOT) {
+		return false;
+	}
+
+	ActionVector actions;
+	BinaryNode* node = root->getChild();
+	while (node) {
+		Action* action = readAction(node);
+		if (!action) {
+			for (Action* loaded : actions) {
+				delete loaded;
+			}
+			return false;
+		}
+		actions.push_back(action);
+		node = node->advance();
+	}
+
+	batch->batch.swap(actions);
+	++stats.reloads;
+	return !batch->batch.empty();
+}
+
+void UndoStore::discard(BatchAction* batch) {
+	auto it = records.find(batch);
+	if (it != records.end()) {
+		release(it);
+	}
+	batch->spilled = false;
+}
+
+void UndoStore::clear() {
+	records.clear();
+	holes.clear();
+	file_end = 0;
+	if (file.IsOpened()) {
+		file.Close();
+		wxRemoveFile(filename);
+	}
+	stats.batches = 0;
+	stats.disk_size = 0;
+	stats.raw_size = 0;
+	stats.file_size = 0;
+}
+
+void UndoStore::writeAction(NodeFileWriteHandle& writer, Action* action) {
+	writer.addNode(NODE_ACTION);
+	writer.addU8(uint8_t(action->type));
+	writer.addU8(action->commited);
+	for (Change* change : action->changes) {
+		writer.addNode(NODE_CHANGE);
+		writeChange(writer, change);
+		writer.endNode();
+	}
+	writer.endNode();
+}
+
+void UndoStore::writeChange(NodeFileWriteHandle& writer, Change* change) {
+	if (change->type == CHANGE_TILE) {
+		// Stored the same way as a delta without a base, the action unpacks
+		// it again if the batch stays in memory after all
+		change->data = TileDelta::Create(reinterpret_cast<Tile*>(change->data), nullptr);
+		change->type = CHANGE_TILE_DELTA;
+	}
+
+	writer.addU8(uint8_t(change->type));
+	switch (change->type) {
+		case CHANGE_TILE_DELTA:
+			reinterpret_cast<TileDelta*>(change->data)->serialize(iomap, writer);
+			break;
+		case CHANGE_MOVE_HOUSE_EXIT: {
+			auto* exit = reinterpret_cast<std::pair<uint32_t, Position>*>(change->data);
+			writer.addU32(exit->first);
+			writePosition(writer, exit->second);
+			break;
+		}
+		case CHANGE_MOVE_WAYPOINT: {
+			auto* waypoint = reinterpret_cast<std::pair<std::string, Position>*>(change->data);
+			writer.addString(waypoint->first);
+			writePosition(writer, waypoint->second);
+			break;
+		}
+		case CHANGE_ITEM_IDS: {
+			auto* items = reinterpret_cast<ItemIdChangeList*>(change->data);
+			writer.addU32(uint32_t(items->size()));
+			for (const ItemIdChange& item : *items) {
+				writePosition(writer, item.position);
+				writer.addU32(item.index);
+				writer.addU16(item.from);
+				writer.addU16(item.to);
+			}
+			break;
+		}
+		case CHANGE_SELECTION:
+			reinterpret_cast<SelectionChangeList*>(change->data)->serialize(writer);
+			break;
+		case CHANGE_MOVE_TILES: {
+			auto* moves = reinterpret_cast<TileMoveList*>(change->data);
+			writer.addU16(uint16_t(int16_t(moves->offset.x)));
+			writer.addU16(uint16_t(int16_t(moves->offset.y)));
+			writer.addU8(uint8_t(int8_t(moves->offset.z)));
+			writer.addU32(uint32_t(moves->sources.size()));
+			for (const Position& source : moves->sources) {
+				writePosition(writer, source);
+			}
+			// Replaced tiles as child nodes, stored like tile changes. They are
+			// written from copies, the list keeps its tiles in case the spill
+			// fails and the batch stays in memory.
+			for (const auto& entry : moves->displaced) {
+				writer.addNode(NODE_CHANGE);
+				writer.addU32(entry.first);
+				TileDelta* delta = TileDelta::Create(entry.second->deepCopy(editor.map), nullptr);
+				delta->serialize(iomap, writer);
+				delete delta;
+				writer.endNode();
+			}
+			break;
+		}
+		default:
+			break;
+	}
+}
+
+Action* UndoStore::readAction(BinaryNode* node) {
+	uint8_t type, ident, commited;
+	if (!node->getByte(type) || type != NODE_ACTION || !node->getU8(ident) || !node->getU8(commited)) {
+		return nullptr;
+	}
+
+	Action* action = editor.actionQueue->createAction(ActionIdentifier(ident));
+	action->commited = commited != 0;
+	BinaryNode* child = node->getChild();
+	while (child) {
+		Change* change = readChange(child);
+		if (!change) {
+			delete action;
+			return nullptr;
+		}
+		action->changes.push_back(change);
+		child = child->advance();
+	}
+	return action;
+}
+
+Change* UndoStore::readChange(BinaryNode* node) {
+	uint8_t type, change_type;
+	if (!node->getByte(type) || type != NODE_CHANGE || !node->getU8(change_type)) {
+		return nullptr;
+	}
+
+	Change* change = newd Change();
+	switch (change_type) {
+		case CHANGE_TILE_DELTA: {
+			TileDelta* delta = TileDelta::Unserialize(iomap, node);
+			if (!delta) {
+				break;
+			}
+			change->type = CHANGE_TILE_DELTA;
+			change->data = delta;
+			return change;
+		}
+		case CHANGE_MOVE_HOUSE_EXIT: {
+			auto* exit = newd std::pair<uint32_t, Position>();
+			change->type = CHANGE_MOVE_HOUSE_EXIT;
+			change->data = exit;
+			if (!node->getU32(exit->first) || !readPosition(node, exit->second)) {
+				break;
+			}
+			return change;
+		}
+		case CHANGE_MOVE_WAYPOINT: {
+			auto* waypoint = newd std::pair<std::string, Position>();
+			change->type = CHANGE_MOVE_WAYPOINT;
+			change->data = waypoint;
+			if (!node->getString(waypoint->first) || !readPosition(node, waypoint->second)) {
+				break;
+			}
+			return change;
+		}
+		case CHANGE_ITEM_IDS: {
+			auto* items = newd ItemIdChangeList();
+			change->type = CHANGE_ITEM_IDS;
+			change->data = items;
+			uint32_t count;
+			if (!node->getU32(count)) {
+				break;
+			}
+			items->resize(count);
+			bool ok = true;
+			for (ItemIdChange& item : *items) {
+				if (!readPosition(node, item.position) || !node->getU32(item.index) || !node->getU16(item.from) || !node->getU16(item.to)) {
+					ok = false;
+					break;
+				}
+			}
+			if (!ok) {
+				break;
+			}
+			return change;
+		}
+		case CHANGE_SELECTION: {
+			auto* selection = newd SelectionChangeList();
+			change->type = CHANGE_SELECTION;
+			change->data = selection;
+			if (!selection->unserialize(node)) {
+				break;
+			}
+			return change;
+		}
+		case CHANGE_MOVE_TILES: {
+			auto* moves = newd TileMoveList();
+			change->type = CHANGE_MOVE_TILES;
+			change->data = moves;
+			uint16_t x, y;
+			uint8_t z;
+			uint32_t count;
+			if (!node->getU16(x) || !node->getU16(y) || !node->getU8(z) || !node->getU32(count)) {
+				break;
+			}
+			moves->offset = Position(int16_t(x), int16_t(y), int8_t(z));
+			moves->sources.resize(count);
+			bool ok = true;
+			for (Position& source : moves->sources) {
+				if (!readPosition(node, source)) {
+					ok = false;
+					break;
+				}
+			}
+			BinaryNode* child = ok ? node->getChild() : nullptr;
+			while (child) {
+				uint8_t child_type;
+				uint32_t index;
+				TileDelta* delta = nullptr;
+				if (!child->getByte(child_type) || child_type != NODE_CHANGE || !child->getU32(index) || index >= count || !(delta = TileDelta::Unserialize(iomap, child))) {
+					ok = false;
+					break;
+				}
+				moves->displaced.emplace_back(index, delta->createTile(editor.map));
+				delete delta;
+				child = child->advance();
+			}
+			if (!ok) {
+				break;
+			}
+			return change;
+		}
+		case CHANGE_NONE:
+			return change;
+		default:
+			break;
+	}
+	delete change;
+	return nullptr;
+}
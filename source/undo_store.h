@@ -0,0 +1,109 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+
+#ifndef RME_UNDO_STORE_H_
+#define RME_UNDO_STORE_H_
+
+#include "iomap.h"
+
+#include <wx/file.h>
+
+#include <cstdint>
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+class Editor;
+class Action;
+class Change;
+class BatchAction;
+class BinaryNode;
+class NodeFileWriteHandle;
+
+// The part of the undo history moved out of memory. A spilled batch keeps its
+// place in the ActionQueue but its actions are serialised (tiles as OTBM item
+// nodes), compressed into a temporary spill file and deleted. reload()
+// recreates them before the batch is undone or redone.
+class UndoStore {
+public:
+	struct Statistics {
+		// Batches currently in the spill file and their size there
+		size_t batches = 0;
+		uint64_t disk_size = 0;
+		uint64_t raw_size = 0;
+		// Size of the spill file, including space freed by discarded batches
+		uint64_t file_size = 0;
+		// Since the editor was opened
+		size_t spills = 0;
+		size_t reloads = 0;
+	};
+
+	explicit UndoStore(Editor& editor);
+	~UndoStore();
+
+	UndoStore(const UndoStore&) = delete;
+	UndoStore& operator=(const UndoStore&) = delete;
+
+	// Moves the actions of batch to the spill file. Returns false when the
+	// spill file would grow beyond max_disk_size or could not be written, the
+	// batch is left in memory then.
+	bool spill(BatchAction* batch, uint64_t max_disk_size);
+	// Recreates the actions of a spilled batch, returns false if its record
+	// could not be read back. The record is dropped either way.
+	bool reload(BatchAction* batch);
+	// Drops the record of a spilled batch that is deleted
+	void discard(BatchAction* batch);
+	// Drops every record and removes the spill file
+	void clear();
+
+	const Statistics& getStatistics() const {
+		return stats;
+	}
+
+private:
+	struct Record {
+		uint64_t offset;
+		uint32_t size;
+		uint32_t raw_size;
+	};
+	typedef std::unordered_map<const BatchAction*, Record> RecordMap;
+
+	bool open();
+	uint64_t allocate(uint32_t size);
+	void release(RecordMap::iterator it);
+	// Returns a range of the spill file to the holes
+	void freeRange(uint64_t offset, uint64_t size);
+
+	void writeAction(NodeFileWriteHandle& writer, Action* action);
+	void writeChange(NodeFileWriteHandle& writer, Change* change);
+	Action* readAction(BinaryNode* node);
+	Change* readChange(BinaryNode* node);
+
+	Editor& editor;
+	VirtualIOMap iomap;
+
+	wxString filename;
+	wxFile file;
+	uint64_t file_end;
+	// Unused ranges of the spill file by offset, merged with their neighbours
+	std::map<uint64_t, uint64_t> holes;
+	RecordMap records;
+	Statistics stats;
+};
+
+#endif
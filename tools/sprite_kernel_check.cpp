@@ -0,0 +1,441 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+// Checks every SpriteKernels instruction set the CPU supports against the
+// per-pixel code GameSprite used before the kernels, byte for byte, and
+// optionally times them. Built with -DRME_BUILD_SPRITE_KERNEL_CHECK=ON.
+//
+// Usage: sprite_kernel_check [--bench [iterations]] [--spr file [--extended] [--alpha]]
+//
+// Without --spr the sprites are generated from a fixed seed.
+
+#include "main.h"
+
+#include "sprite_kernels.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+
+namespace {
+	const int RGB_SIZE = SPRITE_PIXELS_SIZE * 3;
+	const int RGBA_SIZE = SPRITE_PIXELS_SIZE * 4;
+
+	struct Sprite {
+		std::vector<uint8_t> dump;
+		bool has_alpha;
+	};
+
+	// ========================================================================
+	// Reference code, as GameSprite had it before the kernels
+
+	void referenceDecodeRGB(const uint8_t* dump, int size, bool has_alpha, uint8_t* data) {
+		const int pixels_data_size = SPRITE_PIXELS * SPRITE_PIXELS * 3;
+		uint8_t bpp = has_alpha ? 4 : 3;
+		int write = 0;
+		int read = 0;
+
+		// decompress pixels
+		while (read < size && write < pixels_data_size) {
+			int transparent = dump[read] | dump[read + 1] << 8;
+			read += 2;
+			for (int i = 0; i < transparent && write < pixels_data_size; i++) {
+				data[write + 0] = 0xFF; // red
+				data[write + 1] = 0x00; // green
+				data[write + 2] = 0xFF; // blue
+				write += 3;
+			}
+
+			int colored = dump[read] | dump[read + 1] << 8;
+			read += 2;
+			for (int i = 0; i < colored && write < pixels_data_size; i++) {
+				data[write + 0] = dump[read + 0]; // red
+				data[write + 1] = dump[read + 1]; // green
+				data[write + 2] = dump[read + 2]; // blue
+				write += 3;
+				read += bpp;
+			}
+		}
+
+		// fill remaining pixels
+		while (write < pixels_data_size) {
+			data[write + 0] = 0xFF; // red
+			data[write + 1] = 0x00; // green
+			data[write + 2] = 0xFF; // blue
+			write += 3;
+		}
+	}
+
+	void referenceDecodeRGBA(const uint8_t* dump, int size, bool use_alpha, uint8_t* data) {
+		const int pixels_data_size = SPRITE_PIXELS_SIZE * 4;
+		uint8_t bpp = use_alpha ? 4 : 3;
+		int write = 0;
+		int read = 0;
+
+		// decompress pixels
+		while (read < size && write < pixels_data_size) {
+			int transparent = dump[read] | dump[read + 1] << 8;
+			if (use_alpha && transparent >= SPRITE_PIXELS_SIZE) { // Corrupted sprite?
+				break;
+			}
+			read += 2;
+			for (int i = 0; i < transparent && write < pixels_data_size; i++) {
+				data[write + 0] = 0x00; // red
+				data[write + 1] = 0x00; // green
+				data[write + 2] = 0x00; // blue
+				data[write + 3] = 0x00; // alpha
+				write += 4;
+			}
+
+			int colored = dump[read] | dump[read + 1] << 8;
+			read += 2;
+			for (int i = 0; i < colored && write < pixels_data_size; i++) {
+				data[write + 0] = dump[read + 0]; // red
+				data[write + 1] = dump[read + 1]; // green
+				data[write + 2] = dump[read + 2]; // blue
+				data[write + 3] = use_alpha ? dump[read + 3] : 0xFF; // alpha
+				write += 4;
+				read += bpp;
+			}
+		}
+
+		// fill remaining pixels
+		while (write < pixels_data_size) {
+			data[write + 0] = 0x00; // red
+			data[write + 1] = 0x00; // green
+			data[write + 2] = 0x00; // blue
+			data[write + 3] = 0x00; // alpha
+			write += 4;
+		}
+	}
+
+	void referenceColorizePixel(uint32_t color, uint8_t& red, uint8_t& green, uint8_t& blue) {
+		uint8_t ro = (color & 0xFF0000) >> 16; // rgb outfit
+		uint8_t go = (color & 0xFF00) >> 8;
+		uint8_t bo = (color & 0xFF);
+		red = (uint8_t)(red * (ro / 255.f));
+		green = (uint8_t)(green * (go / 255.f));
+		blue = (uint8_t)(blue * (bo / 255.f));
+	}
+
+	void referenceColorize(uint8_t* data, int bpp, const uint8_t* template_rgbdata, const uint32_t colors[4]) {
+		for (int y = 0; y < SPRITE_PIXELS; ++y) {
+			for (int x = 0; x < SPRITE_PIXELS; ++x) {
+				uint8_t& red = data[y * SPRITE_PIXELS * bpp + x * bpp + 0];
+				uint8_t& green = data[y * SPRITE_PIXELS * bpp + x * bpp + 1];
+				uint8_t& blue = data[y * SPRITE_PIXELS * bpp + x * bpp + 2];
+
+				const uint8_t& tred = template_rgbdata[y * SPRITE_PIXELS * 3 + x * 3 + 0];
+				const uint8_t& tgreen = template_rgbdata[y * SPRITE_PIXELS * 3 + x * 3 + 1];
+				const uint8_t& tblue = template_rgbdata[y * SPRITE_PIXELS * 3 + x * 3 + 2];
+
+				if (tred && tgreen && !tblue) { // yellow => head
+					referenceColorizePixel(colors[0], red, green, blue);
+				} else if (tred && !tgreen && !tblue) { // red => body
+					referenceColorizePixel(colors[1], red, green, blue);
+				} else if (!tred && tgreen && !tblue) { // green => legs
+					referenceColorizePixel(colors[2], red, green, blue);
+				} else if (!tred && !tgreen && tblue) { // blue => feet
+					referenceColorizePixel(colors[3], red, green, blue);
+				}
+			}
+		}
+	}
+
+	// ========================================================================
+	// Sample sprites
+
+	// Random well formed dumps: runs of every length up to a full sprite,
+	// sprites ending early and colored runs reaching past the last pixel
+	void generateSprites(std::mt19937& rng, std::vector<Sprite>& sprites) {
+		for (int n = 0; n < 2000; ++n) {
+			Sprite sprite;
+			sprite.has_alpha = (n & 1) != 0;
+			const int bpp = sprite.has_alpha ? 4 : 3;
+			const int max_run = (n % 7 == 0) ? SPRITE_PIXELS_SIZE : 1 << (rng() % 8);
+			const int pixels = SPRITE_PIXELS_SIZE + int(rng() % 64) - 48;
+
+			int written = 0;
+			while (written < pixels) {
+				int transparent = int(rng() % (max_run + 1));
+				if (rng() % 500 == 0) {
+					// Treated as corrupted by the RGBA decoder with alpha
+					transparent = SPRITE_PIXELS_SIZE + int(rng() % 16);
+				}
+				const int colored = int(rng() % (max_run + 1));
+				sprite.dump.push_back(uint8_t(transparent));
+				sprite.dump.push_back(uint8_t(transparent >> 8));
+				sprite.dump.push_back(uint8_t(colored));
+				sprite.dump.push_back(uint8_t(colored >> 8));
+				for (int i = 0; i < colored * bpp; ++i) {
+					sprite.dump.push_back(uint8_t(rng()));
+				}
+				written += transparent + colored;
+			}
+			sprites.push_back(std::move(sprite));
+		}
+	}
+
+	// Reads every sprite of a Tibia.spr file
+	bool loadSprites(const char* filename, bool extended, bool has_alpha, std::vector<Sprite>& sprites) {
+		FILE* file = fopen(filename, "rb");
+		if (!file) {
+			return false;
+		}
+		std::vector<uint8_t> data;
+		uint8_t buffer[65536];
+		size_t read;
+		while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+			data.insert(data.end(), buffer, buffer + read);
+		}
+		fclose(file);
+
+		auto u16 = [&data](size_t offset) {
+			return uint32_t(data[offset] | data[offset + 1] << 8);
+		};
+		auto u32 = [&u16](size_t offset) {
+			return u16(offset) | u16(offset + 2) << 16;
+		};
+
+		const size_t header = extended ? 8 : 6;
+		if (data.size() < header) {
+			return false;
+		}
+		const uint32_t count = extended ? u32(4) : u16(4);
+		if (data.size() < header + size_t(count) * 4) {
+			return false;
+		}
+		for (uint32_t i = 0; i < count; ++i) {
+			const uint32_t offset = u32(header + size_t(i) * 4);
+			// Skip the transparent color key in front of the size
+			if (offset == 0 || size_t(offset) + 5 > data.size()) {
+				continue;
+			}
+			const uint32_t size = u16(offset + 3);
+			if (size == 0 || size_t(offset) + 5 + size > data.size()) {
+				continue;
+			}
+			Sprite sprite;
+			sprite.dump.assign(data.begin() + offset + 5, data.begin() + offset + 5 + size);
+			sprite.has_alpha = has_alpha;
+			sprites.push_back(std::move(sprite));
+		}
+		return true;
+	}
+
+	// Template masks: the four outfit parts, unmasked pixels and mixed colors
+	// that match no part, with channel values other than 0xFF
+	void generateTemplate(std::mt19937& rng, uint8_t* template_rgb) {
+		for (int i = 0; i < SPRITE_PIXELS_SIZE; ++i) {
+			for (int c = 0; c < 3; ++c) {
+				template_rgb[i * 3 + c] = (rng() % 3 == 0) ? 0 : uint8_t(1 + rng() % 255);
+			}
+		}
+	}
+
+	void referenceColorizeRGB(uint8_t* rgb, const uint8_t* template_rgb, const uint32_t colors[4]) {
+		referenceColorize(rgb, 3, template_rgb, colors);
+	}
+
+	void referenceColorizeRGBA(uint8_t* rgba, const uint8_t* template_rgb, const uint32_t colors[4]) {
+		referenceColorize(rgba, 4, template_rgb, colors);
+	}
+
+	// ========================================================================
+
+	struct Functions {
+		void (*decodeRGB)(const uint8_t*, int, bool, uint8_t*);
+		void (*decodeRGBA)(const uint8_t*, int, bool, uint8_t*);
+		void (*colorizeRGB)(uint8_t*, const uint8_t*, const uint32_t*);
+		void (*colorizeRGBA)(uint8_t*, const uint8_t*, const uint32_t*);
+	};
+
+	const Functions reference_functions = { referenceDecodeRGB, referenceDecodeRGBA, referenceColorizeRGB, referenceColorizeRGBA };
+	const Functions kernel_functions = { SpriteKernels::decodeRGB, SpriteKernels::decodeRGBA, SpriteKernels::colorizeRGB, SpriteKernels::colorizeRGBA };
+
+	struct Samples {
+		std::vector<Sprite> sprites;
+		// One template and four outfit colors per sprite
+		std::vector<uint8_t> templates;
+		std::vector<uint32_t> colors;
+	};
+
+	// Decoded and colorized output of every sample, as RGB and RGBA
+	struct Output {
+		std::vector<uint8_t> rgb, rgba;
+		std::vector<uint8_t> colorized_rgb, colorized_rgba;
+	};
+
+	void run(const Functions& functions, const Samples& samples, Output& output) {
+		const size_t count = samples.sprites.size();
+		output.rgb.resize(count * RGB_SIZE);
+		output.rgba.resize(count * RGBA_SIZE);
+		for (size_t i = 0; i < count; ++i) {
+			const Sprite& sprite = samples.sprites[i];
+			functions.decodeRGB(sprite.dump.data(), int(sprite.dump.size()), sprite.has_alpha, &output.rgb[i * RGB_SIZE]);
+			functions.decodeRGBA(sprite.dump.data(), int(sprite.dump.size()), sprite.has_alpha, &output.rgba[i * RGBA_SIZE]);
+		}
+		output.colorized_rgb = output.rgb;
+		output.colorized_rgba = output.rgba;
+		for (size_t i = 0; i < count; ++i) {
+			functions.colorizeRGB(&output.colorized_rgb[i * RGB_SIZE], &samples.templates[i * RGB_SIZE], &samples.colors[i * 4]);
+			functions.colorizeRGBA(&output.colorized_rgba[i * RGBA_SIZE], &samples.templates[i * RGB_SIZE], &samples.colors[i * 4]);
+		}
+	}
+
+	typedef std::chrono::steady_clock Clock;
+
+	double elapsedNs(Clock::time_point start, size_t count) {
+		return std::chrono::duration<double, std::nano>(Clock::now() - start).count() / count;
+	}
+
+	// Prints the time per sprite of decoding and of colorizing, RGB and RGBA
+	// together. Colorizing runs repeatedly over the same buffers, the values
+	// only get darker which does not change the work done.
+	void bench(const char* name, const Functions& functions, const Samples& samples, int iterations) {
+		const size_t count = samples.sprites.size();
+		std::vector<uint8_t> rgb(count * RGB_SIZE);
+		std::vector<uint8_t> rgba(count * RGBA_SIZE);
+
+		Clock::time_point start = Clock::now();
+		for (int n = 0; n < iterations; ++n) {
+			for (size_t i = 0; i < count; ++i) {
+				const Sprite& sprite = samples.sprites[i];
+				functions.decodeRGB(sprite.dump.data(), int(sprite.dump.size()), sprite.has_alpha, &rgb[i * RGB_SIZE]);
+				functions.decodeRGBA(sprite.dump.data(), int(sprite.dump.size()), sprite.has_alpha, &rgba[i * RGBA_SIZE]);
+			}
+		}
+		const double decode = elapsedNs(start, count * iterations);
+
+		start = Clock::now();
+		for (int n = 0; n < iterations; ++n) {
+			for (size_t i = 0; i < count; ++i) {
+				functions.colorizeRGB(&rgb[i * RGB_SIZE], &samples.templates[i * RGB_SIZE], &samples.colors[i * 4]);
+				functions.colorizeRGBA(&rgba[i * RGBA_SIZE], &samples.templates[i * RGB_SIZE], &samples.colors[i * 4]);
+			}
+		}
+		const double colorize = elapsedNs(start, count * iterations);
+		printf("%-10s %12.1f %12.1f\n", name, decode, colorize);
+	}
+
+	// Reports the first differing byte of up to a few sprites
+	size_t compare(const char* kernel, const char* isa, const std::vector<uint8_t>& expected, const std::vector<uint8_t>& actual, int sprite_size) {
+		size_t mismatches = 0;
+		for (size_t i = 0; i < expected.size(); i += sprite_size) {
+			const uint8_t* e = &expected[i];
+			const uint8_t* a = &actual[i];
+			if (memcmp(e, a, sprite_size) == 0) {
+				continue;
+			}
+			if (++mismatches <= 3) {
+				int first = 0;
+				while (e[first] == a[first]) {
+					++first;
+				}
+				printf("%s (%s): sprite %zu differs at byte %d, expected %d, got %d\n", kernel, isa, i / sprite_size, first, e[first], a[first]);
+			}
+		}
+		return mismatches;
+	}
+}
+
+int main(int argc, char** argv) {
+	int iterations = 0;
+	const char* spr_filename = nullptr;
+	bool extended = false;
+	bool alpha = false;
+	for (int i = 1; i < argc; ++i) {
+		if (strcmp(argv[i], "--bench") == 0) {
+			iterations = 20;
+			if (i + 1 < argc && argv[i + 1][0] != '-') {
+				iterations = std::max(1, atoi(argv[++i]));
+			}
+		} else if (strcmp(argv[i], "--spr") == 0 && i + 1 < argc) {
+			spr_filename = argv[++i];
+		} else if (strcmp(argv[i], "--extended") == 0) {
+			extended = true;
+		} else if (strcmp(argv[i], "--alpha") == 0) {
+			alpha = true;
+		} else {
+			printf("Usage: %s [--bench [iterations]] [--spr file [--extended] [--alpha]]\n", argv[0]);
+			return 2;
+		}
+	}
+
+	std::mt19937 rng(0x524D45);
+	Samples samples;
+	if (spr_filename) {
+		if (!loadSprites(spr_filename, extended, alpha, samples.sprites)) {
+			printf("Could not read sprites from %s\n", spr_filename);
+			return 2;
+		}
+	} else {
+		generateSprites(rng, samples.sprites);
+	}
+	if (samples.sprites.empty()) {
+		printf("No sprites to check\n");
+		return 2;
+	}
+
+	const size_t count = samples.sprites.size();
+	samples.templates.resize(count * RGB_SIZE);
+	samples.colors.resize(count * 4);
+	for (size_t i = 0; i < count; ++i) {
+		generateTemplate(rng, &samples.templates[i * RGB_SIZE]);
+		for (int part = 0; part < 4; ++part) {
+			samples.colors[i * 4 + part] = rng() & 0xFFFFFF;
+		}
+	}
+
+	Output expected;
+	run(reference_functions, samples, expected);
+
+	printf("%zu sprites, best instruction set: %s\n", count, SpriteKernels::getInstructionSetName(SpriteKernels::getSupportedInstructionSet()));
+	if (iterations > 0) {
+		printf("%-10s %12s %12s (ns per sprite, RGB + RGBA)\n", "", "decode", "colorize");
+		bench("Reference", reference_functions, samples, iterations);
+	}
+
+	bool ok = true;
+	for (int isa = SpriteKernels::ISA_SCALAR; isa <= SpriteKernels::ISA_AVX2; ++isa) {
+		const char* name = SpriteKernels::getInstructionSetName(SpriteKernels::InstructionSet(isa));
+		SpriteKernels::setInstructionSet(SpriteKernels::InstructionSet(isa));
+		if (SpriteKernels::getInstructionSet() != isa) {
+			printf("%-10s not supported by this CPU, skipped\n", name);
+			continue;
+		}
+
+		Output actual;
+		run(kernel_functions, samples, actual);
+		size_t mismatches = compare("decodeRGB", name, expected.rgb, actual.rgb, RGB_SIZE);
+		mismatches += compare("decodeRGBA", name, expected.rgba, actual.rgba, RGBA_SIZE);
+		mismatches += compare("colorizeRGB", name, expected.colorized_rgb, actual.colorized_rgb, RGB_SIZE);
+		mismatches += compare("colorizeRGBA", name, expected.colorized_rgba, actual.colorized_rgba, RGBA_SIZE);
+		ok = ok && mismatches == 0;
+
+		if (iterations > 0) {
+			bench(name, kernel_functions, samples, iterations);
+		}
+		if (mismatches > 0) {
+			printf("%-10s %zu mismatching outputs\n", name, mismatches);
+		} else if (iterations == 0) {
+			printf("%-10s identical\n", name);
+		}
+	}
+	return ok ? 0 : 1;
+}